@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <curl/curl.h>
+#include "curl_wrapper.hpp"
+
+// Runs many HTTP requests concurrently on one curl multi handle driven by an
+// event loop thread. Requests to the same host beyond maxRequestsPerHost wait
+// in a FIFO queue; over HTTP/2 the running ones share a connection.
+// All public methods are thread-safe.
+class AsyncRequestEngine {
+public:
+    using RequestId = uint64_t;
+    // Receives the response body, or a non-null error. Runs on the event loop
+    // thread, so it should return quickly and must not throw.
+    using Callback = std::function<void(std::string response, std::exception_ptr error)>;
+
+    struct Options {
+        size_t maxRequestsPerHost = 8;
+        // Applied when submit() is given no timeout, zero waits forever
+        std::chrono::milliseconds defaultTimeout{0};
+    };
+
+    AsyncRequestEngine();
+    explicit AsyncRequestEngine(const Options& options);
+    // Fails every unfinished request with an error and stops the event loop
+    ~AsyncRequestEngine();
+
+    AsyncRequestEngine(const AsyncRequestEngine&) = delete;
+    AsyncRequestEngine& operator=(const AsyncRequestEngine&) = delete;
+
+    // Queues a request. The timeout counts from submission, so it includes
+    // time spent waiting for a free slot.
+    RequestId submit(HttpRequest request, Callback callback,
+                     std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+    std::future<std::string> submit(HttpRequest request,
+                                    std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+    // Fails the request with an error unless it has already finished
+    void cancel(RequestId id);
+
+    // Blocks until every submitted request has finished
+    void waitIdle();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Transfer {
+        RequestId id;
+        HttpRequest request;
+        Callback callback;
+        Clock::time_point deadline;
+        std::string host;
+        CURL* handle = nullptr;
+        struct curl_slist* headers = nullptr;
+        std::string response;
+    };
+
+    void run();
+    void takeCommands();
+    void expireQueued();
+    void startQueued();
+    int pollTimeout() const;
+    void start(std::unique_ptr<Transfer> transfer);
+    void finish(Transfer& transfer, CURLcode result);
+    void fail(Transfer& transfer, const std::string& message);
+    void complete(Transfer& transfer, std::string response, std::exception_ptr error);
+    std::unique_ptr<Transfer> takeQueued(RequestId id);
+
+    Options options;
+    CURLM* multi;
+
+    // Shared with submitting threads
+    std::mutex mutex;
+    std::condition_variable idleCondition;
+    std::vector<std::unique_ptr<Transfer>> submitted;
+    std::vector<RequestId> cancelled;
+    RequestId nextId = 1;
+    size_t unfinished = 0;
+    bool stopping = false;
+
+    // Owned by the event loop thread
+    std::unordered_map<std::string, std::deque<std::unique_ptr<Transfer>>> queuedByHost;
+    std::unordered_map<std::string, size_t> runningByHost;
+    std::unordered_map<RequestId, std::unique_ptr<Transfer>> running;
+
+    std::thread loop; // Last, so it starts after the state above
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Standard base64 (RFC 4648, with padding) into caller-provided buffers.
+// On x86 the fastest kernel the CPU supports is chosen at runtime: AVX2
+// handles 24 input bytes per step, SSSE3 12, otherwise a scalar table
+// lookup is used. All kernels produce identical output.
+class Base64 {
+public:
+    static size_t encodedSize(size_t length);
+    // Upper bound for decode(), exact for padded input without padding
+    static size_t decodedSize(size_t length);
+
+    // Writes encodedSize(length) characters to out
+    static void encode(const unsigned char* data, size_t length, char* out);
+    // Writes at most decodedSize(length) bytes to out and returns how many.
+    // Accepts input with or without padding.
+    // Throws std::runtime_error on characters outside the alphabet.
+    static size_t decode(const char* data, size_t length, unsigned char* out);
+
+    // "avx2", "ssse3" or "scalar"
+    static const char* implementation();
+    // Forces a kernel, e.g. for benchmarks; false if the CPU lacks it
+    static bool selectImplementation(const std::string& name);
+};
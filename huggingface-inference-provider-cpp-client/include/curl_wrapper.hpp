@@ -1,7 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <string>
+#include <vector>
+#include <mutex>
 #include <curl/curl.h>
+#include "request_body.hpp"
 
 class CurlGlobalManager {
 public:
@@ -14,6 +19,42 @@ private:
     ~CurlGlobalManager();
 };
 
+struct HttpRequest {
+    std::string url;
+    RequestBody body;
+    std::vector<std::string> headers;
+};
+
+// Process-wide pool of reusable easy handles. A returned handle keeps its
+// open connections, so the next request to the same host skips DNS, TCP and
+// TLS setup. All handles also share one DNS cache and one TLS session cache,
+// so even a fresh connection resumes the TLS session. Thread-safe.
+class CurlHandlePool {
+public:
+    static CurlHandlePool& getInstance();
+    CurlHandlePool(const CurlHandlePool&) = delete;
+    CurlHandlePool& operator=(const CurlHandlePool&) = delete;
+
+    // Returns an idle handle with default options, or a new one
+    CURL* acquire();
+    // Resets the handle's options and keeps it for reuse
+    void release(CURL* handle);
+
+private:
+    CurlHandlePool();
+    ~CurlHandlePool();
+
+    void applyDefaults(CURL* handle);
+    static void lockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlockShare(CURL* handle, curl_lock_data data, void* userptr);
+
+    CURLSH* share;
+    std::mutex shareMutexes[CURL_LOCK_DATA_LAST];
+    std::mutex poolMutex;
+    std::vector<CURL*> idleHandles;
+};
+
+// Easy handle checked out of the CurlHandlePool for its lifetime
 class CurlEasyHandle {
 private:
     CURL* handle;
@@ -28,12 +69,26 @@ public:
 };
 
 class CurlWrapper {
+public:
+    // Receives the response body as it arrives; returns false to stop
+    using DataCallback = std::function<bool(const char* data, size_t length)>;
+
 private:
     CurlEasyHandle easyHandle;
     std::string responseBuffer;
     struct curl_slist* headers;
 
+    struct StreamState {
+        CURL* handle;
+        const DataCallback* onData;
+        const std::atomic<bool>* cancelled;
+        std::string* errorBody;
+    };
+
     static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s);
+    static size_t StreamWriteCallback(char* contents, size_t size, size_t nmemb, void* userdata);
+    static int StreamProgressCallback(void* userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t);
+    void checkResult(CURLcode res);
 
 public:
     CurlWrapper();
@@ -41,6 +96,12 @@ public:
 
     CurlWrapper& setUrl(const std::string& url);
     CurlWrapper& setPostFields(const std::string& data);
+    // Streams the body while sending; it must outlive perform()
+    CurlWrapper& setBody(RequestBody& body);
     CurlWrapper& addHeader(const std::string& header);
     std::string perform();
+    // Performs the request handing the body to onData chunk by chunk.
+    // Returns false if onData or the cancelled flag, polled at least once a
+    // second, stopped the transfer early. Error responses throw as in perform().
+    bool performStreaming(const DataCallback& onData, const std::atomic<bool>* cancelled = nullptr);
 };
\ No newline at end of file
@@ -4,21 +4,106 @@
 #include <memory>
 #include <unordered_map>
 #include <functional>
+#include <future>
+#include <chrono>
+#include <stdexcept>
 #include <nlohmann/json.hpp>
 #include "curl_wrapper.hpp"
+#include "async_request_engine.hpp"
+#include "image_processing.hpp"
+#include "response_cache.hpp"
 
 class HuggingFaceTask {
+public:
+    enum class UploadMode {
+        Json,   // Image base64-encoded inside the JSON payload
+        Binary  // Raw image bytes as application/octet-stream, without parameters
+    };
+
 protected:
     std::string apiEndpoint;
     std::string token;
+    UploadMode uploadMode = UploadMode::Json;
+    EncoderPolicy encoderPolicy;
+    std::shared_ptr<ResponseCache> responseCache;
+
+    // Images go into the payload as placeholders from RequestBody::attachBase64
+    virtual nlohmann::json preparePayload(std::vector<RequestBody::Bytes>& images) const = 0;
+    // Encoded image for UploadMode::Binary, nullptr if the task cannot send one
+    virtual RequestBody::Bytes prepareBinaryInput() const;
+    std::vector<std::string> requestHeaders(const std::string& contentType) const;
+    // Builds the HTTP request, by default a POST of the payload or image to apiEndpoint
+    virtual HttpRequest prepareRequest() const;
+    // Turns the response body into the result of execute()
+    virtual std::string processResponse(const std::string& response);
 
-    virtual nlohmann::json preparePayload() const = 0;
+    // Performs the request, or takes its response from the cache, and
+    // returns the response body
+    std::string sendRequest() const;
+    static std::string performRequest(HttpRequest& request);
+    // Submits the request; transfer errors reach the callback as "HTTP request failed".
+    // A cached response is passed to the callback before this returns 0,
+    // a request coalesced with one in flight also returns 0. A coalesced
+    // request shares the timeout and cancellation of the one it waits for,
+    // not its own, and cannot be cancelled by itself.
+    AsyncRequestEngine::RequestId submitRequest(AsyncRequestEngine& engine,
+                                                AsyncRequestEngine::Callback callback,
+                                                std::chrono::milliseconds timeout) const;
 
 public:
     HuggingFaceTask(const std::string& endpoint, const std::string& authToken);
     virtual ~HuggingFaceTask() = default;
 
+    void setUploadMode(UploadMode mode);
+    void setEncoderPolicy(const EncoderPolicy& policy);
+    // Shares a cache of responses, nullptr to send every request
+    void setResponseCache(std::shared_ptr<ResponseCache> cache);
+
     virtual std::string execute();
+
+    // Runs the request on the engine. The payload is prepared on the calling
+    // thread and the response processed on the engine's event loop thread,
+    // or on the calling thread if it is cached; the task must outlive the
+    // request.
+    std::future<std::string> executeAsync(AsyncRequestEngine& engine,
+                                          std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+    AsyncRequestEngine::RequestId executeAsync(AsyncRequestEngine& engine,
+                                               AsyncRequestEngine::Callback callback,
+                                               std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+};
+
+// Task with a typed result, parsed straight from the received response by
+// parseResult(); execute() still returns the response text as is
+template<typename Result>
+class TypedHuggingFaceTask : public HuggingFaceTask {
+public:
+    using HuggingFaceTask::HuggingFaceTask;
+
+    Result executeTyped() {
+        return parseResult(sendRequest());
+    }
+
+    // Like executeAsync(), the result is parsed on the event loop thread
+    std::future<Result> executeTypedAsync(AsyncRequestEngine& engine,
+                                          std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        auto promise = std::make_shared<std::promise<Result>>();
+        std::future<Result> future = promise->get_future();
+        submitRequest(engine, [this, promise](std::string response, std::exception_ptr error) {
+            if (error) {
+                promise->set_exception(error);
+                return;
+            }
+            try {
+                promise->set_value(parseResult(response));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        }, timeout);
+        return future;
+    }
+
+protected:
+    virtual Result parseResult(const std::string& response) const = 0;
 };
 
 class HuggingFaceTaskFactory {
@@ -29,4 +114,26 @@ public:
         const std::string& authToken,
         const nlohmann::json& params
     );
+
+    // createTask() for a task with a typed result, e.g.
+    // createTypedTask<ObjectDetectionResults>("object-detection", ...)
+    template<typename Result>
+    static std::unique_ptr<TypedHuggingFaceTask<Result>> createTypedTask(
+        const std::string& taskType,
+        const std::string& endpoint,
+        const std::string& authToken,
+        const nlohmann::json& params
+    ) {
+        std::unique_ptr<HuggingFaceTask> task = createTask(taskType, endpoint, authToken, params);
+        auto* typedTask = dynamic_cast<TypedHuggingFaceTask<Result>*>(task.get());
+        if (!typedTask) {
+            throw std::runtime_error("Task type " + taskType + " does not produce the requested result type");
+        }
+        task.release();
+        return std::unique_ptr<TypedHuggingFaceTask<Result>>(typedTask);
+    }
+
+    // Reads "passthrough", "image_format" ("jpeg", "png" or "webp"),
+    // "image_quality", "max_image_bytes" and "min_image_quality"
+    static EncoderPolicy createEncoderPolicy(const nlohmann::json& params);
 };
@@ -1,17 +1,19 @@
 #pragma once
 
 #include "huggingface_task.hpp"
+#include "task_results.hpp"
 #include <vector>
 
-class ImageClassification : public HuggingFaceTask {
+class ImageClassification : public TypedHuggingFaceTask<ClassificationResults> {
 private:
     std::string imagePath;
 
 protected:
-    nlohmann::json preparePayload() const override;
+    nlohmann::json preparePayload(std::vector<RequestBody::Bytes>& images) const override;
+    RequestBody::Bytes prepareBinaryInput() const override;
+    ClassificationResults parseResult(const std::string& response) const override;
 
 public:
     ImageClassification(const std::string& endpoint, const std::string& authToken, 
                        const nlohmann::json& params);
-    std::string execute() override; 
 };
@@ -1,24 +1,58 @@
 #pragma once
+#include <optional>
 #include <string>
 #include <vector>
 #include <opencv2/opencv.hpp>
 
+enum class ImageFormat { Jpeg, Png, WebP };
+
+// How encodeImageBytes() turns an image file into upload bytes
+struct EncoderPolicy {
+    // Send the file as is when it is not resized, is in an accepted format
+    // and fits maxBytes, without decoding it. JPEGs that EXIF rotates are
+    // re-encoded upright instead, as cv::imread() shows them
+    bool passthrough = true;
+    std::vector<ImageFormat> acceptedFormats = {ImageFormat::Jpeg, ImageFormat::Png, ImageFormat::WebP};
+
+    // Otherwise the image is encoded in this format
+    ImageFormat format = ImageFormat::Jpeg;
+    int quality = 95;  // 1-100, JPEG and WebP only
+    // Byte budget, 0 for none. JPEG and WebP are encoded at the highest
+    // quality in [minQuality, quality] that fits, or at minQuality if none
+    // does; PNG at maximum compression.
+    size_t maxBytes = 0;
+    int minQuality = 40;
+};
 
 class ImageProcessing {
 public:
     ImageProcessing() = default;
     ~ImageProcessing() = default;
 
-    static std::string encodeImage(const std::string& image_path, int target_size, bool resize = false);
+    static std::string encodeImage(const std::string& image_path, int target_size, bool resize = false,
+                                   const EncoderPolicy& policy = EncoderPolicy());
+    // Same image as encodeImage(), before base64 encoding
+    static std::vector<unsigned char> encodeImageBytes(const std::string& image_path, int target_size, bool resize = false,
+                                                       const EncoderPolicy& policy = EncoderPolicy());
+
+    // Format of encoded image bytes, from their signature
+    static std::optional<ImageFormat> detectFormat(const std::vector<unsigned char>& data);
+    // MIME type of encoded image bytes, image/jpeg if unknown
+    static std::string mimeType(const std::vector<unsigned char>& data);
+    // EXIF orientation (1-8) of JPEG bytes, 1 (upright) if they have none
+    static int jpegOrientation(const std::vector<unsigned char>& data);
 
     // Public methods for testing
+    static std::vector<unsigned char> readFile(const std::string& image_path);
     static cv::Mat readImage(const std::string& image_path);
     static cv::Mat resizeImage(const cv::Mat& image, int target_size);
     static cv::Mat createSquareCanvas(const cv::Mat& image, int target_size);
     static std::vector<unsigned char> encodeToJpg(const cv::Mat& image);
+    static std::vector<unsigned char> encode(const cv::Mat& image, const EncoderPolicy& policy);
     static std::string encodeToBase64(const std::vector<unsigned char>& data);
     static std::vector<unsigned char> decodeBase64(const std::string& encoded_string);
 
 private:
     static cv::Size calculateNewSize(const cv::Mat& image, int target_size);
+    static std::vector<unsigned char> encodeAtQuality(const cv::Mat& image, ImageFormat format, int quality);
 };
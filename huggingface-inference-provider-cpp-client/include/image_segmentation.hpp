@@ -2,15 +2,9 @@
 #include <vector>
 #include <nlohmann/json.hpp>
 #include "huggingface_task.hpp"
-#include <opencv2/opencv.hpp>
+#include "task_results.hpp"
 
-struct SegmentationResult {
-    std::string label;
-    double score;
-    cv::Mat mask;
-};
-
-class ImageSegmentation : public HuggingFaceTask {
+class ImageSegmentation : public TypedHuggingFaceTask<SegmentationResults> {
 private:
     std::string imagePath;
     double maskThreshold;
@@ -21,7 +15,10 @@ private:
     bool resize;
 
 protected:
-    nlohmann::json preparePayload() const override;
+    nlohmann::json preparePayload(std::vector<RequestBody::Bytes>& images) const override;
+    // Only without parameters, a binary upload cannot carry them
+    RequestBody::Bytes prepareBinaryInput() const override;
+    SegmentationResults parseResult(const std::string& response) const override;
 
 public:
     ImageSegmentation(const std::string& endpoint, const std::string& authToken, 
@@ -32,6 +29,4 @@ public:
                       double threshold = 0,
                       int targetSize = 1024,
                       bool resize = false);
-
-    std::string execute();
 };
\ No newline at end of file
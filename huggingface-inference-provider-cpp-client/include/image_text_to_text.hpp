@@ -1,25 +1,56 @@
 #pragma once
 #include "huggingface_task.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <vector>
 
 class ImageTextToText : public HuggingFaceTask {
 public:
+    using Duration = std::chrono::duration<double, std::milli>;
+    // Receives each generated piece of text as it arrives; returns false to
+    // stop generating
+    using TokenCallback = std::function<bool(const std::string& token)>;
+
+    struct StreamResult {
+        std::string text;
+        size_t tokens = 0;
+        bool cancelled = false;  // Stopped by the callback or cancel()
+        Duration timeToFirstToken{0};  // From sending the request
+        Duration meanInterTokenLatency{0};
+        Duration maxInterTokenLatency{0};
+        Duration totalTime{0};
+    };
+
     ImageTextToText(const std::string& endpoint, const std::string& authToken, 
                     const std::vector<std::string>& images, 
                     const std::string& prompt,  
                     int targetSize = 1024,
                     bool resize = false);
 
-    std::string execute() override;
+    void setMaxTokens(int tokens);
+
+    // Requests a streamed completion and hands each token to onToken as soon
+    // as its server-sent event arrives, on the calling thread. Exceptions
+    // thrown by onToken stop the stream and are rethrown from here.
+    StreamResult executeStream(const TokenCallback& onToken);
+    // Stops a running executeStream() from another thread, or the next one
+    // if none is running yet
+    void cancel();
 
 protected:
-    nlohmann::json preparePayload() const override;
+    nlohmann::json preparePayload(std::vector<RequestBody::Bytes>& attachedImages) const override;
+    HttpRequest prepareRequest() const override;
 
 private:
+    HttpRequest prepareChatRequest(bool stream) const;
+
     std::vector<std::string> images;
     std::string prompt;
     int targetSize;
     bool resize;
-};
\ No newline at end of file
+    int maxTokens = 500;
+    std::atomic<bool> cancelled{false};
+};
@@ -1,18 +1,19 @@
 #pragma once
 #include "huggingface_task.hpp"
+#include "task_results.hpp"
 #include <vector>
 
-class ObjectDetection : public HuggingFaceTask {
+class ObjectDetection : public TypedHuggingFaceTask<ObjectDetectionResults> {
 private:
     std::string imagePath;
     double threshold;
 
 protected:
-    nlohmann::json preparePayload() const override;
+    nlohmann::json preparePayload(std::vector<RequestBody::Bytes>& images) const override;
+    ObjectDetectionResults parseResult(const std::string& response) const override;
 
 public:
     ObjectDetection(const std::string& endpoint, const std::string& authToken, 
                     const nlohmann::json& params);
-    std::string execute() override;
 };
 
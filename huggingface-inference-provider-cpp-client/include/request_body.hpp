@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <curl/curl.h>
+#include <nlohmann/json.hpp>
+
+// HTTP request body streamed to curl through CURLOPT_READFUNCTION. It is a
+// sequence of parts: text such as JSON, binary data sent as is, and binary
+// data base64-encoded while it is being sent. So an image is held once, in
+// its encoded file format, instead of as a base64 string, inside a JSON
+// document and again as the dumped payload.
+class RequestBody {
+public:
+    using Bytes = std::shared_ptr<const std::vector<unsigned char>>;
+
+    RequestBody() = default;
+    explicit RequestBody(std::string text);
+
+    // Stores an image for fromJson() and returns the string to put in the
+    // payload where its base64 encoding belongs, also inside a longer string
+    static std::string attachBase64(std::vector<Bytes>& images, std::vector<unsigned char> data);
+    // Dumps the payload, streaming images in place of their placeholders
+    static RequestBody fromJson(const nlohmann::json& payload, const std::vector<Bytes>& images);
+
+    void appendText(std::string text);
+    void appendBinary(Bytes data);
+    void appendBase64(Bytes data);
+
+    // Bytes sent in total, i.e. the Content-Length
+    size_t size() const;
+    bool empty() const;
+
+    // Copies the next bytes into buffer, returns 0 at the end
+    size_t read(char* buffer, size_t length);
+    // Moves the read position, returns false if offset is past the end
+    bool seek(size_t offset);
+
+    // Sets the read and seek callbacks and the size on a handle; the body
+    // must outlive the transfer
+    void attachTo(CURL* handle);
+
+private:
+    enum class Encoding { Text, Binary, Base64 };
+
+    struct Part {
+        Encoding encoding;
+        std::string text;
+        Bytes data;
+        size_t size; // After encoding
+    };
+
+    static size_t readCallback(char* buffer, size_t size, size_t nitems, void* userdata);
+    static int seekCallback(void* userdata, curl_off_t offset, int origin);
+
+    std::vector<Part> parts;
+    size_t totalSize = 0;
+    size_t partIndex = 0;  // Read position
+    size_t partOffset = 0;
+};
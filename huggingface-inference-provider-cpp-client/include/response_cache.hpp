@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "async_request_engine.hpp"
+#include "curl_wrapper.hpp"
+
+// Cache of successful responses, content-addressed by a SHA-256 of the
+// request: URL, headers except Authorization, and body, i.e. the task
+// parameters and encoded image bytes. Entries live in an in-memory LRU tier
+// and, when a directory is given, in files that outlive the process; both
+// expire after the TTL. Expired files are deleted when the cache is created
+// and by a sweep while storing, at most once an hour. Identical requests
+// arriving while one is in flight wait for its response instead of being
+// sent again. Thread-safe, and meant to be shared by any number of tasks
+// through HuggingFaceTask::setResponseCache().
+class ResponseCache {
+public:
+    struct Options {
+        size_t maxMemoryBytes = 64 * 1024 * 1024;
+        // Empty for no disk tier
+        std::string directory;
+        std::chrono::seconds ttl = std::chrono::hours(24);
+    };
+
+    struct Stats {
+        uint64_t memoryHits = 0;
+        uint64_t diskHits = 0;
+        uint64_t coalesced = 0;  // Served by a request already in flight
+        uint64_t misses = 0;     // Sent to the server
+        uint64_t evictions = 0;  // Dropped from memory for space
+        uint64_t expired = 0;    // Misses that found a stale entry
+    };
+
+    // Gets the response passed on to the waiting callbacks
+    using Fetch = std::function<void(AsyncRequestEngine::Callback complete)>;
+
+    ResponseCache();
+    explicit ResponseCache(const Options& options);
+
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    // Hex SHA-256 of the request, read through its body and rewound
+    static std::string makeKey(HttpRequest& request);
+
+    // Calls done with the cached response if there is one, right away on
+    // the calling thread. Otherwise waits for an identical request in
+    // flight, or calls fetch and stores its response; done then runs
+    // wherever fetch completes. Errors are passed on but not cached.
+    // Returns whether fetch was called.
+    // A waiter shares the outcome of the fetch it waits for: it fails when
+    // that fetch times out or is cancelled, and cannot stop it on its own.
+    bool get(const std::string& key, AsyncRequestEngine::Callback done, const Fetch& fetch);
+    // Blocking get(), fetch runs on the calling thread
+    std::string get(const std::string& key, const std::function<std::string()>& fetch);
+
+    Stats stats() const;
+    // Empties the memory tier and deletes the files of the disk tier
+    void clear();
+
+private:
+    using Clock = std::chrono::system_clock;
+
+    struct Entry {
+        std::string key;
+        std::string response;
+        Clock::time_point expiry;
+    };
+
+    // Drop a stale entry, setting expired
+    std::optional<std::string> lookupMemory(const std::string& key, bool& expired);
+    std::optional<std::string> lookupDisk(const std::string& key, bool& expired);
+    void storeMemory(const std::string& key, const std::string& response, Clock::time_point expiry);
+    void storeDisk(const std::string& key, const std::string& response, Clock::time_point expiry);
+    void store(const std::string& key, const std::string& response);
+    // Hands the response to the callbacks waiting for it
+    void notify(const std::string& key, const std::string& response, std::exception_ptr error);
+    std::string diskPath(const std::string& key) const;
+    // Deletes expired entry files, unless a sweep ran recently
+    void pruneDisk();
+
+    Options options;
+    mutable std::mutex mutex;
+    std::list<Entry> lru;  // Most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> entries;
+    size_t memoryBytes = 0;
+    // Callbacks waiting for each request in flight
+    std::unordered_map<std::string, std::vector<AsyncRequestEngine::Callback>> inFlight;
+    Stats counters;
+    Clock::time_point nextPrune;  // Earliest time of the next disk sweep
+};
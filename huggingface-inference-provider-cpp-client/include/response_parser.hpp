@@ -0,0 +1,15 @@
+#pragma once
+
+#include <string>
+#include "task_results.hpp"
+
+// Parses task responses straight into result structs with a single SAX pass
+// over the received text, without building a JSON document. Strings are
+// moved out of the parser, and segmentation masks are base64-decoded as
+// they are read. Throws std::runtime_error on malformed responses.
+class ResponseParser {
+public:
+    static ObjectDetectionResults parseObjectDetections(const std::string& response);
+    static ClassificationResults parseClassifications(const std::string& response);
+    static SegmentationResults parseSegmentations(const std::string& response);
+};
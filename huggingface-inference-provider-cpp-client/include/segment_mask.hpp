@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+// Binary mask stored as runs of set pixels per row. Segmentation masks are
+// mostly a few large regions, so this takes a few bytes per row instead of
+// a byte per pixel, and can be drawn at any size without resizing a Mat.
+class SegmentMask {
+public:
+    SegmentMask() = default;
+    // Pixels that are nonzero in a CV_8UC1 mask
+    static SegmentMask fromMat(const cv::Mat& mask);
+
+    int width() const;
+    int height() const;
+    bool empty() const;
+    // Number of set pixels
+    size_t area() const;
+
+    // CV_8UC1, 255 inside the mask
+    cv::Mat toMat() const;
+    // Writes value to the set pixels of row y of the mask scaled to size,
+    // sampled like cv::INTER_NEAREST; row holds size.width labels
+    void fillRow(int y, cv::Size size, uint16_t value, uint16_t* row) const;
+
+private:
+    int cols = 0;
+    int rows = 0;
+    std::vector<size_t> rowStart;          // First run of each row, rows + 1 entries
+    std::vector<std::pair<int, int>> runs; // [begin, end) columns
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <functional>
+#include <string>
+
+// Incremental parser of a text/event-stream (server-sent events). feed()
+// takes the response in whatever chunks it arrives in and calls back once
+// per complete event, so an event is handled as soon as its blank line is
+// received.
+class SseParser {
+public:
+    struct Event {
+        std::string type;  // "event" field, "message" if absent
+        std::string data;  // "data" fields joined by newlines
+        std::string id;
+    };
+    // Returns false to stop parsing
+    using EventCallback = std::function<bool(const Event& event)>;
+
+    explicit SseParser(EventCallback onEvent);
+
+    // Returns false once the callback has stopped parsing
+    bool feed(const char* data, size_t length);
+
+private:
+    bool processLine(const char* line, size_t length);
+
+    EventCallback onEvent;
+    std::string pending;  // Incomplete last line
+    Event current;
+    bool hasData = false;
+    bool stopped = false;
+};
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+#include "segment_mask.hpp"
+
+struct BoundingBox {
+    int xmin = 0;
+    int ymin = 0;
+    int xmax = 0;
+    int ymax = 0;
+};
+
+struct ObjectDetectionResult {
+    std::string label;
+    double score = 0;
+    BoundingBox box;
+};
+
+struct ClassificationResult {
+    std::string label;
+    double score = 0;
+};
+
+struct SegmentationResult {
+    std::string label;
+    std::optional<double> score;  // None for semantic segmentation
+    SegmentMask mask;
+};
+
+using ObjectDetectionResults = std::vector<ObjectDetectionResult>;
+using ClassificationResults = std::vector<ClassificationResult>;
+using SegmentationResults = std::vector<SegmentationResult>;
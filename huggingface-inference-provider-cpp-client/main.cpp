@@ -5,6 +5,7 @@
 #include <variant>
 #include <filesystem>
 #include <cstdlib>
+#include <limits>
 #include <nlohmann/json.hpp>
 #include <opencv2/opencv.hpp>
 
@@ -27,27 +28,20 @@ std::optional<std::string> getEnvVar(std::string_view key) {
 template<typename T>
 using Result = std::variant<T, std::string>;
 
-void drawBoundingBoxes(const nlohmann::json& result, const std::string& imagePath) {
+void drawBoundingBoxes(const ObjectDetectionResults& detections, const std::string& imagePath) {
     cv::Mat image = cv::imread(imagePath);
     if (image.empty()) {
         std::cerr << "Error: Could not read the image." << std::endl;
         return;
     }
 
-    for (const auto& detection : result) {
-        std::string label = detection["label"];
-        float score = detection["score"];
-        auto box = detection["box"];
+    for (const auto& detection : detections) {
+        const BoundingBox& box = detection.box;
 
-        int xmin = box["xmin"];
-        int ymin = box["ymin"];
-        int xmax = box["xmax"];
-        int ymax = box["ymax"];
+        cv::rectangle(image, cv::Point(box.xmin, box.ymin), cv::Point(box.xmax, box.ymax), cv::Scalar(0, 255, 0), 2);
 
-        cv::rectangle(image, cv::Point(xmin, ymin), cv::Point(xmax, ymax), cv::Scalar(0, 255, 0), 2);
-
-        std::string label_with_score = label + " " + std::to_string(score).substr(0, 4);
-        cv::putText(image, label_with_score, cv::Point(xmin, ymin - 10),
+        std::string label_with_score = detection.label + " " + std::to_string(detection.score).substr(0, 4);
+        cv::putText(image, label_with_score, cv::Point(box.xmin, box.ymin - 10),
                     cv::FONT_HERSHEY_SIMPLEX, 0.9, cv::Scalar(0, 255, 0), 2);
     }
 
@@ -59,40 +53,56 @@ void drawBoundingBoxes(const nlohmann::json& result, const std::string& imagePat
     cv::imwrite("result_" + std::filesystem::path(imagePath).filename().string(), image);
 }
 
-void drawImageSegmentationMasks(const nlohmann::json& jsonResult, const std::string& imagePath) {
+void drawImageSegmentationMasks(const SegmentationResults& segments, const std::string& imagePath) {
     // Load the input image
     cv::Mat image = cv::imread(imagePath);
+    if (image.empty()) {
+        std::cerr << "Error: Could not read the image." << std::endl;
+        return;
+    }
 
-    // Create a map to store the colors for each label
-    std::map<std::string, cv::Scalar> labelColors;
-
-    // Draw the masks on the input image
-    for (const auto& segment : jsonResult) {
-        std::string label = segment["label"];
-        std::string base64Mask = segment["mask"];
-        std::vector<unsigned char> decodedMask = ImageProcessing::decodeBase64(base64Mask);
-        cv::Mat mask = cv::imdecode(decodedMask, cv::IMREAD_GRAYSCALE);
-
-        // Resize the mask to match the input image size
-        cv::resize(mask, mask, image.size());
-
-        // Assign a color to the label if it doesn't exist
-        if (labelColors.find(label) == labelColors.end()) {
-            // Generate a random color for the label
+    // Give each label an id and a random color; id 0 is no segment. The
+    // colors are stored at half intensity, the weight they are blended with.
+    std::map<std::string, uint16_t> labelIds;
+    std::vector<cv::Vec3b> halfColors(1, cv::Vec3b(0, 0, 0));
+    std::vector<uint16_t> segmentIds;
+    for (const auto& segment : segments) {
+        auto found = labelIds.find(segment.label);
+        if (found == labelIds.end()) {
+            if (halfColors.size() > std::numeric_limits<uint16_t>::max()) {
+                std::cerr << "Error: Too many labels to draw." << std::endl;
+                return;
+            }
             int r = rand() % 256;
             int g = rand() % 256;
             int b = rand() % 256;
-            labelColors[label] = cv::Scalar(b, g, r);
+            halfColors.push_back(cv::Vec3b(b / 2, g / 2, r / 2));
+            found = labelIds.emplace(segment.label, static_cast<uint16_t>(halfColors.size() - 1)).first;
         }
-
-        // Draw the mask on the input image
-        cv::Mat coloredMask;
-        cv::cvtColor(mask, coloredMask, cv::COLOR_GRAY2BGR);
-        coloredMask *= 255; // Convert to 0-255 range
-        coloredMask.setTo(labelColors[label], mask); // Set color to the label color
-        cv::addWeighted(image, 1, coloredMask, 0.5, 0, image);
+        segmentIds.push_back(found->second);
     }
 
+    // Composite all masks in a single pass over the image: for each row, the
+    // masks, scaled to the image, set the label of their pixels (later
+    // segments on top), then the label colors are added with saturation in
+    // one vectorized cv::add
+    cv::parallel_for_(cv::Range(0, image.rows), [&](const cv::Range& range) {
+        std::vector<uint16_t> labels(image.cols);
+        cv::Mat overlay(1, image.cols, CV_8UC3);
+        for (int y = range.start; y < range.end; ++y) {
+            std::fill(labels.begin(), labels.end(), 0);
+            for (size_t i = 0; i < segments.size(); ++i) {
+                segments[i].mask.fillRow(y, image.size(), segmentIds[i], labels.data());
+            }
+            cv::Vec3b* colors = overlay.ptr<cv::Vec3b>(0);
+            for (int x = 0; x < image.cols; ++x) {
+                colors[x] = halfColors[labels[x]];
+            }
+            cv::Mat row = image.row(y);
+            cv::add(row, overlay, row);
+        }
+    });
+
     // Display the output image
     cv::imshow("Instance Segmentation Result", image);
     cv::waitKey(0);
@@ -102,30 +112,58 @@ void drawImageSegmentationMasks(const nlohmann::json& jsonResult, const std::str
     cv::imwrite("result_" + std::filesystem::path(imagePath).filename().string(), image);
 }
 
+void showResult(const ObjectDetectionResults& detections, const std::string& imagePath) {
+    std::cout << "Detected objects:\n";
+    for (const auto& detection : detections) {
+        std::cout << "Label: " << detection.label << ", Score: " << detection.score << "\n";
+        std::cout << "Bounding box: "
+                  << "(" << detection.box.xmin << ", " << detection.box.ymin << ") - "
+                  << "(" << detection.box.xmax << ", " << detection.box.ymax << ")\n";
+    }
+    drawBoundingBoxes(detections, imagePath);
+}
+
+void showResult(const ClassificationResults& classifications, const std::string&) {
+    std::cout << "Image Classification Results:\n";
+    for (const auto& classification : classifications) {
+        std::cout << "Label: " << classification.label << ", Score: " << classification.score << "\n";
+    }
+}
+
+void showResult(const SegmentationResults& segments, const std::string& imagePath) {
+    std::cout << "Instance Segmentation Results:\n";
+    for (const auto& segment : segments) {
+        std::cout << "Label: " << segment.label;
+        if (segment.score) {
+            std::cout << ", Score: " << *segment.score;
+        }
+        std::cout << "\n";
+    }
+    drawImageSegmentationMasks(segments, imagePath);
+}
 
 template<typename T>
-void processResult(const Result<T>& result, const std::string& taskType, const std::string& imagePath) {
+void processResult(const Result<T>& result, const std::string& imagePath) {
     if (auto value = std::get_if<T>(&result)) {
-        
-        if (taskType == "object-detection") {
-            drawBoundingBoxes(*value, imagePath);
-            std::cout << "Success: " << value->dump(2) << std::endl;
-        } else if (taskType == "image-segmentation") {
-            drawImageSegmentationMasks(*value, imagePath);
-        }
+        showResult(*value, imagePath);
     } else {
         std::cerr << "Error: " << std::get<std::string>(result) << std::endl;
     }
 }
 
-Result<nlohmann::json> executeTask(const std::string& taskType, 
-                                   const std::string& model, 
-                                   const std::string& authToken, 
-                                   const nlohmann::json& params) {
+template<typename T>
+Result<T> executeTask(const std::string& taskType, 
+                      const std::string& model, 
+                      const std::string& authToken, 
+                      const nlohmann::json& params,
+                      const nlohmann::json& encoderParams,
+                      const std::shared_ptr<ResponseCache>& cache) {
     try {
-        auto task = HuggingFaceTaskFactory::createTask(taskType, model, authToken, params);
-        std::string response = task->execute();
-        return nlohmann::json::parse(response);
+        nlohmann::json taskParams = params;
+        taskParams.update(encoderParams);
+        auto task = HuggingFaceTaskFactory::createTypedTask<T>(taskType, model, authToken, taskParams);
+        task->setResponseCache(cache);
+        return task->executeTyped();
     } catch (const std::exception& e) {
         return std::string(e.what());
     }
@@ -138,7 +176,16 @@ int main(int argc, char** argv)
         ("h,help", "Print help")
         ("i,input", "Input source", cxxopts::value<std::string>())
         ("t,task", "Task type", cxxopts::value<std::string>())
-        ("m,model", "Model name", cxxopts::value<std::string>());
+        ("m,model", "Model name", cxxopts::value<std::string>())
+        ("b,binary", "Upload raw image bytes instead of base64 JSON (image-classification)")
+        ("reencode", "Always decode and re-encode the image instead of uploading the file as is")
+        ("format", "Image upload format: jpeg, png or webp", cxxopts::value<std::string>()->default_value("jpeg"))
+        ("quality", "JPEG/WebP quality (1-100)", cxxopts::value<int>()->default_value("95"))
+        ("max-bytes", "Encoded image byte budget, 0 for none", cxxopts::value<size_t>()->default_value("0"))
+        ("s,stream", "Print generated text as it is streamed (image-text-to-text)")
+        ("api-url", "Base URL of the models", cxxopts::value<std::string>()->default_value("https://api-inference.huggingface.co/models"))
+        ("cache-dir", "Cache responses in this directory", cxxopts::value<std::string>())
+        ("cache-ttl", "Hours a cached response stays valid", cxxopts::value<int>()->default_value("24"));
 
     auto result = options.parse(argc, argv);
 
@@ -162,19 +209,35 @@ int main(int argc, char** argv)
 
 
     const std::string taskType = result["task"].as<std::string>();
+    const std::string apiUrl = result["api-url"].as<std::string>();
+    std::shared_ptr<ResponseCache> cache;
+    if (result.count("cache-dir")) {
+        ResponseCache::Options cacheOptions;
+        cacheOptions.directory = result["cache-dir"].as<std::string>();
+        cacheOptions.ttl = std::chrono::hours(result["cache-ttl"].as<int>());
+        cache = std::make_shared<ResponseCache>(cacheOptions);
+    }
+    const nlohmann::json encoderParams{
+        {"passthrough", result.count("reencode") == 0},
+        {"image_format", result["format"].as<std::string>()},
+        {"image_quality", result["quality"].as<int>()},
+        {"max_image_bytes", result["max-bytes"].as<size_t>()}
+    };
 
     if (taskType == "object-detection") {
-        const auto objectDetectionResult = executeTask(
+        const auto objectDetectionResult = executeTask<ObjectDetectionResults>(
             taskType,
-            "https://api-inference.huggingface.co/models/facebook/detr-resnet-50",
+            apiUrl + "/facebook/detr-resnet-50",
             *authToken,
-            nlohmann::json{{"image_path", image_path.string()}, {"threshold", 0.7}}
+            nlohmann::json{{"image_path", image_path.string()}, {"threshold", 0.7}},
+            encoderParams,
+            cache
         );
-        processResult(objectDetectionResult, taskType, image_path.string());
+        processResult(objectDetectionResult, image_path.string());
     } else if (taskType == "image-segmentation") {
-        const auto imageSegmentationResult = executeTask(
+        const auto imageSegmentationResult = executeTask<SegmentationResults>(
             taskType,
-            "https://api-inference.huggingface.co/models/nvidia/segformer-b0-finetuned-ade-512-512",
+            apiUrl + "/nvidia/segformer-b0-finetuned-ade-512-512",
             *authToken,
             nlohmann::json{
                 {"image_path", image_path.string()},
@@ -182,36 +245,61 @@ int main(int argc, char** argv)
                 {"overlap_mask_area_threshold", 0.5},
                 {"subtask", "semantic"},
                 {"threshold", 0.9}
-            }
+            },
+            encoderParams,
+            cache
         );
 
-        processResult(imageSegmentationResult, taskType, image_path.string());
+        processResult(imageSegmentationResult, image_path.string());
     }
     else if (taskType == "image-classification") {
-        const auto imageClassificationResult = executeTask(
+        const auto imageClassificationResult = executeTask<ClassificationResults>(
             taskType,
-            "https://api-inference.huggingface.co/models/google/vit-base-patch16-224",
+            apiUrl + "/google/vit-base-patch16-224",
             *authToken,
-            nlohmann::json{{"image_path", image_path.string()}}
+            nlohmann::json{{"image_path", image_path.string()}, {"binary_upload", result.count("binary") > 0}},
+            encoderParams,
+            cache
         );
-        processResult(imageClassificationResult, taskType, image_path.string());
+        processResult(imageClassificationResult, image_path.string());
     }
     else if (taskType == "image-text-to-text") {
         ImageTextToText task(
-            "https://api-inference.huggingface.co/models/meta-llama/Llama-3.2-11B-Vision-Instruct",
+            apiUrl + "/meta-llama/Llama-3.2-11B-Vision-Instruct",
             *authToken,
             {image_path.string()},
             "Describe this image in one sentence.",
             512,
             true
         );
-        std::string response = task.execute();
-        std::cout << "Response: " << response << std::endl;
+        task.setEncoderPolicy(HuggingFaceTaskFactory::createEncoderPolicy(encoderParams));
+        task.setResponseCache(cache);
+        if (result.count("stream")) {
+            std::cout << "Response: " << std::flush;
+            const auto stream = task.executeStream([](const std::string& token) {
+                std::cout << token << std::flush;
+                return true;
+            });
+            std::cout << "\n\nTokens: " << stream.tokens
+                      << ", time to first token: " << stream.timeToFirstToken.count() << " ms"
+                      << ", inter-token latency: " << stream.meanInterTokenLatency.count() << " ms mean, "
+                      << stream.maxInterTokenLatency.count() << " ms max"
+                      << ", total: " << stream.totalTime.count() << " ms" << std::endl;
+        } else {
+            std::string response = task.execute();
+            std::cout << "Response: " << response << std::endl;
+        }
     }
     else {
         std::cerr << "Error: Invalid task type." << std::endl;
         return 1;
     }
 
+    if (cache) {
+        const ResponseCache::Stats stats = cache->stats();
+        std::cout << "Cache: " << stats.memoryHits + stats.diskHits << " hits, "
+                  << stats.misses << " misses" << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
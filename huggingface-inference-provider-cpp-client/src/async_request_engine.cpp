@@ -0,0 +1,330 @@
+#include "async_request_engine.hpp"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+// Upper bound on a poll, curl wakes the loop earlier for its own timeouts
+constexpr int POLL_TIMEOUT_MS = 1000;
+
+size_t appendResponse(void* contents, size_t size, size_t nmemb, std::string* s) {
+    size_t length = size * nmemb;
+    try {
+        s->append(static_cast<char*>(contents), length);
+        return length;
+    } catch (const std::bad_alloc&) {
+        return 0;
+    }
+}
+
+std::string hostOf(const std::string& url) {
+    std::string host = url;
+    CURLU* parsed = curl_url();
+    char* part = nullptr;
+    if (parsed && curl_url_set(parsed, CURLUPART_URL, url.c_str(), 0) == CURLUE_OK &&
+        curl_url_get(parsed, CURLUPART_HOST, &part, 0) == CURLUE_OK) {
+        host = part;
+        curl_free(part);
+    }
+    curl_url_cleanup(parsed);
+    return host;
+}
+
+CURLM* createMulti() {
+    // The pool owns global initialization and must outlive the handles we return to it
+    CurlHandlePool::getInstance();
+    CURLM* multi = curl_multi_init();
+    if (!multi) {
+        throw std::runtime_error("Failed to create CURL multi handle");
+    }
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    return multi;
+}
+}
+
+AsyncRequestEngine::AsyncRequestEngine() : AsyncRequestEngine(Options()) {}
+
+AsyncRequestEngine::AsyncRequestEngine(const Options& options)
+    : options(options), multi(createMulti()), loop(&AsyncRequestEngine::run, this) {}
+
+AsyncRequestEngine::~AsyncRequestEngine() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    curl_multi_wakeup(multi);
+    loop.join();
+    curl_multi_cleanup(multi);
+}
+
+AsyncRequestEngine::RequestId AsyncRequestEngine::submit(HttpRequest request, Callback callback,
+                                                         std::chrono::milliseconds timeout) {
+    if (timeout.count() <= 0) {
+        timeout = options.defaultTimeout;
+    }
+    auto transfer = std::make_unique<Transfer>();
+    transfer->request = std::move(request);
+    transfer->callback = std::move(callback);
+    transfer->deadline = timeout.count() > 0 ? Clock::now() + timeout : Clock::time_point::max();
+    transfer->host = hostOf(transfer->request.url);
+
+    RequestId id;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        id = nextId++;
+        transfer->id = id;
+        submitted.push_back(std::move(transfer));
+        ++unfinished;
+    }
+    curl_multi_wakeup(multi);
+    return id;
+}
+
+std::future<std::string> AsyncRequestEngine::submit(HttpRequest request,
+                                                    std::chrono::milliseconds timeout) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = promise->get_future();
+    submit(std::move(request), [promise](std::string response, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(response));
+        }
+    }, timeout);
+    return future;
+}
+
+void AsyncRequestEngine::cancel(RequestId id) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cancelled.push_back(id);
+    }
+    curl_multi_wakeup(multi);
+}
+
+void AsyncRequestEngine::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idleCondition.wait(lock, [this] { return unfinished == 0; });
+}
+
+void AsyncRequestEngine::run() {
+    while (true) {
+        takeCommands();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping) {
+                break;
+            }
+        }
+        expireQueued();
+        startQueued();
+
+        int stillRunning = 0;
+        curl_multi_perform(multi, &stillRunning);
+        int messagesLeft = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &messagesLeft)) {
+            if (message->msg == CURLMSG_DONE) {
+                Transfer* transfer = nullptr;
+                curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+                finish(*transfer, message->data.result);
+            }
+        }
+        // Slots freed above are refilled before sleeping
+        startQueued();
+
+        curl_multi_poll(multi, nullptr, 0, pollTimeout(), nullptr);
+    }
+
+    // Shutting down: nothing is waited for
+    std::vector<std::unique_ptr<Transfer>> left;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        left = std::move(submitted);
+    }
+    for (auto& [host, queue] : queuedByHost) {
+        for (auto& transfer : queue) {
+            left.push_back(std::move(transfer));
+        }
+    }
+    queuedByHost.clear();
+    for (auto& [id, transfer] : running) {
+        curl_multi_remove_handle(multi, transfer->handle);
+        left.push_back(std::move(transfer));
+    }
+    running.clear();
+    for (auto& transfer : left) {
+        fail(*transfer, "Request engine stopped");
+    }
+}
+
+void AsyncRequestEngine::takeCommands() {
+    std::vector<std::unique_ptr<Transfer>> newTransfers;
+    std::vector<RequestId> newCancellations;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        newTransfers.swap(submitted);
+        newCancellations.swap(cancelled);
+    }
+    for (auto& transfer : newTransfers) {
+        auto& queue = queuedByHost[transfer->host];
+        queue.push_back(std::move(transfer));
+    }
+
+    for (RequestId id : newCancellations) {
+        if (auto transfer = takeQueued(id)) {
+            fail(*transfer, "Request cancelled");
+            continue;
+        }
+        auto it = running.find(id);
+        if (it != running.end()) {
+            std::unique_ptr<Transfer> transfer = std::move(it->second);
+            running.erase(it);
+            curl_multi_remove_handle(multi, transfer->handle);
+            --runningByHost[transfer->host];
+            fail(*transfer, "Request cancelled");
+        }
+        // Otherwise it has already finished
+    }
+}
+
+void AsyncRequestEngine::expireQueued() {
+    const auto now = Clock::now();
+    for (auto& [host, queue] : queuedByHost) {
+        for (auto it = queue.begin(); it != queue.end();) {
+            if ((*it)->deadline <= now) {
+                std::unique_ptr<Transfer> transfer = std::move(*it);
+                it = queue.erase(it);
+                fail(*transfer, "Timeout was reached while queued");
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+int AsyncRequestEngine::pollTimeout() const {
+    // Wake up in time to expire the first queued request due
+    auto deadline = Clock::now() + std::chrono::milliseconds(POLL_TIMEOUT_MS);
+    for (const auto& [host, queue] : queuedByHost) {
+        for (const auto& transfer : queue) {
+            deadline = std::min(deadline, transfer->deadline);
+        }
+    }
+    const auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+    return static_cast<int>(std::max<std::chrono::milliseconds::rep>(wait.count(), 0));
+}
+
+void AsyncRequestEngine::startQueued() {
+    for (auto& [host, queue] : queuedByHost) {
+        size_t& hostRunning = runningByHost[host];
+        while (!queue.empty() && hostRunning < options.maxRequestsPerHost) {
+            std::unique_ptr<Transfer> transfer = std::move(queue.front());
+            queue.pop_front();
+            start(std::move(transfer));
+        }
+    }
+}
+
+void AsyncRequestEngine::start(std::unique_ptr<Transfer> transfer) {
+    long timeoutMs = 0;
+    if (transfer->deadline != Clock::time_point::max()) {
+        timeoutMs = static_cast<long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            transfer->deadline - Clock::now()).count());
+        if (timeoutMs <= 0) {
+            fail(*transfer, "Timeout was reached while queued");
+            return;
+        }
+    }
+
+    CURL* handle;
+    try {
+        handle = CurlHandlePool::getInstance().acquire();
+    } catch (const std::exception& e) {
+        fail(*transfer, e.what());
+        return;
+    }
+    transfer->handle = handle;
+    for (const auto& header : transfer->request.headers) {
+        transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+    }
+
+    curl_easy_setopt(handle, CURLOPT_URL, transfer->request.url.c_str());
+    if (!transfer->request.body.empty()) {
+        transfer->request.body.attachTo(handle);
+    }
+    if (transfer->headers) {
+        curl_easy_setopt(handle, CURLOPT_HTTPHEADER, transfer->headers);
+    }
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, appendResponse);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, &transfer->response);
+    curl_easy_setopt(handle, CURLOPT_PRIVATE, transfer.get());
+    curl_easy_setopt(handle, CURLOPT_TIMEOUT_MS, timeoutMs);
+    // Wait for an HTTP/2 connection being set up rather than opening another
+    curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+
+    CURLMcode added = curl_multi_add_handle(multi, handle);
+    if (added != CURLM_OK) {
+        fail(*transfer, std::string("curl_multi_add_handle() failed: ") + curl_multi_strerror(added));
+        return;
+    }
+    ++runningByHost[transfer->host];
+    running.emplace(transfer->id, std::move(transfer));
+}
+
+void AsyncRequestEngine::finish(Transfer& finished, CURLcode result) {
+    auto it = running.find(finished.id);
+    std::unique_ptr<Transfer> transfer = std::move(it->second);
+    running.erase(it);
+    curl_multi_remove_handle(multi, transfer->handle);
+    --runningByHost[transfer->host];
+
+    long httpCode = 0;
+    curl_easy_getinfo(transfer->handle, CURLINFO_RESPONSE_CODE, &httpCode);
+    if (result != CURLE_OK) {
+        fail(*transfer, std::string("Transfer failed: ") + curl_easy_strerror(result));
+    } else if (httpCode >= 400) {
+        fail(*transfer, "HTTP error: " + std::to_string(httpCode) + "\nResponse: " + transfer->response);
+    } else {
+        std::string response = std::move(transfer->response);
+        complete(*transfer, std::move(response), nullptr);
+    }
+}
+
+void AsyncRequestEngine::fail(Transfer& transfer, const std::string& message) {
+    complete(transfer, {}, std::make_exception_ptr(std::runtime_error(message)));
+}
+
+void AsyncRequestEngine::complete(Transfer& transfer, std::string response, std::exception_ptr error) {
+    if (transfer.handle) {
+        CurlHandlePool::getInstance().release(transfer.handle);
+        transfer.handle = nullptr;
+    }
+    if (transfer.headers) {
+        curl_slist_free_all(transfer.headers);
+        transfer.headers = nullptr;
+    }
+
+    try {
+        transfer.callback(std::move(response), error);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: Request callback threw: " << e.what() << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--unfinished == 0) {
+        idleCondition.notify_all();
+    }
+}
+
+std::unique_ptr<AsyncRequestEngine::Transfer> AsyncRequestEngine::takeQueued(RequestId id) {
+    for (auto& [host, queue] : queuedByHost) {
+        for (auto it = queue.begin(); it != queue.end(); ++it) {
+            if ((*it)->id == id) {
+                std::unique_ptr<Transfer> transfer = std::move(*it);
+                queue.erase(it);
+                return transfer;
+            }
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,318 @@
+#include "base64.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define BASE64_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr int8_t INVALID = -1;
+
+constexpr std::array<int8_t, 256> makeDecodeTable() {
+    std::array<int8_t, 256> table{};
+    for (auto& value : table) {
+        value = INVALID;
+    }
+    for (int i = 0; i < 64; ++i) {
+        table[static_cast<unsigned char>(ALPHABET[i])] = static_cast<int8_t>(i);
+    }
+    return table;
+}
+
+constexpr std::array<int8_t, 256> DECODE_TABLE = makeDecodeTable();
+
+// Kernels handle whole blocks and return how much input they consumed; the
+// scalar code finishes the rest, including padding and error reporting
+using EncodeBlocks = size_t (*)(const unsigned char* in, size_t length, char* out);
+using DecodeBlocks = size_t (*)(const char* in, size_t length, unsigned char* out);
+
+struct Kernels {
+    const char* name;
+    EncodeBlocks encode;
+    DecodeBlocks decode;
+};
+
+size_t encodeNone(const unsigned char*, size_t, char*) {
+    return 0;
+}
+
+size_t decodeNone(const char*, size_t, unsigned char*) {
+    return 0;
+}
+
+void encodeScalar(const unsigned char* in, size_t length, char* out) {
+    size_t i = 0;
+    for (; i + 3 <= length; i += 3) {
+        const uint32_t triple = (uint32_t(in[i]) << 16) | (uint32_t(in[i + 1]) << 8) | in[i + 2];
+        *out++ = ALPHABET[(triple >> 18) & 0x3f];
+        *out++ = ALPHABET[(triple >> 12) & 0x3f];
+        *out++ = ALPHABET[(triple >> 6) & 0x3f];
+        *out++ = ALPHABET[triple & 0x3f];
+    }
+    if (i < length) {
+        const uint32_t b0 = in[i];
+        const uint32_t b1 = i + 1 < length ? in[i + 1] : 0;
+        *out++ = ALPHABET[b0 >> 2];
+        *out++ = ALPHABET[((b0 & 0x03) << 4) | (b1 >> 4)];
+        *out++ = i + 1 < length ? ALPHABET[(b1 & 0x0f) << 2] : '=';
+        *out++ = '=';
+    }
+}
+
+int8_t decodeChar(const char* in, size_t position) {
+    const int8_t value = DECODE_TABLE[static_cast<unsigned char>(in[position])];
+    if (value == INVALID) {
+        throw std::runtime_error("Invalid base64 character at position " + std::to_string(position));
+    }
+    return value;
+}
+
+// Decodes in[start, length), unpadded and not 1 modulo 4 characters long
+size_t decodeScalar(const char* in, size_t start, size_t length, unsigned char* out) {
+    unsigned char* first = out;
+    size_t i = start;
+    for (; i + 4 <= length; i += 4) {
+        const uint32_t quad = (uint32_t(decodeChar(in, i)) << 18) | (uint32_t(decodeChar(in, i + 1)) << 12) |
+                              (uint32_t(decodeChar(in, i + 2)) << 6) | uint32_t(decodeChar(in, i + 3));
+        *out++ = static_cast<unsigned char>(quad >> 16);
+        *out++ = static_cast<unsigned char>(quad >> 8);
+        *out++ = static_cast<unsigned char>(quad);
+    }
+    if (i + 2 <= length) {
+        const uint32_t c0 = uint32_t(decodeChar(in, i));
+        const uint32_t c1 = uint32_t(decodeChar(in, i + 1));
+        *out++ = static_cast<unsigned char>((c0 << 2) | (c1 >> 4));
+        if (i + 3 == length) {
+            const uint32_t c2 = uint32_t(decodeChar(in, i + 2));
+            *out++ = static_cast<unsigned char>((c1 << 4) | (c2 >> 2));
+        }
+    }
+    return static_cast<size_t>(out - first);
+}
+
+#ifdef BASE64_X86_KERNELS
+// The vector kernels follow Wojciech Muła's and Daniel Lemire's base64
+// algorithms: a byte shuffle spreads each 3-byte group over 4 bytes,
+// multiplies shift the 6-bit fields into place, and a 16-entry shuffle
+// table indexed by value range maps them to ASCII. Decoding validates each
+// character against per-nibble bounds, maps it back and packs the fields
+// with multiply-add.
+
+__attribute__((target("ssse3"))) __m128i encodeReshuffle(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+__attribute__((target("ssse3"))) __m128i encodeTranslate(__m128i indices) {
+    // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+}
+
+__attribute__((target("ssse3"))) size_t encodeSsse3(const unsigned char* in, size_t length, char* out) {
+    size_t i = 0;
+    // Each step reads 16 bytes and encodes the first 12
+    for (; i + 16 <= length; i += 12) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), encodeTranslate(encodeReshuffle(block)));
+        out += 16;
+    }
+    return i;
+}
+
+__attribute__((target("ssse3"))) bool decodeTranslate(__m128i in, __m128i& values) {
+    const __m128i nibble = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+    // Per high nibble: the valid range and what to add to map it to 0..63.
+    // An empty range (1..0) rejects every byte with that nibble.
+    const __m128i lowerBounds = _mm_setr_epi8(1, 1, 0x2b, 0x30, 0x41, 0x50, 0x61, 0x70, 1, 1, 1, 1, 1, 1, 1, 1);
+    const __m128i upperBounds = _mm_setr_epi8(0, 0, 0x2b, 0x39, 0x4f, 0x5a, 0x6f, 0x7a, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i shifts = _mm_setr_epi8(0, 0, 0x3e - 0x2b, 0x34 - 0x30, 0x00 - 0x41, 0x0f - 0x50, 0x1a - 0x61,
+                                         0x29 - 0x70, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i below = _mm_cmplt_epi8(in, _mm_shuffle_epi8(lowerBounds, nibble));
+    const __m128i above = _mm_cmpgt_epi8(in, _mm_shuffle_epi8(upperBounds, nibble));
+    // '/' shares the nibble of '+', whose range is just '+'
+    const __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+    if (_mm_movemask_epi8(_mm_andnot_si128(slash, _mm_or_si128(below, above))) != 0) {
+        return false;
+    }
+    values = _mm_add_epi8(_mm_add_epi8(in, _mm_shuffle_epi8(shifts, nibble)),
+                          _mm_and_si128(slash, _mm_set1_epi8(-3)));
+    return true;
+}
+
+__attribute__((target("ssse3"))) __m128i decodePack(__m128i values) {
+    const __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i triples = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(triples, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+__attribute__((target("ssse3"))) size_t decodeSsse3(const char* in, size_t length, unsigned char* out) {
+    size_t i = 0;
+    // Each step stores 16 bytes of which 12 are valid; the 8 characters
+    // left over decode to at least 4 more, so the rest is overwritten later
+    for (; i + 16 + 8 <= length; i += 16) {
+        __m128i values;
+        if (!decodeTranslate(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)), values)) {
+            break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), decodePack(values));
+        out += 12;
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t encodeAvx2(const unsigned char* in, size_t length, char* out) {
+    const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                             1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                                             'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    size_t i = 0;
+    // Each lane takes 12 bytes; the second load reads up to byte 28
+    for (; i + 28 <= length; i += 24) {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 12));
+        __m256i block = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        block = _mm256_shuffle_epi8(block, shuffle);
+        const __m256i t0 = _mm256_and_si256(block, _mm256_set1_epi32(0x0fc0fc00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(block, _mm256_set1_epi32(0x003f03f0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+        const __m256i encoded = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), encoded);
+        out += 32;
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) size_t decodeAvx2(const char* in, size_t length, unsigned char* out) {
+    const __m256i lowerBounds = _mm256_setr_epi8(1, 1, 0x2b, 0x30, 0x41, 0x50, 0x61, 0x70, 1, 1, 1, 1, 1, 1, 1, 1,
+                                                 1, 1, 0x2b, 0x30, 0x41, 0x50, 0x61, 0x70, 1, 1, 1, 1, 1, 1, 1, 1);
+    const __m256i upperBounds = _mm256_setr_epi8(0, 0, 0x2b, 0x39, 0x4f, 0x5a, 0x6f, 0x7a, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                 0, 0, 0x2b, 0x39, 0x4f, 0x5a, 0x6f, 0x7a, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i shifts = _mm256_setr_epi8(0, 0, 0x3e - 0x2b, 0x34 - 0x30, 0x00 - 0x41, 0x0f - 0x50, 0x1a - 0x61,
+                                            0x29 - 0x70, 0, 0, 0, 0, 0, 0, 0, 0,
+                                            0, 0, 0x3e - 0x2b, 0x34 - 0x30, 0x00 - 0x41, 0x0f - 0x50, 0x1a - 0x61,
+                                            0x29 - 0x70, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    size_t i = 0;
+    // Each step stores 32 bytes of which 24 are valid; the 12 characters
+    // left over decode to at least 8 more
+    for (; i + 32 + 12 <= length; i += 32) {
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        const __m256i nibble = _mm256_and_si256(_mm256_srli_epi32(block, 4), _mm256_set1_epi8(0x0f));
+        const __m256i below = _mm256_cmpgt_epi8(_mm256_shuffle_epi8(lowerBounds, nibble), block);
+        const __m256i above = _mm256_cmpgt_epi8(block, _mm256_shuffle_epi8(upperBounds, nibble));
+        const __m256i slash = _mm256_cmpeq_epi8(block, _mm256_set1_epi8('/'));
+        if (_mm256_movemask_epi8(_mm256_andnot_si256(slash, _mm256_or_si256(below, above))) != 0) {
+            break;
+        }
+        const __m256i values = _mm256_add_epi8(_mm256_add_epi8(block, _mm256_shuffle_epi8(shifts, nibble)),
+                                               _mm256_and_si256(slash, _mm256_set1_epi8(-3)));
+        const __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        const __m256i triples = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        // 12 bytes per lane, then the lanes joined
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(triples, pack),
+                                                           _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), packed);
+        out += 24;
+    }
+    return i;
+}
+#endif
+
+constexpr Kernels SCALAR_KERNELS{"scalar", encodeNone, decodeNone};
+#ifdef BASE64_X86_KERNELS
+constexpr Kernels SSSE3_KERNELS{"ssse3", encodeSsse3, decodeSsse3};
+constexpr Kernels AVX2_KERNELS{"avx2", encodeAvx2, decodeAvx2};
+#endif
+
+const Kernels* bestKernels() {
+#ifdef BASE64_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &AVX2_KERNELS;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return &SSSE3_KERNELS;
+    }
+#endif
+    return &SCALAR_KERNELS;
+}
+
+std::atomic<const Kernels*>& activeKernels() {
+    static std::atomic<const Kernels*> kernels{bestKernels()};
+    return kernels;
+}
+}
+
+size_t Base64::encodedSize(size_t length) {
+    return (length + 2) / 3 * 4;
+}
+
+size_t Base64::decodedSize(size_t length) {
+    const size_t rest = length % 4;
+    return length / 4 * 3 + (rest > 1 ? rest - 1 : 0);
+}
+
+void Base64::encode(const unsigned char* data, size_t length, char* out) {
+    const size_t consumed = activeKernels().load(std::memory_order_relaxed)->encode(data, length, out);
+    encodeScalar(data + consumed, length - consumed, out + consumed / 3 * 4);
+}
+
+size_t Base64::decode(const char* data, size_t length, unsigned char* out) {
+    if (length % 4 == 0 && length > 0 && data[length - 1] == '=') {
+        length -= data[length - 2] == '=' ? 2 : 1;
+    }
+    if (length % 4 == 1) {
+        throw std::runtime_error("Invalid base64 length");
+    }
+    const size_t consumed = activeKernels().load(std::memory_order_relaxed)->decode(data, length, out);
+    const size_t written = consumed / 4 * 3;
+    return written + decodeScalar(data, consumed, length, out + written);
+}
+
+const char* Base64::implementation() {
+    return activeKernels().load()->name;
+}
+
+bool Base64::selectImplementation(const std::string& name) {
+    const Kernels* kernels = nullptr;
+    if (name == SCALAR_KERNELS.name) {
+        kernels = &SCALAR_KERNELS;
+    }
+#ifdef BASE64_X86_KERNELS
+    __builtin_cpu_init();
+    if (name == SSSE3_KERNELS.name && __builtin_cpu_supports("ssse3")) {
+        kernels = &SSSE3_KERNELS;
+    }
+    if (name == AVX2_KERNELS.name && __builtin_cpu_supports("avx2")) {
+        kernels = &AVX2_KERNELS;
+    }
+#endif
+    if (!kernels) {
+        return false;
+    }
+    activeKernels().store(kernels);
+    return true;
+}
@@ -18,16 +18,101 @@ CurlGlobalManager::~CurlGlobalManager() {
     curl_global_cleanup();
 }
 
-// CurlEasyHandle implementation
-CurlEasyHandle::CurlEasyHandle() : handle(curl_easy_init()) {
+// CurlHandlePool implementation
+namespace {
+// More idle handles than concurrent requests only hold sockets open
+constexpr size_t MAX_IDLE_HANDLES = 16;
+constexpr long KEEPALIVE_IDLE_SECONDS = 30;
+constexpr long KEEPALIVE_INTERVAL_SECONDS = 15;
+constexpr long DNS_CACHE_SECONDS = 300;
+}
+
+CurlHandlePool& CurlHandlePool::getInstance() {
+    static CurlHandlePool instance;
+    return instance;
+}
+
+CurlHandlePool::CurlHandlePool() {
+    // Initialized first, so libcurl is cleaned up after the pool
+    CurlGlobalManager::getInstance();
+    share = curl_share_init();
+    if (!share) {
+        throw std::runtime_error("Failed to create CURL share handle");
+    }
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockShare);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+    curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    // Connections stay per handle: libcurl does not support sharing a
+    // connection cache between concurrently running threads
+}
+
+CurlHandlePool::~CurlHandlePool() {
+    for (CURL* handle : idleHandles) {
+        curl_easy_cleanup(handle);
+    }
+    curl_share_cleanup(share);
+}
+
+CURL* CurlHandlePool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (!idleHandles.empty()) {
+            // Most recently used first, its connections are the least likely to have timed out
+            CURL* handle = idleHandles.back();
+            idleHandles.pop_back();
+            return handle;
+        }
+    }
+
+    CURL* handle = curl_easy_init();
     if (!handle) {
         throw std::runtime_error("Failed to create CURL handle");
     }
+    applyDefaults(handle);
+    return handle;
+}
+
+void CurlHandlePool::release(CURL* handle) {
+    // Drops options pointing into the caller's buffers but keeps open connections
+    curl_easy_reset(handle);
+    applyDefaults(handle);
+
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (idleHandles.size() < MAX_IDLE_HANDLES) {
+        idleHandles.push_back(handle);
+    } else {
+        curl_easy_cleanup(handle);
+    }
+}
+
+void CurlHandlePool::applyDefaults(CURL* handle) {
+    curl_easy_setopt(handle, CURLOPT_SHARE, share);
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPIDLE, KEEPALIVE_IDLE_SECONDS);
+    curl_easy_setopt(handle, CURLOPT_TCP_KEEPINTVL, KEEPALIVE_INTERVAL_SECONDS);
+    curl_easy_setopt(handle, CURLOPT_TCP_NODELAY, 1L);
+    curl_easy_setopt(handle, CURLOPT_DNS_CACHE_TIMEOUT, DNS_CACHE_SECONDS);
+    // Signals cannot be used for timeouts with several threads
+    curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
 }
 
+void CurlHandlePool::lockShare(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<CurlHandlePool*>(userptr)->shareMutexes[data].lock();
+}
+
+void CurlHandlePool::unlockShare(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<CurlHandlePool*>(userptr)->shareMutexes[data].unlock();
+}
+
+// CurlEasyHandle implementation
+CurlEasyHandle::CurlEasyHandle() : handle(CurlHandlePool::getInstance().acquire()) {}
+
 CurlEasyHandle::~CurlEasyHandle() {
     if (handle) {
-        curl_easy_cleanup(handle);
+        CurlHandlePool::getInstance().release(handle);
     }
 }
 
@@ -69,6 +154,11 @@ CurlWrapper& CurlWrapper::setPostFields(const std::string& data) {
     return *this;
 }
 
+CurlWrapper& CurlWrapper::setBody(RequestBody& body) {
+    body.attachTo(easyHandle.get());
+    return *this;
+}
+
 CurlWrapper& CurlWrapper::addHeader(const std::string& header) {
     headers = curl_slist_append(headers, header.c_str());
     return *this;
@@ -80,7 +170,58 @@ std::string CurlWrapper::perform() {
     }
 
     responseBuffer.clear();
+    checkResult(curl_easy_perform(easyHandle.get()));
+    return responseBuffer;
+}
+
+bool CurlWrapper::performStreaming(const DataCallback& onData, const std::atomic<bool>* cancelled) {
+    if (headers) {
+        curl_easy_setopt(easyHandle.get(), CURLOPT_HTTPHEADER, headers);
+    }
+
+    responseBuffer.clear();
+    StreamState state{easyHandle.get(), &onData, cancelled, &responseBuffer};
+    curl_easy_setopt(easyHandle.get(), CURLOPT_WRITEFUNCTION, StreamWriteCallback);
+    curl_easy_setopt(easyHandle.get(), CURLOPT_WRITEDATA, &state);
+    if (cancelled) {
+        curl_easy_setopt(easyHandle.get(), CURLOPT_XFERINFOFUNCTION, StreamProgressCallback);
+        curl_easy_setopt(easyHandle.get(), CURLOPT_XFERINFODATA, &state);
+        curl_easy_setopt(easyHandle.get(), CURLOPT_NOPROGRESS, 0L);
+    }
+
     CURLcode res = curl_easy_perform(easyHandle.get());
+    curl_easy_setopt(easyHandle.get(), CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(easyHandle.get(), CURLOPT_WRITEDATA, &responseBuffer);
+    curl_easy_setopt(easyHandle.get(), CURLOPT_NOPROGRESS, 1L);
+
+    if (res == CURLE_WRITE_ERROR || res == CURLE_ABORTED_BY_CALLBACK) {
+        return false;
+    }
+    checkResult(res);
+    return true;
+}
+
+size_t CurlWrapper::StreamWriteCallback(char* contents, size_t size, size_t nmemb, void* userdata) {
+    StreamState* state = static_cast<StreamState*>(userdata);
+    const size_t length = size * nmemb;
+    // An error response is not the stream, keep it for the exception
+    long httpCode = 0;
+    curl_easy_getinfo(state->handle, CURLINFO_RESPONSE_CODE, &httpCode);
+    if (httpCode >= 400) {
+        state->errorBody->append(contents, length);
+        return length;
+    }
+    if ((state->cancelled && state->cancelled->load()) || !(*state->onData)(contents, length)) {
+        return 0;  // Fails the transfer with CURLE_WRITE_ERROR
+    }
+    return length;
+}
+
+int CurlWrapper::StreamProgressCallback(void* userdata, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+    return static_cast<StreamState*>(userdata)->cancelled->load() ? 1 : 0;
+}
+
+void CurlWrapper::checkResult(CURLcode res) {
     if (res != CURLE_OK) {
         throw std::runtime_error(std::string("curl_easy_perform() failed: ") + curl_easy_strerror(res));
     }
@@ -90,6 +231,4 @@ std::string CurlWrapper::perform() {
     if (httpCode >= 400) {
         throw std::runtime_error("HTTP error: " + std::to_string(httpCode) + "\nResponse: " + responseBuffer);
     }
-
-    return responseBuffer;
 }
\ No newline at end of file
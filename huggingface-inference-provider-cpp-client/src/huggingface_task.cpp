@@ -7,23 +7,159 @@
 HuggingFaceTask::HuggingFaceTask(const std::string& endpoint, const std::string& authToken)
     : apiEndpoint(endpoint), token(authToken) {}
     
+void HuggingFaceTask::setUploadMode(UploadMode mode)
+{
+    uploadMode = mode;
+}
+
+void HuggingFaceTask::setEncoderPolicy(const EncoderPolicy& policy)
+{
+    encoderPolicy = policy;
+}
+
+void HuggingFaceTask::setResponseCache(std::shared_ptr<ResponseCache> cache)
+{
+    responseCache = std::move(cache);
+}
+
+RequestBody::Bytes HuggingFaceTask::prepareBinaryInput() const
+{
+    return nullptr;
+}
+
+std::vector<std::string> HuggingFaceTask::requestHeaders(const std::string& contentType) const
+{
+    return {
+        "Content-Type: " + contentType,
+        "Authorization: Bearer " + token,
+        // Streamed bodies would otherwise wait for a 100 Continue first
+        "Expect:"
+    };
+}
+
+HttpRequest HuggingFaceTask::prepareRequest() const
+{
+    if (uploadMode == UploadMode::Binary) {
+        RequestBody::Bytes image = prepareBinaryInput();
+        if (!image) {
+            throw std::runtime_error("Binary upload is not supported by this task");
+        }
+        RequestBody body;
+        body.appendBinary(std::move(image));
+        return HttpRequest{apiEndpoint, std::move(body), requestHeaders("application/octet-stream")};
+    }
+
+    std::vector<RequestBody::Bytes> images;
+    nlohmann::json payload = preparePayload(images);
+    return HttpRequest{
+        apiEndpoint,
+        RequestBody::fromJson(payload, images),
+        requestHeaders("application/json")
+    };
+}
+
+std::string HuggingFaceTask::processResponse(const std::string& response)
+{
+    return response;
+}
+
 std::string HuggingFaceTask::execute() 
 {
-    CurlWrapper curl;
-    nlohmann::json payload = preparePayload();
-    std::string payloadStr = payload.dump();
+    return processResponse(sendRequest());
+}
 
-    try {
-        std::string response = curl.setUrl(apiEndpoint)
-            .setPostFields(payloadStr)
-            .addHeader("Content-Type: application/json")
-            .addHeader("Authorization: Bearer " + token)
-            .perform();
+std::string HuggingFaceTask::sendRequest() const
+{
+    HttpRequest request = prepareRequest();
+    if (!responseCache) {
+        return performRequest(request);
+    }
+    return responseCache->get(ResponseCache::makeKey(request), [&request] {
+        return performRequest(request);
+    });
+}
 
-        return response;
+std::string HuggingFaceTask::performRequest(HttpRequest& request)
+{
+    std::string response;
+
+    try {
+        CurlWrapper curl;
+        curl.setUrl(request.url).setBody(request.body);
+        for (const auto& header : request.headers) {
+            curl.addHeader(header);
+        }
+        response = curl.perform();
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("HTTP request failed: ") + e.what());
     }
+
+    return response;
+}
+
+std::future<std::string> HuggingFaceTask::executeAsync(AsyncRequestEngine& engine,
+                                                       std::chrono::milliseconds timeout)
+{
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> future = promise->get_future();
+    executeAsync(engine, [promise](std::string response, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        } else {
+            promise->set_value(std::move(response));
+        }
+    }, timeout);
+    return future;
+}
+
+AsyncRequestEngine::RequestId HuggingFaceTask::executeAsync(AsyncRequestEngine& engine,
+                                                            AsyncRequestEngine::Callback callback,
+                                                            std::chrono::milliseconds timeout)
+{
+    return submitRequest(engine, [this, callback = std::move(callback)](std::string response, std::exception_ptr error) {
+        if (error) {
+            callback({}, error);
+            return;
+        }
+        std::string result;
+        try {
+            result = processResponse(response);
+        } catch (...) {
+            callback({}, std::current_exception());
+            return;
+        }
+        callback(std::move(result), nullptr);
+    }, timeout);
+}
+
+AsyncRequestEngine::RequestId HuggingFaceTask::submitRequest(AsyncRequestEngine& engine,
+                                                             AsyncRequestEngine::Callback callback,
+                                                             std::chrono::milliseconds timeout) const
+{
+    HttpRequest request = prepareRequest();
+    AsyncRequestEngine::Callback done = [callback = std::move(callback)](std::string response, std::exception_ptr error) {
+        if (error) {
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception& e) {
+                callback({}, std::make_exception_ptr(std::runtime_error(std::string("HTTP request failed: ") + e.what())));
+            } catch (...) {
+                callback({}, error);
+            }
+            return;
+        }
+        callback(std::move(response), nullptr);
+    };
+    if (!responseCache) {
+        return engine.submit(std::move(request), std::move(done), timeout);
+    }
+
+    const std::string key = ResponseCache::makeKey(request);
+    AsyncRequestEngine::RequestId id = 0;
+    responseCache->get(key, std::move(done), [&](AsyncRequestEngine::Callback complete) {
+        id = engine.submit(std::move(request), std::move(complete), timeout);
+    });
+    return id;
 }
 
 std::unique_ptr<HuggingFaceTask> HuggingFaceTaskFactory::createTask(
@@ -32,13 +168,14 @@ std::unique_ptr<HuggingFaceTask> HuggingFaceTaskFactory::createTask(
     const std::string& authToken,
     const nlohmann::json& params
 ) {
+    std::unique_ptr<HuggingFaceTask> task;
     if (taskType == "object-detection") {
-        return std::make_unique<ObjectDetection>(endpoint, authToken, params);
+        task = std::make_unique<ObjectDetection>(endpoint, authToken, params);
     } else if (taskType == "image-classification") {
-        return std::make_unique<ImageClassification>(endpoint, authToken, params);
+        task = std::make_unique<ImageClassification>(endpoint, authToken, params);
     }
-    else if (taskType == "instance-segmentation") {
-            return std::make_unique<ImageSegmentation>(
+    else if (taskType == "instance-segmentation" || taskType == "image-segmentation") {
+            task = std::make_unique<ImageSegmentation>(
                 endpoint,
                 authToken,
                 params["image_path"].get<std::string>(),
@@ -51,4 +188,30 @@ std::unique_ptr<HuggingFaceTask> HuggingFaceTaskFactory::createTask(
      else {
         throw std::runtime_error("Unknown task type: " + taskType);
     }
+
+    if (params.value("binary_upload", false)) {
+        task->setUploadMode(HuggingFaceTask::UploadMode::Binary);
+    }
+    task->setEncoderPolicy(createEncoderPolicy(params));
+    return task;
+}
+
+EncoderPolicy HuggingFaceTaskFactory::createEncoderPolicy(const nlohmann::json& params)
+{
+    EncoderPolicy policy;
+    policy.passthrough = params.value("passthrough", policy.passthrough);
+    const std::string format = params.value("image_format", "jpeg");
+    if (format == "jpeg" || format == "jpg") {
+        policy.format = ImageFormat::Jpeg;
+    } else if (format == "png") {
+        policy.format = ImageFormat::Png;
+    } else if (format == "webp") {
+        policy.format = ImageFormat::WebP;
+    } else {
+        throw std::runtime_error("Unknown image format: " + format);
+    }
+    policy.quality = params.value("image_quality", policy.quality);
+    policy.maxBytes = params.value("max_image_bytes", policy.maxBytes);
+    policy.minQuality = params.value("min_image_quality", policy.minQuality);
+    return policy;
 }
\ No newline at end of file
@@ -1,19 +1,128 @@
 #include "image_processing.hpp"
-#include "base64.h" 
+#include "base64.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
 #include <stdexcept>
 
-std::string ImageProcessing::encodeImage(const std::string& image_path, int target_size, bool resize) {
-    cv::Mat image = readImage(image_path);
+std::string ImageProcessing::encodeImage(const std::string& image_path, int target_size, bool resize,
+                                         const EncoderPolicy& policy) {
+    return encodeToBase64(encodeImageBytes(image_path, target_size, resize, policy));
+}
+
+std::vector<unsigned char> ImageProcessing::encodeImageBytes(const std::string& image_path, int target_size, bool resize,
+                                                             const EncoderPolicy& policy) {
+    std::vector<unsigned char> file = readFile(image_path);
+
+    if (!resize && policy.passthrough && (policy.maxBytes == 0 || file.size() <= policy.maxBytes)) {
+        std::optional<ImageFormat> format = detectFormat(file);
+        if (format && std::find(policy.acceptedFormats.begin(), policy.acceptedFormats.end(), *format) !=
+                          policy.acceptedFormats.end() &&
+            (*format != ImageFormat::Jpeg || jpegOrientation(file) == 1)) {
+            return file;
+        }
+    }
+
+    cv::Mat image = cv::imdecode(file, cv::IMREAD_COLOR);
+    if (image.empty()) {
+        throw std::runtime_error("Unable to decode image file: " + image_path);
+    }
+    file = {};
 
     if (resize) {
         cv::Mat resized_image = resizeImage(image, target_size);
         cv::Mat squared_image = createSquareCanvas(resized_image, target_size);
-        std::vector<unsigned char> jpg_data = encodeToJpg(squared_image);
-        return encodeToBase64(jpg_data);
+        return encode(squared_image, policy);
     } else {
-        std::vector<unsigned char> jpg_data = encodeToJpg(image);
-        return encodeToBase64(jpg_data);
+        return encode(image, policy);
+    }
+}
+
+std::optional<ImageFormat> ImageProcessing::detectFormat(const std::vector<unsigned char>& data) {
+    const auto startsWith = [&data](size_t offset, const char* signature, size_t length) {
+        return data.size() >= offset + length && std::memcmp(data.data() + offset, signature, length) == 0;
+    };
+    if (startsWith(0, "\xFF\xD8\xFF", 3)) {
+        return ImageFormat::Jpeg;
+    }
+    if (startsWith(0, "\x89PNG\r\n\x1A\n", 8)) {
+        return ImageFormat::Png;
+    }
+    if (startsWith(0, "RIFF", 4) && startsWith(8, "WEBP", 4)) {
+        return ImageFormat::WebP;
+    }
+    return std::nullopt;
+}
+
+std::string ImageProcessing::mimeType(const std::vector<unsigned char>& data) {
+    switch (detectFormat(data).value_or(ImageFormat::Jpeg)) {
+    case ImageFormat::Png:
+        return "image/png";
+    case ImageFormat::WebP:
+        return "image/webp";
+    default:
+        return "image/jpeg";
+    }
+}
+
+int ImageProcessing::jpegOrientation(const std::vector<unsigned char>& data) {
+    const auto readBigEndian16 = [&data](size_t offset) {
+        return static_cast<unsigned>(data[offset] << 8 | data[offset + 1]);
+    };
+    if (detectFormat(data) != ImageFormat::Jpeg) {
+        return 1;
     }
+    size_t pos = 2;
+    // Walk the segments before the image data for the APP1 Exif one
+    while (pos + 4 <= data.size() && data[pos] == 0xFF) {
+        const unsigned char marker = data[pos + 1];
+        if (marker == 0xDA || marker == 0xD9) {
+            break;
+        }
+        const size_t length = readBigEndian16(pos + 2);
+        const size_t end = pos + 2 + length;
+        if (length < 2 || end > data.size()) {
+            break;
+        }
+        if (marker != 0xE1 || length < 16 || std::memcmp(data.data() + pos + 4, "Exif\0\0", 6) != 0) {
+            pos = end;
+            continue;
+        }
+
+        // TIFF header, then IFD0 with 12-byte entries
+        const size_t tiff = pos + 10;
+        const bool littleEndian = data[tiff] == 'I';
+        const auto read16 = [&](size_t offset) -> unsigned {
+            return littleEndian ? data[offset] | data[offset + 1] << 8 : readBigEndian16(offset);
+        };
+        const auto read32 = [&](size_t offset) -> size_t {
+            return littleEndian ? read16(offset) | static_cast<size_t>(read16(offset + 2)) << 16
+                                : static_cast<size_t>(read16(offset)) << 16 | read16(offset + 2);
+        };
+        const size_t ifd = tiff + read32(tiff + 4);
+        if (ifd + 2 > end) {
+            return 1;
+        }
+        const size_t entries = read16(ifd);
+        for (size_t i = 0; i < entries && ifd + 2 + 12 * (i + 1) <= end; ++i) {
+            const size_t entry = ifd + 2 + 12 * i;
+            if (read16(entry) == 0x0112) {
+                const unsigned orientation = read16(entry + 8);
+                return orientation >= 1 && orientation <= 8 ? static_cast<int>(orientation) : 1;
+            }
+        }
+        return 1;
+    }
+    return 1;
+}
+
+std::vector<unsigned char> ImageProcessing::readFile(const std::string& image_path) {
+    std::ifstream file(image_path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open image file: " + image_path);
+    }
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
 }
 
 cv::Mat ImageProcessing::readImage(const std::string& image_path) {
@@ -48,13 +157,71 @@ std::vector<unsigned char> ImageProcessing::encodeToJpg(const cv::Mat& image) {
     return buf;
 }
 
+std::vector<unsigned char> ImageProcessing::encode(const cv::Mat& image, const EncoderPolicy& policy) {
+    const int maxQuality = std::clamp(policy.quality, 1, 100);
+    std::vector<unsigned char> encoded = encodeAtQuality(image, policy.format, maxQuality);
+    if (policy.maxBytes == 0 || encoded.size() <= policy.maxBytes) {
+        return encoded;
+    }
+    if (policy.format == ImageFormat::Png) {
+        // Lossless, so compression is all the budget can buy
+        std::vector<int> params = {cv::IMWRITE_PNG_COMPRESSION, 9};
+        if (!cv::imencode(".png", image, encoded, params)) {
+            throw std::runtime_error("Unable to encode image as PNG");
+        }
+        return encoded;
+    }
+
+    // The size grows with the quality, so binary search for the highest
+    // quality that fits; the last quality tried is minQuality if none does
+    const int minQuality = std::clamp(policy.minQuality, 1, maxQuality);
+    std::vector<unsigned char> fitting;
+    int low = minQuality;
+    int high = maxQuality - 1;
+    while (low <= high) {
+        const int quality = low + (high - low) / 2;
+        std::vector<unsigned char> candidate = encodeAtQuality(image, policy.format, quality);
+        if (candidate.size() <= policy.maxBytes) {
+            fitting = std::move(candidate);
+            low = quality + 1;
+        } else {
+            high = quality - 1;
+            encoded = std::move(candidate);
+        }
+    }
+    return fitting.empty() ? encoded : fitting;
+}
+
+std::vector<unsigned char> ImageProcessing::encodeAtQuality(const cv::Mat& image, ImageFormat format, int quality) {
+    std::vector<unsigned char> buf;
+    bool encoded = false;
+    switch (format) {
+    case ImageFormat::Jpeg:
+        encoded = cv::imencode(".jpg", image, buf, {cv::IMWRITE_JPEG_QUALITY, quality});
+        break;
+    case ImageFormat::Png:
+        encoded = cv::imencode(".png", image, buf);
+        break;
+    case ImageFormat::WebP:
+        encoded = cv::imencode(".webp", image, buf, {cv::IMWRITE_WEBP_QUALITY, quality});
+        break;
+    }
+    if (!encoded) {
+        throw std::runtime_error("Unable to encode image");
+    }
+    return buf;
+}
+
 std::string ImageProcessing::encodeToBase64(const std::vector<unsigned char>& data) {
-    return base64_encode(data.data(), data.size());
+    std::string encoded(Base64::encodedSize(data.size()), '\0');
+    Base64::encode(data.data(), data.size(), encoded.data());
+    return encoded;
 }
 
 std::vector<unsigned char> ImageProcessing::decodeBase64(const std::string& encoded_string) {
-    std::string decoded = base64_decode(encoded_string);
-    return std::vector<unsigned char>(decoded.begin(), decoded.end());
+    std::vector<unsigned char> decoded(Base64::decodedSize(encoded_string.size()));
+    decoded.resize(Base64::decode(encoded_string.data(), encoded_string.size(), decoded.data()));
+    return decoded;
 }
 
 cv::Size ImageProcessing::calculateNewSize(const cv::Mat& image, int target_size) {
@@ -1,9 +1,10 @@
 #include "image_segmentation.hpp"
 #include "image_processing.hpp"
+#include "response_parser.hpp"
 
 
-nlohmann::json ImageSegmentation::preparePayload() const {
-    std::string base64Image = ImageProcessing::encodeImage(imagePath, targetSize, resize);
+nlohmann::json ImageSegmentation::preparePayload(std::vector<RequestBody::Bytes>& images) const {
+    std::string base64Image = RequestBody::attachBase64(images, ImageProcessing::encodeImageBytes(imagePath, targetSize, resize, encoderPolicy));
 
     nlohmann::json payload;
     payload["inputs"] = base64Image;
@@ -21,6 +22,14 @@ nlohmann::json ImageSegmentation::preparePayload() const {
     return payload;
 }
 
+RequestBody::Bytes ImageSegmentation::prepareBinaryInput() const {
+    if (maskThreshold > 0 || overlapMaskAreaThreshold > 0 || !subtask.empty() || threshold > 0) {
+        return nullptr;
+    }
+    return std::make_shared<const std::vector<unsigned char>>(
+        ImageProcessing::encodeImageBytes(imagePath, targetSize, resize, encoderPolicy));
+}
+
 ImageSegmentation::ImageSegmentation(const std::string& endpoint, const std::string& authToken, 
                                      const std::string& imagePath, 
                                      double maskThreshold, 
@@ -29,7 +38,7 @@ ImageSegmentation::ImageSegmentation(const std::string& endpoint, const std::str
                                      double threshold,
                                      int targetSize,
                                      bool resize)
-    : HuggingFaceTask(endpoint, authToken), 
+    : TypedHuggingFaceTask(endpoint, authToken), 
       imagePath(imagePath), 
       maskThreshold(maskThreshold), 
       overlapMaskAreaThreshold(overlapMaskAreaThreshold), 
@@ -38,15 +47,6 @@ ImageSegmentation::ImageSegmentation(const std::string& endpoint, const std::str
       targetSize(targetSize),
       resize(resize) {}
 
-std::string ImageSegmentation::execute() {
-    std::string response = HuggingFaceTask::execute();
-    nlohmann::json result = nlohmann::json::parse(response);
-
-    // Process and print the results
-    std::cout << "Instance Segmentation Results:\n";
-    for (const auto& segment : result) {
-        std::cout << "Label: " << segment["label"] << ", Score: " << segment["score"] << "\n";
-    }
-
-    return result.dump();
+SegmentationResults ImageSegmentation::parseResult(const std::string& response) const {
+    return ResponseParser::parseSegmentations(response);
 }
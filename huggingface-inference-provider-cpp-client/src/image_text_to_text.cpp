@@ -1,6 +1,10 @@
 #include "image_text_to_text.hpp"
 #include "curl_wrapper.hpp"
 #include "image_processing.hpp"
+#include "sse_parser.hpp"
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
 
 ImageTextToText::ImageTextToText(const std::string& endpoint, const std::string& authToken, 
                                  const std::vector<std::string>& images, 
@@ -14,26 +18,136 @@ ImageTextToText::ImageTextToText(const std::string& endpoint, const std::string&
       {
       }
 
-std::string ImageTextToText::execute() {
-    nlohmann::json payload = preparePayload();
+void ImageTextToText::setMaxTokens(int tokens) {
+    maxTokens = tokens;
+}
+
+void ImageTextToText::cancel() {
+    cancelled = true;
+}
+
+HttpRequest ImageTextToText::prepareRequest() const {
+    return prepareChatRequest(false);
+}
+
+HttpRequest ImageTextToText::prepareChatRequest(bool stream) const {
+    if (uploadMode == UploadMode::Binary) {
+        throw std::runtime_error("Binary upload is not supported by image-text-to-text");
+    }
+    std::vector<RequestBody::Bytes> images;
+    nlohmann::json payload = preparePayload(images);
     payload["inputs"] = payload["messages"];
-    std::string payloadStr = payload.dump();
+    payload["stream"] = stream;
 
+    std::vector<std::string> headers = requestHeaders("application/json");
+    if (stream) {
+        headers.push_back("Accept: text/event-stream");
+    }
+    return HttpRequest{
+        apiEndpoint + "/v1/chat/completions",
+        RequestBody::fromJson(payload, images),
+        std::move(headers)
+    };
+}
+
+ImageTextToText::StreamResult ImageTextToText::executeStream(const TokenCallback& onToken) {
+    // A cancel() is used up by the stream it stops, even one that came
+    // before the stream started
+    struct ResetOnExit {
+        std::atomic<bool>& flag;
+        ~ResetOnExit() { flag = false; }
+    } resetCancelled{cancelled};
+
+    HttpRequest request = prepareChatRequest(true);
+    StreamResult result;
+    // Errors from the callbacks below must not unwind through libcurl, they
+    // are kept here and rethrown once the transfer has stopped
+    std::exception_ptr streamError;
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start;
+    Clock::time_point lastToken;
+    bool done = false;
+
+    // Chat completion chunks carry the text in choices[0].delta.content,
+    // the stream ends with "data: [DONE]"
+    SseParser parser([&](const SseParser::Event& event) {
+        // Read on to the end of the response after [DONE], so that the
+        // connection can be reused
+        if (done || event.data == "[DONE]") {
+            done = true;
+            return true;
+        }
+        nlohmann::json chunk = nlohmann::json::parse(event.data, nullptr, false);
+        if (chunk.is_discarded()) {
+            streamError = std::make_exception_ptr(std::runtime_error("Malformed stream event: " + event.data));
+            return false;
+        }
+        if (chunk.contains("error")) {
+            streamError = std::make_exception_ptr(std::runtime_error("Stream error: " + chunk["error"].dump()));
+            return false;
+        }
+        if (!chunk.contains("choices") || chunk["choices"].empty()) {
+            return true;
+        }
+        const nlohmann::json& delta = chunk["choices"][0].value("delta", nlohmann::json::object());
+        if (!delta.contains("content") || !delta["content"].is_string()) {
+            return true;
+        }
+        const std::string& token = delta["content"].get_ref<const std::string&>();
+        if (token.empty()) {
+            return true;
+        }
+
+        const Clock::time_point now = Clock::now();
+        if (result.tokens == 0) {
+            result.timeToFirstToken = now - start;
+        } else {
+            const Duration gap = now - lastToken;
+            result.meanInterTokenLatency += gap;
+            result.maxInterTokenLatency = std::max(result.maxInterTokenLatency, gap);
+        }
+        lastToken = now;
+        ++result.tokens;
+        result.text += token;
+        if (!onToken(token)) {
+            result.cancelled = true;
+            return false;
+        }
+        return true;
+    });
+
+    bool completed;
     try {
-        std::string response = CurlWrapper()
-            .setUrl(apiEndpoint + "/v1/chat/completions")
-            .setPostFields(payloadStr)
-            .addHeader("Content-Type: application/json")
-            .addHeader("Authorization: Bearer " + token)
-            .perform();
-
-        return response;
+        CurlWrapper curl;
+        curl.setUrl(request.url).setBody(request.body);
+        for (const auto& header : request.headers) {
+            curl.addHeader(header);
+        }
+        start = Clock::now();
+        completed = curl.performStreaming([&parser, &streamError](const char* data, size_t length) {
+            try {
+                return parser.feed(data, length);
+            } catch (...) {
+                streamError = std::current_exception();
+                return false;
+            }
+        }, &cancelled);
     } catch (const std::exception& e) {
         throw std::runtime_error(std::string("HTTP request failed: ") + e.what());
     }
+
+    if (streamError) {
+        std::rethrow_exception(streamError);
+    }
+    result.cancelled = result.cancelled || (!completed && cancelled);
+    result.totalTime = Clock::now() - start;
+    if (result.tokens > 1) {
+        result.meanInterTokenLatency /= static_cast<double>(result.tokens - 1);
+    }
+    return result;
 }
 
-nlohmann::json ImageTextToText::preparePayload() const {
+nlohmann::json ImageTextToText::preparePayload(std::vector<RequestBody::Bytes>& attachedImages) const {
     nlohmann::json payload;
     // Extract model name from endpoint URL
     size_t pos = apiEndpoint.find("/models/");
@@ -45,10 +159,13 @@ nlohmann::json ImageTextToText::preparePayload() const {
 
     // Add images to the payload
     for (const auto& image : images) {
-        std::string base64Image = ImageProcessing::encodeImage(image, targetSize, resize);
+        std::vector<unsigned char> bytes = ImageProcessing::encodeImageBytes(image, targetSize, resize, encoderPolicy);
+        // Passed through files keep their format
+        const std::string mimeType = ImageProcessing::mimeType(bytes);
+        std::string base64Image = RequestBody::attachBase64(attachedImages, std::move(bytes));
         payload["messages"][0]["content"].push_back({
             {"type", "image_url"},
-            {"image_url", {{"url", "data:image/jpeg;base64," + base64Image}}}
+            {"image_url", {{"url", "data:" + mimeType + ";base64," + base64Image}}}
         });
     }
 
@@ -58,7 +175,7 @@ nlohmann::json ImageTextToText::preparePayload() const {
         {"text", prompt}
     });
 
-    payload["max_tokens"] = 500;
+    payload["max_tokens"] = maxTokens;
     payload["stream"] = false;
 
     return payload;
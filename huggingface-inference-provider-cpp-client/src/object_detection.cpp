@@ -1,35 +1,23 @@
 #include "object_detection.hpp"
 #include "image_processing.hpp"
-#include <iostream>
+#include "response_parser.hpp"
 
 ObjectDetection::ObjectDetection(const std::string& endpoint, const std::string& authToken, 
                                  const nlohmann::json& params)
-    : HuggingFaceTask(endpoint, authToken) {
+    : TypedHuggingFaceTask(endpoint, authToken) {
     imagePath = params["image_path"].get<std::string>();
     threshold = params.value("threshold", 0.5);
 }
 
-nlohmann::json ObjectDetection::preparePayload() const {
-    // Convert image to base64
-    std::string base64Image = ImageProcessing::encodeImage(imagePath, 224);  // 224 is an example size, adjust as needed
+nlohmann::json ObjectDetection::preparePayload(std::vector<RequestBody::Bytes>& images) const {
+    // Base64-encoded while the request is sent
+    std::string base64Image = RequestBody::attachBase64(images, ImageProcessing::encodeImageBytes(imagePath, 224, false, encoderPolicy));  // 224 is an example size, adjust as needed
     return nlohmann::json{
         {"inputs", base64Image},
         {"parameters", {{"threshold", threshold}}}
     };
 }
 
-std::string ObjectDetection::execute() {
-    std::string response = HuggingFaceTask::execute();
-    nlohmann::json result = nlohmann::json::parse(response);
-    
-    // Process and print the results
-    std::cout << "Detected objects:\n";
-    for (const auto& obj : result) {
-        std::cout << "Label: " << obj["label"] << ", Score: " << obj["score"] << "\n";
-        std::cout << "Bounding box: "
-                  << "(" << obj["box"]["xmin"] << ", " << obj["box"]["ymin"] << ") - "
-                  << "(" << obj["box"]["xmax"] << ", " << obj["box"]["ymax"] << ")\n";
-    }
-    
-    return result.dump();
+ObjectDetectionResults ObjectDetection::parseResult(const std::string& response) const {
+    return ResponseParser::parseObjectDetections(response);
 }
@@ -0,0 +1,171 @@
+#include "request_body.hpp"
+#include "base64.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+// NUL characters do not occur in file paths or prompts, and the JSON dump
+// always escapes them, which makes the placeholder easy to find
+const std::string PLACEHOLDER_PREFIX = std::string(1, '\0') + "image:";
+const std::string DUMPED_PLACEHOLDER_PREFIX = "\\u0000image:";
+const std::string DUMPED_PLACEHOLDER_SUFFIX = "\\u0000";
+
+// Writes the base64 encoding of data from character offset on
+size_t encodeBase64Range(const std::vector<unsigned char>& data, size_t offset, char* out, size_t length) {
+    const size_t encodedSize = Base64::encodedSize(data.size());
+    const size_t fullGroups = data.size() / 3;
+    size_t written = 0;
+    while (written < length && offset < encodedSize) {
+        const size_t group = offset / 4;
+        const size_t within = offset % 4;
+        if (within == 0 && group < fullGroups && length - written >= 4) {
+            const size_t groups = std::min((length - written) / 4, fullGroups - group);
+            Base64::encode(data.data() + group * 3, groups * 3, out + written);
+            written += groups * 4;
+            offset += groups * 4;
+            continue;
+        }
+        // Group split by the buffer end, or the padded last group
+        char quad[4];
+        Base64::encode(data.data() + group * 3, std::min<size_t>(3, data.size() - group * 3), quad);
+        const size_t take = std::min(4 - within, length - written);
+        std::memcpy(out + written, quad + within, take);
+        written += take;
+        offset += take;
+    }
+    return written;
+}
+}
+
+RequestBody::RequestBody(std::string text) {
+    appendText(std::move(text));
+}
+
+std::string RequestBody::attachBase64(std::vector<Bytes>& images, std::vector<unsigned char> data) {
+    images.push_back(std::make_shared<const std::vector<unsigned char>>(std::move(data)));
+    return PLACEHOLDER_PREFIX + std::to_string(images.size() - 1) + std::string(1, '\0');
+}
+
+RequestBody RequestBody::fromJson(const nlohmann::json& payload, const std::vector<Bytes>& images) {
+    const std::string dumped = payload.dump();
+    RequestBody body;
+    size_t start = 0;
+    for (size_t found = dumped.find(DUMPED_PLACEHOLDER_PREFIX); found != std::string::npos;
+         found = dumped.find(DUMPED_PLACEHOLDER_PREFIX, found + 1)) {
+        // After an odd number of backslashes the match starts with an escaped
+        // backslash, i.e. a string that merely contains the text
+        size_t backslashes = 0;
+        while (found > backslashes && dumped[found - backslashes - 1] == '\\') {
+            ++backslashes;
+        }
+        if (backslashes % 2 == 1) {
+            continue;
+        }
+        const size_t indexStart = found + DUMPED_PLACEHOLDER_PREFIX.size();
+        const size_t indexEnd = dumped.find(DUMPED_PLACEHOLDER_SUFFIX, indexStart);
+        if (indexEnd == std::string::npos) {
+            break;
+        }
+        const size_t index = std::stoul(dumped.substr(indexStart, indexEnd - indexStart));
+        if (index >= images.size()) {
+            throw std::runtime_error("Payload refers to missing image " + std::to_string(index));
+        }
+        body.appendText(dumped.substr(start, found - start));
+        body.appendBase64(images[index]);
+        start = indexEnd + DUMPED_PLACEHOLDER_SUFFIX.size();
+    }
+    body.appendText(dumped.substr(start));
+    return body;
+}
+
+void RequestBody::appendText(std::string text) {
+    if (text.empty()) {
+        return;
+    }
+    const size_t size = text.size();
+    parts.push_back({Encoding::Text, std::move(text), nullptr, size});
+    totalSize += size;
+}
+
+void RequestBody::appendBinary(Bytes data) {
+    const size_t size = data->size();
+    parts.push_back({Encoding::Binary, {}, std::move(data), size});
+    totalSize += size;
+}
+
+void RequestBody::appendBase64(Bytes data) {
+    const size_t size = Base64::encodedSize(data->size());
+    parts.push_back({Encoding::Base64, {}, std::move(data), size});
+    totalSize += size;
+}
+
+size_t RequestBody::size() const {
+    return totalSize;
+}
+
+bool RequestBody::empty() const {
+    return totalSize == 0;
+}
+
+size_t RequestBody::read(char* buffer, size_t length) {
+    size_t written = 0;
+    while (written < length && partIndex < parts.size()) {
+        const Part& part = parts[partIndex];
+        const size_t take = std::min(length - written, part.size - partOffset);
+        switch (part.encoding) {
+        case Encoding::Text:
+            std::memcpy(buffer + written, part.text.data() + partOffset, take);
+            break;
+        case Encoding::Binary:
+            std::memcpy(buffer + written, part.data->data() + partOffset, take);
+            break;
+        case Encoding::Base64:
+            encodeBase64Range(*part.data, partOffset, buffer + written, take);
+            break;
+        }
+        written += take;
+        partOffset += take;
+        if (partOffset == part.size) {
+            ++partIndex;
+            partOffset = 0;
+        }
+    }
+    return written;
+}
+
+bool RequestBody::seek(size_t offset) {
+    if (offset > totalSize) {
+        return false;
+    }
+    partIndex = 0;
+    while (partIndex < parts.size() && offset >= parts[partIndex].size) {
+        offset -= parts[partIndex].size;
+        ++partIndex;
+    }
+    partOffset = offset;
+    return true;
+}
+
+void RequestBody::attachTo(CURL* handle) {
+    seek(0);
+    curl_easy_setopt(handle, CURLOPT_POST, 1L);
+    curl_easy_setopt(handle, CURLOPT_READFUNCTION, readCallback);
+    curl_easy_setopt(handle, CURLOPT_READDATA, this);
+    curl_easy_setopt(handle, CURLOPT_SEEKFUNCTION, seekCallback);
+    curl_easy_setopt(handle, CURLOPT_SEEKDATA, this);
+    curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(totalSize));
+}
+
+size_t RequestBody::readCallback(char* buffer, size_t size, size_t nitems, void* userdata) {
+    return static_cast<RequestBody*>(userdata)->read(buffer, size * nitems);
+}
+
+int RequestBody::seekCallback(void* userdata, curl_off_t offset, int origin) {
+    // curl only rewinds from the start, e.g. to resend after a redirect
+    if (origin != SEEK_SET || offset < 0 ||
+        !static_cast<RequestBody*>(userdata)->seek(static_cast<size_t>(offset))) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+    return CURL_SEEKFUNC_OK;
+}
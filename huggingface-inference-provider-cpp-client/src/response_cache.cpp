@@ -0,0 +1,413 @@
+#include "response_cache.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+const std::string DISK_MAGIC = "hfcache1";
+constexpr size_t KEY_LENGTH = 64;
+// Longest wait between sweeps of the disk tier for expired entries
+constexpr std::chrono::hours PRUNE_INTERVAL(1);
+
+// SHA-256 (FIPS 180-4), fed incrementally
+class Sha256 {
+public:
+    void update(const void* data, size_t length) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        totalLength += length;
+        while (length > 0) {
+            const size_t take = std::min(length, sizeof(block) - blockLength);
+            std::memcpy(block + blockLength, bytes, take);
+            blockLength += take;
+            bytes += take;
+            length -= take;
+            if (blockLength == sizeof(block)) {
+                compress();
+                blockLength = 0;
+            }
+        }
+    }
+
+    void update(const std::string& text) {
+        update(text.data(), text.size());
+    }
+
+    std::string hexDigest() {
+        const uint64_t bitLength = totalLength * 8;
+        const unsigned char padding = 0x80;
+        update(&padding, 1);
+        const unsigned char zero = 0;
+        while (blockLength != 56) {
+            update(&zero, 1);
+        }
+        unsigned char lengthBytes[8];
+        for (int i = 0; i < 8; ++i) {
+            lengthBytes[i] = static_cast<unsigned char>(bitLength >> (56 - 8 * i));
+        }
+        update(lengthBytes, 8);
+
+        static const char* HEX = "0123456789abcdef";
+        std::string digest;
+        for (uint32_t word : state) {
+            for (int shift = 28; shift >= 0; shift -= 4) {
+                digest.push_back(HEX[(word >> shift) & 0xF]);
+            }
+        }
+        return digest;
+    }
+
+private:
+    static uint32_t rotateRight(uint32_t value, int bits) {
+        return (value >> bits) | (value << (32 - bits));
+    }
+
+    void compress() {
+        static const uint32_t K[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+        uint32_t w[64];
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) |
+                   (uint32_t(block[4 * i + 2]) << 8) | uint32_t(block[4 * i + 3]);
+        }
+        for (int i = 16; i < 64; ++i) {
+            const uint32_t s0 = rotateRight(w[i - 15], 7) ^ rotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = rotateRight(w[i - 2], 17) ^ rotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            const uint32_t s1 = rotateRight(e, 6) ^ rotateRight(e, 11) ^ rotateRight(e, 25);
+            const uint32_t choice = (e & f) ^ (~e & g);
+            const uint32_t temp1 = h + s1 + choice + K[i] + w[i];
+            const uint32_t s0 = rotateRight(a, 2) ^ rotateRight(a, 13) ^ rotateRight(a, 22);
+            const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+            const uint32_t temp2 = s0 + majority;
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+    uint32_t state[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    unsigned char block[64];
+    size_t blockLength = 0;
+    uint64_t totalLength = 0;
+};
+
+bool isAuthorization(const std::string& header) {
+    static const std::string NAME = "authorization:";
+    return header.size() >= NAME.size() &&
+           std::equal(NAME.begin(), NAME.end(), header.begin(), [](char expected, char actual) {
+               return expected == std::tolower(static_cast<unsigned char>(actual));
+           });
+}
+
+int64_t toSeconds(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+}
+
+bool isKey(const std::string& name) {
+    return name.size() == KEY_LENGTH && name.find_first_not_of("0123456789abcdef") == std::string::npos;
+}
+}
+
+ResponseCache::ResponseCache() : ResponseCache(Options()) {}
+
+ResponseCache::ResponseCache(const Options& options) : options(options) {
+    if (!options.directory.empty()) {
+        std::error_code error;
+        fs::create_directories(options.directory, error);
+        if (error) {
+            throw std::runtime_error("Unable to create cache directory " + options.directory + ": " + error.message());
+        }
+        pruneDisk();
+    }
+}
+
+std::string ResponseCache::makeKey(HttpRequest& request) {
+    Sha256 hash;
+    hash.update(request.url);
+    hash.update("\n", 1);
+    // The token does not change the response, so it must not split the cache
+    for (const auto& header : request.headers) {
+        if (!isAuthorization(header)) {
+            hash.update(header);
+            hash.update("\n", 1);
+        }
+    }
+    hash.update("\n", 1);
+
+    request.body.seek(0);
+    char buffer[64 * 1024];
+    for (size_t read; (read = request.body.read(buffer, sizeof(buffer))) > 0;) {
+        hash.update(buffer, read);
+    }
+    request.body.seek(0);
+    return hash.hexDigest();
+}
+
+bool ResponseCache::get(const std::string& key, AsyncRequestEngine::Callback done, const Fetch& fetch) {
+    bool expired = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (std::optional<std::string> response = lookupMemory(key, expired)) {
+            ++counters.memoryHits;
+            lock.unlock();
+            done(std::move(*response), nullptr);
+            return false;
+        }
+        auto waiting = inFlight.find(key);
+        if (waiting != inFlight.end()) {
+            ++counters.coalesced;
+            waiting->second.push_back(std::move(done));
+            return false;
+        }
+        // Claimed before reading the disk, so that identical requests
+        // arriving meanwhile wait for it too
+        inFlight[key].push_back(std::move(done));
+    }
+
+    if (!options.directory.empty()) {
+        if (std::optional<std::string> response = lookupDisk(key, expired)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++counters.diskHits;
+            }
+            notify(key, *response, nullptr);
+            return false;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++counters.misses;
+        if (expired) {
+            ++counters.expired;
+        }
+    }
+    fetch([this, key](std::string response, std::exception_ptr error) {
+        if (!error) {
+            store(key, response);
+        }
+        notify(key, response, error);
+    });
+    return true;
+}
+
+std::string ResponseCache::get(const std::string& key, const std::function<std::string()>& fetch) {
+    std::promise<std::string> promise;
+    std::future<std::string> future = promise.get_future();
+    get(key, [&promise](std::string response, std::exception_ptr error) {
+        if (error) {
+            promise.set_exception(error);
+        } else {
+            promise.set_value(std::move(response));
+        }
+    }, [&fetch](AsyncRequestEngine::Callback complete) {
+        std::string response;
+        try {
+            response = fetch();
+        } catch (...) {
+            complete({}, std::current_exception());
+            return;
+        }
+        complete(std::move(response), nullptr);
+    });
+    return future.get();
+}
+
+ResponseCache::Stats ResponseCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+void ResponseCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    lru.clear();
+    entries.clear();
+    memoryBytes = 0;
+    if (options.directory.empty()) {
+        return;
+    }
+    std::error_code error;
+    for (const auto& file : fs::directory_iterator(options.directory, error)) {
+        if (isKey(file.path().filename().string())) {
+            fs::remove(file.path(), error);
+        }
+    }
+}
+
+std::optional<std::string> ResponseCache::lookupMemory(const std::string& key, bool& expired) {
+    auto found = entries.find(key);
+    if (found == entries.end()) {
+        return std::nullopt;
+    }
+    if (found->second->expiry <= Clock::now()) {
+        memoryBytes -= found->second->response.size();
+        lru.erase(found->second);
+        entries.erase(found);
+        expired = true;
+        return std::nullopt;
+    }
+    lru.splice(lru.begin(), lru, found->second);
+    return found->second->response;
+}
+
+std::optional<std::string> ResponseCache::lookupDisk(const std::string& key, bool& expired) {
+    const std::string path = diskPath(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    std::string magic;
+    int64_t expiry = 0;
+    if (!(file >> magic >> expiry) || magic != DISK_MAGIC || file.get() != '\n') {
+        return std::nullopt;
+    }
+    if (expiry <= toSeconds(Clock::now())) {
+        file.close();
+        std::error_code error;
+        fs::remove(path, error);
+        expired = true;
+        return std::nullopt;
+    }
+    std::string response((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    storeMemory(key, response, Clock::time_point(std::chrono::seconds(expiry)));
+    return response;
+}
+
+void ResponseCache::storeMemory(const std::string& key, const std::string& response, Clock::time_point expiry) {
+    if (response.size() > options.maxMemoryBytes) {
+        return;
+    }
+    auto found = entries.find(key);
+    if (found != entries.end()) {
+        memoryBytes -= found->second->response.size();
+        lru.erase(found->second);
+        entries.erase(found);
+    }
+    lru.push_front({key, response, expiry});
+    entries[key] = lru.begin();
+    memoryBytes += response.size();
+    while (memoryBytes > options.maxMemoryBytes) {
+        memoryBytes -= lru.back().response.size();
+        entries.erase(lru.back().key);
+        lru.pop_back();
+        ++counters.evictions;
+    }
+}
+
+void ResponseCache::storeDisk(const std::string& key, const std::string& response, Clock::time_point expiry) {
+    // Written to a temporary file and renamed, so that readers, also in
+    // other processes, never see a partial entry
+    std::ostringstream suffix;
+    suffix << ".tmp." << ::getpid() << '.' << std::this_thread::get_id();
+    const std::string path = diskPath(key);
+    const std::string temporaryPath = path + suffix.str();
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file << DISK_MAGIC << ' ' << toSeconds(expiry) << '\n';
+        file.write(response.data(), static_cast<std::streamsize>(response.size()));
+        if (!file) {
+            return;
+        }
+    }
+    std::error_code error;
+    fs::rename(temporaryPath, path, error);
+    if (error) {
+        fs::remove(temporaryPath, error);
+    }
+}
+
+void ResponseCache::pruneDisk() {
+    const Clock::time_point now = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (now < nextPrune) {
+            return;
+        }
+        nextPrune = now + PRUNE_INTERVAL;
+    }
+
+    // Entries are otherwise only deleted when a lookup finds them stale.
+    // Temporary files older than a sweep were left by a writer that died.
+    std::error_code error;
+    for (const auto& file : fs::directory_iterator(options.directory, error)) {
+        const std::string name = file.path().filename().string();
+        bool stale = false;
+        if (isKey(name)) {
+            std::ifstream entry(file.path(), std::ios::binary);
+            std::string magic;
+            int64_t expiry = 0;
+            stale = entry >> magic >> expiry && magic == DISK_MAGIC && expiry <= toSeconds(now);
+        } else if (name.size() > KEY_LENGTH && isKey(name.substr(0, KEY_LENGTH)) &&
+                   name.compare(KEY_LENGTH, 5, ".tmp.") == 0) {
+            std::error_code timeError;
+            const auto modified = fs::last_write_time(file.path(), timeError);
+            stale = !timeError && fs::file_time_type::clock::now() - modified > PRUNE_INTERVAL;
+        }
+        if (stale) {
+            std::error_code removeError;
+            fs::remove(file.path(), removeError);
+        }
+    }
+}
+
+void ResponseCache::store(const std::string& key, const std::string& response) {
+    const Clock::time_point expiry = Clock::now() + options.ttl;
+    if (!options.directory.empty()) {
+        storeDisk(key, response, expiry);
+        pruneDisk();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    storeMemory(key, response, expiry);
+}
+
+void ResponseCache::notify(const std::string& key, const std::string& response, std::exception_ptr error) {
+    std::vector<AsyncRequestEngine::Callback> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = inFlight.find(key);
+        if (found != inFlight.end()) {
+            waiters = std::move(found->second);
+            inFlight.erase(found);
+        }
+    }
+    for (auto& waiter : waiters) {
+        waiter(response, error);
+    }
+}
+
+std::string ResponseCache::diskPath(const std::string& key) const {
+    return (fs::path(options.directory) / key).string();
+}
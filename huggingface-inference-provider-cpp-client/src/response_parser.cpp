@@ -0,0 +1,206 @@
+#include "response_parser.hpp"
+#include "base64.hpp"
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+
+namespace {
+// Segment as parsed, before its PNG mask is decoded
+struct EncodedSegment {
+    std::string label;
+    std::optional<double> score;
+    std::vector<unsigned char> mask;
+};
+
+void setNumber(ObjectDetectionResult& item, const std::string& key, const std::string& field, double value) {
+    if (key == "score") {
+        item.score = value;
+    } else if (key == "box") {
+        const int coordinate = static_cast<int>(value);
+        if (field == "xmin") item.box.xmin = coordinate;
+        else if (field == "ymin") item.box.ymin = coordinate;
+        else if (field == "xmax") item.box.xmax = coordinate;
+        else if (field == "ymax") item.box.ymax = coordinate;
+    }
+}
+
+void setString(ObjectDetectionResult& item, const std::string& key, const std::string&, std::string& value) {
+    if (key == "label") {
+        item.label = std::move(value);
+    }
+}
+
+void setNumber(ClassificationResult& item, const std::string& key, const std::string&, double value) {
+    if (key == "score") {
+        item.score = value;
+    }
+}
+
+void setString(ClassificationResult& item, const std::string& key, const std::string&, std::string& value) {
+    if (key == "label") {
+        item.label = std::move(value);
+    }
+}
+
+void setNumber(EncodedSegment& item, const std::string& key, const std::string&, double value) {
+    if (key == "score") {
+        item.score = value;
+    }
+}
+
+void setString(EncodedSegment& item, const std::string& key, const std::string&, std::string& value) {
+    if (key == "label") {
+        item.label = std::move(value);
+    } else if (key == "mask") {
+        item.mask.resize(Base64::decodedSize(value.size()));
+        item.mask.resize(Base64::decode(value.data(), value.size(), item.mask.data()));
+    }
+}
+
+// Collects a response of the shape every vision task returns, an array of
+// objects whose values are scalars or objects of scalars, e.g.
+// [{"label": "cat", "score": 0.9, "box": {"xmin": 1, ...}}, ...].
+// Each scalar is handed to setNumber()/setString() with its key and, inside
+// a nested object, its field; anything nested deeper is skipped.
+template<typename Item>
+class ResultArraySax : public nlohmann::json_sax<nlohmann::json> {
+public:
+    std::vector<Item> items;
+
+    bool null() override { return scalar(); }
+    bool boolean(bool) override { return scalar(); }
+    bool number_integer(number_integer_t value) override { return number(static_cast<double>(value)); }
+    bool number_unsigned(number_unsigned_t value) override { return number(static_cast<double>(value)); }
+    bool number_float(number_float_t value, const string_t&) override { return number(value); }
+    bool binary(binary_t&) override { return scalar(); }
+
+    bool string(string_t& value) override {
+        scalar();
+        if (inItem()) {
+            // The lexer clears its buffer before the next token, so the
+            // value can be moved out instead of copied
+            setString(items.back(), itemKey, nestedKey, value);
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        if (containers.empty()) {
+            throw std::runtime_error("Unexpected response: expected a JSON array");
+        }
+        if (containers.size() == 1) {
+            items.emplace_back();
+        }
+        containers.push_back(Container::Object);
+        return true;
+    }
+
+    bool key(string_t& name) override {
+        if (containers.size() == 2) {
+            itemKey = std::move(name);
+            nestedKey.clear();
+        } else if (containers.size() == 3) {
+            nestedKey = std::move(name);
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        containers.pop_back();
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        if (containers.size() == 1) {
+            throw std::runtime_error("Unexpected response: expected an array of objects");
+        }
+        containers.push_back(Container::Array);
+        return true;
+    }
+
+    bool end_array() override {
+        containers.pop_back();
+        return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& error) override {
+        throw std::runtime_error("Failed to parse response at byte " + std::to_string(position) + ": " + error.what());
+    }
+
+private:
+    enum class Container { Array, Object };
+
+    // Only items, i.e. objects, may appear at the top level and in the array
+    bool scalar() const {
+        if (containers.empty()) {
+            throw std::runtime_error("Unexpected response: expected a JSON array");
+        }
+        if (containers.size() == 1) {
+            throw std::runtime_error("Unexpected response: expected an array of objects");
+        }
+        return true;
+    }
+
+    bool number(double value) {
+        scalar();
+        if (inItem()) {
+            setNumber(items.back(), itemKey, nestedKey, value);
+        }
+        return true;
+    }
+
+    // A value of an item, or of an object nested in one
+    bool inItem() const {
+        if (containers.size() == 2) {
+            return containers[1] == Container::Object;
+        }
+        return containers.size() == 3 && containers[1] == Container::Object && containers[2] == Container::Object;
+    }
+
+    std::vector<Container> containers;
+    std::string itemKey;    // Key in the item
+    std::string nestedKey;  // Key in the object nested in it
+};
+
+template<typename Item>
+std::vector<Item> parseArray(const std::string& response) {
+    ResultArraySax<Item> handler;
+    nlohmann::json::sax_parse(response, &handler);
+    return std::move(handler.items);
+}
+}
+
+ObjectDetectionResults ResponseParser::parseObjectDetections(const std::string& response) {
+    return parseArray<ObjectDetectionResult>(response);
+}
+
+ClassificationResults ResponseParser::parseClassifications(const std::string& response) {
+    return parseArray<ClassificationResult>(response);
+}
+
+SegmentationResults ResponseParser::parseSegmentations(const std::string& response) {
+    std::vector<EncodedSegment> segments = parseArray<EncodedSegment>(response);
+    SegmentationResults results(segments.size());
+    // Decoding the PNG masks dominates, so masks are decoded in parallel,
+    // each straight into runs so that only one full-size Mat per thread
+    // exists at a time
+    std::vector<char> failed(segments.size(), 0);
+    cv::parallel_for_(cv::Range(0, static_cast<int>(segments.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            cv::Mat mask = cv::imdecode(segments[i].mask, cv::IMREAD_GRAYSCALE);
+            if (mask.empty()) {
+                failed[i] = 1;
+                continue;
+            }
+            results[i].mask = SegmentMask::fromMat(mask);
+            segments[i].mask = {};
+        }
+    });
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (failed[i]) {
+            throw std::runtime_error("Unable to decode mask of segment " + segments[i].label);
+        }
+        results[i].label = std::move(segments[i].label);
+        results[i].score = segments[i].score;
+    }
+    return results;
+}
@@ -0,0 +1,119 @@
+#include "segment_mask.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+constexpr uint64_t LOW_BITS = 0x0101010101010101ULL;
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+
+uint64_t load8(const uchar* pixels) {
+    uint64_t word;
+    std::memcpy(&word, pixels, sizeof(word));
+    return word;
+}
+
+// Whether any of the 8 bytes is zero
+bool hasZeroByte(uint64_t word) {
+    return ((word - LOW_BITS) & ~word & HIGH_BITS) != 0;
+}
+}
+
+SegmentMask SegmentMask::fromMat(const cv::Mat& mask) {
+    if (mask.type() != CV_8UC1) {
+        throw std::runtime_error("Segment mask must be CV_8UC1");
+    }
+    SegmentMask result;
+    result.cols = mask.cols;
+    result.rows = mask.rows;
+    result.rowStart.reserve(mask.rows + 1);
+    for (int y = 0; y < mask.rows; ++y) {
+        result.rowStart.push_back(result.runs.size());
+        const uchar* pixels = mask.ptr<uchar>(y);
+        int x = 0;
+        while (x < mask.cols) {
+            // Runs are long, so skip them 8 pixels at a time
+            while (x + 8 <= mask.cols && load8(pixels + x) == 0) {
+                x += 8;
+            }
+            while (x < mask.cols && pixels[x] == 0) {
+                ++x;
+            }
+            const int begin = x;
+            while (x + 8 <= mask.cols && !hasZeroByte(load8(pixels + x))) {
+                x += 8;
+            }
+            while (x < mask.cols && pixels[x] != 0) {
+                ++x;
+            }
+            if (x > begin) {
+                result.runs.emplace_back(begin, x);
+            }
+        }
+    }
+    result.rowStart.push_back(result.runs.size());
+    return result;
+}
+
+int SegmentMask::width() const {
+    return cols;
+}
+
+int SegmentMask::height() const {
+    return rows;
+}
+
+bool SegmentMask::empty() const {
+    return runs.empty();
+}
+
+size_t SegmentMask::area() const {
+    size_t total = 0;
+    for (const auto& run : runs) {
+        total += run.second - run.first;
+    }
+    return total;
+}
+
+cv::Mat SegmentMask::toMat() const {
+    cv::Mat mask(rows, cols, CV_8UC1, cv::Scalar(0));
+    for (int y = 0; y < rows; ++y) {
+        uchar* pixels = mask.ptr<uchar>(y);
+        for (size_t i = rowStart[y]; i < rowStart[y + 1]; ++i) {
+            std::fill(pixels + runs[i].first, pixels + runs[i].second, 255);
+        }
+    }
+    return mask;
+}
+
+void SegmentMask::fillRow(int y, cv::Size size, uint16_t value, uint16_t* row) const {
+    if (rows == 0 || cols == 0) {
+        return;
+    }
+    // Pixel x of the scaled row samples column min(floor(x * ratio), cols - 1)
+    // with the ratio rounded to a double the way cv::resize computes it, so
+    // the result matches INTER_NEAREST exactly, also where x * cols / width
+    // is a whole number that the rounded ratio lands just below
+    const double columnRatio = 1.0 / (static_cast<double>(size.width) / cols);
+    const double rowRatio = 1.0 / (static_cast<double>(size.height) / rows);
+    const int sourceRow = std::min(static_cast<int>(std::floor(y * rowRatio)), rows - 1);
+    const auto sample = [this, columnRatio](int x) {
+        return std::min(static_cast<int>(std::floor(x * columnRatio)), cols - 1);
+    };
+    // First scaled pixel that samples column or a later one: the exact
+    // ceil(column * width / cols), corrected by the rounding of the ratio
+    const auto scale = [this, &size, &sample](int column) {
+        int x = static_cast<int>((static_cast<int64_t>(column) * size.width + cols - 1) / cols);
+        while (x > 0 && sample(x - 1) >= column) {
+            --x;
+        }
+        while (x < size.width && sample(x) < column) {
+            ++x;
+        }
+        return x;
+    };
+    for (size_t i = rowStart[sourceRow]; i < rowStart[sourceRow + 1]; ++i) {
+        std::fill(row + scale(runs[i].first), row + scale(runs[i].second), value);
+    }
+}
@@ -0,0 +1,81 @@
+#include "sse_parser.hpp"
+#include <cstring>
+
+SseParser::SseParser(EventCallback onEvent) : onEvent(std::move(onEvent)) {}
+
+bool SseParser::feed(const char* data, size_t length) {
+    if (stopped) {
+        return false;
+    }
+    // Lines are handled in place in data, only a line split across chunks
+    // is copied to pending
+    const char* end = data + length;
+    while (data < end) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+        if (!newline) {
+            pending.append(data, end);
+            break;
+        }
+        bool keepGoing;
+        if (pending.empty()) {
+            keepGoing = processLine(data, newline - data);
+        } else {
+            pending.append(data, newline);
+            keepGoing = processLine(pending.data(), pending.size());
+            pending.clear();
+        }
+        data = newline + 1;
+        if (!keepGoing) {
+            stopped = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SseParser::processLine(const char* line, size_t length) {
+    if (length > 0 && line[length - 1] == '\r') {
+        --length;
+    }
+
+    if (length == 0) {
+        // A blank line dispatches the event, if it has data
+        bool keepGoing = true;
+        if (hasData) {
+            if (current.type.empty()) {
+                current.type = "message";
+            }
+            keepGoing = onEvent(current);
+        }
+        current.type.clear();
+        current.data.clear();
+        hasData = false;
+        return keepGoing;
+    }
+    if (line[0] == ':') {
+        return true;  // Comment, e.g. a keep-alive
+    }
+
+    const char* colon = static_cast<const char*>(std::memchr(line, ':', length));
+    const size_t nameLength = colon ? static_cast<size_t>(colon - line) : length;
+    size_t valueStart = colon ? nameLength + 1 : length;
+    if (valueStart < length && line[valueStart] == ' ') {
+        ++valueStart;
+    }
+    const std::string name(line, nameLength);
+    const char* value = line + valueStart;
+    const size_t valueLength = length - valueStart;
+
+    if (name == "data") {
+        if (hasData) {
+            current.data.push_back('\n');
+        }
+        current.data.append(value, valueLength);
+        hasData = true;
+    } else if (name == "event") {
+        current.type.assign(value, valueLength);
+    } else if (name == "id") {
+        current.id.assign(value, valueLength);
+    }
+    return true;
+}
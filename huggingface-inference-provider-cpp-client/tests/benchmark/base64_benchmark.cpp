@@ -0,0 +1,88 @@
+/**
+ * Base64 throughput, in MB/s of unencoded data, of each Base64 kernel the
+ * CPU supports, against cpp-base64 as ImageProcessing used it before:
+ *   encode: base64_encode() into a new string
+ *   decode: base64_decode() into a string, then copied into a vector
+ * Sizes are typical of a segmentation mask PNG, a 224px JPEG and a
+ * multi-megapixel JPEG.
+ *
+ *   base64_benchmark [total_megabytes_per_case]
+ */
+#include "base64.hpp"
+#include "base64.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr size_t SIZES[] = {16 * 1024, 256 * 1024, 4 * 1024 * 1024};
+
+template<typename Function>
+double megabytesPerSecond(size_t bytesPerCall, size_t totalBytes, Function&& function) {
+    const size_t calls = std::max<size_t>(totalBytes / bytesPerCall, 1);
+    function(); // Warm up
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        function();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(bytesPerCall * calls) / elapsed.count() / 1e6;
+}
+
+void printRow(const std::string& name, size_t size, double encode, double decode) {
+    std::cout << std::left << std::setw(12) << name << std::right << std::setw(10) << size / 1024 << " KiB"
+              << std::setw(12) << std::fixed << std::setprecision(0) << encode << " MB/s"
+              << std::setw(12) << decode << " MB/s\n";
+}
+}
+
+int main(int argc, char** argv) {
+    const size_t totalBytes = (argc > 1 ? std::stoul(argv[1]) : 512) * 1024 * 1024;
+    std::mt19937 rng(42);
+
+    std::cout << "Selected kernel: " << Base64::implementation() << "\n";
+    std::cout << std::left << std::setw(12) << "codec" << std::right << std::setw(14) << "input"
+              << std::setw(17) << "encode" << std::setw(17) << "decode" << "\n";
+    for (size_t size : SIZES) {
+        std::vector<unsigned char> data(size);
+        for (auto& byte : data) {
+            byte = static_cast<unsigned char>(rng());
+        }
+        const std::string encoded = base64_encode(data.data(), data.size());
+
+        volatile size_t sink = 0;
+        const double referenceEncode = megabytesPerSecond(size, totalBytes, [&] {
+            sink = sink + base64_encode(data.data(), data.size()).size();
+        });
+        const double referenceDecode = megabytesPerSecond(size, totalBytes, [&] {
+            std::string decoded = base64_decode(encoded);
+            std::vector<unsigned char> bytes(decoded.begin(), decoded.end());
+            sink = sink + bytes.size();
+        });
+        printRow("cpp-base64", size, referenceEncode, referenceDecode);
+
+        std::string encodeBuffer(Base64::encodedSize(size), '\0');
+        std::vector<unsigned char> decodeBuffer(Base64::decodedSize(encoded.size()));
+        for (const char* kernel : {"scalar", "ssse3", "avx2"}) {
+            if (!Base64::selectImplementation(kernel)) {
+                continue;
+            }
+            const double encode = megabytesPerSecond(size, totalBytes, [&] {
+                Base64::encode(data.data(), data.size(), encodeBuffer.data());
+            });
+            const double decode = megabytesPerSecond(size, totalBytes, [&] {
+                sink = sink + Base64::decode(encoded.data(), encoded.size(), decodeBuffer.data());
+            });
+            if (encodeBuffer != encoded) {
+                std::cerr << "Error: " << kernel << " output differs from cpp-base64" << std::endl;
+                return 1;
+            }
+            printRow(kernel, size, encode, decode);
+        }
+    }
+    return 0;
+}
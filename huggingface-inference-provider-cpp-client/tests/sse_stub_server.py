@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+"""Local stand-in for the chat completions endpoint of image-text-to-text.
+
+Answers POST .../v1/chat/completions with a canned reply. With "stream": true
+the reply is sent as server-sent events, one token per event, with a
+configurable delay before the first token and between tokens, so streaming,
+time-to-first-token and cancellation can be exercised without a model:
+
+    python3 tests/sse_stub_server.py --port 8080 --first-token-delay 0.5
+    ./huggingface_app -i cat.jpeg -t image-text-to-text --stream \\
+        --api-url http://127.0.0.1:8080/models
+"""
+import argparse
+import json
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+REPLY = "A small cat sits on a wooden table next to a cup of coffee."
+
+
+def chunk(model, delta, finish_reason=None):
+    return {
+        "object": "chat.completion.chunk",
+        "model": model,
+        "choices": [{"index": 0, "delta": delta, "finish_reason": finish_reason}],
+    }
+
+
+class Handler(BaseHTTPRequestHandler):
+    def do_POST(self):
+        body = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+        if not self.path.endswith("/v1/chat/completions"):
+            self.send_json(404, {"error": "Not found: " + self.path})
+            return
+        try:
+            payload = json.loads(body)
+        except ValueError:
+            self.send_json(400, {"error": "Malformed JSON"})
+            return
+        model = payload.get("model", "stub")
+        tokens = [word + " " for word in REPLY.split(" ")][: payload.get("max_tokens", 500)]
+        tokens[-1] = tokens[-1].rstrip()
+
+        if not payload.get("stream"):
+            self.send_json(200, {
+                "object": "chat.completion",
+                "model": model,
+                "choices": [{"index": 0, "message": {"role": "assistant", "content": "".join(tokens)},
+                             "finish_reason": "stop"}],
+            })
+            return
+
+        self.send_response(200)
+        self.send_header("Content-Type", "text/event-stream")
+        self.send_header("Cache-Control", "no-cache")
+        self.end_headers()
+        try:
+            self.send_event(chunk(model, {"role": "assistant", "content": ""}))
+            time.sleep(self.server.first_token_delay)
+            for i, token in enumerate(tokens):
+                if i > 0:
+                    time.sleep(self.server.token_delay)
+                if i % 4 == 0:
+                    self.wfile.write(b": keep-alive\n\n")
+                self.send_event(chunk(model, {"content": token}))
+            self.send_event(chunk(model, {}, "stop"))
+            self.wfile.write(b"data: [DONE]\n\n")
+            self.wfile.flush()
+        except (BrokenPipeError, ConnectionResetError):
+            pass  # The client cancelled
+
+    def send_event(self, data):
+        self.wfile.write(b"data: " + json.dumps(data).encode() + b"\n\n")
+        self.wfile.flush()
+
+    def send_json(self, status, data):
+        body = json.dumps(data).encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            super().log_message(format, *args)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--first-token-delay", type=float, default=0.3, help="seconds")
+    parser.add_argument("--token-delay", type=float, default=0.05, help="seconds")
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    server = ThreadingHTTPServer(("127.0.0.1", args.port), Handler)
+    server.first_token_delay = args.first_token_delay
+    server.token_delay = args.token_delay
+    server.verbose = args.verbose
+    print(f"Serving on http://127.0.0.1:{args.port}")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,114 @@
+#include "async_request_engine.hpp"
+#include <arpa/inet.h>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+// Local port that accepts connections but never answers, so requests to it
+// only finish by timeout or cancellation
+class SilentServer {
+public:
+    SilentServer() {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(addr);
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), length) != 0 ||
+            ::listen(fd, 16) != 0 ||
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length) != 0) {
+            throw std::runtime_error("Failed to open a local socket");
+        }
+        port = ntohs(addr.sin_port);
+    }
+    ~SilentServer() { ::close(fd); }
+
+    HttpRequest request() const {
+        return HttpRequest{"http://127.0.0.1:" + std::to_string(port) + "/models/test",
+                           RequestBody("{}"), {"Content-Type: application/json"}};
+    }
+
+private:
+    int fd = -1;
+    int port = 0;
+};
+
+std::string errorOf(std::future<std::string>& future) {
+    try {
+        future.get();
+    } catch (const std::exception& e) {
+        return e.what();
+    }
+    return "";
+}
+}
+
+TEST(AsyncRequestEngineTest, TimesOutRunningRequest) {
+    SilentServer server;
+    AsyncRequestEngine engine;
+    const auto start = std::chrono::steady_clock::now();
+    auto future = engine.submit(server.request(), 200ms);
+    EXPECT_NE(errorOf(future).find("Timeout"), std::string::npos);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+}
+
+TEST(AsyncRequestEngineTest, TimeoutIncludesTimeQueued) {
+    SilentServer server;
+    AsyncRequestEngine::Options options;
+    options.maxRequestsPerHost = 1;
+    AsyncRequestEngine engine(options);
+    std::promise<std::exception_ptr> runningError;
+    const auto running = engine.submit(server.request(), [&runningError](std::string, std::exception_ptr error) {
+        runningError.set_value(error);
+    });
+    const auto start = std::chrono::steady_clock::now();
+    auto queued = engine.submit(server.request(), 200ms);
+    EXPECT_EQ(errorOf(queued), "Timeout was reached while queued");
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 800ms);
+    engine.cancel(running);
+    EXPECT_TRUE(runningError.get_future().get());
+}
+
+TEST(AsyncRequestEngineTest, CancelsRunningAndQueuedRequests) {
+    SilentServer server;
+    AsyncRequestEngine::Options options;
+    options.maxRequestsPerHost = 1;
+    AsyncRequestEngine engine(options);
+    std::atomic<int> cancelled{0};
+    auto countCancelled = [&cancelled](std::string, std::exception_ptr error) {
+        if (!error) {
+            return;
+        }
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::runtime_error& e) {
+            cancelled += std::string(e.what()) == "Request cancelled" ? 1 : 0;
+        }
+    };
+    const auto running = engine.submit(server.request(), countCancelled);
+    const auto queued = engine.submit(server.request(), countCancelled);
+    engine.cancel(queued);
+    engine.cancel(running);
+    engine.waitIdle();
+    EXPECT_EQ(cancelled.load(), 2);
+
+    // Cancelling a finished request does nothing
+    engine.cancel(running);
+    engine.waitIdle();
+    EXPECT_EQ(cancelled.load(), 2);
+}
+
+TEST(AsyncRequestEngineTest, DestructorFailsUnfinishedRequests) {
+    SilentServer server;
+    std::future<std::string> future;
+    {
+        AsyncRequestEngine engine;
+        future = engine.submit(server.request());
+    }
+    EXPECT_EQ(errorOf(future), "Request engine stopped");
+}
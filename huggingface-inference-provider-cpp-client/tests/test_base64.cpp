@@ -0,0 +1,117 @@
+#include "base64.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace {
+// Up to 120 bytes, i.e. 160 characters: every kernel runs several blocks and
+// leaves each possible remainder to the scalar tail
+constexpr size_t MAX_LENGTH = 120;
+
+std::vector<unsigned char> randomBytes(size_t length) {
+    std::mt19937 generator(static_cast<unsigned>(length));
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<unsigned char> data(length);
+    for (auto& value : data) {
+        value = static_cast<unsigned char>(byte(generator));
+    }
+    return data;
+}
+
+std::string encode(const std::vector<unsigned char>& data) {
+    std::string encoded(Base64::encodedSize(data.size()), '\0');
+    Base64::encode(data.data(), data.size(), encoded.data());
+    return encoded;
+}
+
+std::vector<unsigned char> decode(const std::string& encoded) {
+    std::vector<unsigned char> decoded(Base64::decodedSize(encoded.size()));
+    decoded.resize(Base64::decode(encoded.data(), encoded.size(), decoded.data()));
+    return decoded;
+}
+
+// Restores the default kernel after each test
+class Base64Test : public ::testing::Test {
+protected:
+    void TearDown() override { Base64::selectImplementation(initial); }
+
+    // Kernels this CPU can run, scalar first
+    static std::vector<std::string> kernels() {
+        std::vector<std::string> available;
+        for (const char* name : {"scalar", "ssse3", "avx2"}) {
+            if (Base64::selectImplementation(name)) {
+                available.push_back(name);
+            }
+        }
+        return available;
+    }
+
+    const std::string initial = Base64::implementation();
+};
+}
+
+TEST_F(Base64Test, EncodesKnownVectors) {
+    for (const auto& kernel : kernels()) {
+        SCOPED_TRACE(kernel);
+        Base64::selectImplementation(kernel);
+        const std::string text = "foobar";
+        const std::vector<std::string> expected = {"", "Zg==", "Zm8=", "Zm9v", "Zm9vYg==", "Zm9vYmE=", "Zm9vYmFy"};
+        for (size_t length = 0; length <= text.size(); ++length) {
+            EXPECT_EQ(encode({text.begin(), text.begin() + static_cast<std::ptrdiff_t>(length)}), expected[length]);
+        }
+        EXPECT_EQ(encode({0xfb, 0xff, 0xbf}), "+/+/");
+    }
+}
+
+TEST_F(Base64Test, KernelsMatchScalarAcrossBlockBoundaries) {
+    ASSERT_TRUE(Base64::selectImplementation("scalar"));
+    std::vector<std::string> reference;
+    for (size_t length = 0; length <= MAX_LENGTH; ++length) {
+        reference.push_back(encode(randomBytes(length)));
+    }
+
+    for (const auto& kernel : kernels()) {
+        SCOPED_TRACE(kernel);
+        Base64::selectImplementation(kernel);
+        for (size_t length = 0; length <= MAX_LENGTH; ++length) {
+            const auto data = randomBytes(length);
+            ASSERT_EQ(encode(data), reference[length]) << "length " << length;
+            ASSERT_EQ(decode(reference[length]), data) << "length " << length;
+
+            // Without padding
+            std::string unpadded = reference[length];
+            unpadded.erase(unpadded.find_last_not_of('=') + 1);
+            ASSERT_EQ(decode(unpadded), data) << "unpadded length " << length;
+        }
+    }
+}
+
+TEST_F(Base64Test, RejectsInvalidCharactersAnywhere) {
+    for (const auto& kernel : kernels()) {
+        SCOPED_TRACE(kernel);
+        Base64::selectImplementation(kernel);
+        // 18 and 33 bytes encode to 24 and 44 characters, the least the
+        // SSSE3 and AVX2 decoders take on; the longer ones run several blocks
+        for (size_t length : {size_t(18), size_t(33), size_t(48), size_t(60), MAX_LENGTH}) {
+            const std::string valid = encode(randomBytes(length));
+            for (size_t position = 0; position < valid.size(); ++position) {
+                // Neighbours of the alphabet ranges and a non-ASCII byte
+                for (char bad : {'*', '-', '.', ':', '@', '[', '`', '{', '\x80'}) {
+                    std::string invalid = valid;
+                    invalid[position] = bad;
+                    EXPECT_THROW(decode(invalid), std::runtime_error)
+                        << "length " << length << " position " << position << " character " << int(bad);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(Base64Test, RejectsImpossibleLengths) {
+    for (const auto& kernel : kernels()) {
+        SCOPED_TRACE(kernel);
+        Base64::selectImplementation(kernel);
+        EXPECT_THROW(decode("Zm9vY"), std::runtime_error);
+        EXPECT_TRUE(decode("").empty());
+    }
+}
@@ -0,0 +1,89 @@
+#include "image_processing.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+namespace {
+// APP1 segment holding an EXIF IFD0 with just the orientation tag
+std::vector<unsigned char> exifSegment(int orientation, bool littleEndian) {
+    const auto put16 = [littleEndian](std::vector<unsigned char>& out, unsigned value) {
+        if (littleEndian) {
+            out.insert(out.end(), {static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8)});
+        } else {
+            out.insert(out.end(), {static_cast<unsigned char>(value >> 8), static_cast<unsigned char>(value)});
+        }
+    };
+    std::vector<unsigned char> tiff;
+    tiff.insert(tiff.end(), littleEndian ? std::initializer_list<unsigned char>{'I', 'I'}
+                                         : std::initializer_list<unsigned char>{'M', 'M'});
+    put16(tiff, 42);
+    put16(tiff, littleEndian ? 8 : 0);  // IFD0 offset 8, as 32 bits
+    put16(tiff, littleEndian ? 0 : 8);
+    put16(tiff, 1);                     // One entry
+    put16(tiff, 0x0112);                // Orientation
+    put16(tiff, 3);                     // SHORT
+    put16(tiff, 1);
+    put16(tiff, 0);
+    put16(tiff, static_cast<unsigned>(orientation));
+    put16(tiff, 0);
+    put16(tiff, 0);                     // No next IFD
+    put16(tiff, 0);
+
+    const size_t length = 2 + 6 + tiff.size();
+    std::vector<unsigned char> segment = {0xFF, 0xE1, static_cast<unsigned char>(length >> 8),
+                                          static_cast<unsigned char>(length), 'E', 'x', 'i', 'f', 0, 0};
+    segment.insert(segment.end(), tiff.begin(), tiff.end());
+    return segment;
+}
+
+std::vector<unsigned char> jpegWithOrientation(int orientation, bool littleEndian = true) {
+    cv::Mat image(24, 32, CV_8UC3, cv::Scalar(0, 0, 255));
+    image(cv::Rect(0, 0, 8, 24)).setTo(cv::Scalar(255, 0, 0));
+    std::vector<unsigned char> jpeg;
+    cv::imencode(".jpg", image, jpeg);
+    const std::vector<unsigned char> segment = exifSegment(orientation, littleEndian);
+    jpeg.insert(jpeg.begin() + 2, segment.begin(), segment.end());
+    return jpeg;
+}
+
+class TempImage {
+public:
+    TempImage(const std::string& name, const std::vector<unsigned char>& bytes)
+        : path((std::filesystem::temp_directory_path() / name).string()) {
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    }
+    ~TempImage() { std::remove(path.c_str()); }
+
+    const std::string path;
+};
+}
+
+TEST(ImageProcessingTest, ReadsJpegOrientation) {
+    EXPECT_EQ(ImageProcessing::jpegOrientation(jpegWithOrientation(6)), 6);
+    EXPECT_EQ(ImageProcessing::jpegOrientation(jpegWithOrientation(8, false)), 8);
+    EXPECT_EQ(ImageProcessing::jpegOrientation(jpegWithOrientation(1)), 1);
+
+    std::vector<unsigned char> plain;
+    cv::imencode(".jpg", cv::Mat(8, 8, CV_8UC3, cv::Scalar::all(0)), plain);
+    EXPECT_EQ(ImageProcessing::jpegOrientation(plain), 1);
+
+    std::vector<unsigned char> truncated = jpegWithOrientation(6);
+    truncated.resize(20);
+    EXPECT_EQ(ImageProcessing::jpegOrientation(truncated), 1);
+}
+
+TEST(ImageProcessingTest, PassesThroughOnlyUprightJpegs) {
+    const std::vector<unsigned char> upright = jpegWithOrientation(1);
+    const TempImage uprightFile("upright_exif_test.jpg", upright);
+    EXPECT_EQ(ImageProcessing::encodeImageBytes(uprightFile.path, 0), upright);
+
+    // Rotated a quarter turn, as cv::imread() loads it
+    const std::vector<unsigned char> rotated = jpegWithOrientation(6);
+    const TempImage rotatedFile("rotated_exif_test.jpg", rotated);
+    const std::vector<unsigned char> encoded = ImageProcessing::encodeImageBytes(rotatedFile.path, 0);
+    EXPECT_NE(encoded, rotated);
+    const cv::Mat decoded = cv::imdecode(encoded, cv::IMREAD_COLOR);
+    EXPECT_EQ(decoded.size(), cv::Size(24, 32));
+    EXPECT_EQ(decoded.size(), cv::imread(rotatedFile.path).size());
+}
@@ -0,0 +1,135 @@
+#include "image_text_to_text.hpp"
+#include <arpa/inet.h>
+#include <csignal>
+#include <future>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+const std::string REPLY = "A small cat sits on a wooden table next to a cup of coffee.";
+
+bool acceptsConnections(int port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const bool connected = ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+    ::close(fd);
+    return connected;
+}
+
+int freePort() {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    ::bind(fd, reinterpret_cast<sockaddr*>(&addr), length);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &length);
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+// tests/sse_stub_server.py in a child process, waiting 300 ms before the
+// first token and 20 ms between tokens
+class StubServer {
+public:
+    StubServer() : port(freePort()) {
+        const std::string portArg = std::to_string(port);
+        pid = ::fork();
+        if (pid == 0) {
+            ::execl(PYTHON_EXECUTABLE, PYTHON_EXECUTABLE, SSE_STUB_SERVER, "--port", portArg.c_str(),
+                    "--first-token-delay", "0.3", "--token-delay", "0.02", static_cast<char*>(nullptr));
+            ::_exit(127);
+        }
+        for (int i = 0; i < 100 && !acceptsConnections(port); ++i) {
+            std::this_thread::sleep_for(50ms);
+        }
+    }
+    ~StubServer() {
+        ::kill(pid, SIGTERM);
+        ::waitpid(pid, nullptr, 0);
+    }
+
+    std::string endpoint() const { return "http://127.0.0.1:" + std::to_string(port) + "/models/stub"; }
+
+private:
+    int port;
+    pid_t pid = -1;
+};
+
+class ImageTextToTextTest : public ::testing::Test {
+protected:
+    StubServer server;
+    ImageTextToText task{server.endpoint(), "token", {}, "Describe the image"};
+};
+}
+
+TEST_F(ImageTextToTextTest, StreamsTokensAsTheyArrive) {
+    std::vector<std::string> tokens;
+    const auto result = task.executeStream([&tokens](const std::string& token) {
+        tokens.push_back(token);
+        return true;
+    });
+    EXPECT_FALSE(result.cancelled);
+    EXPECT_EQ(result.text, REPLY);
+    EXPECT_EQ(result.tokens, 14u);
+    EXPECT_EQ(tokens.size(), result.tokens);
+    EXPECT_GE(result.timeToFirstToken, 300ms);
+    EXPECT_LT(result.timeToFirstToken, result.totalTime);
+    EXPECT_GE(result.meanInterTokenLatency, 15ms);
+    EXPECT_GE(result.maxInterTokenLatency, result.meanInterTokenLatency);
+}
+
+TEST_F(ImageTextToTextTest, CallbackStopsTheStream) {
+    const auto result = task.executeStream([](const std::string&) { return false; });
+    EXPECT_TRUE(result.cancelled);
+    EXPECT_EQ(result.tokens, 1u);
+    EXPECT_EQ(result.text, "A ");
+}
+
+TEST_F(ImageTextToTextTest, CancelStopsARunningStream) {
+    std::promise<void> firstToken;
+    std::thread canceller([&] {
+        firstToken.get_future().wait();
+        task.cancel();
+    });
+    bool first = true;
+    const auto result = task.executeStream([&](const std::string&) {
+        if (first) {
+            first = false;
+            firstToken.set_value();
+        }
+        return true;
+    });
+    canceller.join();
+    EXPECT_TRUE(result.cancelled);
+    EXPECT_LT(result.tokens, 14u);
+}
+
+TEST_F(ImageTextToTextTest, CancelBeforeTheStreamStartsIsKept) {
+    task.cancel();
+    const auto cancelled = task.executeStream([](const std::string&) { return true; });
+    EXPECT_TRUE(cancelled.cancelled);
+    EXPECT_EQ(cancelled.tokens, 0u);
+
+    // Used up by the stream it stopped
+    const auto next = task.executeStream([](const std::string&) { return true; });
+    EXPECT_FALSE(next.cancelled);
+    EXPECT_EQ(next.text, REPLY);
+}
+
+TEST_F(ImageTextToTextTest, CallbackExceptionsReachTheCaller) {
+    EXPECT_THROW(task.executeStream([](const std::string&) -> bool { throw std::logic_error("stop"); }),
+                 std::logic_error);
+
+    // The task is still usable afterwards
+    EXPECT_EQ(task.executeStream([](const std::string&) { return true; }).text, REPLY);
+}
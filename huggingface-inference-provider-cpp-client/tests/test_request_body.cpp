@@ -0,0 +1,110 @@
+#include "request_body.hpp"
+#include "base64.hpp"
+#include <gtest/gtest.h>
+#include <numeric>
+
+namespace {
+// 100 bytes: base64 groups end at every third byte and the last one is padded
+std::vector<unsigned char> imageBytes() {
+    std::vector<unsigned char> data(100);
+    std::iota(data.begin(), data.end(), static_cast<unsigned char>(200));
+    return data;
+}
+
+std::string toBase64(const std::vector<unsigned char>& data) {
+    std::string encoded(Base64::encodedSize(data.size()), '\0');
+    Base64::encode(data.data(), data.size(), encoded.data());
+    return encoded;
+}
+
+std::string readAll(RequestBody& body, size_t bufferSize) {
+    std::string out;
+    std::vector<char> buffer(bufferSize);
+    for (size_t n; (n = body.read(buffer.data(), buffer.size())) > 0;) {
+        out.append(buffer.data(), n);
+    }
+    return out;
+}
+
+// Text, a base64 image and a binary part
+RequestBody mixedBody() {
+    RequestBody body("{\"image\":\"");
+    body.appendBase64(std::make_shared<const std::vector<unsigned char>>(imageBytes()));
+    body.appendText("\"}");
+    body.appendBinary(std::make_shared<const std::vector<unsigned char>>(std::vector<unsigned char>{0, 1, 2}));
+    return body;
+}
+
+std::string mixedExpected() {
+    return "{\"image\":\"" + toBase64(imageBytes()) + "\"}" + std::string("\0\1\2", 3);
+}
+}
+
+TEST(RequestBodyTest, FromJsonStreamsImagesInPlaceOfPlaceholders) {
+    std::vector<RequestBody::Bytes> images;
+    nlohmann::json payload;
+    payload["inputs"] = RequestBody::attachBase64(images, imageBytes());
+    payload["parameters"]["prompt"] = "a cat";
+    payload["url"] = "data:image/png;base64," + RequestBody::attachBase64(images, {1, 2, 3, 4});
+
+    RequestBody body = RequestBody::fromJson(payload, images);
+
+    nlohmann::json expected = payload;
+    expected["inputs"] = toBase64(imageBytes());
+    expected["url"] = "data:image/png;base64," + toBase64({1, 2, 3, 4});
+    EXPECT_EQ(readAll(body, 4096), expected.dump());
+}
+
+TEST(RequestBodyTest, FromJsonKeepsTextThatLooksLikeAPlaceholder) {
+    std::vector<RequestBody::Bytes> images;
+    nlohmann::json payload;
+    // The characters \u0000image: typed into a prompt, not a NUL
+    payload["prompt"] = "\\u0000image:0\\u0000";
+    payload["escaped"] = "\\\\u0000image:0\\u0000";
+    payload["inputs"] = RequestBody::attachBase64(images, {9, 8, 7});
+
+    RequestBody body = RequestBody::fromJson(payload, images);
+
+    nlohmann::json expected = payload;
+    expected["inputs"] = toBase64({9, 8, 7});
+    EXPECT_EQ(readAll(body, 4096), expected.dump());
+}
+
+TEST(RequestBodyTest, FromJsonRejectsMissingImages) {
+    std::vector<RequestBody::Bytes> images;
+    nlohmann::json payload;
+    payload["inputs"] = RequestBody::attachBase64(images, {1});
+    images.clear();
+    EXPECT_THROW(RequestBody::fromJson(payload, images), std::runtime_error);
+}
+
+TEST(RequestBodyTest, ReadsWithBuffersThatSplitBase64Groups) {
+    const std::string expected = mixedExpected();
+    for (size_t bufferSize : {1, 2, 3, 5, 6, 7, 11, 13, 64, 4096}) {
+        SCOPED_TRACE("buffer size " + std::to_string(bufferSize));
+        RequestBody body = mixedBody();
+        const std::string read = readAll(body, bufferSize);
+        EXPECT_EQ(read, expected);
+        EXPECT_EQ(body.size(), read.size());
+    }
+}
+
+TEST(RequestBodyTest, SeeksIntoTheMiddleOfParts) {
+    const std::string expected = mixedExpected();
+    RequestBody body = mixedBody();
+    ASSERT_EQ(body.size(), expected.size());
+    for (size_t offset = 0; offset <= expected.size(); ++offset) {
+        ASSERT_TRUE(body.seek(offset));
+        EXPECT_EQ(readAll(body, 5), expected.substr(offset)) << "offset " << offset;
+    }
+    EXPECT_FALSE(body.seek(expected.size() + 1));
+}
+
+TEST(RequestBodyTest, EmptyBody) {
+    RequestBody body;
+    EXPECT_TRUE(body.empty());
+    EXPECT_EQ(body.size(), 0u);
+    char buffer[4];
+    EXPECT_EQ(body.read(buffer, sizeof(buffer)), 0u);
+    EXPECT_TRUE(body.seek(0));
+}
@@ -0,0 +1,73 @@
+#include "response_cache.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+class ResponseCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        directory = fs::temp_directory_path() / ("response_cache_test." + std::to_string(::getpid()));
+        fs::remove_all(directory);
+        fs::create_directories(directory);
+    }
+    void TearDown() override { fs::remove_all(directory); }
+
+    // Writes an entry file the way the disk tier does
+    fs::path writeEntry(char keyDigit, int64_t expirySeconds, const std::string& response) {
+        const fs::path path = directory / std::string(64, keyDigit);
+        std::ofstream(path, std::ios::binary) << "hfcache1 " << expirySeconds << '\n' << response;
+        return path;
+    }
+
+    fs::path directory;
+};
+
+int64_t secondsFromNow(int64_t seconds) {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count() + seconds;
+}
+}
+
+TEST_F(ResponseCacheTest, DeletesExpiredFilesWhenCreated) {
+    const fs::path expired = writeEntry('a', secondsFromNow(-60), "old");
+    const fs::path fresh = writeEntry('b', secondsFromNow(3600), "new");
+    const fs::path unrelated = directory / "notes.txt";
+    std::ofstream(unrelated) << "kept";
+
+    ResponseCache::Options options;
+    options.directory = directory.string();
+    ResponseCache cache(options);
+
+    EXPECT_FALSE(fs::exists(expired));
+    EXPECT_TRUE(fs::exists(fresh));
+    EXPECT_TRUE(fs::exists(unrelated));
+    EXPECT_EQ(cache.get(std::string(64, 'b'), []() -> std::string { throw std::logic_error("not cached"); }), "new");
+}
+
+TEST_F(ResponseCacheTest, WaitersShareTheOutcomeOfTheRequestInFlight) {
+    ResponseCache cache;
+    const std::string key(64, 'c');
+    AsyncRequestEngine::Callback complete;
+    std::vector<std::string> errors;
+    auto record = [&errors](std::string, std::exception_ptr error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            errors.push_back(e.what());
+        }
+    };
+
+    EXPECT_TRUE(cache.get(key, record, [&complete](AsyncRequestEngine::Callback done) { complete = std::move(done); }));
+    EXPECT_FALSE(cache.get(key, record, [](AsyncRequestEngine::Callback) { FAIL() << "Sent twice"; }));
+    EXPECT_EQ(cache.stats().coalesced, 1u);
+
+    complete({}, std::make_exception_ptr(std::runtime_error("Request cancelled")));
+    EXPECT_EQ(errors, (std::vector<std::string>{"Request cancelled", "Request cancelled"}));
+
+    // The error was not cached
+    EXPECT_EQ(cache.get(key, [] { return std::string("ok"); }), "ok");
+}
@@ -0,0 +1,104 @@
+#include "response_parser.hpp"
+#include "base64.hpp"
+#include <gtest/gtest.h>
+
+namespace {
+std::string pngBase64(const cv::Mat& mask) {
+    std::vector<unsigned char> png;
+    cv::imencode(".png", mask, png);
+    std::string encoded(Base64::encodedSize(png.size()), '\0');
+    Base64::encode(png.data(), png.size(), encoded.data());
+    return encoded;
+}
+
+// Responses every parse function must reject
+const std::vector<std::string> MALFORMED = {
+    "",
+    "[{\"label\": \"cat\", \"score\": 0.9}",  // Truncated
+    "[{\"label\": \"cat\" \"score\": 0.9}]",  // Missing comma
+    "{\"error\": \"Model is loading\"}",
+    "\"cat\"",
+    "[[{\"label\": \"cat\", \"score\": 0.9}]]",
+    "[\"cat\", \"dog\"]",
+    "[0.9]",
+};
+}
+
+TEST(ResponseParserTest, ParsesClassificationsInAnyKeyOrder) {
+    const auto results = ResponseParser::parseClassifications(
+        R"([{"label": "cat", "score": 0.75},
+            {"score": 0.25, "label": "dog"},
+            {"label": "bird"}])");
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(results[0].label, "cat");
+    EXPECT_DOUBLE_EQ(results[0].score, 0.75);
+    EXPECT_EQ(results[1].label, "dog");
+    EXPECT_DOUBLE_EQ(results[1].score, 0.25);
+    EXPECT_EQ(results[2].label, "bird");
+    EXPECT_DOUBLE_EQ(results[2].score, 0.0);  // No score given
+    EXPECT_TRUE(ResponseParser::parseClassifications("[]").empty());
+}
+
+TEST(ResponseParserTest, SkipsValuesNestedDeeperThanAnItemObject) {
+    const auto results = ResponseParser::parseClassifications(
+        R"([{"meta": {"label": "nested", "extra": {"score": 5, "label": "deeper"}},
+             "label": "cat", "ranks": [1, {"score": 7}], "flag": true, "none": null,
+             "score": 0.5}])");
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0].label, "cat");
+    EXPECT_DOUBLE_EQ(results[0].score, 0.5);
+}
+
+TEST(ResponseParserTest, ParsesObjectDetectionBoxes) {
+    const auto results = ResponseParser::parseObjectDetections(
+        R"([{"score": 0.9, "label": "cat", "box": {"xmin": 1, "ymin": 2, "xmax": 30, "ymax": 40}},
+            {"box": {"ymax": 8, "xmax": 7, "extra": {"xmin": 99}, "ymin": 6, "xmin": 5}, "label": "dog"}])");
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].label, "cat");
+    EXPECT_DOUBLE_EQ(results[0].score, 0.9);
+    EXPECT_EQ(results[0].box.xmin, 1);
+    EXPECT_EQ(results[0].box.ymin, 2);
+    EXPECT_EQ(results[0].box.xmax, 30);
+    EXPECT_EQ(results[0].box.ymax, 40);
+
+    EXPECT_EQ(results[1].label, "dog");
+    EXPECT_DOUBLE_EQ(results[1].score, 0.0);
+    EXPECT_EQ(results[1].box.xmin, 5);
+    EXPECT_EQ(results[1].box.ymin, 6);
+    EXPECT_EQ(results[1].box.xmax, 7);
+    EXPECT_EQ(results[1].box.ymax, 8);
+}
+
+TEST(ResponseParserTest, ParsesSegmentationsAndDecodesMasks) {
+    cv::Mat mask = cv::Mat::zeros(3, 11, CV_8UC1);
+    mask(cv::Rect(0, 0, 4, 1)).setTo(255);
+    mask(cv::Rect(7, 1, 4, 2)).setTo(255);
+    const std::string encoded = pngBase64(mask);
+
+    const auto results = ResponseParser::parseSegmentations(
+        "[{\"mask\": \"" + encoded + "\", \"score\": 0.8, \"label\": \"cat\"},"
+        " {\"label\": \"sky\", \"mask\": \"" + encoded + "\"}]");
+    ASSERT_EQ(results.size(), 2u);
+    EXPECT_EQ(results[0].label, "cat");
+    ASSERT_TRUE(results[0].score);
+    EXPECT_DOUBLE_EQ(*results[0].score, 0.8);
+    EXPECT_EQ(results[1].label, "sky");
+    EXPECT_FALSE(results[1].score);  // Semantic segmentation
+    for (const auto& result : results) {
+        EXPECT_EQ(result.mask.area(), 12u);
+        EXPECT_EQ(cv::countNonZero(result.mask.toMat() != mask), 0);
+    }
+
+    EXPECT_THROW(ResponseParser::parseSegmentations(R"([{"label": "cat", "mask": "AAAA"}])"), std::runtime_error);
+    EXPECT_THROW(ResponseParser::parseSegmentations(R"([{"label": "cat", "mask": "not*base64"}])"),
+                 std::runtime_error);
+}
+
+TEST(ResponseParserTest, RejectsMalformedResponses) {
+    for (const auto& response : MALFORMED) {
+        SCOPED_TRACE(response);
+        EXPECT_THROW(ResponseParser::parseClassifications(response), std::runtime_error);
+        EXPECT_THROW(ResponseParser::parseObjectDetections(response), std::runtime_error);
+        EXPECT_THROW(ResponseParser::parseSegmentations(response), std::runtime_error);
+    }
+}
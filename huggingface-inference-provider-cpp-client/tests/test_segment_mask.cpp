@@ -0,0 +1,81 @@
+#include "segment_mask.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+namespace {
+// Rows with runs of random length, nonzero values other than 255, and every
+// second row starting and ending with a set pixel
+cv::Mat randomMask(int rows, int cols, unsigned seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> runLength(1, 12);
+    std::uniform_int_distribution<int> value(1, 255);
+    cv::Mat mask = cv::Mat::zeros(rows, cols, CV_8UC1);
+    for (int y = 0; y < rows; ++y) {
+        uchar* pixels = mask.ptr<uchar>(y);
+        bool set = y % 2 == 0;
+        for (int x = 0; x < cols;) {
+            const int end = std::min(cols, x + runLength(generator));
+            for (; x < end; ++x) {
+                pixels[x] = set ? static_cast<uchar>(value(generator)) : 0;
+            }
+            set = !set;
+        }
+        if (y % 2 == 0) {
+            pixels[cols - 1] = 1;
+        }
+    }
+    return mask;
+}
+}
+
+TEST(SegmentMaskTest, RoundTripsMasksOfAnyWidth) {
+    for (int cols : {1, 2, 7, 8, 9, 15, 16, 17, 31, 33, 64, 70}) {
+        SCOPED_TRACE("width " + std::to_string(cols));
+        const cv::Mat mask = randomMask(6, cols, static_cast<unsigned>(cols));
+        const SegmentMask segment = SegmentMask::fromMat(mask);
+        EXPECT_EQ(segment.width(), cols);
+        EXPECT_EQ(segment.height(), 6);
+        EXPECT_EQ(segment.area(), static_cast<size_t>(cv::countNonZero(mask)));
+
+        const cv::Mat restored = segment.toMat();
+        ASSERT_EQ(restored.type(), CV_8UC1);
+        for (int y = 0; y < mask.rows; ++y) {
+            for (int x = 0; x < mask.cols; ++x) {
+                ASSERT_EQ(restored.at<uchar>(y, x), mask.at<uchar>(y, x) ? 255 : 0) << "at " << x << "," << y;
+            }
+        }
+    }
+}
+
+TEST(SegmentMaskTest, RoundTripsFullAndEmptyRows) {
+    cv::Mat mask = cv::Mat::zeros(3, 19, CV_8UC1);
+    mask.row(1).setTo(255);
+    const SegmentMask segment = SegmentMask::fromMat(mask);
+    EXPECT_FALSE(segment.empty());
+    EXPECT_EQ(segment.area(), 19u);
+    EXPECT_EQ(cv::countNonZero(segment.toMat() != mask), 0);
+
+    EXPECT_TRUE(SegmentMask::fromMat(cv::Mat::zeros(4, 9, CV_8UC1)).empty());
+    EXPECT_THROW(SegmentMask::fromMat(cv::Mat::zeros(2, 2, CV_8UC3)), std::runtime_error);
+}
+
+TEST(SegmentMaskTest, FillRowMatchesNearestNeighbourResize) {
+    const cv::Mat mask = randomMask(7, 30, 3);
+    const SegmentMask segment = SegmentMask::fromMat(mask);
+    // Up, down, unchanged and mixed; 30 -> 26 hits a column where the
+    // rounded scale ratio samples one column earlier than exact arithmetic
+    for (const cv::Size size : {cv::Size(60, 14), cv::Size(90, 21), cv::Size(26, 5), cv::Size(7, 3),
+                                cv::Size(30, 7), cv::Size(97, 4), cv::Size(1, 1)}) {
+        SCOPED_TRACE(std::to_string(size.width) + "x" + std::to_string(size.height));
+        cv::Mat resized;
+        cv::resize(mask, resized, size, 0, 0, cv::INTER_NEAREST);
+        std::vector<uint16_t> row(static_cast<size_t>(size.width));
+        for (int y = 0; y < size.height; ++y) {
+            std::fill(row.begin(), row.end(), 0);
+            segment.fillRow(y, size, 7, row.data());
+            for (int x = 0; x < size.width; ++x) {
+                ASSERT_EQ(row[x], resized.at<uchar>(y, x) ? 7 : 0) << "at " << x << "," << y;
+            }
+        }
+    }
+}
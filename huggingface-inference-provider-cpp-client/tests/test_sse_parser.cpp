@@ -0,0 +1,66 @@
+#include "sse_parser.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace {
+const std::string STREAM =
+    ": keep-alive\r\n\r\n"
+    "data: {\"n\": 1}\r\n\r\n"
+    "event: update\n"
+    "id: 7\n"
+    "data: first\n"
+    "data:second\n"
+    "\n"
+    "data: [DONE]\n\n";
+
+std::vector<SseParser::Event> parseInChunks(const std::string& stream, size_t chunkSize) {
+    std::vector<SseParser::Event> events;
+    SseParser parser([&events](const SseParser::Event& event) {
+        events.push_back(event);
+        return true;
+    });
+    for (size_t pos = 0; pos < stream.size(); pos += chunkSize) {
+        EXPECT_TRUE(parser.feed(stream.data() + pos, std::min(chunkSize, stream.size() - pos)));
+    }
+    return events;
+}
+}
+
+TEST(SseParserTest, ParsesEventsSplitAnywhere) {
+    for (size_t chunkSize : {STREAM.size(), size_t(1), size_t(2), size_t(5), size_t(13)}) {
+        SCOPED_TRACE("chunk size " + std::to_string(chunkSize));
+        const std::vector<SseParser::Event> events = parseInChunks(STREAM, chunkSize);
+        ASSERT_EQ(events.size(), 3u);
+        EXPECT_EQ(events[0].type, "message");
+        EXPECT_EQ(events[0].data, "{\"n\": 1}");
+        EXPECT_EQ(events[1].type, "update");
+        EXPECT_EQ(events[1].id, "7");
+        EXPECT_EQ(events[1].data, "first\nsecond");
+        EXPECT_EQ(events[2].type, "message");
+        EXPECT_EQ(events[2].data, "[DONE]");
+    }
+}
+
+TEST(SseParserTest, HoldsBackAnEventUntilItsBlankLine) {
+    std::vector<std::string> data;
+    SseParser parser([&data](const SseParser::Event& event) {
+        data.push_back(event.data);
+        return true;
+    });
+    const std::string partial = "data: token\n";
+    parser.feed(partial.data(), partial.size());
+    EXPECT_TRUE(data.empty());
+    parser.feed("\n", 1);
+    EXPECT_EQ(data, std::vector<std::string>{"token"});
+}
+
+TEST(SseParserTest, StopsWhenTheCallbackReturnsFalse) {
+    int calls = 0;
+    SseParser parser([&calls](const SseParser::Event&) {
+        ++calls;
+        return false;
+    });
+    EXPECT_FALSE(parser.feed(STREAM.data(), STREAM.size()));
+    EXPECT_FALSE(parser.feed(STREAM.data(), STREAM.size()));
+    EXPECT_EQ(calls, 1);
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "ensemble_classifier.hpp"
+#include "image_processor.hpp"
+#include "inference_backend.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Escalation thresholds of a cascade
+ */
+struct CascadeOptions {
+  float min_confidence = 0.5f; ///< Escalate when the top-1 probability is lower
+  float min_margin = 0.2f;     ///< Escalate when top-1 minus top-2 is lower
+};
+
+/**
+ * @brief Runs models from cheapest to most expensive, stopping when confident
+ *
+ * Every tier classifies the same decoded window, subsampled to its own frame
+ * count and preprocessed by its own processor. A tier's answer is accepted
+ * when both its top-1 probability and its margin over the runner-up reach the
+ * thresholds; otherwise the window is passed to the next tier. The last tier
+ * always answers. Tiers reuse their logits buffer across windows, so
+ * classify() must not be called concurrently; stats() may be.
+ */
+class CascadeClassifier {
+public:
+  struct Result {
+    std::string model_name;                                     ///< Tier that answered
+    size_t tier = 0;                                            ///< Index of that tier
+    std::vector<InferenceBackend::InferenceResult> predictions; ///< Top predictions
+  };
+
+  struct TierStats {
+    std::string model_name; ///< Tier model
+    uint64_t calls = 0;     ///< Windows this tier classified
+    uint64_t escalations = 0; ///< Windows passed on to the next tier
+    double total_ms = 0.0;  ///< Preprocessing plus inference time
+  };
+
+  /**
+   * @brief A loaded tier model
+   */
+  struct Tier {
+    std::string model_name;                    ///< Tier model
+    std::unique_ptr<InferenceBackend> client;  ///< Backend running the model
+    std::unique_ptr<ImageProcessor> processor; ///< Tier preprocessing
+    ModelInfo model_info;                      ///< Model metadata
+    std::vector<float> logits;                 ///< Output buffer reused per window
+  };
+
+  /**
+   * @brief Creates the cascade and fetches metadata for every tier
+   * @param server_url URL of the Triton server
+   * @param labels_file Path to file containing class labels
+   * @param tiers Models ordered from cheapest to most expensive
+   * @param options Escalation thresholds
+   * @param backend Inference backend name, see create_backend()
+   * @throws std::runtime_error if tiers is empty or a tier fails to load
+   */
+  CascadeClassifier(const std::string &server_url,
+                    const std::string &labels_file,
+                    const std::vector<EnsembleMemberSpec> &tiers,
+                    const CascadeOptions &options = {},
+                    const std::string &backend = "triton");
+
+  /**
+   * @brief Creates the cascade from already loaded tiers
+   * @param tiers Tiers ordered from cheapest to most expensive
+   * @param options Escalation thresholds
+   * @throws std::runtime_error if tiers is empty
+   */
+  explicit CascadeClassifier(std::vector<Tier> tiers,
+                             const CascadeOptions &options = {});
+
+  /**
+   * @brief Classifies one window, escalating while tiers are unsure
+   * @param frames Window of frames in RGB format
+   * @param top_k Number of predictions to return
+   * @return Predictions of the first confident tier, or of the last tier
+   */
+  Result classify(const std::vector<cv::Mat> &frames, int top_k = 3);
+
+  /**
+   * @brief Returns per-tier call counts, escalations and latency
+   */
+  std::vector<TierStats> stats() const;
+
+  /**
+   * @brief Fraction of windows the first tier did not answer
+   */
+  double escalation_rate() const;
+
+private:
+  static std::vector<Tier>
+  load_tiers(const std::string &server_url, const std::string &labels_file,
+             const std::vector<EnsembleMemberSpec> &tiers,
+             const std::string &backend);
+
+  bool is_confident(
+      const std::vector<InferenceBackend::InferenceResult> &predictions) const;
+
+  CascadeOptions options_;
+  std::vector<Tier> tiers_;
+  mutable std::mutex stats_mutex_;
+  std::vector<TierStats> stats_;
+};
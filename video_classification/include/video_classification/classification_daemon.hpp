@@ -0,0 +1,84 @@
+#pragma once
+
+#include "classification_service.hpp"
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * @brief Serves a ClassificationService over a Unix domain socket
+ *
+ * Clients send newline-delimited JSON requests such as
+ * `{"id": "42", "video": "/data/clip.mp4", "top_k": 5}` and receive one JSON
+ * line per request, in order, as soon as it completes:
+ * `{"id": "42", "video": "...", "predictions": [{"label": ..., "probability":
+ * ...}]}` or `{"id": "42", "error": "..."}`. A connection may pipeline any
+ * number of requests.
+ *
+ * All connections are polled on the thread calling run(); only complete
+ * requests are handed to the worker pool, one at a time per connection, so
+ * idle connections hold no worker.
+ */
+class ClassificationDaemon {
+public:
+  /**
+   * @brief Binds the listening socket
+   * @param service Warm service used for every request
+   * @param socket_path Filesystem path of the Unix socket (replaced if stale)
+   * @param max_concurrency Maximum number of requests handled at once
+   * @throws std::runtime_error if the socket cannot be created, or if
+   *         socket_path is not a socket or a daemon is still listening on it
+   */
+  ClassificationDaemon(ClassificationService &service,
+                       const std::string &socket_path, size_t max_concurrency);
+  ~ClassificationDaemon();
+
+  ClassificationDaemon(const ClassificationDaemon &) = delete;
+  ClassificationDaemon &operator=(const ClassificationDaemon &) = delete;
+
+  /**
+   * @brief Accepts connections until @p stop_requested becomes true
+   *
+   * On stop the listening socket is closed, requests already received are
+   * completed and answered, and idle connections are closed before returning.
+   */
+  void run(const std::atomic<bool> &stop_requested);
+
+  /**
+   * @brief Handles one request line and returns the response line
+   *
+   * `top_k` must be an integer in [1, MAX_TOP_K]; other values are answered
+   * with an error.
+   */
+  std::string handle_request(const std::string &request_line);
+
+  static constexpr int MAX_TOP_K = 1000;
+
+private:
+  struct Connection {
+    explicit Connection(int socket_fd) : fd(socket_fd) {}
+    int fd;
+    std::string pending;   // Received, not yet dispatched (polling thread)
+    bool closed = false;   // Peer closed or the connection failed
+    std::atomic<bool> busy{false};    // A request is on the pool
+    std::atomic<bool> failed{false};  // Sending its response failed
+  };
+
+  // Submits the next complete request of an idle connection, returns
+  // whether the connection should stay open
+  bool dispatch(Connection &connection, ThreadPool &workers);
+  void receive(Connection &connection);
+  void wake();
+
+  ClassificationService &service_;
+  std::string socket_path_;
+  size_t max_concurrency_;
+  int listen_fd_ = -1;
+  // Workers write to wake_fds_[1] when a request completes, so the polling
+  // thread dispatches the next one without waiting for the poll timeout
+  int wake_fds_[2] = {-1, -1};
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "image_processor.hpp"
+#include "inference_backend.hpp"
+#include "video_fingerprint.hpp"
+#include "video_utils.hpp"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings for a long-lived classification service
+ */
+struct ServiceOptions {
+  std::string backend = "triton";                   ///< See create_backend()
+  std::string server_url = "http://localhost:8000"; ///< Triton server URL
+  std::string labels_file;                          ///< Class labels file
+  std::string model_name = "videomae_large";        ///< Model on Triton
+  std::string config_file;                          ///< Processor config
+  std::string model_type = "videomae";              ///< Processor type
+  int window_size = 16;                             ///< Frames per clip
+  size_t num_clients = 1; ///< Backend instances, i.e. max parallel requests
+  FrameColorFormat color_format = FrameColorFormat::RGB; ///< Decode layout
+  std::string seek_index_dir; ///< Cache of VideoSeekIndex files (empty: none)
+  /// FingerprintIndex file for reusing predictions of duplicates (empty: none)
+  std::string fingerprint_index;
+  int duplicate_distance = 24; ///< Largest fingerprint distance of a duplicate
+};
+
+/**
+ * @brief Near-duplicate lookups of a ClassificationService
+ */
+struct DuplicateStats {
+  uint64_t lookups = 0; ///< Videos fingerprinted
+  uint64_t hits = 0;    ///< Videos answered from a stored duplicate
+  /// Hits times the mean time to preprocess and infer a window, which a hit
+  /// skips; the window is decoded and fingerprinted either way
+  double saved_ms = 0.0;
+};
+
+/**
+ * @brief Keeps backend connections, model metadata and processor warm
+ *
+ * Configuration, labels and model metadata are loaded once at construction.
+ * Triton HTTP clients are not safe for concurrent synchronous requests, so
+ * each call borrows one connection from a fixed pool for its duration. The
+ * in-process ONNX Runtime backend is loaded once and lent to num_clients
+ * calls at a time, which run its session concurrently.
+ */
+class ClassificationService {
+public:
+  /**
+   * @brief Loads configuration and connects to the server
+   * @param options Service settings
+   * @throws std::runtime_error if the model or configuration cannot be loaded
+   */
+  explicit ClassificationService(const ServiceOptions &options);
+
+  /**
+   * @brief Classifies the first window of a video
+   *
+   * With a fingerprint index, the decoded window is fingerprinted and a video
+   * matching one classified before is answered with the stored predictions,
+   * without preprocessing or running inference.
+   *
+   * @param video_path Path to the video file
+   * @param top_k Number of predictions to return
+   * @return Top predictions with labels and probabilities
+   */
+  std::vector<InferenceBackend::InferenceResult>
+  classify(const std::string &video_path, int top_k = 3);
+
+  const ModelInfo &model_info() const { return model_info_; }
+
+  DuplicateStats duplicate_stats() const;
+
+private:
+  InferenceBackend *acquire_client();
+  void release_client(InferenceBackend *client);
+  std::vector<InferenceBackend::InferenceResult>
+  classify_window(const std::string &video_path,
+                  const std::vector<cv::Mat> &frames, int top_k);
+
+  ServiceOptions options_;
+  ModelInfo model_info_;
+  std::unique_ptr<ImageProcessor> processor_;
+  std::vector<std::unique_ptr<InferenceBackend>> clients_;
+  std::vector<InferenceBackend *> idle_clients_;
+  std::mutex mutex_;
+  std::condition_variable client_cv_;
+  std::unique_ptr<FingerprintIndex> fingerprints_;
+  mutable std::mutex stats_mutex_;
+  DuplicateStats duplicate_stats_;
+  uint64_t classified_ = 0;     ///< Videos classified after a lookup miss
+  double classified_ms_ = 0.0;  ///< Time spent classifying them
+};
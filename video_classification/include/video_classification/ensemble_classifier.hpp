@@ -0,0 +1,75 @@
+#pragma once
+
+#include "image_processor.hpp"
+#include "inference_backend.hpp"
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Describes one model of an ensemble
+ */
+struct EnsembleMemberSpec {
+  std::string model_name;  ///< Name of the model on Triton server
+  std::string config_file; ///< Processor config file (empty for defaults)
+  std::string model_type = "auto"; ///< Model type when the config has none
+};
+
+/**
+ * @brief Runs several models on the same decoded frames
+ *
+ * Each member owns its processor, model metadata and backend connection so the
+ * per-model preprocessing and inference requests run concurrently. Frames are
+ * decoded once by the caller and shared read-only between members. Members
+ * reuse their logits buffer across windows, so classify() must not be called
+ * concurrently.
+ */
+class EnsembleClassifier {
+public:
+  struct MemberResult {
+    std::string model_name;                              ///< Member model
+    std::vector<float> logits;                           ///< Raw output logits
+    std::vector<InferenceBackend::InferenceResult> predictions; ///< Top predictions
+  };
+
+  struct Result {
+    std::vector<MemberResult> members; ///< Per-model results, in spec order
+    std::vector<InferenceBackend::InferenceResult> fused; ///< Late-fused predictions
+  };
+
+  /**
+   * @brief Creates the ensemble and fetches metadata for every member
+   * @param server_url URL of the Triton server
+   * @param labels_file Path to file containing class labels
+   * @param specs Models to run, in reporting order
+   * @param backend Inference backend name, see create_backend()
+   * @throws std::runtime_error if specs is empty or a member fails to load
+   */
+  EnsembleClassifier(const std::string &server_url,
+                     const std::string &labels_file,
+                     const std::vector<EnsembleMemberSpec> &specs,
+                     const std::string &backend = "triton");
+
+  /**
+   * @brief Classifies one window of frames with all members
+   * @param frames Window of frames in RGB format
+   * @param fuse Average the members' logits into a fused prediction
+   * @return Per-member and optionally fused results
+   * @throws std::runtime_error if fusing models with different label spaces
+   */
+  Result classify(const std::vector<cv::Mat> &frames, bool fuse);
+
+private:
+  struct Member {
+    std::string model_name;
+    std::unique_ptr<InferenceBackend> client;
+    std::unique_ptr<ImageProcessor> processor;
+    ModelInfo model_info;
+    std::vector<float> logits; ///< Output buffer reused per window
+  };
+
+  MemberResult run_member(Member &member, const std::vector<cv::Mat> &frames);
+
+  std::vector<Member> members_;
+};
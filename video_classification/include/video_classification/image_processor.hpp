@@ -23,7 +23,88 @@ public:
                                      int channels,
                                      const std::string &format) = 0;
 
+  /**
+   * @brief Processes video frames into several spatial views
+   *
+   * Each frame is resized once so its shorter side matches the crop size, and
+   * @p num_crops crops are taken from the same resized buffer, evenly spaced
+   * along the longer side (left/center/right or top/center/bottom for three).
+   *
+   * @param frames Vector of frames in RGB format
+   * @param channels Number of color channels (typically 3 for RGB)
+   * @param format Output format ("FORMAT_NCHW", "FORMAT_NHWC", or "FORMAT_NONE")
+   * @param num_crops Number of spatial views per frame
+   * @return Flattened pixel values laid out as [num_crops, frames, ...]
+   */
+  std::vector<float> process_multi_crop(const std::vector<cv::Mat> &frames,
+                                        int channels, const std::string &format,
+                                        int num_crops) const;
+
+  /**
+   * @brief Processes planar YUV420 frames into model input format
+   *
+   * Luma and chroma planes are resized directly to the target geometry, so
+   * chroma upsampling is folded into the resize; YUV to RGB conversion
+   * (BT.601, as cv::COLOR_YUV2RGB_I420) is fused with normalization and runs
+   * only on the cropped pixels. Output matches process() for a single view
+   * and process_multi_crop() otherwise, up to interpolation rounding.
+   *
+   * @param frames Frames from read_video_frames() with FrameColorFormat::YUV420
+   * @param channels Number of color channels (must be 3)
+   * @param format Output format ("FORMAT_NCHW", "FORMAT_NHWC", or "FORMAT_NONE")
+   * @param num_crops Number of spatial views per frame
+   * @return Flattened pixel values laid out as [num_crops, frames, ...]
+   */
+  std::vector<float> process_yuv420(const std::vector<cv::Mat> &frames,
+                                    int channels, const std::string &format,
+                                    int num_crops = 1) const;
+
 protected:
+  /**
+   * @brief Resize and crop geometry for one frame
+   */
+  struct ResizePlan {
+    cv::Size size;     ///< Size of the resized frame
+    int crop_size;     ///< Side of the square crop taken from the resized frame
+    int interpolation; ///< OpenCV interpolation flag for the resize
+  };
+
+  /**
+   * @brief Describes how a frame of the given size is resized and cropped
+   * @param frame_size Size of the decoded frame
+   * @param multi_crop True when several crops are taken along the long side
+   */
+  virtual ResizePlan resize_plan(const cv::Size &frame_size,
+                                 bool multi_crop) const = 0;
+
+  /**
+   * @brief Per-channel affine mapping 8-bit pixels to model inputs
+   *
+   * Folds rescaling, offset and mean/std normalization into
+   * value = pixel * scale[c] + bias[c].
+   */
+  virtual void channel_affine(std::vector<float> &scale,
+                              std::vector<float> &bias) const = 0;
+
+  /**
+   * @brief Size of a frame resized so that its shorter side equals @p edge
+   */
+  static cv::Size shortest_edge_size(const cv::Size &frame_size, int edge);
+
+  /**
+   * @brief Square crop rectangles evenly spaced along the longer side
+   */
+  static std::vector<cv::Rect> spatial_crops(const cv::Size &resized,
+                                             int crop_size, int num_crops);
+
+  /**
+   * @brief Normalizes one crop into @p out using channel_affine()
+   * @param crop Cropped frame (CV_8U or CV_32F, RGB)
+   * @param out Destination of channels * crop.rows * crop.cols values
+   */
+  void normalize_crop(const cv::Mat &crop, int channels,
+                      const std::string &format, float *out) const;
+
   /**
    * @brief Normalizes and converts image channels to NCHW or NHWC format
    *
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Holds metadata and configuration for a model
+ */
+struct ModelInfo {
+  std::string output_name_;      ///< Name of the output tensor
+  std::string input_name_;       ///< Name of the input tensor
+  std::string input_datatype_;   ///< Data type of input (e.g., "FP32")
+  int input_t_;                  ///< Number of frames per clip
+  int input_c_;                  ///< Number of input channels
+  int input_h_;                  ///< Input height
+  int input_w_;                  ///< Input width
+  std::string input_format_;     ///< Input format ("FORMAT_NCHW" or "FORMAT_NHWC")
+  int type1_;                    ///< OpenCV type for single channel (e.g., CV_32FC1)
+  int type3_;                    ///< OpenCV type for three channels (e.g., CV_32FC3)
+  int max_batch_size_;           ///< Maximum batch size supported by model
+};
+
+/**
+ * @brief Interface of an engine that runs video classification models
+ *
+ * Implementations provide model metadata and raw logits; label lookup and
+ * softmax/top-k postprocessing are shared.
+ */
+class InferenceBackend {
+public:
+  struct InferenceResult {
+    std::string label;     ///< Human-readable label
+    float probability;     ///< Prediction probability (0.0 to 1.0)
+  };
+
+  /**
+   * @param labels_file Optional path to file containing class labels
+   */
+  explicit InferenceBackend(const std::string &labels_file = "");
+  virtual ~InferenceBackend() = default;
+
+  /**
+   * @brief Retrieves model metadata and configuration
+   * @param model_name Name or path identifying the model
+   * @param model_info Output parameter to store model information
+   */
+  virtual void get_model_info(const std::string &model_name,
+                              ModelInfo &model_info) = 0;
+
+  /**
+   * @brief Performs inference and returns the raw output logits
+   * @param input_data Preprocessed input data as float vector
+   * @param model_name Name or path identifying the model
+   * @param model_info Model metadata
+   * @param shape Shape of the input tensor
+   * @return Flattened output logits, batch-major for batched inputs
+   */
+  virtual std::vector<float> infer_logits(const std::vector<float> &input_data,
+                                          const std::string &model_name,
+                                          const ModelInfo &model_info,
+                                          const std::vector<int64_t> &shape) = 0;
+
+  /**
+   * @brief Performs inference writing the logits into a caller buffer
+   *
+   * Lets steady-state callers reuse their input and output memory. The
+   * default implementation calls infer_logits() and copies.
+   *
+   * @param input_data Preprocessed input data
+   * @param model_name Name or path identifying the model
+   * @param model_info Model metadata
+   * @param shape Shape of the input tensor
+   * @param logits Output buffer, batch-major for batched inputs
+   * @return Number of logits written
+   * @throws std::runtime_error if logits is too small for the model output
+   */
+  virtual size_t infer_logits_into(std::span<const float> input_data,
+                                   const std::string &model_name,
+                                   const ModelInfo &model_info,
+                                   const std::vector<int64_t> &shape,
+                                   std::span<float> logits);
+
+  /**
+   * @brief Performs inference into a buffer reused across calls
+   *
+   * The buffer is resized to the model output and keeps its capacity, so a
+   * caller that holds one buffer per worker stops allocating for the output
+   * once it has seen its largest batch. The default implementation calls
+   * infer_logits().
+   *
+   * @param input_data Preprocessed input data
+   * @param model_name Name or path identifying the model
+   * @param model_info Model metadata
+   * @param shape Shape of the input tensor
+   * @param logits Output buffer, batch-major for batched inputs
+   */
+  virtual void infer_logits_into(std::span<const float> input_data,
+                                 const std::string &model_name,
+                                 const ModelInfo &model_info,
+                                 const std::vector<int64_t> &shape,
+                                 std::vector<float> &logits);
+
+  /**
+   * @brief Performs inference on the given input data
+   * @param input_data Preprocessed input data as float vector
+   * @param model_name Name or path identifying the model
+   * @param model_info Model metadata
+   * @param shape Shape of the input tensor
+   * @return Vector of top predictions with labels and probabilities
+   */
+  std::vector<InferenceResult> infer(const std::vector<float> &input_data,
+                                     const std::string &model_name,
+                                     const ModelInfo &model_info,
+                                     const std::vector<int64_t> &shape);
+
+  /**
+   * @brief Converts logits to the top predictions using softmax
+   * @param logits Output logits of a single sample
+   * @param top_k Number of predictions to return
+   * @return Vector of top predictions with labels and probabilities
+   */
+  std::vector<InferenceResult>
+  postprocess_results(const std::vector<float> &logits, int top_k = 3);
+
+  /**
+   * @brief Looks up the output index of a label
+   * @param label Label as listed in the labels file, or "unknown_<index>"
+   * @return Index into the logits, or -1 if the label is not known
+   */
+  int label_index(const std::string &label) const;
+
+protected:
+  void load_labels(const std::string &labels_file);
+
+  std::map<std::string, std::string> id2label_;
+};
+
+/**
+ * @brief Creates an inference backend by name
+ * @param backend "triton" or "onnxruntime"
+ * @param server_url Triton server URL (ignored by in-process backends)
+ * @param labels_file Optional path to file containing class labels
+ * @return Unique pointer to the backend
+ * @throws std::runtime_error if the backend is unknown or not compiled in
+ */
+std::unique_ptr<InferenceBackend>
+create_backend(const std::string &backend, const std::string &server_url,
+               const std::string &labels_file);
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "inference_backend.hpp"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <onnxruntime_cxx_api.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief In-process inference with ONNX Runtime on the CPU
+ *
+ * Loads models exported by python/export.py: a single `pixel_values` input of
+ * shape [batch, frames, 3, H, W] with a dynamic batch axis and a single
+ * `logits` output. The model name passed to the backend is the path of the
+ * .onnx file; sessions are created on first use and kept for the lifetime of
+ * the backend.
+ *
+ * Requests are bound with Ort::IoBinding: the input tensor wraps the
+ * caller's buffer without a copy and the output is written into a buffer
+ * preallocated per model and batch size. The backend may be called from
+ * several threads at once: while one request holds a model's binding, the
+ * others run the shared session directly with ORT-allocated outputs.
+ */
+class OnnxRuntimeBackend : public InferenceBackend {
+public:
+  /**
+   * @param labels_file Optional path to file containing class labels
+   * @param intra_op_threads Threads used inside operators (0 lets ORT decide)
+   * @param max_batch_size Batch size reported for models with dynamic batch
+   */
+  explicit OnnxRuntimeBackend(const std::string &labels_file = "",
+                              int intra_op_threads = 0,
+                              int max_batch_size = 8);
+
+  void get_model_info(const std::string &model_name,
+                      ModelInfo &model_info) override;
+
+  std::vector<float> infer_logits(const std::vector<float> &input_data,
+                                  const std::string &model_name,
+                                  const ModelInfo &model_info,
+                                  const std::vector<int64_t> &shape) override;
+
+  using InferenceBackend::infer_logits_into;
+
+  void infer_logits_into(std::span<const float> input_data,
+                         const std::string &model_name,
+                         const ModelInfo &model_info,
+                         const std::vector<int64_t> &shape,
+                         std::vector<float> &logits) override;
+
+private:
+  struct ModelSession {
+    std::unique_ptr<Ort::Session> session;
+    std::unique_ptr<Ort::IoBinding> binding;
+    std::string input_name;
+    std::string output_name;
+    std::vector<int64_t> output_shape; ///< Output shape, batch dim excluded
+    std::vector<float> output_buffer;  ///< Preallocated output storage
+    Ort::Value output_tensor{nullptr}; ///< Tensor view over output_buffer
+    int64_t bound_batch = 0;           ///< Batch size output_buffer is sized for
+    std::mutex mutex;                  ///< IoBinding is not thread-safe
+  };
+
+  ModelSession &session_for(const std::string &model_path);
+  /// Runs the model into model.output_buffer; needs model.mutex held
+  void run(ModelSession &model, std::span<const float> input_data,
+           const ModelInfo &model_info, const std::vector<int64_t> &shape);
+  /// Runs the model without the binding, safe without model.mutex
+  void run_unbound(ModelSession &model, std::span<const float> input_data,
+                   const std::vector<int64_t> &shape,
+                   std::vector<float> &logits);
+
+  Ort::Env env_;
+  Ort::SessionOptions session_options_;
+  Ort::MemoryInfo memory_info_;
+  int max_batch_size_;
+  std::map<std::string, std::unique_ptr<ModelSession>> sessions_;
+  std::mutex sessions_mutex_;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "thread_pool.hpp"
+#include "video_processor.hpp"
+#include <functional>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings for ParallelVideoDecoder
+ */
+struct ParallelDecodeOptions {
+  size_t num_threads = 0; ///< Decoder threads, 0 for the hardware concurrency
+  size_t max_buffered_windows = 32; ///< Decoded windows held before decoders wait
+  bool convert_rgb = true;          ///< Convert frames from BGR to RGB
+  /// Optional index shared by all decoders for keyframe-aware seeking
+  std::shared_ptr<const VideoSeekIndex> seek_index;
+};
+
+/**
+ * @brief Decodes the windows of a long video concurrently
+ *
+ * The window list is cut into contiguous segments at window boundaries. Each
+ * decoder thread owns a VideoProcessor, seeks once to the start of a segment
+ * and decodes it sequentially, so only the first frame of a segment pays for
+ * a seek to the preceding keyframe. Windows are delivered to the caller in
+ * order; decoders running ahead block once max_buffered_windows are waiting,
+ * which bounds memory to roughly that many windows of frames.
+ */
+class ParallelVideoDecoder {
+public:
+  /**
+   * @brief Callback receiving one decoded window
+   * @param window_index Position of the window in the list passed to decode()
+   * @param window Frame indices and time span of the window
+   * @param frames Decoded frames; may be shorter than the window at the end
+   */
+  using WindowCallback =
+      std::function<void(size_t window_index,
+                         const VideoProcessor::WindowIndices &window,
+                         std::vector<cv::Mat> &frames)>;
+
+  /**
+   * @brief Starts the decoder threads
+   * @param video_path Path to the video file
+   * @param options Thread count and memory bound
+   */
+  explicit ParallelVideoDecoder(const std::string &video_path,
+                                const ParallelDecodeOptions &options = {});
+
+  /**
+   * @brief Decodes all windows and calls on_window for each, in order
+   *
+   * on_window runs on the calling thread while decoders keep working ahead.
+   *
+   * @param windows Windows from VideoProcessor::splitVideoIntoWindows()
+   * @param on_window Consumer of decoded windows
+   * @throws std::runtime_error if the video cannot be opened; exceptions from
+   *         on_window are rethrown after decoders stop
+   */
+  void decode(const std::vector<VideoProcessor::WindowIndices> &windows,
+              const WindowCallback &on_window);
+
+  size_t num_threads() const { return pool_.size(); }
+
+private:
+  std::string video_path_;
+  ParallelDecodeOptions options_;
+  ThreadPool pool_;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "inference_backend.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief One window matching a PredictionQuery
+ */
+struct PredictionHit {
+  std::string_view video; ///< Video path, valid while the index is open
+  float start_time;       ///< Window start in seconds
+  float end_time;         ///< Window end in seconds
+  float probability;      ///< Probability of the queried label
+};
+
+/**
+ * @brief Filters for PredictionIndex::query()
+ */
+struct PredictionQuery {
+  std::string label;           ///< Label to look up
+  float min_probability = 0.0f; ///< Smallest probability returned
+  std::string video;           ///< Only this video (empty for all)
+  double start_time = 0.0;     ///< Windows ending before this are skipped
+  /// Windows starting after this are skipped
+  double end_time = std::numeric_limits<double>::infinity();
+  size_t limit = 0;            ///< Maximum hits (0 for all)
+};
+
+/**
+ * @brief Accumulates per-window predictions and writes a PredictionIndex file
+ */
+class PredictionIndexWriter {
+public:
+  /**
+   * @brief Records the top-k predictions of one window
+   * @param video Video path
+   * @param start_time Window start in seconds
+   * @param end_time Window end in seconds
+   * @param predictions Top predictions of the window
+   */
+  void add_window(const std::string &video, double start_time,
+                  double end_time,
+                  const std::vector<InferenceBackend::InferenceResult>
+                      &predictions);
+
+  /**
+   * @brief Writes the index, replacing path atomically
+   *
+   * Concurrent writers to the same path do not corrupt it, but the last one
+   * wins; use merge_into() to add to an index other processes update too.
+   *
+   * @param path Output file
+   * @throws std::runtime_error if the file cannot be written
+   */
+  void write(const std::string &path) const;
+
+  /**
+   * @brief Adds these windows to the index at path, creating it if needed
+   *
+   * The read-modify-write is done under an exclusive lock on `path.lock`, so
+   * concurrent processes updating the same index do not lose each other's
+   * windows.
+   *
+   * @param path Index file
+   * @param replace_video Video whose windows already in the index are dropped,
+   *        e.g. because it is being re-indexed (empty to keep everything)
+   * @throws std::runtime_error if the index cannot be read, locked or written
+   */
+  void merge_into(const std::string &path,
+                  const std::string &replace_video = "") const;
+
+  size_t num_windows() const { return window_video_.size(); }
+
+private:
+  friend class PredictionIndex;
+
+  struct Posting {
+    uint32_t window;
+    float probability;
+  };
+
+  static uint32_t intern(const std::string &name,
+                         std::unordered_map<std::string, uint32_t> &ids,
+                         std::vector<std::string> &names);
+  void add_posting(uint32_t window, const std::string &label,
+                   float probability);
+
+  std::vector<std::string> videos_;
+  std::unordered_map<std::string, uint32_t> video_ids_;
+  std::vector<std::string> labels_;
+  std::unordered_map<std::string, uint32_t> label_ids_;
+  std::vector<uint32_t> window_video_;
+  std::vector<float> window_start_;
+  std::vector<float> window_end_;
+  std::vector<std::vector<Posting>> postings_; ///< Per label id
+};
+
+/**
+ * @brief Read-only, memory-mapped index of per-window predictions
+ *
+ * Windows are stored column by column (video id, start, end) and each label
+ * has a posting list of (window, probability) sorted by descending
+ * probability, so threshold queries stop at the first posting below the
+ * threshold and only touch the pages they need. The file is little-endian.
+ */
+class PredictionIndex {
+public:
+  /**
+   * @brief Maps an index file written by PredictionIndexWriter
+   * @param path Index file
+   * @throws std::runtime_error if the file is missing or malformed
+   */
+  explicit PredictionIndex(const std::string &path);
+  ~PredictionIndex();
+
+  PredictionIndex(const PredictionIndex &) = delete;
+  PredictionIndex &operator=(const PredictionIndex &) = delete;
+
+  /**
+   * @brief Finds windows where a label was predicted
+   * @param query Label, probability threshold, video and time filters
+   * @return Matching windows, by descending probability
+   */
+  std::vector<PredictionHit> query(const PredictionQuery &query) const;
+
+  /**
+   * @brief Copies windows into a writer, e.g. to extend the index
+   * @param writer Destination
+   * @param exclude_video Video whose windows are left out, e.g. because it is
+   *        being re-indexed (empty to copy everything)
+   */
+  void append_to(PredictionIndexWriter &writer,
+                 const std::string &exclude_video = "") const;
+
+  size_t num_windows() const { return num_windows_; }
+  size_t num_videos() const { return videos_.size(); }
+  const std::vector<std::string_view> &labels() const { return labels_; }
+
+private:
+  const unsigned char *data_ = nullptr;
+  size_t size_ = 0;
+  size_t num_windows_ = 0;
+  std::vector<std::string_view> videos_;
+  std::vector<std::string_view> labels_;
+  std::unordered_map<std::string_view, uint32_t> label_ids_;
+  const uint32_t *window_video_ = nullptr;
+  const float *window_start_ = nullptr;
+  const float *window_end_ = nullptr;
+  const uint64_t *posting_begin_ = nullptr; ///< num_labels + 1 entries
+  const uint32_t *posting_window_ = nullptr;
+  const float *posting_probability_ = nullptr;
+};
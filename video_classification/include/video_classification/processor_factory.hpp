@@ -0,0 +1,47 @@
+#pragma once
+#include "image_processor.hpp"
+#include <memory>
+#include <rapidjson/document.h>
+#include <string>
+
+/**
+ * @brief Loads model configuration from a JSON file
+ * @param config_path Path to the configuration file
+ * @param config Output RapidJSON document to store the configuration
+ * @throws std::runtime_error if file cannot be opened or parsed
+ */
+void load_config_from_file(const std::string &config_path,
+                           rapidjson::Document &config);
+
+/**
+ * @brief Creates image processor based on model type
+ * @param model_type Type of model ("videomae", "vivit", or "timesformer")
+ * @param config RapidJSON document with model configuration
+ * @return Unique pointer to the appropriate image processor
+ * @throws std::runtime_error if model type is unrecognized
+ */
+std::unique_ptr<ImageProcessor> create_processor(const std::string &model_type,
+                                                 const rapidjson::Document &config);
+
+/**
+ * @brief Guesses the model type from a Triton model name
+ * @param model_name Name of the model on Triton server
+ * @return "vivit", "timesformer", or "videomae" as fallback
+ */
+std::string detect_model_type(const std::string &model_name);
+
+/**
+ * @brief Resolves configuration and creates the processor for a model
+ *
+ * If @p config_file is set it is loaded and its "model_type" overrides
+ * @p model_type. Otherwise "auto" is resolved from @p model_name and
+ * configs/<model_type>.json is used, falling back to hardcoded defaults.
+ *
+ * @param config_file Path to the configuration file (may be empty)
+ * @param model_name Name of the model on Triton server
+ * @param model_type In/out model type, updated to the resolved type
+ * @return Unique pointer to the appropriate image processor
+ */
+std::unique_ptr<ImageProcessor> load_processor(const std::string &config_file,
+                                               const std::string &model_name,
+                                               std::string &model_type);
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A claimed shard, valid until its lease expires or is taken over
+ */
+struct ShardLease {
+  std::string shard; ///< Shard name, e.g. "shard-00003"
+  std::string path;  ///< Lease file owned by this worker
+};
+
+/**
+ * @brief Counts of shards in each state
+ */
+struct ShardQueueStatus {
+  size_t pending = 0;
+  size_t leased = 0;
+  size_t done = 0;
+};
+
+/**
+ * @brief Work queue of manifest shards on a shared filesystem
+ *
+ * Layout under the queue directory:
+ *   manifest.txt        all videos, in output order
+ *   pending/<shard>     video list of an unclaimed shard
+ *   leased/<shard>@<worker>  claimed shard; its mtime is the lease heartbeat
+ *   done/<shard>        finished shard
+ *   results/<shard>@<worker>.jsonl  one JSON line per finished video
+ *
+ * Every state change is a rename(), which is atomic, so of several workers
+ * racing for a shard exactly one wins. A lease whose file was not touched
+ * within the lease duration is expired and may be taken over by renaming it
+ * to the new owner; the previous owner notices on its next renew(). This
+ * includes expired leases held under this worker's own id, left by an earlier
+ * run that died, so a restarted worker resumes its own shards. Results
+ * are appended per worker and flushed after every video, so a worker that
+ * takes over a shard skips the videos already finished.
+ */
+class ShardQueue {
+public:
+  /**
+   * @brief Opens an existing queue
+   * @param queue_dir Directory created by create()
+   * @param worker_id Unique name of this worker, without '@' or '/'
+   * @param lease_duration Time after which an untouched lease expires
+   * @throws std::runtime_error if the queue does not exist or the id is invalid
+   */
+  ShardQueue(const std::string &queue_dir, const std::string &worker_id,
+             std::chrono::milliseconds lease_duration);
+
+  /**
+   * @brief Splits a manifest into pending shards
+   * @param queue_dir Directory to create
+   * @param videos Video paths, in output order
+   * @param shard_size Videos per shard
+   * @throws std::runtime_error if the queue already exists
+   */
+  static void create(const std::string &queue_dir,
+                     const std::vector<std::string> &videos,
+                     size_t shard_size);
+
+  /**
+   * @brief Claims a pending shard, or else takes over an expired lease
+   * @return The lease, or std::nullopt if no shard is available right now
+   */
+  std::optional<ShardLease> claim();
+
+  /**
+   * @brief Extends a lease
+   * @return false if the lease was lost to another worker
+   */
+  bool renew(const ShardLease &lease) const;
+
+  /**
+   * @brief Marks a leased shard as done
+   * @return false if the lease was lost to another worker
+   */
+  bool complete(const ShardLease &lease) const;
+
+  /**
+   * @brief Returns the videos of a shard
+   */
+  std::vector<std::string> shard_videos(const ShardLease &lease) const;
+
+  /**
+   * @brief Returns the videos of a shard any worker has recorded results for
+   */
+  std::set<std::string> completed_videos(const std::string &shard) const;
+
+  /**
+   * @brief Durably appends the result of one video
+   * @param lease Lease of the shard the video belongs to
+   * @param json_line Single-line JSON object with a "video" member
+   */
+  void record_result(const ShardLease &lease,
+                     const std::string &json_line) const;
+
+  /**
+   * @brief Writes all results as JSONL in manifest order
+   *
+   * Videos processed twice after a lease takeover are written once.
+   *
+   * @param output_path Output file, replaced atomically
+   * @return Number of videos without a result
+   */
+  size_t merge(const std::string &output_path) const;
+
+  ShardQueueStatus status() const;
+
+  const std::string &worker_id() const { return worker_id_; }
+
+  /**
+   * @brief Returns a default worker id made of host name and process id
+   */
+  static std::string default_worker_id();
+
+private:
+  std::string queue_dir_;
+  std::string worker_id_;
+  std::chrono::milliseconds lease_duration_;
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "inference_backend.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Service level of one stream
+ */
+struct StreamOptions {
+  std::string name;                     ///< Shown in statistics
+  int priority = 0;                     ///< Larger gets a bigger share of batches
+  std::chrono::milliseconds slo{2000};  ///< Deadline after submission
+  size_t max_queued = 8;                ///< Oldest windows are shed beyond this
+};
+
+/**
+ * @brief Settings of a StreamScheduler
+ */
+struct SchedulerOptions {
+  size_t max_batch_size = 0; ///< Windows per request, 0 for the model maximum
+  int top_k = 3;             ///< Predictions per window
+};
+
+/**
+ * @brief Per-stream outcome counts of a StreamScheduler
+ */
+struct StreamStats {
+  std::string name;
+  uint64_t submitted = 0; ///< Windows accepted by submit()
+  uint64_t on_time = 0;   ///< Classified before their deadline
+  uint64_t late = 0;      ///< Classified after their deadline
+  uint64_t shed = 0;      ///< Dropped because they could not make it
+  uint64_t failed = 0;    ///< Inference errors
+  int degradation = 0;    ///< Current level, see StreamScheduler::degradation()
+  double mean_latency_ms = 0.0; ///< Submission to result, classified windows
+
+  uint64_t deadline_misses() const { return late + shed; }
+};
+
+/**
+ * @brief Shares inference backends between many streams with latency SLOs
+ *
+ * Streams submit preprocessed windows; each gets a deadline of submission
+ * time plus the stream's SLO. One worker per backend repeatedly forms a
+ * batch earliest-deadline-first, but under contention a stream may first
+ * take only its share of the batch, proportional to 1 + priority; free slots
+ * then go to the remaining windows by deadline. So a heavy stream cannot
+ * starve the others, while an idle system still fills batches.
+ *
+ * Before each batch, windows whose deadline falls before the expected batch
+ * latency are shed rather than sent late. Streams that keep missing
+ * deadlines are degraded: at level n the producer should keep one window in
+ * 2^n, e.g. by sampling at a lower fps. A stream recovers one level after a
+ * run of windows without misses.
+ */
+class StreamScheduler {
+public:
+  enum class Outcome { OnTime, Late, Shed, Failed };
+
+  struct WindowResult {
+    Outcome outcome;
+    std::vector<InferenceBackend::InferenceResult> predictions; ///< Empty unless classified
+    std::chrono::milliseconds latency; ///< Submission to outcome
+    std::string error;                 ///< Set when inference failed
+  };
+
+  /// Runs on a scheduler worker, or on the submit() caller's thread for
+  /// windows shed there because the stream's queue is full; must not call
+  /// back into the scheduler
+  using Callback = std::function<void(const WindowResult &)>;
+
+  /**
+   * @brief Starts one worker per backend
+   * @param backends Backends used by one worker each, e.g. one TritonClient
+   *        per connection; must outlive the scheduler
+   * @param model_name Name or path identifying the model
+   * @param model_info Model metadata; one window is one batch entry
+   * @param options Batching settings
+   * @throws std::runtime_error if backends is empty
+   */
+  StreamScheduler(std::vector<InferenceBackend *> backends,
+                  const std::string &model_name, const ModelInfo &model_info,
+                  const SchedulerOptions &options = {});
+
+  /**
+   * @brief Classifies everything still queued and stops the workers
+   */
+  ~StreamScheduler();
+
+  StreamScheduler(const StreamScheduler &) = delete;
+  StreamScheduler &operator=(const StreamScheduler &) = delete;
+
+  /**
+   * @brief Registers a stream
+   * @return Stream id for submit()
+   */
+  size_t add_stream(const StreamOptions &options);
+
+  /**
+   * @brief Queues one preprocessed window of a stream
+   * @param stream Id from add_stream()
+   * @param pixel_values Model input of a single window
+   * @param on_done Receives the predictions or the reason there are none.
+   *        Windows shed because the stream already has max_queued waiting
+   *        are reported before submit() returns, on the calling thread.
+   */
+  void submit(size_t stream, std::vector<float> pixel_values,
+              Callback on_done);
+
+  /**
+   * @brief Returns how far a stream should thin out its windows
+   * @return Level n: keep one window in 2^n
+   */
+  int degradation(size_t stream) const;
+
+  /**
+   * @brief Blocks until every submitted window has an outcome
+   */
+  void wait_idle();
+
+  std::vector<StreamStats> stats() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Pending {
+    size_t stream;
+    uint64_t sequence;
+    Clock::time_point submitted;
+    Clock::time_point deadline;
+    std::vector<float> pixel_values;
+    Callback on_done;
+  };
+
+  struct Stream {
+    StreamOptions options;
+    StreamStats stats;
+    size_t queued = 0;
+    double total_latency_ms = 0.0;
+    std::deque<bool> recent_misses; ///< Outcomes since the level last changed
+  };
+
+  void run_worker(InferenceBackend *backend);
+  std::vector<Pending> take_batch(std::vector<Pending> &shed);
+  void record_outcome(Stream &stream, Outcome outcome, double latency_ms);
+
+  std::string model_name_;
+  ModelInfo model_info_;
+  size_t max_batch_size_;
+  int top_k_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable idle_cv_;
+  std::vector<Stream> streams_;
+  std::vector<Pending> queue_;
+  uint64_t next_sequence_ = 0;
+  size_t in_flight_ = 0;
+  double batch_ms_ = 0.0; ///< Moving average of batch latency, 0 until known
+  bool stop_ = false;
+  std::vector<std::thread> workers_; // Last, so they start after the state
+};
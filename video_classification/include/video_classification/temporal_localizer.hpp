@@ -0,0 +1,101 @@
+#pragma once
+
+#include "image_processor.hpp"
+#include "inference_backend.hpp"
+#include "video_processor.hpp"
+#include "video_seek_index.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Settings of the two localization passes
+ *
+ * Strides count sampled frames between window starts; 0 picks the default.
+ */
+struct LocalizationOptions {
+  std::string target_label;      ///< Label whose occurrences are localized
+  float coarse_fps = 0.25f;      ///< Sampling rate of the first pass
+  int coarse_stride = 0;         ///< First-pass stride, default one window
+  float fine_fps = 1.0f;         ///< Sampling rate of the second pass
+  int fine_stride = 0;           ///< Second-pass stride, default half a window
+  float coarse_threshold = 0.2f; ///< Coarse windows at or above are re-examined
+  float fine_threshold = 0.5f;   ///< Fine windows at or above are reported
+  size_t decode_threads = 0;     ///< Decoder threads, 0 for all cores
+};
+
+/**
+ * @brief A time span of a video, in seconds
+ */
+struct TimeSpan {
+  double start = 0.0;
+  double end = 0.0;
+  float probability = 0.0f; ///< Highest target probability inside the span
+};
+
+/**
+ * @brief Finds where an action happens with a coarse and a fine pass
+ *
+ * The first pass classifies windows sampled at a low rate, so each covers a
+ * long stretch of video. Segments whose target probability reaches the coarse
+ * threshold, widened by one coarse sample interval on each side, are
+ * classified again at the fine rate with overlapping windows, and fine
+ * windows reaching the fine threshold are merged into intervals. Frames
+ * shared by overlapping windows are decoded once.
+ */
+class TemporalLocalizer {
+public:
+  struct Result {
+    std::vector<TimeSpan> intervals; ///< Localized occurrences, in time order
+    double fine_fraction = 0.0;      ///< Share of the video given a fine pass
+    size_t coarse_windows = 0;       ///< Windows classified by the first pass
+    size_t fine_windows = 0;         ///< Windows classified by the second pass
+  };
+
+  /**
+   * @param client Backend running the model
+   * @param processor Preprocessor of the model
+   * @param model_name Name or path identifying the model
+   * @param model_info Model metadata; input_t_ sets the window size
+   * @param options Pass settings
+   * @throws std::runtime_error if the target label is unknown to the client
+   */
+  TemporalLocalizer(InferenceBackend &client, ImageProcessor &processor,
+                    const std::string &model_name, const ModelInfo &model_info,
+                    const LocalizationOptions &options);
+
+  /**
+   * @brief Localizes the target label in a video
+   * @param video_path Path to the video file
+   * @param seek_index Optional keyframe index of the video
+   * @throws std::runtime_error if the video cannot be opened
+   */
+  Result localize(const std::string &video_path,
+                  std::shared_ptr<const VideoSeekIndex> seek_index = nullptr);
+
+  /**
+   * @brief Merges spans that overlap or lie within max_gap of each other
+   * @return Merged spans in time order, keeping the highest probability
+   */
+  static std::vector<TimeSpan> merge_spans(std::vector<TimeSpan> spans,
+                                           double max_gap = 0.0);
+
+private:
+  struct ScoredWindow {
+    double start_time;
+    double end_time;
+    float probability;
+  };
+
+  std::vector<ScoredWindow>
+  score_windows(const std::string &video_path,
+                const std::shared_ptr<const VideoSeekIndex> &seek_index,
+                const std::vector<VideoProcessor::WindowIndices> &windows);
+
+  InferenceBackend &client_;
+  ImageProcessor &processor_;
+  std::string model_name_;
+  ModelInfo model_info_;
+  LocalizationOptions options_;
+  size_t target_index_;
+};
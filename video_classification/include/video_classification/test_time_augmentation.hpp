@@ -0,0 +1,38 @@
+#pragma once
+
+#include "image_processor.hpp"
+#include "inference_backend.hpp"
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Multi-view evaluation settings (temporal clips x spatial crops)
+ */
+struct TtaOptions {
+  int num_clips = 1; ///< Temporal clips sampled across the video
+  int num_crops = 3; ///< Spatial crops per clip
+};
+
+/**
+ * @brief Classifies every clip x crop view and averages the logits
+ *
+ * Views are packed into batched requests of up to the model's
+ * max_batch_size_ (one view per request for models without batching), so a
+ * 4 x 3 evaluation on a model with max_batch_size_ >= 12 costs a single
+ * request.
+ *
+ * @param backend Inference backend
+ * @param processor Processor providing process_multi_crop()
+ * @param model_name Name or path identifying the model
+ * @param model_info Model metadata
+ * @param clips Temporal clips of RGB frames, all of the same length
+ * @param num_crops Spatial crops per clip
+ * @return Logits averaged over all views
+ */
+std::vector<float> classify_multi_view(InferenceBackend &backend,
+                                       const ImageProcessor &processor,
+                                       const std::string &model_name,
+                                       const ModelInfo &model_info,
+                                       const std::vector<std::vector<cv::Mat>> &clips,
+                                       int num_crops);
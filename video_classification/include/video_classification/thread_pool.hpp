@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Fixed-size pool of worker threads executing queued tasks in order
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Starts the worker threads
+   * @param num_threads Number of workers (at least one is started)
+   */
+  explicit ThreadPool(size_t num_threads);
+
+  /**
+   * @brief Finishes all queued tasks and joins the workers
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Queues a task for execution
+   * @param task Callable run on one of the workers; exceptions are swallowed
+   */
+  void submit(std::function<void()> task);
+
+  /**
+   * @brief Blocks until the queue is empty and no task is running
+   */
+  void wait_idle();
+
+  size_t size() const { return workers_.size(); }
+
+private:
+  void worker_loop();
+
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable task_cv_;
+  std::condition_variable idle_cv_;
+  size_t active_ = 0;
+  bool stopping_ = false;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Arguments attached to a trace event, shown in the viewer's details
+ *
+ * Unset fields are left out of the trace.
+ */
+struct TraceArgs {
+  std::string_view video = {};   ///< Video path
+  int64_t window = -1;           ///< Window index
+  int64_t frame = -1;            ///< Frame index
+  std::string_view request = {}; ///< Request id
+};
+
+/**
+ * @brief Process-wide recorder of Chrome trace-event timelines
+ *
+ * Each thread appends to its own chunked buffer without locking; chunks are
+ * published with a release store so write() can read them while threads keep
+ * running. Strings in TraceArgs are interned in a shared table the first
+ * time a thread sees them and looked up in a per-thread cache afterwards, so
+ * only new videos and request ids take a lock. Disabled, a trace
+ * scope costs one relaxed atomic load. The output loads in Perfetto
+ * (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Use the TRACE_SCOPE macro rather than TraceScope directly, so that builds
+ * without VIDEO_CLASSIFICATION_WITH_TRACING contain no tracing code at all.
+ * A process records a single session: events are kept until exit.
+ */
+class Tracer {
+public:
+  /**
+   * @brief Starts recording events
+   */
+  static void start();
+
+  static bool enabled() noexcept {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Stops recording and writes all events as trace-event JSON
+   * @param path Output file
+   * @throws std::runtime_error if the file cannot be written
+   */
+  static void write(const std::string &path);
+
+  /**
+   * @brief Returns nanoseconds on the steady clock used for event times
+   */
+  static uint64_t now_ns() noexcept;
+
+  /**
+   * @brief Records a span that began and ended on the calling thread
+   */
+  static void record(const char *name, uint64_t start_ns, uint64_t end_ns,
+                     const TraceArgs &args);
+
+  /**
+   * @brief Records a span that may overlap others on the same thread, e.g. an
+   *        asynchronous request completed on a callback thread
+   * @param id Identifier distinguishing concurrent spans of the same name
+   */
+  static void record_async(const char *name, uint64_t id, uint64_t start_ns,
+                           uint64_t end_ns, const TraceArgs &args);
+
+private:
+  static std::atomic<bool> enabled_;
+};
+
+/**
+ * @brief Records the lifetime of a scope as one trace event
+ *
+ * The name must be a string literal; args must stay valid until the scope
+ * ends.
+ */
+class TraceScope {
+public:
+  explicit TraceScope(const char *name, const TraceArgs &args = {}) noexcept
+      : name_(name), args_(args),
+        start_ns_(Tracer::enabled() ? Tracer::now_ns() : 0) {}
+
+  ~TraceScope() {
+    if (start_ns_ != 0) {
+      Tracer::record(name_, start_ns_, Tracer::now_ns(), args_);
+    }
+  }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+  const char *name_;
+  TraceArgs args_;
+  uint64_t start_ns_;
+};
+
+#define VC_TRACE_CONCAT_INNER(a, b) a##b
+#define VC_TRACE_CONCAT(a, b) VC_TRACE_CONCAT_INNER(a, b)
+
+#ifdef VIDEO_CLASSIFICATION_WITH_TRACING
+/// Traces the enclosing scope, e.g. TRACE_SCOPE("decode", .window = w)
+#define TRACE_SCOPE(name, ...)                                                 \
+  TraceScope VC_TRACE_CONCAT(trace_scope_, __LINE__)(name,                      \
+                                                     TraceArgs{__VA_ARGS__})
+#define TRACE_ENABLED() Tracer::enabled()
+#else
+#define TRACE_SCOPE(name, ...) static_cast<void>(0)
+#define TRACE_ENABLED() false
+#endif
@@ -1,75 +1,208 @@
 #pragma once
 
+#include "inference_backend.hpp"
 #include "json_utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <http_client.h>
-#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <rapidjson/document.h>
 #include <string>
 #include <vector>
 
 /**
- * @brief Holds metadata and configuration for a Triton model
+ * @brief Load balancing, ejection and hedging settings for TritonClient
  */
-struct ModelInfo {
-  std::string output_name_;      ///< Name of the output tensor
-  std::string input_name_;       ///< Name of the input tensor
-  std::string input_datatype_;   ///< Data type of input (e.g., "FP32")
-  int input_c_;                  ///< Number of input channels
-  int input_h_;                  ///< Input height
-  int input_w_;                  ///< Input width
-  std::string input_format_;     ///< Input format ("FORMAT_NCHW" or "FORMAT_NHWC")
-  int type1_;                    ///< OpenCV type for single channel (e.g., CV_32FC1)
-  int type3_;                    ///< OpenCV type for three channels (e.g., CV_32FC3)
-  int max_batch_size_;           ///< Maximum batch size supported by model
+struct TritonRoutingOptions {
+  int max_consecutive_failures = 3; ///< Failures before an endpoint is ejected
+  std::chrono::milliseconds eject_cooldown{10000}; ///< Wait before re-probing
+  /// Wait at startup for readiness probes; unanswered replicas start ejected
+  std::chrono::milliseconds probe_timeout{1000};
+  double hedge_quantile = 0.95;  ///< Latency quantile used as hedge deadline
+  size_t min_hedge_samples = 20; ///< Latency samples required before hedging
+  size_t latency_window = 256;   ///< Recent latencies kept per endpoint
+};
+
+/**
+ * @brief Snapshot of one endpoint's routing statistics
+ */
+struct EndpointStats {
+  std::string url;        ///< Server URL
+  bool healthy = true;    ///< False while ejected
+  size_t outstanding = 0; ///< Requests currently in flight
+  uint64_t requests = 0;  ///< Requests sent, including hedges
+  uint64_t failures = 0;  ///< Requests that failed
+  uint64_t hedges = 0;    ///< Hedged duplicates sent to this endpoint
+  uint64_t hedge_wins = 0; ///< Hedged duplicates that answered first
+  double p50_ms = 0.0;    ///< Median latency over the recent window
+  double p95_ms = 0.0;    ///< 95th percentile latency over the recent window
 };
 
 /**
  * @brief Client for interacting with Triton Inference Server
+ *
+ * Accepts one or more replicas of the same model. Each request goes to the
+ * healthy endpoint with the fewest requests in flight. Endpoints that fail
+ * repeatedly are ejected and re-admitted after a readiness probe, which runs
+ * on a background thread per replica so that a replica that never answers
+ * cannot stall requests or startup. When a
+ * request outlives the endpoint's recent p95 latency, a duplicate is sent to
+ * another replica and whichever answers first is used.
+ *
+ * Requests run on pooled contexts that keep their Triton input, output and
+ * options objects and buffers across calls, so once warmed up the client
+ * itself does not allocate per request; see infer_logits_into().
  */
-class TritonClient {
+class TritonClient : public InferenceBackend {
 public:
-  struct InferenceResult {
-    std::string label;     ///< Human-readable label
-    float probability;     ///< Prediction probability (0.0 to 1.0)
-  };
-
   /**
    * @brief Constructs a Triton client
-   * @param server_url URL of the Triton server (e.g., "http://localhost:8000")
+   * @param server_url URL of the Triton server (e.g., "http://localhost:8000"),
+   *        or a comma-separated list of replica URLs
    * @param labels_file Optional path to file containing class labels
+   * @param routing Load balancing and hedging settings
    */
   TritonClient(const std::string &server_url,
-               const std::string &labels_file = "");
+               const std::string &labels_file = "",
+               const TritonRoutingOptions &routing = {});
 
   /**
-   * @brief Performs inference on the given input data
+   * @brief Constructs a client balancing over several Triton replicas
+   * @param server_urls URLs of servers hosting the same models
+   * @param labels_file Optional path to file containing class labels
+   * @param routing Load balancing and hedging settings
+   * @throws std::runtime_error if server_urls is empty
+   */
+  TritonClient(const std::vector<std::string> &server_urls,
+               const std::string &labels_file = "",
+               const TritonRoutingOptions &routing = {});
+
+  ~TritonClient() override;
+
+  /**
+   * @brief Performs inference and returns the raw output logits
    * @param input_data Preprocessed input data as float vector
    * @param model_name Name of the model on Triton server
    * @param model_info Model metadata
    * @param shape Shape of the input tensor
-   * @return Vector of top predictions with labels and probabilities
+   * @return Flattened output logits, batch-major for batched inputs
    */
-  std::vector<InferenceResult> infer(const std::vector<float> &input_data,
-                                     const std::string &model_name,
-                                     const ModelInfo &model_info,
-                                     const std::vector<int64_t> &shape);
+  std::vector<float> infer_logits(const std::vector<float> &input_data,
+                                  const std::string &model_name,
+                                  const ModelInfo &model_info,
+                                  const std::vector<int64_t> &shape) override;
+
+  /**
+   * @brief Performs inference writing the logits into a caller buffer
+   *
+   * Without hedging the input is sent straight from input_data; with several
+   * replicas it is copied once into the request context, because a losing
+   * attempt may still be uploading after this call returns. The winning
+   * response is copied directly into logits.
+   *
+   * @param input_data Preprocessed input data
+   * @param model_name Name of the model on Triton server
+   * @param model_info Model metadata
+   * @param shape Shape of the input tensor
+   * @param logits Output buffer, batch-major for batched inputs
+   * @return Number of logits written
+   * @throws std::runtime_error if inference fails or logits is too small
+   */
+  size_t infer_logits_into(std::span<const float> input_data,
+                           const std::string &model_name,
+                           const ModelInfo &model_info,
+                           const std::vector<int64_t> &shape,
+                           std::span<float> logits) override;
+
+  /**
+   * @brief Performs inference into a buffer reused across calls
+   *
+   * The winning response is copied straight into logits, which only
+   * reallocates when the output is larger than any before.
+   *
+   * @throws std::runtime_error if inference fails
+   */
+  void infer_logits_into(std::span<const float> input_data,
+                         const std::string &model_name,
+                         const ModelInfo &model_info,
+                         const std::vector<int64_t> &shape,
+                         std::vector<float> &logits) override;
 
   /**
    * @brief Retrieves model metadata and configuration
    * @param model_name Name of the model on Triton server
    * @param model_info Output parameter to store model information
    */
-  void get_model_info(const std::string &model_name, ModelInfo &model_info);
+  void get_model_info(const std::string &model_name,
+                      ModelInfo &model_info) override;
+
+  /**
+   * @brief Returns per-endpoint routing statistics
+   */
+  std::vector<EndpointStats> endpoint_stats() const;
 
 private:
-  std::vector<InferenceResult>
-  postprocess_results(const std::vector<float> &logits);
+  struct Prober;
+
+  struct Endpoint {
+    std::string url;
+    std::mutex mutex; ///< Guards the counters below
+    size_t outstanding = 0;
+    uint64_t requests = 0;
+    uint64_t failures = 0;
+    uint64_t hedges = 0;
+    uint64_t hedge_wins = 0;
+    int consecutive_failures = 0;
+    bool ejected = false;
+    std::chrono::steady_clock::time_point ejected_until;
+    std::vector<double> latencies_ms; ///< Ring buffer of recent latencies
+    size_t next_latency = 0;          ///< Slot the next latency overwrites
+    std::vector<double> latency_scratch; ///< Reused by quantile queries
+    std::shared_ptr<Prober> prober; ///< Readiness probes, with several replicas
+
+    std::mutex sync_mutex; ///< Serializes synchronous calls on sync_client
+    // Declared last so they are destroyed first: their destructors wait for
+    // in-flight callbacks, which update the fields above
+    std::unique_ptr<triton::client::InferenceServerHttpClient> sync_client;
+    std::unique_ptr<triton::client::InferenceServerHttpClient> async_client;
+  };
+
+  struct RequestContext;
+  struct Attempt;
+
   static void parse_model_http(const rapidjson::Document &model_metadata,
                                const rapidjson::Document &model_config,
                                const size_t batch_size, ModelInfo *model_info);
-  void load_labels(const std::string &labels_file);
 
-  std::unique_ptr<triton::client::InferenceServerHttpClient> http_client_;
-  std::map<std::string, std::string> id2label_;
+  static void run_prober(std::shared_ptr<Prober> prober);
+  static void request_probe(Prober &prober);
+  static void record_outcome(Endpoint &endpoint,
+                             const TritonRoutingOptions &routing, bool success,
+                             double latency_ms);
+  Endpoint *select_endpoint(const Endpoint *exclude);
+  bool is_available(Endpoint &endpoint);
+  std::optional<std::chrono::microseconds> hedge_delay(Endpoint &endpoint);
+  RequestContext &acquire_context();
+  void finish_context(RequestContext &context);
+  size_t run_request(RequestContext &context, const float *input_data,
+                     size_t input_size, const std::string &model_name,
+                     const ModelInfo &model_info,
+                     const std::vector<int64_t> &shape,
+                     std::span<float> logits, std::vector<float> *output);
+  void send_attempt(Endpoint &endpoint, RequestContext &context,
+                    const ModelInfo &model_info,
+                    const std::vector<int64_t> &shape, bool hedge);
+  void complete_attempt(Attempt &attempt, triton::client::InferResult *result);
+
+  TritonRoutingOptions routing_;
+  // Contexts outlive the endpoints, whose clients drain pending callbacks
+  std::mutex contexts_mutex_;
+  std::vector<std::unique_ptr<RequestContext>> contexts_;
+  std::vector<RequestContext *> free_contexts_;
+  std::vector<std::unique_ptr<Endpoint>> endpoints_;
+  std::atomic<size_t> next_endpoint_{0};
 };
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "inference_backend.hpp"
+#include "video_utils.hpp"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Perceptual fingerprint of the window a video is classified from
+ *
+ * A 64-bit difference hash (dHash) of each of a few frames spread evenly over
+ * the decoded classification window, plus the video's duration. Each hash
+ * compares neighbouring pixels of a 9x8 grayscale thumbnail, so it survives
+ * re-encoding, rescaling and small color shifts, and the window is sampled by
+ * time, which keeps frames aligned across frame rates. Videos with matching
+ * windows get the same predictions, and hashing frames that are decoded for
+ * classification anyway costs no extra decoding.
+ */
+struct VideoFingerprint {
+  static constexpr size_t NUM_FRAMES = 8;
+
+  std::array<uint64_t, NUM_FRAMES> frame_hashes{}; ///< dHash per sampled frame
+  double duration = 0.0;                           ///< Seconds
+
+  /**
+   * @brief Hashes frames already decoded for classification
+   * @param frames Frames of the classification window, see read_video_frames()
+   * @param color_format Pixel layout of the frames
+   * @param duration Duration of the video in seconds
+   * @throws std::runtime_error if frames is empty
+   */
+  static VideoFingerprint from_frames(const std::vector<cv::Mat> &frames,
+                                      FrameColorFormat color_format,
+                                      double duration);
+
+  /**
+   * @brief Computes the difference hash of one frame
+   * @param frame Grayscale, or three-channel BGR or RGB frame
+   * @param rgb True if a three-channel frame is RGB
+   */
+  static uint64_t dhash(const cv::Mat &frame, bool rgb = false);
+
+  /**
+   * @brief Returns the number of differing bits over all frame hashes
+   */
+  int distance(const VideoFingerprint &other) const;
+};
+
+/**
+ * @brief Fingerprints of classified videos with their predictions
+ *
+ * Entries are appended to a JSON-lines file, one per video, so several
+ * processes can share it: a lookup that finds no match reads the entries
+ * other processes appended since and tries again. Lookups scan every
+ * entry, comparing hashes with popcount and stopping at the first frame
+ * that exceeds the distance budget; that takes about a millisecond for the
+ * hundred thousand entries of a large ingest. All methods are thread-safe.
+ */
+class FingerprintIndex {
+public:
+  struct Match {
+    std::string video; ///< Previously classified video
+    int distance;      ///< Differing fingerprint bits
+    std::vector<InferenceBackend::InferenceResult> predictions; ///< Stored top predictions
+  };
+
+  /**
+   * @brief Opens or creates the index file
+   * @param path JSON-lines file
+   * @param max_distance Largest fingerprint distance counted as a duplicate
+   * @throws std::runtime_error if the file cannot be created
+   */
+  FingerprintIndex(const std::string &path, int max_distance);
+
+  /**
+   * @brief Finds the closest stored video within max_distance
+   *
+   * Durations must also agree, within a second or 2 percent.
+   */
+  std::optional<Match> find(const VideoFingerprint &fingerprint);
+
+  /**
+   * @brief Stores the predictions of a newly classified video
+   * @throws std::runtime_error if the entry cannot be written
+   */
+  void add(const std::string &video, const VideoFingerprint &fingerprint,
+           const std::vector<InferenceBackend::InferenceResult> &predictions);
+
+  size_t size() const;
+
+private:
+  struct Entry {
+    std::string video;
+    VideoFingerprint fingerprint;
+    std::vector<InferenceBackend::InferenceResult> predictions;
+  };
+
+  void read_new_entries();
+  std::optional<Match> find_loaded(const VideoFingerprint &fingerprint) const;
+
+  std::string path_;
+  int max_distance_;
+  mutable std::mutex mutex_;
+  std::vector<Entry> entries_;
+  uint64_t read_offset_ = 0; ///< Bytes of the file already loaded
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "video_seek_index.hpp"
+#include <memory>
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <string>
@@ -21,14 +23,43 @@ public:
     VideoProcessor();
     ~VideoProcessor();
 
-    bool openVideo(const std::string& videoPath);
+    /**
+     * @brief Opens a video
+     * @param videoPath Path to the video file
+     * @param seekIndex Optional index providing exact frame count and times
+     *        and keyframe-aware seeking
+     */
+    bool openVideo(const std::string& videoPath,
+                   std::shared_ptr<const VideoSeekIndex> seekIndex = nullptr);
     VideoInfo getVideoInfo() const;
     std::vector<WindowIndices> splitVideoIntoWindows(int windowSize, float samplingFps) const;
+    /**
+     * @brief Splits a time range into windows of sampled frames
+     * @param windowSize Sampled frames per window
+     * @param samplingFps Frames sampled per second of video
+     * @param stride Sampled frames between window starts; windows overlap when
+     *        it is smaller than windowSize
+     * @param startTime First time sampled, in seconds
+     * @param endTime Last time sampled, in seconds
+     *
+     * When the stride does not reach the last sampled frame, a final window
+     * ending on it is added, so the end of the range is always covered.
+     */
+    std::vector<WindowIndices> splitVideoIntoWindows(int windowSize, float samplingFps,
+                                                     int stride, double startTime,
+                                                     double endTime) const;
     std::vector<cv::Mat> extractFrames(const std::vector<int>& indices);
     std::vector<float> preprocessFrames(const std::vector<cv::Mat>& frames, int targetSize = 224);
     std::vector<cv::Mat> padVideoFrames(const std::vector<cv::Mat>& frames, int targetLength);
 
 private:
+    std::vector<WindowIndices> splitWindows(int windowSize, float samplingFps,
+                                            int stride, double startTime,
+                                            double endTime, bool coverEnd) const;
+
     cv::VideoCapture cap;
+    std::string path; // Shown in trace events
     VideoInfo info;
+    std::shared_ptr<const VideoSeekIndex> seekIndex;
+    int nextFrame = 0; // Index of the frame the next grab() returns
 };
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <opencv2/opencv.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Frame count, timestamps and keyframe positions of a video
+ *
+ * Built once by scanning the container's packets without decoding them and
+ * cached in an index directory under the hash of the video file, so later
+ * jobs over the same corpus skip the scan. CAP_PROP_FRAME_COUNT and
+ * CAP_PROP_FPS are estimates derived from the container header; the index
+ * holds the actual number of frames and each frame's presentation time, which
+ * also makes variable-frame-rate videos sample correctly by time.
+ *
+ * Seeks go by presentation time, see seek(): OpenCV resolves
+ * CAP_PROP_POS_FRAMES by multiplying with the nominal frame rate, which lands
+ * on the wrong frame of a variable-frame-rate video.
+ *
+ * Knowing the group-of-pictures structure lets readers decide whether a seek
+ * pays off: decoding forward is cheaper as long as no keyframe lies between
+ * the current position and the frame a seek would start decoding from.
+ */
+class VideoSeekIndex {
+public:
+  /**
+   * @brief Creates an index from scanned data
+   * @param file_hash Hash of the video file, see hash_file()
+   * @param nominal_fps Frame rate reported by the container
+   * @param frame_times Presentation time of each frame in seconds as
+   *        CAP_PROP_POS_MSEC reports it; the first need not be zero
+   * @param keyframes Frame numbers of keyframes, ascending; empty if unknown
+   */
+  VideoSeekIndex(uint64_t file_hash, double nominal_fps,
+                 std::vector<double> frame_times, std::vector<int> keyframes);
+
+  /**
+   * @brief Scans a video's packets without decoding
+   * @param video_path Path to the video file
+   * @throws std::runtime_error if the video cannot be opened or has no frames
+   */
+  static VideoSeekIndex build(const std::string &video_path);
+
+  /**
+   * @brief Loads the cached index of a video, building and caching it if
+   *        missing or stale
+   *
+   * A cache that cannot be written is reported as a warning and the index is
+   * still returned.
+   *
+   * @param video_path Path to the video file
+   * @param index_dir Directory of cached indexes, created if needed
+   * @throws std::runtime_error if the video cannot be indexed
+   */
+  static std::shared_ptr<const VideoSeekIndex>
+  load_or_build(const std::string &video_path, const std::string &index_dir);
+
+  /**
+   * @brief Reads an index file
+   * @param path Index file
+   * @param file_hash Expected hash of the video
+   * @return The index, or std::nullopt if the file is missing, malformed or
+   *         belongs to another video
+   */
+  static std::optional<VideoSeekIndex> load(const std::string &path,
+                                            uint64_t file_hash);
+
+  /**
+   * @brief Writes the index, replacing path atomically
+   * @throws std::runtime_error if the file cannot be written
+   */
+  void save(const std::string &path) const;
+
+  /**
+   * @brief Hashes the size and the first and last MiB of a file
+   * @throws std::runtime_error if the file cannot be read
+   */
+  static uint64_t hash_file(const std::string &path);
+
+  int frame_count() const { return static_cast<int>(frame_ms_.size()); }
+  double duration() const;
+  double fps() const;
+  double frame_time(int frame) const;
+
+  /**
+   * @brief Returns the first frame presented at or after a time
+   * @param seconds Time from the first frame
+   * @return Frame number, or frame_count() if the video ends before
+   */
+  int frame_at_time(double seconds) const;
+
+  bool has_keyframes() const { return !keyframes_.empty(); }
+
+  /**
+   * @brief Returns the last keyframe at or before a frame
+   */
+  int keyframe_before(int frame) const;
+
+  /**
+   * @brief Tells whether seeking to target is cheaper than decoding forward
+   * @param position Frame the capture returns next
+   * @param target Frame to read
+   */
+  bool should_seek(int position, int target) const;
+
+  /**
+   * @brief Seeks a capture by presentation time to shortly before a frame
+   *
+   * OpenCV rounds the time to the nominal frame rate, so the seek aims one
+   * nominal interval early and the caller grabs forward, locating each
+   * grabbed frame with grabbed_frame().
+   *
+   * @return Frame the next grab() is expected to return
+   */
+  int seek(cv::VideoCapture &cap, int frame) const;
+
+  /**
+   * @brief Returns the frame a capture grabbed last, from its timestamp
+   * @param cap Capture positioned by grab() or read()
+   * @param expected Frame to assume if the timestamp matches no frame
+   */
+  int grabbed_frame(const cv::VideoCapture &cap, int expected) const;
+
+  bool variable_frame_rate() const;
+
+  uint64_t file_hash() const { return file_hash_; }
+
+  /**
+   * @brief Returns the presentation time of the first frame in seconds
+   */
+  double start_time() const { return start_ms_ / 1000.0; }
+
+private:
+  uint64_t file_hash_;
+  double nominal_fps_;
+  uint32_t start_ms_ = 0; ///< Presentation time of the first frame
+  std::vector<uint32_t> frame_ms_; ///< Presentation times from the first frame
+  std::vector<uint32_t> keyframes_;
+};
@@ -1,17 +1,62 @@
 #pragma once
+#include "video_seek_index.hpp"
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <vector>
 
+/**
+ * @brief Pixel layout of decoded frames.
+ */
+enum class FrameColorFormat {
+  RGB,    ///< 8-bit interleaved RGB (CV_8UC3)
+  YUV420, ///< Planar I420 as one CV_8UC1 Mat of height * 3 / 2 rows
+};
+
 /**
  * @brief Reads frames from a video file, sampling at 1 FPS.
  *
+ * With FrameColorFormat::YUV420 the frames keep the decoder's native planar
+ * layout and no color conversion is done; use
+ * ImageProcessor::process_yuv420() to convert only the pixels that survive
+ * resize and crop. This path decodes through GStreamer and reads the video
+ * forward from the start instead of seeking.
+ *
+ * With a seek index, frames are picked by presentation time and the capture
+ * only seeks when a keyframe makes it cheaper than decoding forward; without
+ * one, every sampled frame is seeked to.
+ *
  * @param video_path Path to the video file.
  * @param target_frames Maximum number of frames/seconds to read.
- * @return std::vector<cv::Mat> Vector of read frames (RGB).
+ * @param color_format Pixel layout of the returned frames.
+ * @param seek_index Optional index of the video, see VideoSeekIndex.
+ * @param duration Optional output set to the length of the whole video in
+ *                 seconds, or 0 if the capture does not report it.
+ * @return std::vector<cv::Mat> Vector of read frames.
+ */
+std::vector<cv::Mat>
+read_video_frames(const std::string &video_path, int target_frames,
+                  FrameColorFormat color_format = FrameColorFormat::RGB,
+                  const VideoSeekIndex *seek_index = nullptr,
+                  double *duration = nullptr);
+
+/**
+ * @brief Reads several temporal clips spread uniformly over a video.
+ *
+ * Each clip holds @p clip_length frames sampled at 1 FPS, like
+ * read_video_frames(). Clip start times are evenly spaced so the first clip
+ * starts at the beginning and the last one ends at the end of the video;
+ * frames shared by overlapping clips are decoded once. Short clips are padded
+ * by duplicating their last frame.
+ *
+ * @param video_path Path to the video file.
+ * @param clip_length Number of frames per clip.
+ * @param num_clips Number of clips.
+ * @param seek_index Optional index of the video, see VideoSeekIndex.
+ * @return std::vector<std::vector<cv::Mat>> Clips of RGB frames.
  */
-std::vector<cv::Mat> read_video_frames(const std::string &video_path,
-                                       int target_frames);
+std::vector<std::vector<cv::Mat>>
+read_video_clips(const std::string &video_path, int clip_length, int num_clips,
+                 const VideoSeekIndex *seek_index = nullptr);
 
 /**
  * @brief Pads a sequence of frames to a target length by duplicating the last
@@ -23,3 +68,16 @@ std::vector<cv::Mat> read_video_frames(const std::string &video_path,
  */
 std::vector<cv::Mat> pad_video_frames(const std::vector<cv::Mat> &frames,
                                       int target_length);
+
+/**
+ * @brief Picks evenly spaced frames from a window.
+ *
+ * Frames share pixel buffers with the input. When count exceeds the number of
+ * frames, frames are repeated.
+ *
+ * @param frames Window of frames.
+ * @param count Number of frames to return.
+ * @return std::vector<cv::Mat> count frames in temporal order.
+ */
+std::vector<cv::Mat> sample_frames(const std::vector<cv::Mat> &frames,
+                                   int count);
@@ -11,6 +11,12 @@ public:
   std::vector<float> process(const std::vector<cv::Mat> &frames, int channels,
                              const std::string &format) override;
 
+protected:
+  ResizePlan resize_plan(const cv::Size &frame_size,
+                         bool multi_crop) const override;
+  void channel_affine(std::vector<float> &scale,
+                      std::vector<float> &bias) const override;
+
 private:
   int image_size;
   std::vector<float> mean;
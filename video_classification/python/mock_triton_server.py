@@ -0,0 +1,122 @@
+"""Minimal KServe v2 HTTP server that mimics a Triton video classification model.
+
+Returns random logits after an injected delay, which makes it easy to exercise
+load balancing, ejection and hedging with several local replicas:
+
+    python python/mock_triton_server.py --port 8001 --delay-ms 40 &
+    python python/mock_triton_server.py --port 8002 --delay-ms 40 --jitter-ms 400 &
+    python python/mock_triton_server.py --port 8003 --fail-rate 0.5 &
+    ./build/debug/src/app/video_classification_app \
+        -u http://localhost:8001,http://localhost:8002,http://localhost:8003 video.mp4
+"""
+import argparse
+import json
+import random
+import re
+import struct
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+MODEL_PATH = re.compile(r"^/v2/models/([^/]+)(?:/versions/([^/]+))?(/config|/infer)?$")
+
+
+def make_handler(args):
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def log_message(self, fmt, *log_args):
+            if args.verbose:
+                super().log_message(fmt, *log_args)
+
+        def send_json(self, status, body):
+            payload = json.dumps(body).encode()
+            self.send_response(status)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(payload)))
+            self.end_headers()
+            self.wfile.write(payload)
+
+        def do_GET(self):
+            if self.path in ("/v2/health/ready", "/v2/health/live"):
+                self.send_response(200)
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+            match = MODEL_PATH.match(self.path)
+            if not match:
+                self.send_json(404, {"error": "not found"})
+                return
+            name, _, suffix = match.groups()
+            if suffix == "/config":
+                self.send_json(200, {
+                    "name": name,
+                    "max_batch_size": args.max_batch_size,
+                    "input": [{"name": "pixel_values", "data_type": "TYPE_FP32",
+                               "format": "FORMAT_NCHW", "dims": [16, 3, 224, 224]}],
+                    "output": [{"name": "logits", "data_type": "TYPE_FP32",
+                                "dims": [args.num_classes]}],
+                })
+            else:
+                self.send_json(200, {
+                    "name": name,
+                    "versions": ["4"],
+                    "platform": "mock",
+                    "inputs": [{"name": "pixel_values", "datatype": "FP32",
+                                "shape": [-1, 16, 3, 224, 224]}],
+                    "outputs": [{"name": "logits", "datatype": "FP32",
+                                 "shape": [-1, args.num_classes]}],
+                })
+
+        def do_POST(self):
+            length = int(self.headers.get("Content-Length", 0))
+            body = self.rfile.read(length)
+            match = MODEL_PATH.match(self.path)
+            if not match or match.group(3) != "/infer":
+                self.send_json(404, {"error": "not found"})
+                return
+
+            header_length = int(self.headers.get("Inference-Header-Content-Length", length))
+            request = json.loads(body[:header_length])
+            batch = request["inputs"][0]["shape"][0]
+
+            time.sleep((args.delay_ms + random.uniform(0, args.jitter_ms)) / 1000.0)
+            if random.random() < args.fail_rate:
+                self.send_json(500, {"error": "injected failure"})
+                return
+
+            count = batch * args.num_classes
+            data = struct.pack(f"<{count}f", *(random.gauss(0, 1) for _ in range(count)))
+            header = json.dumps({
+                "model_name": match.group(1),
+                "outputs": [{"name": "logits", "datatype": "FP32",
+                             "shape": [batch, args.num_classes],
+                             "parameters": {"binary_data_size": len(data)}}],
+            }).encode()
+            self.send_response(200)
+            self.send_header("Content-Type", "application/octet-stream")
+            self.send_header("Inference-Header-Content-Length", str(len(header)))
+            self.send_header("Content-Length", str(len(header) + len(data)))
+            self.end_headers()
+            self.wfile.write(header + data)
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--port", type=int, default=8000)
+    parser.add_argument("--delay-ms", type=float, default=50.0, help="Base inference latency")
+    parser.add_argument("--jitter-ms", type=float, default=0.0, help="Extra uniform random latency")
+    parser.add_argument("--fail-rate", type=float, default=0.0, help="Fraction of requests answered with 500")
+    parser.add_argument("--num-classes", type=int, default=400)
+    parser.add_argument("--max-batch-size", type=int, default=8)
+    parser.add_argument("--verbose", action="store_true")
+    args = parser.parse_args()
+
+    server = ThreadingHTTPServer(("127.0.0.1", args.port), make_handler(args))
+    print(f"Mock Triton listening on http://127.0.0.1:{args.port}")
+    server.serve_forever()
+
+
+if __name__ == "__main__":
+    main()
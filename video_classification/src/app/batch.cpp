@@ -0,0 +1,293 @@
+#include "video_classification/classification_service.hpp"
+#include "video_classification/shard_queue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+constexpr size_t DEFAULT_SHARD_SIZE = 100;
+constexpr int DEFAULT_LEASE_SECONDS = 300;
+constexpr int DEFAULT_TOP_K = 5;
+constexpr auto IDLE_POLL_INTERVAL = std::chrono::seconds(10);
+
+void print_usage(const char *program) {
+  std::cerr
+      << "Usage: " << program << " init [-s shard_size] <queue_dir> <manifest>\n"
+      << "       " << program
+      << " work [-w worker_id] [-L lease_seconds] [-m model] [-u url] "
+         "[-l labels_file] [-c config_file] [-t model_type] [-B backend] "
+         "[-k top_k] [-D fingerprint_file] [-M max_distance] <queue_dir>\n"
+      << "       " << program << " merge <queue_dir> <output.jsonl>\n"
+      << "       " << program << " status <queue_dir>\n"
+      << "  init:   Split a manifest (one video path per line) into shards\n"
+      << "  work:   Claim shards and classify their videos until none are left\n"
+      << "  merge:  Write all results as JSONL in manifest order\n"
+      << "  status: Show pending, leased and finished shard counts\n"
+      << "  -s: Videos per shard (default: 100)\n"
+      << "  -w: Worker id, unique across nodes (default: <host>-<pid>)\n"
+      << "  -L: Seconds without heartbeat before a lease expires (default: 300)\n"
+      << "  -k: Predictions per video (default: 5)\n"
+      << "  -D: Reuse predictions of near-duplicates recorded in this file,\n"
+      << "      shared by all workers\n"
+      << "  Other options as in video_classification_app\n";
+}
+
+std::string result_line(const std::string &video,
+                        const std::vector<InferenceBackend::InferenceResult>
+                            *predictions,
+                        const std::string &error) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("video");
+  writer.String(video.c_str(), static_cast<rapidjson::SizeType>(video.size()));
+  if (predictions == nullptr) {
+    writer.Key("error");
+    writer.String(error.c_str(),
+                  static_cast<rapidjson::SizeType>(error.size()));
+  } else {
+    writer.Key("predictions");
+    writer.StartArray();
+    for (const auto &prediction : *predictions) {
+      writer.StartObject();
+      writer.Key("label");
+      writer.String(prediction.label.c_str(),
+                    static_cast<rapidjson::SizeType>(prediction.label.size()));
+      writer.Key("probability");
+      writer.Double(static_cast<double>(prediction.probability));
+      writer.EndObject();
+    }
+    writer.EndArray();
+  }
+  writer.EndObject();
+  return buffer.GetString();
+}
+
+/**
+ * @brief Keeps a lease alive from a background thread while a shard runs
+ */
+class LeaseHeartbeat {
+public:
+  LeaseHeartbeat(const ShardQueue &queue, const ShardLease &lease,
+                 std::chrono::milliseconds interval)
+      : thread_([this, &queue, &lease, interval] {
+          std::unique_lock<std::mutex> lock(mutex_);
+          while (!stop_cv_.wait_for(lock, interval, [this] { return stop_; })) {
+            if (!queue.renew(lease)) {
+              lost_ = true;
+              return;
+            }
+          }
+        }) {}
+
+  ~LeaseHeartbeat() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    stop_cv_.notify_all();
+    thread_.join();
+  }
+
+  bool lost() const { return lost_.load(); }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable stop_cv_;
+  bool stop_ = false;
+  std::atomic<bool> lost_{false};
+  std::thread thread_; // Last, so it starts after the members it uses
+};
+
+int run_work(ShardQueue &queue, ClassificationService &service, int top_k,
+             std::chrono::milliseconds lease_duration) {
+  size_t processed = 0;
+  while (true) {
+    auto lease = queue.claim();
+    if (!lease) {
+      const auto status = queue.status();
+      if (status.pending == 0 && status.leased == 0) {
+        break;
+      }
+      // Other workers hold the rest; wait in case one of them dies
+      std::this_thread::sleep_for(IDLE_POLL_INTERVAL);
+      continue;
+    }
+
+    std::cout << queue.worker_id() << ": claimed " << lease->shard
+              << std::endl;
+    const auto videos = queue.shard_videos(*lease);
+    const auto completed = queue.completed_videos(lease->shard);
+    bool lost = false;
+    {
+      LeaseHeartbeat heartbeat(queue, *lease, lease_duration / 3);
+      for (const auto &video : videos) {
+        if (heartbeat.lost()) {
+          lost = true;
+          break;
+        }
+        if (completed.count(video) > 0) {
+          continue; // Finished before a crash or takeover
+        }
+        try {
+          const auto predictions = service.classify(video, top_k);
+          queue.record_result(*lease, result_line(video, &predictions, ""));
+        } catch (const std::exception &e) {
+          std::cerr << "Warning: " << video << ": " << e.what() << std::endl;
+          queue.record_result(*lease, result_line(video, nullptr, e.what()));
+        }
+        ++processed;
+      }
+      lost = lost || heartbeat.lost();
+    }
+
+    if (lost || !queue.complete(*lease)) {
+      std::cerr << "Warning: Lost lease of " << lease->shard
+                << " to another worker" << std::endl;
+    }
+  }
+  std::cout << queue.worker_id() << ": no shards left, processed " << processed
+            << " videos" << std::endl;
+  const auto duplicates = service.duplicate_stats();
+  if (duplicates.lookups > 0) {
+    std::cout << queue.worker_id() << ": " << duplicates.hits << " of "
+              << duplicates.lookups << " were duplicates, saving about "
+              << duplicates.saved_ms / 1000.0 << "s" << std::endl;
+  }
+  return 0;
+}
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    print_usage(argv[0]);
+    return 1;
+  }
+  const std::string command = argv[1];
+
+  ServiceOptions service_options;
+  service_options.labels_file = "labels/kinetics400.txt";
+  std::string worker_id;
+  size_t shard_size = DEFAULT_SHARD_SIZE;
+  int lease_seconds = DEFAULT_LEASE_SECONDS;
+  int top_k = DEFAULT_TOP_K;
+
+  optind = 2; // Options follow the command
+  int opt;
+  while ((opt = getopt(argc, argv, "s:w:L:m:u:l:c:t:B:k:D:M:")) != -1) {
+    try {
+      switch (opt) {
+      case 's':
+        shard_size = std::stoul(optarg);
+        break;
+      case 'w':
+        worker_id = optarg;
+        break;
+      case 'L':
+        lease_seconds = std::stoi(optarg);
+        break;
+      case 'm':
+        service_options.model_name = optarg;
+        break;
+      case 'u':
+        service_options.server_url = optarg;
+        break;
+      case 'l':
+        service_options.labels_file = optarg;
+        break;
+      case 'c':
+        service_options.config_file = optarg;
+        break;
+      case 't':
+        service_options.model_type = optarg;
+        break;
+      case 'B':
+        service_options.backend = optarg;
+        break;
+      case 'k':
+        top_k = std::stoi(optarg);
+        break;
+      case 'D':
+        service_options.fingerprint_index = optarg;
+        break;
+      case 'M':
+        service_options.duplicate_distance = std::stoi(optarg);
+        break;
+      default:
+        print_usage(argv[0]);
+        return 1;
+      }
+    } catch (const std::exception &) {
+      std::cerr << "Error: Invalid value '" << optarg << "' for -"
+                << static_cast<char>(opt) << "\n";
+      return 1;
+    }
+  }
+  if (lease_seconds <= 0 || top_k <= 0) {
+    std::cerr << "Error: Lease and top_k must be > 0\n";
+    return 1;
+  }
+  std::vector<std::string> args(argv + optind, argv + argc);
+  const auto lease_duration = std::chrono::milliseconds(std::chrono::seconds(lease_seconds));
+
+  try {
+    if (command == "init" && args.size() == 2) {
+      std::ifstream manifest(args[1]);
+      if (!manifest) {
+        throw std::runtime_error("Failed to read manifest: " + args[1]);
+      }
+      std::vector<std::string> videos;
+      for (std::string line; std::getline(manifest, line);) {
+        if (!line.empty()) {
+          videos.push_back(line);
+        }
+      }
+      ShardQueue::create(args[0], videos, shard_size);
+      std::cout << "Queued " << videos.size() << " videos in "
+                << (videos.size() + shard_size - 1) / std::max<size_t>(shard_size, 1)
+                << " shards" << std::endl;
+      return 0;
+    }
+    if (command == "work" && args.size() == 1) {
+      ShardQueue queue(args[0],
+                       worker_id.empty() ? ShardQueue::default_worker_id()
+                                         : worker_id,
+                       lease_duration);
+      ClassificationService service(service_options);
+      return run_work(queue, service, top_k, lease_duration);
+    }
+    if (command == "merge" && args.size() == 2) {
+      ShardQueue queue(args[0], ShardQueue::default_worker_id(), lease_duration);
+      const size_t missing = queue.merge(args[1]);
+      if (missing > 0) {
+        std::cerr << "Warning: " << missing << " videos have no result yet"
+                  << std::endl;
+      }
+      return 0;
+    }
+    if (command == "status" && args.size() == 1) {
+      ShardQueue queue(args[0], ShardQueue::default_worker_id(), lease_duration);
+      const auto status = queue.status();
+      std::cout << "pending: " << status.pending
+                << ", leased: " << status.leased << ", done: " << status.done
+                << std::endl;
+      return 0;
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  print_usage(argv[0]);
+  return 1;
+}
@@ -0,0 +1,85 @@
+#include "video_classification/prediction_index.hpp"
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+  PredictionQuery query;
+  bool list_labels = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "p:v:s:e:n:L")) != -1) {
+    try {
+      switch (opt) {
+      case 'p':
+        query.min_probability = std::stof(optarg);
+        break;
+      case 'v':
+        query.video = optarg;
+        break;
+      case 's':
+        query.start_time = std::stod(optarg);
+        break;
+      case 'e':
+        query.end_time = std::stod(optarg);
+        break;
+      case 'n':
+        query.limit = std::stoul(optarg);
+        break;
+      case 'L':
+        list_labels = true;
+        break;
+      default:
+        std::cerr << "Usage: " << argv[0]
+                  << " [-p min_probability] [-v video] [-s start] [-e end] "
+                     "[-n limit] <index_file> <label>\n"
+                  << "       " << argv[0] << " -L <index_file>\n"
+                  << "  -p: Minimum probability (default: 0)\n"
+                  << "  -v: Only windows of this video\n"
+                  << "  -s: Only windows ending at or after this time (seconds)\n"
+                  << "  -e: Only windows starting at or before this time (seconds)\n"
+                  << "  -n: Maximum number of results (default: all)\n"
+                  << "  -L: List the labels in the index\n";
+        return 1;
+      }
+    } catch (const std::exception &e) {
+      std::cerr << "Error: Invalid value '" << optarg << "' for -"
+                << static_cast<char>(opt) << "\n";
+      return 1;
+    }
+  }
+
+  if (optind >= argc || (!list_labels && optind + 1 >= argc)) {
+    std::cerr << "Error: Index file and label must be specified\n";
+    return 1;
+  }
+
+  try {
+    PredictionIndex index(argv[optind]);
+    if (list_labels) {
+      for (const auto &label : index.labels()) {
+        std::cout << label << "\n";
+      }
+      return 0;
+    }
+
+    query.label = argv[optind + 1];
+    const auto start = std::chrono::steady_clock::now();
+    const auto hits = index.query(query);
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+
+    for (const auto &hit : hits) {
+      std::cout << hit.video << "\t" << hit.start_time << "\t" << hit.end_time
+                << "\t" << hit.probability << "\n";
+    }
+    std::cerr << hits.size() << " windows of " << index.num_windows()
+              << " matched in " << elapsed_ms << " ms\n";
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
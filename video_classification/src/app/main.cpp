@@ -1,61 +1,246 @@
+#include "video_classification/cascade_classifier.hpp"
+#include "video_classification/classification_daemon.hpp"
+#include "video_classification/ensemble_classifier.hpp"
+#include "video_classification/parallel_video_decoder.hpp"
+#include "video_classification/prediction_index.hpp"
+#include "video_classification/processor_factory.hpp"
+#include "video_classification/temporal_localizer.hpp"
+#include "video_classification/test_time_augmentation.hpp"
+#include "video_classification/tracer.hpp"
+#include "video_classification/inference_backend.hpp"
 #include "video_classification/triton_client.hpp"
-#include "video_classification/videomae_image_processor.hpp"
-#include "video_classification/vivit_image_processor.hpp"
-#include "video_classification/timesformer_image_processor.hpp"
 #include "video_classification/video_utils.hpp"
+#include <atomic>
+#include <csignal>
 #include <iostream>
 #include <memory>
 #include <opencv2/opencv.hpp>
-#include <rapidjson/document.h>
-#include <rapidjson/istreamwrapper.h>
-#include <rapidjson/error/en.h>
 #include <stdexcept>
 #include <vector>
 #include <filesystem>
-#include <fstream>
+#include <functional>
 
 namespace {
 constexpr int DEFAULT_WINDOW_SIZE = 16;
 constexpr int DEFAULT_BATCH_SIZE = 1;
+constexpr int DEFAULT_DAEMON_CONCURRENCY = 4;
+
+std::atomic<bool> g_stop_requested{false};
+
+void request_stop(int) { g_stop_requested = true; }
+
+/**
+ * @brief Records a trace for the lifetime of the object and writes it on
+ *        every exit path
+ */
+class TraceSession {
+public:
+  explicit TraceSession(std::string path) : path_(std::move(path)) {
+    if (path_.empty()) {
+      return;
+    }
+#ifdef VIDEO_CLASSIFICATION_WITH_TRACING
+    Tracer::start();
+#else
+    std::cerr << "Warning: Built without tracing (ENABLE_TRACING=OFF), "
+              << path_ << " will be empty" << std::endl;
+#endif
+  }
+
+  ~TraceSession() {
+    if (path_.empty()) {
+      return;
+    }
+    try {
+      Tracer::write(path_);
+    } catch (const std::exception &e) {
+      std::cerr << "Warning: " << e.what() << std::endl;
+    }
+  }
+
+  TraceSession(const TraceSession &) = delete;
+  TraceSession &operator=(const TraceSession &) = delete;
+
+private:
+  std::string path_;
+};
+
+/**
+ * @brief Parses an ensemble member argument of the form model[:config_file]
+ * @param arg Command-line argument value
+ * @return Member specification
+ */
+EnsembleMemberSpec parse_member_spec(const std::string &arg) {
+  EnsembleMemberSpec spec;
+  const auto sep = arg.find(':');
+  spec.model_name = arg.substr(0, sep);
+  if (sep != std::string::npos) {
+    spec.config_file = arg.substr(sep + 1);
+  }
+  if (spec.model_name.empty()) {
+    throw std::runtime_error("Invalid ensemble member '" + arg +
+                             "', expecting model[:config_file]");
+  }
+  return spec;
+}
+
+/**
+ * @brief Parses cascade thresholds of the form min_confidence[:min_margin]
+ * @param arg Command-line argument value
+ * @return Cascade settings
+ */
+CascadeOptions parse_cascade_options(const std::string &arg) {
+  CascadeOptions options;
+  const auto sep = arg.find(':');
+  try {
+    options.min_confidence = std::stof(arg.substr(0, sep));
+    if (sep != std::string::npos) {
+      options.min_margin = std::stof(arg.substr(sep + 1));
+    }
+  } catch (const std::exception &) {
+    throw std::runtime_error("Invalid cascade thresholds '" + arg +
+                             "', expecting min_confidence[:min_margin]");
+  }
+  return options;
+}
+
+/**
+ * @brief Decodes every window of a video in parallel and visits them in order
+ * @param video_path Path to the video file
+ * @param window_size Frames per window, sampled at 1 FPS
+ * @param decode_threads Decoder threads, 0 for all cores
+ * @param seek_index Optional keyframe index of the video
+ * @param on_window Called with each window's time span and padded frames
+ */
+void for_each_window(
+    const std::string &video_path, int window_size, size_t decode_threads,
+    const std::shared_ptr<const VideoSeekIndex> &seek_index,
+    const std::function<void(const VideoProcessor::WindowIndices &,
+                             std::vector<cv::Mat> &)> &on_window) {
+  VideoProcessor video;
+  if (!video.openVideo(video_path, seek_index)) {
+    throw std::runtime_error("Failed to open video: " + video_path);
+  }
+  const auto windows = video.splitVideoIntoWindows(window_size, 1.0f);
+
+  ParallelDecodeOptions decode_options;
+  decode_options.num_threads = decode_threads;
+  decode_options.seek_index = seek_index;
+  ParallelVideoDecoder decoder(video_path, decode_options);
+
+  std::cout << "Predictions for video '" << video_path << "' ("
+            << windows.size() << " windows):\n";
+  decoder.decode(windows, [&](size_t,
+                              const VideoProcessor::WindowIndices &window,
+                              std::vector<cv::Mat> &frames) {
+    if (frames.empty()) {
+      return;
+    }
+    frames = pad_video_frames(frames, window_size);
+    std::cout << " [" << window.startTime << "s - " << window.endTime
+              << "s]:\n";
+    on_window(window, frames);
+  });
+}
+
+/**
+ * @brief Prints how often the cascade escalated and what each tier cost
+ */
+void print_cascade_stats(const CascadeClassifier &cascade) {
+  std::cerr << "Cascade escalation rate: " << cascade.escalation_rate() * 100.0
+            << "%\n";
+  for (const auto &tier : cascade.stats()) {
+    std::cerr << "  " << tier.model_name << ": calls=" << tier.calls
+              << " escalations=" << tier.escalations << " mean="
+              << (tier.calls == 0
+                      ? 0.0
+                      : tier.total_ms / static_cast<double>(tier.calls))
+              << "ms\n";
+  }
+}
 
 /**
- * @brief Loads model configuration from a JSON file
- * @param config_path Path to the configuration file
- * @param config Output RapidJSON document to store the configuration
- * @throws std::runtime_error if file cannot be opened or parsed
+ * @brief Parses a multi-view argument of the form <clips>x<crops>
+ * @param arg Command-line argument value
+ * @return Multi-view settings
  */
-void load_config_from_file(const std::string &config_path, rapidjson::Document &config) {
-  std::ifstream ifs(config_path);
-  if (!ifs.is_open()) {
-    throw std::runtime_error("Failed to open config file: " + config_path);
-  }
-  rapidjson::IStreamWrapper isw(ifs);
-  config.ParseStream(isw);
-  if (config.HasParseError()) {
-    throw std::runtime_error("Failed to parse config file: " + config_path +
-                            " - Error: " + rapidjson::GetParseError_En(config.GetParseError()) +
-                            " at offset " + std::to_string(config.GetErrorOffset()));
+TtaOptions parse_tta_options(const std::string &arg) {
+  TtaOptions options;
+  const auto sep = arg.find('x');
+  try {
+    options.num_clips = std::stoi(arg.substr(0, sep));
+    if (sep != std::string::npos) {
+      options.num_crops = std::stoi(arg.substr(sep + 1));
+    }
+  } catch (const std::exception &) {
+    throw std::runtime_error("Invalid multi-view setting '" + arg +
+                             "', expecting <clips>x<crops>");
+  }
+  if (options.num_clips <= 0 || options.num_crops <= 0) {
+    throw std::runtime_error("Clips and crops must be > 0");
+  }
+  return options;
+}
+
+/**
+ * @brief Parses localization thresholds of the form coarse[:fine]
+ * @param arg Command-line argument value
+ * @param options Settings to update
+ */
+void parse_localization_thresholds(const std::string &arg,
+                                   LocalizationOptions &options) {
+  const auto sep = arg.find(':');
+  try {
+    options.coarse_threshold = std::stof(arg.substr(0, sep));
+    if (sep != std::string::npos) {
+      options.fine_threshold = std::stof(arg.substr(sep + 1));
+    }
+  } catch (const std::exception &) {
+    throw std::runtime_error("Invalid localization thresholds '" + arg +
+                             "', expecting coarse[:fine]");
   }
 }
 
 /**
- * @brief Creates image processor based on model type
- * @param model_type Type of model ("videomae", "vivit", or "timesformer")
- * @param config RapidJSON document with model configuration
- * @return Unique pointer to the appropriate image processor
- * @throws std::runtime_error if model type is unrecognized
+ * @brief Prints how many videos were answered from a stored duplicate
  */
-std::unique_ptr<ImageProcessor> create_processor(const std::string &model_type,
-                                                  const rapidjson::Document &config) {
-  if (model_type == "vivit") {
-    return std::make_unique<VivitImageProcessor>(config);
-  } else if (model_type == "timesformer") {
-    return std::make_unique<TimeSformerImageProcessor>(config);
-  } else if (model_type == "videomae") {
-    return std::make_unique<VideoMAEImageProcessor>(config);
-  } else {
-    throw std::runtime_error("Unknown model type: " + model_type +
-                            ". Supported types: videomae, vivit, timesformer");
+void print_duplicate_stats(const DuplicateStats &stats) {
+  std::cerr << "Duplicates: " << stats.hits << " of " << stats.lookups
+            << " videos ("
+            << (stats.lookups == 0 ? 0.0
+                                   : 100.0 * static_cast<double>(stats.hits) /
+                                         static_cast<double>(stats.lookups))
+            << "%), saving about " << stats.saved_ms / 1000.0 << "s\n";
+}
+
+/**
+ * @brief Prints routing statistics when balancing over several Triton servers
+ */
+void print_endpoint_stats(const InferenceBackend &backend) {
+  const auto *triton = dynamic_cast<const TritonClient *>(&backend);
+  if (triton == nullptr) {
+    return;
+  }
+  const auto stats = triton->endpoint_stats();
+  if (stats.size() < 2) {
+    return;
+  }
+  std::cerr << "Endpoint statistics:\n";
+  for (const auto &endpoint : stats) {
+    std::cerr << "  " << endpoint.url << (endpoint.healthy ? "" : " (ejected)")
+              << ": requests=" << endpoint.requests
+              << " failures=" << endpoint.failures
+              << " hedges=" << endpoint.hedges
+              << " hedge_wins=" << endpoint.hedge_wins
+              << " p50=" << endpoint.p50_ms << "ms p95=" << endpoint.p95_ms
+              << "ms\n";
+  }
+}
+
+void print_results(
+    const std::vector<InferenceBackend::InferenceResult> &results) {
+  for (const auto &result : results) {
+    std::cout << "  " << result.label << ": " << result.probability << "\n";
   }
 }
 }
@@ -69,10 +254,29 @@ int main(int argc, char **argv) {
   std::string model_type = "videomae";  // Default model type
   int batch_size = DEFAULT_BATCH_SIZE;
   int window_size = DEFAULT_WINDOW_SIZE;
+  std::vector<EnsembleMemberSpec> ensemble;
+  std::vector<EnsembleMemberSpec> cascade;
+  CascadeOptions cascade_options;
+  bool fuse_logits = false;
+  std::string backend = "triton";
+  bool use_tta = false;
+  TtaOptions tta_options;
+  std::string socket_path;
+  int max_concurrency = DEFAULT_DAEMON_CONCURRENCY;
+  FrameColorFormat color_format = FrameColorFormat::RGB;
+  bool full_video = false;
+  std::string index_path;
+  size_t decode_threads = 0;
+  std::string seek_index_dir;
+  std::string trace_path;
+  LocalizationOptions localization;
+  std::string fingerprint_path;
+  int duplicate_distance = ServiceOptions().duplicate_distance;
+  bool duplicate_distance_set = false;
 
   // Parse command-line arguments
   int opt;
-  while ((opt = getopt(argc, argv, "m:u:b:l:c:t:")) != -1) {
+  while ((opt = getopt(argc, argv, "m:u:b:l:c:t:E:Fd:j:B:A:YWP:C:T:o:K:R:L:H:D:M:")) != -1) {
     switch (opt) {
     case 'm':
       model_name = optarg;
@@ -101,19 +305,226 @@ int main(int argc, char **argv) {
     case 't':
       model_type = optarg;
       break;
+    case 'E':
+      try {
+        ensemble.push_back(parse_member_spec(optarg));
+      } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+      }
+      break;
+    case 'F':
+      fuse_logits = true;
+      break;
+    case 'C':
+      try {
+        cascade.push_back(parse_member_spec(optarg));
+      } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+      }
+      break;
+    case 'T':
+      try {
+        cascade_options = parse_cascade_options(optarg);
+      } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+      }
+      break;
+    case 'B':
+      backend = optarg;
+      break;
+    case 'A':
+      try {
+        tta_options = parse_tta_options(optarg);
+        use_tta = true;
+      } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+      }
+      break;
+    case 'd':
+      socket_path = optarg;
+      break;
+    case 'j':
+      try {
+        max_concurrency = std::stoi(optarg);
+        if (max_concurrency <= 0) {
+          std::cerr << "Error: Concurrency must be > 0\n";
+          return 1;
+        }
+      } catch (const std::exception &e) {
+        std::cerr << "Error: Invalid concurrency '" << optarg << "'\n";
+        return 1;
+      }
+      break;
+    case 'Y':
+      color_format = FrameColorFormat::YUV420;
+      break;
+    case 'W':
+      full_video = true;
+      break;
+    case 'o':
+      index_path = optarg;
+      break;
+    case 'K':
+      seek_index_dir = optarg;
+      break;
+    case 'R':
+      trace_path = optarg;
+      break;
+    case 'L':
+      localization.target_label = optarg;
+      break;
+    case 'D':
+      fingerprint_path = optarg;
+      break;
+    case 'M':
+      try {
+        duplicate_distance = std::stoi(optarg);
+        if (duplicate_distance < 0) {
+          std::cerr << "Error: Duplicate distance must be >= 0\n";
+          return 1;
+        }
+      } catch (const std::exception &) {
+        std::cerr << "Error: Invalid duplicate distance '" << optarg << "'\n";
+        return 1;
+      }
+      duplicate_distance_set = true;
+      break;
+    case 'H':
+      try {
+        parse_localization_thresholds(optarg, localization);
+      } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+      }
+      break;
+    case 'P':
+      try {
+        const int threads = std::stoi(optarg);
+        if (threads < 0) {
+          std::cerr << "Error: Decoder threads must be >= 0\n";
+          return 1;
+        }
+        decode_threads = static_cast<size_t>(threads);
+      } catch (const std::exception &e) {
+        std::cerr << "Error: Invalid decoder thread count '" << optarg << "'\n";
+        return 1;
+      }
+      break;
     default:
       std::cerr << "Usage: " << argv[0]
                 << " [-m model] [-u url] [-b batch_size] [-l labels_file] "
-                   "[-c config_file] [-t model_type] <video_path>\n"
-                << "  -m: Model name on Triton server (default: videomae_large)\n"
-                << "  -u: Triton server URL (default: http://localhost:8000)\n"
+                   "[-c config_file] [-t model_type] [-E model[:config]]... "
+                   "[-F] [-d socket_path] [-j concurrency] [-B backend] [-A clipsxcrops] [-Y] [-W] [-P threads] [-C model[:config]]... [-T conf[:margin]] [-o index_file] [-K index_dir] [-R trace_file] [-L label] [-H coarse[:fine]] [-D fingerprint_file] [-M max_distance] <video_path>\n"
+                << "  -m: Model name on Triton server, or .onnx path with -B onnxruntime\n"
+                << "      (default: videomae_large)\n"
+                << "  -u: Triton server URL, or comma-separated replica URLs to load\n"
+                << "      balance over (default: http://localhost:8000)\n"
                 << "  -b: Batch size (default: 1)\n"
                 << "  -l: Labels file path (default: labels/kinetics400.txt)\n"
                 << "  -c: Model config file path (optional)\n"
-                << "  -t: Model type: videomae, vivit, or timesformer (default: videomae)\n";
+                << "  -t: Model type: videomae, vivit, or timesformer (default: videomae)\n"
+                << "  -E: Ensemble member model[:config_file], repeat to run several\n"
+                << "      models on the same decoded frames\n"
+                << "  -F: Fuse ensemble members by averaging their logits\n"
+                << "  -d: Run as a daemon serving requests on this Unix socket\n"
+                << "  -j: Daemon request concurrency (default: 4)\n"
+                << "  -B: Inference backend: triton or onnxruntime (default: triton)\n"
+                << "  -A: Multi-view evaluation, e.g. 4x3 for 4 temporal clips x 3\n"
+                << "      spatial crops with averaged logits\n"
+                << "  -Y: Decode to YUV420 and convert color only on cropped pixels\n"
+                << "      (requires OpenCV built with GStreamer; single window or -d)\n"
+                << "  -W: Classify every window of the whole video\n"
+                << "  -P: Decoder threads for -W (default: all cores)\n"
+                << "  -C: Cascade tier model[:config_file], repeat from cheapest to\n"
+                << "      most expensive; later tiers run only when earlier ones are unsure\n"
+                << "  -T: Cascade thresholds min_confidence[:min_margin] (default: 0.5:0.2)\n"
+                << "  -o: Add per-window predictions to this index file, query it\n"
+                << "      with video_index_query\n"
+                << "  -K: Cache keyframe seek indexes in this directory, built on\n"
+                << "      first use, for exact timing and fewer seeks\n"
+                << "  -R: Write a timeline of decode, preprocessing and inference\n"
+                << "      to this file, viewable in ui.perfetto.dev\n"
+                << "  -L: Localize this label: a coarse pass at 0.25 fps, then 1 fps\n"
+                << "      windows only where the coarse pass found it\n"
+                << "  -H: Localization thresholds coarse[:fine] (default: 0.2:0.5)\n"
+                << "  -D: With -d, answer near-duplicates of videos recorded in this\n"
+                << "      fingerprint file with their stored predictions\n"
+                << "  -M: Largest fingerprint distance of a duplicate, in bits out of\n"
+                << "      512 (default: 24)\n";
+      return 1;
+    }
+  }
+  if (color_format == FrameColorFormat::YUV420 &&
+      (!ensemble.empty() || !cascade.empty() || use_tta || full_video ||
+       !localization.target_label.empty())) {
+    std::cerr << "Error: -Y cannot be combined with -E, -C, -A, -W or -L\n";
+    return 1;
+  }
+  if (!ensemble.empty() &&
+      (!cascade.empty() || use_tta || !localization.target_label.empty())) {
+    std::cerr << "Error: -E cannot be combined with -C, -A or -L\n";
+    return 1;
+  }
+  if (socket_path.empty() &&
+      (!fingerprint_path.empty() || duplicate_distance_set)) {
+    std::cerr << "Error: -D and -M are only used by the daemon (-d)\n";
+    return 1;
+  }
+  if (duplicate_distance_set && fingerprint_path.empty()) {
+    std::cerr << "Error: -M requires -D\n";
+    return 1;
+  }
+  if (use_tta && full_video) {
+    std::cerr << "Error: -A spreads its clips over the whole video and cannot "
+                 "be combined with -W\n";
+    return 1;
+  }
+  if (!index_path.empty() &&
+      (!socket_path.empty() || use_tta || (!ensemble.empty() && !fuse_logits))) {
+    std::cerr << "Error: -o records one prediction list per window and cannot "
+                 "be combined with -d, -A, or -E without -F\n";
+    return 1;
+  }
+  TraceSession trace_session(trace_path);
+  if (!socket_path.empty()) {
+    try {
+      ServiceOptions service_options;
+      service_options.backend = backend;
+      service_options.server_url = url;
+      service_options.labels_file = labels_file;
+      service_options.model_name = model_name;
+      service_options.config_file = config_file;
+      service_options.model_type = model_type;
+      service_options.window_size = window_size;
+      service_options.num_clients = static_cast<size_t>(max_concurrency);
+      service_options.color_format = color_format;
+      service_options.seek_index_dir = seek_index_dir;
+      service_options.fingerprint_index = fingerprint_path;
+      service_options.duplicate_distance = duplicate_distance;
+      ClassificationService service(service_options);
+      ClassificationDaemon daemon(service, socket_path,
+                                  static_cast<size_t>(max_concurrency));
+
+      std::signal(SIGINT, request_stop);
+      std::signal(SIGTERM, request_stop);
+      std::cout << "Serving '" << model_name << "' on " << socket_path
+                << std::endl;
+      daemon.run(g_stop_requested);
+      std::cout << "Drained, shutting down" << std::endl;
+      if (!fingerprint_path.empty()) {
+        print_duplicate_stats(service.duplicate_stats());
+      }
+    } catch (const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
       return 1;
     }
+    return 0;
   }
+
   if (optind >= argc) {
     std::cerr << "Error: Video file must be specified\n";
     return 1;
@@ -131,62 +542,176 @@ int main(int argc, char **argv) {
   }
 
   try {
-    // Initialize Triton client
-    TritonClient client(url, labels_file);
-
-    // Get model info
-    ModelInfo model_info;
-    client.get_model_info(model_name, model_info);
+    std::shared_ptr<const VideoSeekIndex> seek_index;
+    if (!seek_index_dir.empty()) {
+      seek_index = VideoSeekIndex::load_or_build(video_path, seek_index_dir);
+    }
 
-    // Initialize processor with config
-    std::unique_ptr<ImageProcessor> processor;
-    rapidjson::Document config;
-
-    if (!config_file.empty()) {
-      // Load from specified config file
-      load_config_from_file(config_file, config);
-      if (config.HasMember("model_type") && config["model_type"].IsString()) {
-        model_type = config["model_type"].GetString();
+    // Windows of this run are merged into the index at the end: earlier runs
+    // stay in it, windows of this video are replaced
+    PredictionIndexWriter index_writer;
+    auto record_window =
+        [&](double start_time, double end_time,
+            const std::vector<InferenceBackend::InferenceResult> &results) {
+          if (!index_path.empty()) {
+            index_writer.add_window(video_path, start_time, end_time, results);
+          }
+        };
+    auto save_index = [&] {
+      if (!index_path.empty()) {
+        index_writer.merge_into(index_path, video_path);
       }
-      processor = create_processor(model_type, config);
-    } else {
-      // Try to auto-detect model type from model name or use specified type
-      if (model_type == "auto") {
-        if (model_name.find("vivit") != std::string::npos) {
-          model_type = "vivit";
-        } else if (model_name.find("timesformer") != std::string::npos) {
-          model_type = "timesformer";
-        } else {
-          model_type = "videomae";
+    };
+    const double first_window_end = static_cast<double>(window_size - 1);
+
+    if (!ensemble.empty()) {
+      EnsembleClassifier classifier(url, labels_file, ensemble, backend);
+
+      // Each window is decoded once and shared between all members
+      auto classify_window = [&](const std::vector<cv::Mat> &frames,
+                                 double start_time, double end_time) {
+        auto ensemble_results = classifier.classify(frames, fuse_logits);
+        for (const auto &member : ensemble_results.members) {
+          std::cout << " " << member.model_name << ":\n";
+          print_results(member.predictions);
+        }
+        if (fuse_logits) {
+          std::cout << " fused:\n";
+          print_results(ensemble_results.fused);
+          record_window(start_time, end_time, ensemble_results.fused);
         }
+      };
+
+      if (full_video) {
+        for_each_window(video_path, window_size, decode_threads, seek_index,
+                        [&](const VideoProcessor::WindowIndices &window,
+                            std::vector<cv::Mat> &frames) {
+                          classify_window(frames, window.startTime,
+                                          window.endTime);
+                        });
+      } else {
+        auto frames =
+            read_video_frames(video_path, window_size, FrameColorFormat::RGB,
+                              seek_index.get());
+        frames = pad_video_frames(frames, window_size);
+        std::cout << "Predictions for video '" << video_path << "':\n";
+        classify_window(frames, 0.0, first_window_end);
       }
+      save_index();
+      return 0;
+    }
 
-      // Try to load default config file
-      std::string default_config = "configs/" + model_type + ".json";
-      if (std::filesystem::exists(default_config)) {
-        load_config_from_file(default_config, config);
+    if (!cascade.empty()) {
+      CascadeClassifier classifier(url, labels_file, cascade, cascade_options,
+                                   backend);
+      auto classify_window = [&](std::vector<cv::Mat> &frames,
+                                 double start_time, double end_time) {
+        auto result = classifier.classify(frames);
+        std::cout << "  (" << result.model_name << ")\n";
+        print_results(result.predictions);
+        record_window(start_time, end_time, result.predictions);
+      };
+
+      if (full_video) {
+        for_each_window(video_path, window_size, decode_threads, seek_index,
+                        [&](const VideoProcessor::WindowIndices &window,
+                            std::vector<cv::Mat> &frames) {
+                          classify_window(frames, window.startTime,
+                                          window.endTime);
+                        });
       } else {
-        // Fallback to hardcoded defaults
-        std::cerr << "Warning: No config file found, using hardcoded defaults for "
-                  << model_type << "\n";
-        std::string config_json;
-        if (model_type == "vivit") {
-          config_json = R"({"shortest_edge": 256, "crop_size": 224, "rescale_factor": 0.00784313725, "offset": true, "mean": [0.485, 0.456, 0.406], "std": [0.229, 0.224, 0.225]})";
-        } else if (model_type == "timesformer") {
-          config_json = R"({"shortest_edge": 224, "crop_size": 224, "rescale_factor": 0.003921568627, "mean": [0.45, 0.45, 0.45], "std": [0.225, 0.225, 0.225]})";
-        } else {
-          config_json = R"({"image_size": 224, "mean": [0.485, 0.456, 0.406], "std": [0.229, 0.224, 0.225]})";
-        }
-        config.Parse(config_json.c_str());
-        if (config.HasParseError()) {
-          throw std::runtime_error("Failed to parse default config JSON");
-        }
+        auto frames =
+            read_video_frames(video_path, window_size, FrameColorFormat::RGB,
+                              seek_index.get());
+        frames = pad_video_frames(frames, window_size);
+        std::cout << "Predictions for video '" << video_path << "':\n";
+        classify_window(frames, 0.0, first_window_end);
+      }
+      print_cascade_stats(classifier);
+      save_index();
+      return 0;
+    }
+
+    // Initialize inference backend
+    std::unique_ptr<InferenceBackend> client =
+        create_backend(backend, url, labels_file);
+
+    // Get model info
+    ModelInfo model_info;
+    client->get_model_info(model_name, model_info);
+
+    // Initialize processor with config
+    std::unique_ptr<ImageProcessor> processor =
+        load_processor(config_file, model_name, model_type);
+
+    if (!localization.target_label.empty()) {
+      localization.decode_threads = decode_threads;
+      TemporalLocalizer localizer(*client, *processor, model_name, model_info,
+                                  localization);
+      const auto result = localizer.localize(video_path, seek_index);
+      std::cout << "Occurrences of '" << localization.target_label
+                << "' in video '" << video_path << "':\n";
+      for (const auto &interval : result.intervals) {
+        std::cout << " [" << interval.start << "s - " << interval.end
+                  << "s]: " << interval.probability << "\n";
+        record_window(interval.start, interval.end,
+                      {{localization.target_label,
+                        interval.probability}});
       }
-      processor = create_processor(model_type, config);
+      std::cout << "Fine pass covered " << result.fine_fraction * 100.0
+                << "% of the video (" << result.coarse_windows
+                << " coarse, " << result.fine_windows << " fine windows)"
+                << std::endl;
+      print_endpoint_stats(*client);
+      save_index();
+      return 0;
+    }
+
+    if (full_video) {
+      const std::vector<int64_t> shape = {1, window_size, model_info.input_c_,
+                                          model_info.input_h_,
+                                          model_info.input_w_};
+      std::vector<float> logits; // Reused by every window
+      for_each_window(video_path, window_size, decode_threads, seek_index,
+                      [&](const VideoProcessor::WindowIndices &window,
+                          std::vector<cv::Mat> &frames) {
+                        std::vector<float> pixel_values;
+                        {
+                          TRACE_SCOPE("preprocess", .video = video_path);
+                          pixel_values = processor->process(
+                              frames, model_info.input_c_,
+                              model_info.input_format_);
+                        }
+                        TRACE_SCOPE("infer", .video = video_path);
+                        client->infer_logits_into(pixel_values, model_name,
+                                                  model_info, shape, logits);
+                        auto results = client->postprocess_results(logits);
+                        print_results(results);
+                        record_window(window.startTime, window.endTime,
+                                      results);
+                      });
+      print_endpoint_stats(*client);
+      save_index();
+      return 0;
+    }
+
+    if (use_tta) {
+      auto clips = read_video_clips(video_path, window_size,
+                                    tta_options.num_clips, seek_index.get());
+      auto logits = classify_multi_view(*client, *processor, model_name,
+                                        model_info, clips,
+                                        tta_options.num_crops);
+      std::cout << "Predictions for video '" << video_path << "' ("
+                << tta_options.num_clips << " clips x "
+                << tta_options.num_crops << " crops):\n";
+      print_results(client->postprocess_results(logits));
+      print_endpoint_stats(*client);
+      return 0;
     }
 
     // Read video frames at 1 FPS
-    auto frames = read_video_frames(video_path, window_size);
+    auto frames = read_video_frames(video_path, window_size, color_format,
+                                    seek_index.get());
     frames = pad_video_frames(frames, window_size);
 
     // Verify frame count
@@ -196,8 +721,12 @@ int main(int argc, char **argv) {
     }
 
     // Preprocess frames
-    auto pixel_values = processor->process(frames, model_info.input_c_,
-                                          model_info.input_format_);
+    auto pixel_values =
+        color_format == FrameColorFormat::YUV420
+            ? processor->process_yuv420(frames, model_info.input_c_,
+                                        model_info.input_format_)
+            : processor->process(frames, model_info.input_c_,
+                                 model_info.input_format_);
 
     // Validate input data size
     const size_t expected_elements = static_cast<size_t>(batch_size) *
@@ -217,13 +746,14 @@ int main(int argc, char **argv) {
                                   model_info.input_h_, model_info.input_w_};
 
     // Perform inference
-    auto results = client.infer(pixel_values, model_name, model_info, shape);
+    auto results = client->infer(pixel_values, model_name, model_info, shape);
 
     // Output results
     std::cout << "Predictions for video '" << video_path << "':\n";
-    for (const auto &result : results) {
-      std::cout << "  " << result.label << ": " << result.probability << "\n";
-    }
+    print_results(results);
+    print_endpoint_stats(*client);
+    record_window(0.0, first_window_end, results);
+    save_index();
   } catch (const std::exception &e) {
     std::cerr << "Error: " << e.what() << std::endl;
     return 1;
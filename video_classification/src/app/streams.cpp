@@ -0,0 +1,244 @@
+#include "video_classification/processor_factory.hpp"
+#include "video_classification/stream_scheduler.hpp"
+#include "video_classification/video_processor.hpp"
+#include "video_classification/video_utils.hpp"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+constexpr int DEFAULT_CONNECTIONS = 2;
+constexpr int DEFAULT_SLO_MS = 2000;
+
+void print_usage(const char *program) {
+  std::cerr
+      << "Usage: " << program
+      << " [-m model] [-u url] [-l labels_file] [-c config_file] "
+         "[-t model_type] [-B backend] [-j connections] [-S slo_ms] "
+         "[-b max_batch] [-r] <video[:priority]>...\n"
+      << "Classifies the windows of several videos as concurrent streams\n"
+      << "sharing one inference budget.\n"
+      << "  -j: Backend connections, one batch in flight each (default: 2)\n"
+      << "  -S: Latency SLO per window in milliseconds (default: 2000)\n"
+      << "  -b: Windows per batch (default: the model maximum)\n"
+      << "  -r: Submit windows in real time, as a camera would\n"
+      << "  priority: Larger gets a bigger share of contended batches\n"
+      << "  Other options as in video_classification_app\n";
+}
+
+struct StreamSpec {
+  std::string video;
+  int priority = 0;
+};
+
+StreamSpec parse_stream_spec(const std::string &arg) {
+  StreamSpec spec;
+  spec.video = arg;
+  const auto sep = arg.rfind(':');
+  if (sep != std::string::npos) {
+    try {
+      spec.priority = std::stoi(arg.substr(sep + 1));
+      spec.video = arg.substr(0, sep);
+    } catch (const std::exception &) {
+      // Part of the path
+    }
+  }
+  return spec;
+}
+
+/**
+ * @brief Decodes and preprocesses the windows of one video and submits them
+ *
+ * Keeps one window in 2^n while the scheduler has degraded the stream to
+ * level n, so a late stream also decodes less.
+ */
+void produce(StreamScheduler &scheduler, size_t stream, const StreamSpec &spec,
+             ImageProcessor &processor, const ModelInfo &model_info,
+             bool real_time, std::mutex &output_mutex) {
+  VideoProcessor video;
+  if (!video.openVideo(spec.video)) {
+    std::lock_guard<std::mutex> lock(output_mutex);
+    std::cerr << "Warning: Failed to open video: " << spec.video << std::endl;
+    return;
+  }
+  const auto windows = video.splitVideoIntoWindows(model_info.input_t_, 1.0f);
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t w = 0; w < windows.size(); ++w) {
+    const auto &window = windows[w];
+    if (real_time) {
+      std::this_thread::sleep_until(
+          start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<double>(window.endTime)));
+    }
+    const auto keep_every = size_t{1} << scheduler.degradation(stream);
+    if (w % keep_every != 0) {
+      continue;
+    }
+
+    auto frames = video.extractFrames(window.indices);
+    if (frames.empty()) {
+      continue;
+    }
+    for (auto &frame : frames) {
+      cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
+    }
+    auto pixel_values =
+        processor.process(pad_video_frames(frames, model_info.input_t_),
+                          model_info.input_c_, model_info.input_format_);
+    scheduler.submit(
+        stream, std::move(pixel_values),
+        [&spec, &output_mutex, start_time = window.startTime,
+         end_time = window.endTime](const StreamScheduler::WindowResult &result) {
+          std::lock_guard<std::mutex> lock(output_mutex);
+          std::cout << spec.video << " [" << start_time << "s - " << end_time
+                    << "s]: ";
+          switch (result.outcome) {
+          case StreamScheduler::Outcome::Shed:
+            std::cout << "shed after " << result.latency.count() << "ms\n";
+            return;
+          case StreamScheduler::Outcome::Failed:
+            std::cout << "failed: " << result.error << "\n";
+            return;
+          default:
+            break;
+          }
+          if (!result.predictions.empty()) {
+            std::cout << result.predictions.front().label << " ("
+                      << result.predictions.front().probability << ")";
+          }
+          std::cout << " in " << result.latency.count() << "ms"
+                    << (result.outcome == StreamScheduler::Outcome::Late
+                            ? ", late"
+                            : "")
+                    << "\n";
+        });
+  }
+}
+}
+
+int main(int argc, char **argv) {
+  std::string model_name = "videomae_large";
+  std::string url = "http://localhost:8000";
+  std::string labels_file = "labels/kinetics400.txt";
+  std::string config_file;
+  std::string model_type = "videomae";
+  std::string backend = "triton";
+  int connections = DEFAULT_CONNECTIONS;
+  int slo_ms = DEFAULT_SLO_MS;
+  SchedulerOptions scheduler_options;
+  bool real_time = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "m:u:l:c:t:B:j:S:b:r")) != -1) {
+    try {
+      switch (opt) {
+      case 'm':
+        model_name = optarg;
+        break;
+      case 'u':
+        url = optarg;
+        break;
+      case 'l':
+        labels_file = optarg;
+        break;
+      case 'c':
+        config_file = optarg;
+        break;
+      case 't':
+        model_type = optarg;
+        break;
+      case 'B':
+        backend = optarg;
+        break;
+      case 'j':
+        connections = std::stoi(optarg);
+        break;
+      case 'S':
+        slo_ms = std::stoi(optarg);
+        break;
+      case 'b':
+        scheduler_options.max_batch_size = std::stoul(optarg);
+        break;
+      case 'r':
+        real_time = true;
+        break;
+      default:
+        print_usage(argv[0]);
+        return 1;
+      }
+    } catch (const std::exception &) {
+      std::cerr << "Error: Invalid value '" << optarg << "' for -"
+                << static_cast<char>(opt) << "\n";
+      return 1;
+    }
+  }
+  if (optind >= argc || connections <= 0 || slo_ms <= 0) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  try {
+    std::vector<std::unique_ptr<InferenceBackend>> backends;
+    std::vector<InferenceBackend *> backend_ptrs;
+    const int num_backends = backend == "onnxruntime" ? 1 : connections;
+    for (int i = 0; i < num_backends; ++i) {
+      backends.push_back(create_backend(backend, url, labels_file));
+      backend_ptrs.push_back(backends.back().get());
+    }
+    ModelInfo model_info;
+    backends.front()->get_model_info(model_name, model_info);
+
+    std::vector<StreamSpec> specs;
+    for (int i = optind; i < argc; ++i) {
+      specs.push_back(parse_stream_spec(argv[i]));
+    }
+    // Producers preprocess concurrently, so each gets its own processor
+    std::vector<std::unique_ptr<ImageProcessor>> processors;
+    for (size_t i = 0; i < specs.size(); ++i) {
+      processors.push_back(load_processor(config_file, model_name, model_type));
+    }
+
+    StreamScheduler scheduler(backend_ptrs, model_name, model_info,
+                              scheduler_options);
+    std::vector<size_t> stream_ids;
+    for (const auto &spec : specs) {
+      StreamOptions stream_options;
+      stream_options.name = spec.video;
+      stream_options.priority = spec.priority;
+      stream_options.slo = std::chrono::milliseconds(slo_ms);
+      stream_ids.push_back(scheduler.add_stream(stream_options));
+    }
+
+    std::mutex output_mutex;
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < specs.size(); ++i) {
+      producers.emplace_back([&, i] {
+        produce(scheduler, stream_ids[i], specs[i], *processors[i],
+                model_info, real_time, output_mutex);
+      });
+    }
+    for (auto &producer : producers) {
+      producer.join();
+    }
+    scheduler.wait_idle();
+
+    std::cout << "\nStream statistics:\n";
+    for (const auto &stats : scheduler.stats()) {
+      std::cout << "  " << stats.name << ": submitted=" << stats.submitted
+                << " on_time=" << stats.on_time << " late=" << stats.late
+                << " shed=" << stats.shed << " failed=" << stats.failed
+                << " misses=" << stats.deadline_misses()
+                << " degradation=" << stats.degradation
+                << " mean=" << stats.mean_latency_ms << "ms\n";
+    }
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,128 @@
+#include "video_classification/cascade_classifier.hpp"
+#include "video_classification/processor_factory.hpp"
+#include "video_classification/video_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+CascadeClassifier::CascadeClassifier(
+    const std::string &server_url, const std::string &labels_file,
+    const std::vector<EnsembleMemberSpec> &tiers, const CascadeOptions &options,
+    const std::string &backend)
+    : CascadeClassifier(load_tiers(server_url, labels_file, tiers, backend),
+                        options) {}
+
+CascadeClassifier::CascadeClassifier(std::vector<Tier> tiers,
+                                     const CascadeOptions &options)
+    : options_(options), tiers_(std::move(tiers)) {
+  if (tiers_.empty()) {
+    throw std::runtime_error("Cascade requires at least one model");
+  }
+  for (const auto &tier : tiers_) {
+    TierStats stats;
+    stats.model_name = tier.model_name;
+    stats_.push_back(stats);
+  }
+}
+
+std::vector<CascadeClassifier::Tier>
+CascadeClassifier::load_tiers(const std::string &server_url,
+                              const std::string &labels_file,
+                              const std::vector<EnsembleMemberSpec> &tiers,
+                              const std::string &backend) {
+  std::vector<Tier> loaded;
+  loaded.reserve(tiers.size());
+  for (const auto &spec : tiers) {
+    Tier tier;
+    tier.model_name = spec.model_name;
+    tier.client = create_backend(backend, server_url, labels_file);
+    tier.client->get_model_info(spec.model_name, tier.model_info);
+    std::string model_type = spec.model_type;
+    tier.processor =
+        load_processor(spec.config_file, spec.model_name, model_type);
+    loaded.push_back(std::move(tier));
+  }
+  return loaded;
+}
+
+bool CascadeClassifier::is_confident(
+    const std::vector<InferenceBackend::InferenceResult> &predictions) const {
+  if (predictions.empty()) {
+    return false;
+  }
+  const float top1 = predictions[0].probability;
+  const float top2 = predictions.size() > 1 ? predictions[1].probability : 0.0f;
+  return top1 >= options_.min_confidence && top1 - top2 >= options_.min_margin;
+}
+
+CascadeClassifier::Result
+CascadeClassifier::classify(const std::vector<cv::Mat> &frames, int top_k) {
+  for (size_t t = 0; t < tiers_.size(); ++t) {
+    Tier &tier = tiers_[t];
+    const ModelInfo &info = tier.model_info;
+    const auto start = std::chrono::steady_clock::now();
+
+    // Small tiers may take fewer frames than the decoded window
+    const auto clip = sample_frames(frames, info.input_t_);
+    auto pixel_values =
+        tier.processor->process(clip, info.input_c_, info.input_format_);
+    const size_t expected_elements = static_cast<size_t>(info.input_t_) *
+                                     static_cast<size_t>(info.input_c_) *
+                                     static_cast<size_t>(info.input_h_) *
+                                     static_cast<size_t>(info.input_w_);
+    if (pixel_values.size() != expected_elements) {
+      throw std::runtime_error("Invalid input data size for model '" +
+                               tier.model_name + "': expected " +
+                               std::to_string(expected_elements) +
+                               " elements, got " +
+                               std::to_string(pixel_values.size()));
+    }
+
+    std::vector<int64_t> shape = {1, info.input_t_, info.input_c_,
+                                  info.input_h_, info.input_w_};
+    tier.client->infer_logits_into(pixel_values, tier.model_name, info, shape,
+                                   tier.logits);
+    // Two predictions are needed for the margin even when top_k is 1
+    auto predictions =
+        tier.client->postprocess_results(tier.logits, std::max(top_k, 2));
+
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(
+                                  std::chrono::steady_clock::now() - start)
+                                  .count();
+    const bool last = t + 1 == tiers_.size();
+    const bool accept = last || is_confident(predictions);
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      ++stats_[t].calls;
+      stats_[t].total_ms += elapsed_ms;
+      if (!accept) {
+        ++stats_[t].escalations;
+      }
+    }
+
+    if (accept) {
+      predictions.resize(std::min(predictions.size(),
+                                  static_cast<size_t>(std::max(top_k, 0))));
+      Result result;
+      result.model_name = tier.model_name;
+      result.tier = t;
+      result.predictions = std::move(predictions);
+      return result;
+    }
+  }
+  throw std::runtime_error("Cascade has no tiers"); // unreachable
+}
+
+std::vector<CascadeClassifier::TierStats> CascadeClassifier::stats() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  return stats_;
+}
+
+double CascadeClassifier::escalation_rate() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  const TierStats &first = stats_.front();
+  return first.calls == 0 ? 0.0
+                          : static_cast<double>(first.escalations) /
+                                static_cast<double>(first.calls);
+}
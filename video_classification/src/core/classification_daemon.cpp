@@ -0,0 +1,302 @@
+#include "video_classification/classification_daemon.hpp"
+#include "video_classification/thread_pool.hpp"
+#include "video_classification/tracer.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+constexpr int POLL_INTERVAL_MS = 200;
+constexpr int LISTEN_BACKLOG = 64;
+constexpr size_t MAX_REQUEST_BYTES = 64 * 1024;
+
+bool send_all(int fd, const std::string &data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    sent += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Removes the socket a previous daemon left behind. Anything else at the
+// path, including the socket of a daemon still running, is left alone.
+void remove_stale_socket(const std::string &path, const sockaddr_un &addr) {
+  struct stat status {};
+  if (::lstat(path.c_str(), &status) != 0) {
+    if (errno == ENOENT) {
+      return;
+    }
+    throw std::runtime_error("Failed to stat " + path + ": " +
+                             std::strerror(errno));
+  }
+  if (!S_ISSOCK(status.st_mode)) {
+    throw std::runtime_error(path + " exists and is not a socket");
+  }
+  const int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (probe < 0) {
+    throw std::runtime_error("Failed to create socket: " +
+                             std::string(std::strerror(errno)));
+  }
+  const bool connected =
+      ::connect(probe, reinterpret_cast<const sockaddr *>(&addr),
+                sizeof(addr)) == 0;
+  const int connect_error = errno;
+  ::close(probe);
+  if (connected) {
+    throw std::runtime_error("Another daemon is listening on " + path);
+  }
+  if (connect_error != ECONNREFUSED) {
+    throw std::runtime_error("Failed to probe " + path + ": " +
+                             std::strerror(connect_error));
+  }
+  ::unlink(path.c_str());
+}
+
+std::string error_response(const std::string &id, const std::string &message) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("id");
+  writer.String(id.c_str(), static_cast<rapidjson::SizeType>(id.size()));
+  writer.Key("error");
+  writer.String(message.c_str(),
+                static_cast<rapidjson::SizeType>(message.size()));
+  writer.EndObject();
+  return buffer.GetString();
+}
+}
+
+ClassificationDaemon::ClassificationDaemon(ClassificationService &service,
+                                           const std::string &socket_path,
+                                           size_t max_concurrency)
+    : service_(service), socket_path_(socket_path),
+      max_concurrency_(max_concurrency) {
+  sockaddr_un addr{};
+  if (socket_path_.size() >= sizeof(addr.sun_path)) {
+    throw std::runtime_error("Socket path too long: " + socket_path_);
+  }
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, socket_path_.c_str(), sizeof(addr.sun_path) - 1);
+
+  listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd_ < 0) {
+    throw std::runtime_error("Failed to create socket: " +
+                             std::string(std::strerror(errno)));
+  }
+  if (::pipe2(wake_fds_, O_CLOEXEC | O_NONBLOCK) != 0) {
+    const std::string reason = std::strerror(errno);
+    ::close(listen_fd_);
+    throw std::runtime_error("Failed to create wake pipe: " + reason);
+  }
+  auto close_fds = [this] {
+    ::close(listen_fd_);
+    ::close(wake_fds_[0]);
+    ::close(wake_fds_[1]);
+  };
+  try {
+    remove_stale_socket(socket_path_, addr);
+  } catch (...) {
+    close_fds();
+    throw;
+  }
+  if (::bind(listen_fd_, reinterpret_cast<const sockaddr *>(&addr),
+             sizeof(addr)) != 0 ||
+      ::listen(listen_fd_, LISTEN_BACKLOG) != 0) {
+    const std::string reason = std::strerror(errno);
+    close_fds();
+    throw std::runtime_error("Failed to listen on " + socket_path_ + ": " +
+                             reason);
+  }
+}
+
+ClassificationDaemon::~ClassificationDaemon() {
+  if (listen_fd_ >= 0) {
+    ::close(listen_fd_);
+    ::unlink(socket_path_.c_str());
+  }
+  for (int fd : wake_fds_) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+}
+
+void ClassificationDaemon::run(const std::atomic<bool> &stop_requested) {
+  std::vector<std::unique_ptr<Connection>> connections;
+  {
+    // Destroying the pool joins the workers once dispatched requests finish
+    ThreadPool workers(max_concurrency_);
+    std::vector<pollfd> fds;
+    while (true) {
+      if (listen_fd_ >= 0 && stop_requested.load()) {
+        ::close(listen_fd_);
+        listen_fd_ = -1;
+        ::unlink(socket_path_.c_str());
+      }
+
+      // Connections are only closed while no worker is using them
+      std::erase_if(connections, [&](const std::unique_ptr<Connection> &c) {
+        if (c->busy.load() || dispatch(*c, workers)) {
+          return false;
+        }
+        ::close(c->fd);
+        return true;
+      });
+      if (listen_fd_ < 0 && connections.empty()) {
+        break;
+      }
+
+      fds.clear();
+      fds.push_back({wake_fds_[0], POLLIN, 0});
+      fds.push_back({listen_fd_, POLLIN, 0}); // Ignored by poll once closed
+      for (const auto &connection : connections) {
+        // A connection with a full buffer is not read until it catches up
+        const bool readable = !connection->closed &&
+                              connection->pending.size() <= MAX_REQUEST_BYTES;
+        fds.push_back({readable ? connection->fd : -1, POLLIN, 0});
+      }
+      if (::poll(fds.data(), fds.size(), POLL_INTERVAL_MS) <= 0) {
+        continue; // timeout or EINTR from the stop signal
+      }
+
+      if (fds[0].revents != 0) {
+        char drained[64];
+        while (::read(wake_fds_[0], drained, sizeof(drained)) > 0) {
+        }
+      }
+      for (size_t i = 0; i < connections.size(); ++i) {
+        if (fds[i + 2].revents != 0) {
+          receive(*connections[i]);
+        }
+      }
+      if (fds[1].revents & POLLIN) {
+        int client_fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd >= 0) {
+          connections.push_back(std::make_unique<Connection>(client_fd));
+        }
+      }
+    }
+  }
+}
+
+bool ClassificationDaemon::dispatch(Connection &connection, ThreadPool &workers) {
+  if (connection.failed.load()) {
+    return false;
+  }
+  size_t newline;
+  while ((newline = connection.pending.find('\n')) != std::string::npos) {
+    std::string line = connection.pending.substr(0, newline);
+    connection.pending.erase(0, newline + 1);
+    if (line.empty()) {
+      continue;
+    }
+    // Responses stay in order because a connection has at most one request
+    // on the pool
+    connection.busy = true;
+    workers.submit([this, &connection, line = std::move(line)] {
+      if (!send_all(connection.fd, handle_request(line) + "\n")) {
+        connection.failed = true;
+      }
+      connection.busy = false;
+      wake();
+    });
+    return true;
+  }
+  if (connection.pending.size() > MAX_REQUEST_BYTES) {
+    send_all(connection.fd, error_response("", "Request too large") + "\n");
+    return false;
+  }
+  // Idle connections are closed once the daemon drains
+  return !connection.closed && listen_fd_ >= 0;
+}
+
+void ClassificationDaemon::receive(Connection &connection) {
+  char chunk[4096];
+  ssize_t n = ::recv(connection.fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+  if (n > 0) {
+    connection.pending.append(chunk, static_cast<size_t>(n));
+  } else if (n == 0 || (errno != EINTR && errno != EAGAIN)) {
+    // Requests already received are still answered
+    connection.closed = true;
+  }
+}
+
+void ClassificationDaemon::wake() {
+  const char byte = 0;
+  [[maybe_unused]] ssize_t n = ::write(wake_fds_[1], &byte, 1);
+}
+
+std::string ClassificationDaemon::handle_request(const std::string &request_line) {
+  rapidjson::Document request;
+  request.Parse(request_line.c_str(), request_line.size());
+  if (request.HasParseError() || !request.IsObject()) {
+    return error_response("", "Invalid JSON request");
+  }
+
+  std::string id;
+  if (request.HasMember("id") && request["id"].IsString()) {
+    id = request["id"].GetString();
+  }
+  if (!request.HasMember("video") || !request["video"].IsString()) {
+    return error_response(id, "Missing 'video' field");
+  }
+  const std::string video = request["video"].GetString();
+  int top_k = 3;
+  if (request.HasMember("top_k")) {
+    const auto &value = request["top_k"];
+    if (!value.IsInt() || value.GetInt() <= 0 || value.GetInt() > MAX_TOP_K) {
+      return error_response(id, "'top_k' must be an integer between 1 and " +
+                                    std::to_string(MAX_TOP_K));
+    }
+    top_k = value.GetInt();
+  }
+
+  std::vector<InferenceBackend::InferenceResult> results;
+  try {
+    // Spans recorded by the service nest under this one in the timeline
+    TRACE_SCOPE("request", .video = video, .request = id);
+    results = service_.classify(video, top_k);
+  } catch (const std::exception &e) {
+    return error_response(id, e.what());
+  }
+
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("id");
+  writer.String(id.c_str(), static_cast<rapidjson::SizeType>(id.size()));
+  writer.Key("video");
+  writer.String(video.c_str(), static_cast<rapidjson::SizeType>(video.size()));
+  writer.Key("predictions");
+  writer.StartArray();
+  for (const auto &result : results) {
+    writer.StartObject();
+    writer.Key("label");
+    writer.String(result.label.c_str(),
+                  static_cast<rapidjson::SizeType>(result.label.size()));
+    writer.Key("probability");
+    writer.Double(static_cast<double>(result.probability));
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return buffer.GetString();
+}
@@ -0,0 +1,167 @@
+#include "video_classification/classification_service.hpp"
+#include "video_classification/processor_factory.hpp"
+#include "video_classification/tracer.hpp"
+#include "video_classification/video_utils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace {
+// Stored per duplicate so later requests can ask for more than the first
+constexpr int STORED_PREDICTIONS = 5;
+}
+
+ClassificationService::ClassificationService(const ServiceOptions &options)
+    : options_(options) {
+  const size_t num_clients = std::max<size_t>(options_.num_clients, 1);
+  // ONNX Runtime sessions take concurrent calls, so one backend is lent out
+  // to every slot instead of loading the model once per slot
+  const size_t num_backends =
+      options_.backend == "onnxruntime" ? 1 : num_clients;
+  clients_.reserve(num_backends);
+  idle_clients_.reserve(num_clients);
+  for (size_t i = 0; i < num_backends; ++i) {
+    clients_.push_back(create_backend(options_.backend, options_.server_url,
+                                      options_.labels_file));
+  }
+  for (size_t i = 0; i < num_clients; ++i) {
+    idle_clients_.push_back(clients_[i % num_backends].get());
+  }
+
+  clients_.front()->get_model_info(options_.model_name, model_info_);
+  processor_ = load_processor(options_.config_file, options_.model_name,
+                              options_.model_type);
+  if (!options_.fingerprint_index.empty()) {
+    fingerprints_ = std::make_unique<FingerprintIndex>(
+        options_.fingerprint_index, options_.duplicate_distance);
+  }
+}
+
+InferenceBackend *ClassificationService::acquire_client() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  client_cv_.wait(lock, [this] { return !idle_clients_.empty(); });
+  InferenceBackend *client = idle_clients_.back();
+  idle_clients_.pop_back();
+  return client;
+}
+
+void ClassificationService::release_client(InferenceBackend *client) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_clients_.push_back(client);
+  }
+  client_cv_.notify_one();
+}
+
+std::vector<InferenceBackend::InferenceResult>
+ClassificationService::classify(const std::string &video_path, int top_k) {
+  TRACE_SCOPE("classify", .video = video_path);
+  std::shared_ptr<const VideoSeekIndex> seek_index;
+  if (!options_.seek_index_dir.empty()) {
+    seek_index =
+        VideoSeekIndex::load_or_build(video_path, options_.seek_index_dir);
+  }
+  double duration = 0.0;
+  auto frames = read_video_frames(video_path, options_.window_size,
+                                  options_.color_format, seek_index.get(),
+                                  &duration);
+  frames = pad_video_frames(frames, options_.window_size);
+  if (!fingerprints_) {
+    return classify_window(video_path, frames, top_k);
+  }
+
+  VideoFingerprint fingerprint;
+  {
+    TRACE_SCOPE("fingerprint", .video = video_path);
+    fingerprint =
+        VideoFingerprint::from_frames(frames, options_.color_format, duration);
+  }
+  auto match = fingerprints_->find(fingerprint);
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++duplicate_stats_.lookups;
+    if (match) {
+      ++duplicate_stats_.hits;
+    }
+  }
+  if (match) {
+    auto &predictions = match->predictions;
+    predictions.resize(std::min(predictions.size(),
+                                static_cast<size_t>(std::max(top_k, 0))));
+    return predictions;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto results =
+      classify_window(video_path, frames, std::max(top_k, STORED_PREDICTIONS));
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++classified_;
+    classified_ms_ += std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  }
+  fingerprints_->add(video_path, fingerprint, results);
+  results.resize(
+      std::min(results.size(), static_cast<size_t>(std::max(top_k, 0))));
+  return results;
+}
+
+DuplicateStats ClassificationService::duplicate_stats() const {
+  std::lock_guard<std::mutex> lock(stats_mutex_);
+  DuplicateStats stats = duplicate_stats_;
+  if (classified_ > 0) {
+    stats.saved_ms = static_cast<double>(stats.hits) * classified_ms_ /
+                     static_cast<double>(classified_);
+  }
+  return stats;
+}
+
+std::vector<InferenceBackend::InferenceResult>
+ClassificationService::classify_window(
+    [[maybe_unused]] const std::string &video_path,
+    const std::vector<cv::Mat> &frames, int top_k) {
+  std::vector<float> pixel_values;
+  {
+    TRACE_SCOPE("preprocess", .video = video_path);
+    pixel_values =
+        options_.color_format == FrameColorFormat::YUV420
+            ? processor_->process_yuv420(frames, model_info_.input_c_,
+                                         model_info_.input_format_)
+            : processor_->process(frames, model_info_.input_c_,
+                                  model_info_.input_format_);
+  }
+  const size_t expected_elements = static_cast<size_t>(options_.window_size) *
+                                   static_cast<size_t>(model_info_.input_c_) *
+                                   static_cast<size_t>(model_info_.input_h_) *
+                                   static_cast<size_t>(model_info_.input_w_);
+  if (pixel_values.size() != expected_elements) {
+    throw std::runtime_error("Invalid input data size: expected " +
+                             std::to_string(expected_elements) +
+                             " elements, got " +
+                             std::to_string(pixel_values.size()));
+  }
+
+  std::vector<int64_t> shape = {1, options_.window_size, model_info_.input_c_,
+                                model_info_.input_h_, model_info_.input_w_};
+
+  InferenceBackend *client = nullptr;
+  {
+    TRACE_SCOPE("wait_client", .video = video_path);
+    client = acquire_client();
+  }
+  try {
+    TRACE_SCOPE("infer", .video = video_path);
+    // Windows are classified on the caller's worker thread
+    thread_local std::vector<float> logits;
+    client->infer_logits_into(pixel_values, options_.model_name, model_info_,
+                              shape, logits);
+    auto results = client->postprocess_results(logits, top_k);
+    release_client(client);
+    return results;
+  } catch (...) {
+    release_client(client);
+    throw;
+  }
+}
@@ -0,0 +1,95 @@
+#include "video_classification/ensemble_classifier.hpp"
+#include "video_classification/processor_factory.hpp"
+
+#include <future>
+#include <stdexcept>
+
+EnsembleClassifier::EnsembleClassifier(
+    const std::string &server_url, const std::string &labels_file,
+    const std::vector<EnsembleMemberSpec> &specs, const std::string &backend) {
+  if (specs.empty()) {
+    throw std::runtime_error("Ensemble requires at least one model");
+  }
+  members_.reserve(specs.size());
+  for (const auto &spec : specs) {
+    Member member;
+    member.model_name = spec.model_name;
+    member.client = create_backend(backend, server_url, labels_file);
+    member.client->get_model_info(spec.model_name, member.model_info);
+    std::string model_type = spec.model_type;
+    member.processor =
+        load_processor(spec.config_file, spec.model_name, model_type);
+    members_.push_back(std::move(member));
+  }
+}
+
+EnsembleClassifier::MemberResult
+EnsembleClassifier::run_member(Member &member,
+                               const std::vector<cv::Mat> &frames) {
+  const ModelInfo &info = member.model_info;
+  auto pixel_values =
+      member.processor->process(frames, info.input_c_, info.input_format_);
+
+  const size_t expected_elements = frames.size() *
+                                   static_cast<size_t>(info.input_c_) *
+                                   static_cast<size_t>(info.input_h_) *
+                                   static_cast<size_t>(info.input_w_);
+  if (pixel_values.size() != expected_elements) {
+    throw std::runtime_error("Invalid input data size for model '" +
+                             member.model_name + "': expected " +
+                             std::to_string(expected_elements) +
+                             " elements, got " +
+                             std::to_string(pixel_values.size()));
+  }
+
+  std::vector<int64_t> shape = {1, static_cast<int64_t>(frames.size()),
+                                info.input_c_, info.input_h_, info.input_w_};
+
+  MemberResult result;
+  result.model_name = member.model_name;
+  member.client->infer_logits_into(pixel_values, member.model_name, info,
+                                   shape, member.logits);
+  result.logits = member.logits;
+  result.predictions = member.client->postprocess_results(result.logits);
+  return result;
+}
+
+EnsembleClassifier::Result
+EnsembleClassifier::classify(const std::vector<cv::Mat> &frames, bool fuse) {
+  // Each member has its own client, so requests can be in flight together
+  std::vector<std::future<MemberResult>> pending;
+  pending.reserve(members_.size());
+  for (auto &member : members_) {
+    pending.push_back(std::async(std::launch::async, [this, &member, &frames] {
+      return run_member(member, frames);
+    }));
+  }
+
+  Result result;
+  result.members.reserve(pending.size());
+  for (auto &future : pending) {
+    result.members.push_back(future.get());
+  }
+
+  if (fuse) {
+    const size_t num_classes = result.members.front().logits.size();
+    std::vector<float> fused_logits(num_classes, 0.0f);
+    for (const auto &member : result.members) {
+      if (member.logits.size() != num_classes) {
+        throw std::runtime_error(
+            "Cannot fuse model '" + member.model_name + "' with " +
+            std::to_string(member.logits.size()) + " classes into ensemble with " +
+            std::to_string(num_classes) + " classes");
+      }
+      for (size_t i = 0; i < num_classes; ++i) {
+        fused_logits[i] += member.logits[i];
+      }
+    }
+    for (auto &logit : fused_logits) {
+      logit /= static_cast<float>(result.members.size());
+    }
+    result.fused = members_.front().client->postprocess_results(fused_logits);
+  }
+
+  return result;
+}
@@ -1,4 +1,6 @@
 #include "video_classification/image_processor.hpp"
+#include <algorithm>
+#include <stdexcept>
 
 std::vector<float> ImageProcessor::normalize_and_convert(
     const std::vector<cv::Mat> &channels_vec,
@@ -48,3 +50,221 @@ std::vector<float> ImageProcessor::normalize_and_convert(
 
   return pixel_values;
 }
+
+cv::Size ImageProcessor::shortest_edge_size(const cv::Size &frame_size,
+                                            int edge) {
+  int height = frame_size.height;
+  int width = frame_size.width;
+  if (height < width) {
+    return cv::Size(static_cast<int>(static_cast<float>(width) /
+                                     static_cast<float>(height) *
+                                     static_cast<float>(edge)),
+                    edge);
+  }
+  return cv::Size(edge, static_cast<int>(static_cast<float>(height) /
+                                         static_cast<float>(width) *
+                                         static_cast<float>(edge)));
+}
+
+std::vector<cv::Rect> ImageProcessor::spatial_crops(const cv::Size &resized,
+                                                    int crop_size,
+                                                    int num_crops) {
+  std::vector<cv::Rect> crops;
+  const int top = (resized.height - crop_size) / 2;
+  const int left = (resized.width - crop_size) / 2;
+  if (num_crops <= 1) {
+    crops.emplace_back(left, top, crop_size, crop_size);
+    return crops;
+  }
+
+  const bool landscape = resized.width >= resized.height;
+  const int span = (landscape ? resized.width : resized.height) - crop_size;
+  for (int i = 0; i < num_crops; ++i) {
+    const int offset = span * i / (num_crops - 1);
+    if (landscape) {
+      crops.emplace_back(offset, top, crop_size, crop_size);
+    } else {
+      crops.emplace_back(left, offset, crop_size, crop_size);
+    }
+  }
+  return crops;
+}
+
+namespace {
+template <typename T>
+void normalize_pixels(const cv::Mat &crop, int channels, bool nhwc,
+                      const std::vector<float> &scale,
+                      const std::vector<float> &bias, float *out) {
+  const size_t plane = static_cast<size_t>(crop.rows) *
+                       static_cast<size_t>(crop.cols);
+  const size_t num_channels = static_cast<size_t>(channels);
+  for (int y = 0; y < crop.rows; ++y) {
+    const T *row = crop.ptr<T>(y);
+    for (int x = 0; x < crop.cols; ++x) {
+      const size_t pixel = static_cast<size_t>(y) *
+                               static_cast<size_t>(crop.cols) +
+                           static_cast<size_t>(x);
+      for (size_t c = 0; c < num_channels; ++c) {
+        const float value =
+            static_cast<float>(row[static_cast<size_t>(x) * num_channels + c]) *
+                scale[c] +
+            bias[c];
+        if (nhwc) {
+          out[pixel * num_channels + c] = value;
+        } else {
+          out[c * plane + pixel] = value;
+        }
+      }
+    }
+  }
+}
+}
+
+void ImageProcessor::normalize_crop(const cv::Mat &crop, int channels,
+                                    const std::string &format,
+                                    float *out) const {
+  std::vector<float> scale, bias;
+  channel_affine(scale, bias);
+  const bool nhwc = format == "FORMAT_NHWC";
+  if (crop.depth() == CV_8U) {
+    normalize_pixels<uchar>(crop, channels, nhwc, scale, bias, out);
+  } else {
+    cv::Mat float_crop;
+    crop.convertTo(float_crop, CV_32F);
+    normalize_pixels<float>(float_crop, channels, nhwc, scale, bias, out);
+  }
+}
+
+std::vector<float>
+ImageProcessor::process_multi_crop(const std::vector<cv::Mat> &frames,
+                                   int channels, const std::string &format,
+                                   int num_crops) const {
+  num_crops = std::max(num_crops, 1);
+  std::vector<float> pixel_values;
+  if (frames.empty()) {
+    return pixel_values;
+  }
+
+  const ResizePlan first_plan = resize_plan(frames.front().size(), true);
+  const size_t frame_elements = static_cast<size_t>(channels) *
+                                static_cast<size_t>(first_plan.crop_size) *
+                                static_cast<size_t>(first_plan.crop_size);
+  const size_t view_elements = frames.size() * frame_elements;
+  pixel_values.resize(static_cast<size_t>(num_crops) * view_elements);
+
+  cv::Mat resized;
+  for (size_t f = 0; f < frames.size(); ++f) {
+    const ResizePlan plan = resize_plan(frames[f].size(), true);
+    cv::resize(frames[f], resized, plan.size, 0, 0, plan.interpolation);
+
+    const auto crops = spatial_crops(resized.size(), plan.crop_size, num_crops);
+    for (size_t v = 0; v < crops.size(); ++v) {
+      float *out =
+          pixel_values.data() + v * view_elements + f * frame_elements;
+      normalize_crop(resized(crops[v]), channels, format, out);
+    }
+  }
+  return pixel_values;
+}
+
+namespace {
+/**
+ * @brief Converts cropped Y/U/V planes to RGB and normalizes in one pass
+ */
+void normalize_yuv_crop(const cv::Mat &y_plane, const cv::Mat &u_plane,
+                        const cv::Mat &v_plane, bool nhwc,
+                        const std::vector<float> &scale,
+                        const std::vector<float> &bias, float *out) {
+  const size_t plane = static_cast<size_t>(y_plane.rows) *
+                       static_cast<size_t>(y_plane.cols);
+  for (int row = 0; row < y_plane.rows; ++row) {
+    const uchar *y_row = y_plane.ptr<uchar>(row);
+    const uchar *u_row = u_plane.ptr<uchar>(row);
+    const uchar *v_row = v_plane.ptr<uchar>(row);
+    for (int col = 0; col < y_plane.cols; ++col) {
+      const float y = 1.164f * (static_cast<float>(y_row[col]) - 16.0f);
+      const float u = static_cast<float>(u_row[col]) - 128.0f;
+      const float v = static_cast<float>(v_row[col]) - 128.0f;
+      const float rgb[3] = {
+          std::clamp(y + 1.596f * v, 0.0f, 255.0f),
+          std::clamp(y - 0.813f * v - 0.391f * u, 0.0f, 255.0f),
+          std::clamp(y + 2.018f * u, 0.0f, 255.0f)};
+
+      const size_t pixel = static_cast<size_t>(row) *
+                               static_cast<size_t>(y_plane.cols) +
+                           static_cast<size_t>(col);
+      for (size_t c = 0; c < 3; ++c) {
+        const float value = rgb[c] * scale[c] + bias[c];
+        if (nhwc) {
+          out[pixel * 3 + c] = value;
+        } else {
+          out[c * plane + pixel] = value;
+        }
+      }
+    }
+  }
+}
+}
+
+std::vector<float>
+ImageProcessor::process_yuv420(const std::vector<cv::Mat> &frames,
+                               int channels, const std::string &format,
+                               int num_crops) const {
+  if (channels != 3) {
+    throw std::runtime_error("YUV420 input requires 3 channels, got " +
+                             std::to_string(channels));
+  }
+  num_crops = std::max(num_crops, 1);
+  const bool multi_crop = num_crops > 1;
+  std::vector<float> pixel_values;
+  if (frames.empty()) {
+    return pixel_values;
+  }
+
+  std::vector<float> scale, bias;
+  channel_affine(scale, bias);
+  const bool nhwc = format == "FORMAT_NHWC";
+
+  cv::Mat y_resized, u_resized, v_resized;
+  size_t frame_elements = 0;
+  size_t view_elements = 0;
+  for (size_t f = 0; f < frames.size(); ++f) {
+    const cv::Mat &frame = frames[f];
+    if (frame.type() != CV_8UC1 || frame.rows % 3 != 0 || frame.cols % 2 != 0) {
+      throw std::runtime_error("Expecting I420 frames (CV_8UC1, height * 3 / 2 "
+                               "rows)");
+    }
+    const int height = frame.rows * 2 / 3;
+    const int width = frame.cols;
+    // I420: full-resolution Y, then quarter-size U and V planes back to back
+    const cv::Mat y_plane = frame.rowRange(0, height);
+    const uchar *chroma = frame.ptr<uchar>(height);
+    const cv::Mat u_plane(height / 2, width / 2, CV_8UC1,
+                          const_cast<uchar *>(chroma));
+    const cv::Mat v_plane(height / 2, width / 2, CV_8UC1,
+                          const_cast<uchar *>(chroma) +
+                              static_cast<size_t>(height / 2) *
+                                  static_cast<size_t>(width / 2));
+
+    const ResizePlan plan = resize_plan(cv::Size(width, height), multi_crop);
+    cv::resize(y_plane, y_resized, plan.size, 0, 0, plan.interpolation);
+    cv::resize(u_plane, u_resized, plan.size, 0, 0, plan.interpolation);
+    cv::resize(v_plane, v_resized, plan.size, 0, 0, plan.interpolation);
+
+    if (f == 0) {
+      frame_elements = 3 * static_cast<size_t>(plan.crop_size) *
+                       static_cast<size_t>(plan.crop_size);
+      view_elements = frames.size() * frame_elements;
+      pixel_values.resize(static_cast<size_t>(num_crops) * view_elements);
+    }
+
+    const auto crops = spatial_crops(plan.size, plan.crop_size, num_crops);
+    for (size_t v = 0; v < crops.size(); ++v) {
+      float *out =
+          pixel_values.data() + v * view_elements + f * frame_elements;
+      normalize_yuv_crop(y_resized(crops[v]), u_resized(crops[v]),
+                         v_resized(crops[v]), nhwc, scale, bias, out);
+    }
+  }
+  return pixel_values;
+}
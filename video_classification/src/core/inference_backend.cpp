@@ -0,0 +1,149 @@
+#include "video_classification/inference_backend.hpp"
+#include "video_classification/triton_client.hpp"
+#ifdef VIDEO_CLASSIFICATION_WITH_ONNXRUNTIME
+#include "video_classification/onnxruntime_backend.hpp"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+
+InferenceBackend::InferenceBackend(const std::string &labels_file) {
+  if (!labels_file.empty()) {
+    load_labels(labels_file);
+  }
+}
+
+void InferenceBackend::load_labels(const std::string &labels_file) {
+  if (labels_file.empty()) {
+    return;
+  }
+
+  std::ifstream file(labels_file);
+  if (!file.is_open()) {
+    std::cerr << "Warning: Could not open labels file: " << labels_file
+              << std::endl;
+    return;
+  }
+
+  std::string line;
+  int id = 0;
+  while (std::getline(file, line)) {
+    if (!line.empty()) {
+      id2label_[std::to_string(id)] = line;
+      id++;
+    }
+  }
+}
+
+std::vector<InferenceBackend::InferenceResult>
+InferenceBackend::infer(const std::vector<float> &input_data,
+                        const std::string &model_name,
+                        const ModelInfo &model_info,
+                        const std::vector<int64_t> &shape) {
+  return postprocess_results(
+      infer_logits(input_data, model_name, model_info, shape));
+}
+
+size_t InferenceBackend::infer_logits_into(std::span<const float> input_data,
+                                           const std::string &model_name,
+                                           const ModelInfo &model_info,
+                                           const std::vector<int64_t> &shape,
+                                           std::span<float> logits) {
+  const auto result =
+      infer_logits(std::vector<float>(input_data.begin(), input_data.end()),
+                   model_name, model_info, shape);
+  if (result.size() > logits.size()) {
+    throw std::runtime_error("Output buffer holds " +
+                             std::to_string(logits.size()) +
+                             " logits, model returned " +
+                             std::to_string(result.size()));
+  }
+  std::copy(result.begin(), result.end(), logits.begin());
+  return result.size();
+}
+
+void InferenceBackend::infer_logits_into(std::span<const float> input_data,
+                                         const std::string &model_name,
+                                         const ModelInfo &model_info,
+                                         const std::vector<int64_t> &shape,
+                                         std::vector<float> &logits) {
+  logits = infer_logits(std::vector<float>(input_data.begin(), input_data.end()),
+                        model_name, model_info, shape);
+}
+
+std::vector<InferenceBackend::InferenceResult>
+InferenceBackend::postprocess_results(const std::vector<float> &logits,
+                                  int top_k) {
+  std::vector<InferenceResult> results;
+
+  std::vector<float> probs(logits.size());
+  float max_logit = *std::max_element(logits.begin(), logits.end());
+  float sum = 0.0;
+  for (size_t i = 0; i < logits.size(); ++i) {
+    probs[i] = std::exp(logits[i] - max_logit);
+    sum += probs[i];
+  }
+  for (auto &p : probs) {
+    p /= sum;
+  }
+
+  std::vector<int> indices(probs.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  std::sort(indices.begin(), indices.end(), [&probs](int a, int b) {
+    return probs[static_cast<size_t>(a)] > probs[static_cast<size_t>(b)];
+  });
+
+  for (int i = 0; i < std::min(top_k, static_cast<int>(indices.size())); ++i) {
+    int idx = indices[static_cast<size_t>(i)];
+    InferenceResult result;
+    if (id2label_.count(std::to_string(idx))) {
+      result.label = id2label_.at(std::to_string(idx));
+    } else {
+      result.label = "unknown_" + std::to_string(idx);
+    }
+    result.probability = probs[static_cast<size_t>(idx)];
+    results.push_back(result);
+  }
+
+  return results;
+}
+
+int InferenceBackend::label_index(const std::string &label) const {
+  for (const auto &[id, name] : id2label_) {
+    if (name == label) {
+      return std::stoi(id);
+    }
+  }
+  // Accept the names postprocess_results() gives to unlabeled outputs
+  const std::string prefix = "unknown_";
+  if (label.rfind(prefix, 0) == 0) {
+    try {
+      return std::stoi(label.substr(prefix.size()));
+    } catch (const std::exception &) {
+    }
+  }
+  return -1;
+}
+
+std::unique_ptr<InferenceBackend>
+create_backend(const std::string &backend, const std::string &server_url,
+               const std::string &labels_file) {
+  if (backend == "triton") {
+    return std::make_unique<TritonClient>(server_url, labels_file);
+  } else if (backend == "onnxruntime") {
+#ifdef VIDEO_CLASSIFICATION_WITH_ONNXRUNTIME
+    return std::make_unique<OnnxRuntimeBackend>(labels_file);
+#else
+    throw std::runtime_error(
+        "ONNX Runtime backend not available, rebuild with "
+        "-DENABLE_ONNXRUNTIME=ON");
+#endif
+  } else {
+    throw std::runtime_error("Unknown backend: " + backend +
+                             ". Supported backends: triton, onnxruntime");
+  }
+}
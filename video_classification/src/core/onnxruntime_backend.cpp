@@ -0,0 +1,200 @@
+#include "video_classification/onnxruntime_backend.hpp"
+
+#include <functional>
+#include <numeric>
+#include <opencv2/core.hpp>
+#include <stdexcept>
+
+namespace {
+constexpr size_t EXPECTED_INPUT_DIMS = 5; // [batch, frames, c, h, w]
+constexpr int DEFAULT_FRAME_COUNT = 16;   // Assumed for a dynamic frame axis
+
+int64_t element_count(const std::vector<int64_t> &shape) {
+  return std::accumulate(shape.begin(), shape.end(), int64_t{1},
+                         std::multiplies<int64_t>());
+}
+}
+
+OnnxRuntimeBackend::OnnxRuntimeBackend(const std::string &labels_file,
+                                       int intra_op_threads, int max_batch_size)
+    : InferenceBackend(labels_file),
+      env_(ORT_LOGGING_LEVEL_WARNING, "video_classification"),
+      memory_info_(
+          Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)),
+      max_batch_size_(max_batch_size) {
+  session_options_.SetIntraOpNumThreads(intra_op_threads);
+  session_options_.SetGraphOptimizationLevel(
+      GraphOptimizationLevel::ORT_ENABLE_ALL);
+}
+
+OnnxRuntimeBackend::ModelSession &
+OnnxRuntimeBackend::session_for(const std::string &model_path) {
+  std::lock_guard<std::mutex> lock(sessions_mutex_);
+  auto it = sessions_.find(model_path);
+  if (it != sessions_.end()) {
+    return *it->second;
+  }
+
+  auto model = std::make_unique<ModelSession>();
+  try {
+    model->session = std::make_unique<Ort::Session>(env_, model_path.c_str(),
+                                                    session_options_);
+  } catch (const Ort::Exception &e) {
+    throw std::runtime_error("Failed to load ONNX model '" + model_path +
+                             "': " + e.what());
+  }
+  if (model->session->GetInputCount() != 1) {
+    throw std::runtime_error("Expecting 1 input, got " +
+                             std::to_string(model->session->GetInputCount()));
+  }
+  if (model->session->GetOutputCount() != 1) {
+    throw std::runtime_error("Expecting 1 output, got " +
+                             std::to_string(model->session->GetOutputCount()));
+  }
+
+  Ort::AllocatorWithDefaultOptions allocator;
+  model->input_name = model->session->GetInputNameAllocated(0, allocator).get();
+  model->output_name =
+      model->session->GetOutputNameAllocated(0, allocator).get();
+
+  auto output_type_info = model->session->GetOutputTypeInfo(0);
+  auto output_shape =
+      output_type_info.GetTensorTypeAndShapeInfo().GetShape();
+  if (output_shape.empty()) {
+    throw std::runtime_error("Model output has no dimensions");
+  }
+  model->output_shape.assign(output_shape.begin() + 1, output_shape.end());
+  for (int64_t dim : model->output_shape) {
+    if (dim < 0) {
+      throw std::runtime_error(
+          "Variable-size dimension in model output not supported");
+    }
+  }
+  model->binding = std::make_unique<Ort::IoBinding>(*model->session);
+
+  auto &inserted = *model;
+  sessions_.emplace(model_path, std::move(model));
+  return inserted;
+}
+
+void OnnxRuntimeBackend::get_model_info(const std::string &model_name,
+                                        ModelInfo &model_info) {
+  ModelSession &model = session_for(model_name);
+
+  auto input_type_info = model.session->GetInputTypeInfo(0);
+  auto input_tensor_info = input_type_info.GetTensorTypeAndShapeInfo();
+  if (input_tensor_info.GetElementType() !=
+      ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+    throw std::runtime_error("Expecting FP32 input for model '" + model_name +
+                             "'");
+  }
+  auto input_shape = input_tensor_info.GetShape();
+  if (input_shape.size() != EXPECTED_INPUT_DIMS) {
+    throw std::runtime_error("Expecting input to have " +
+                             std::to_string(EXPECTED_INPUT_DIMS) +
+                             " dimensions, got " +
+                             std::to_string(input_shape.size()));
+  }
+
+  model_info.input_name_ = model.input_name;
+  model_info.output_name_ = model.output_name;
+  model_info.input_datatype_ = "FP32";
+  model_info.input_format_ = "FORMAT_NCHW"; // export.py uses [B, T, C, H, W]
+  model_info.input_t_ =
+      input_shape[1] < 0 ? DEFAULT_FRAME_COUNT : static_cast<int>(input_shape[1]);
+  model_info.input_c_ = static_cast<int>(input_shape[2]);
+  model_info.input_h_ = static_cast<int>(input_shape[3]);
+  model_info.input_w_ = static_cast<int>(input_shape[4]);
+  model_info.type1_ = CV_32FC1;
+  model_info.type3_ = CV_32FC3;
+  model_info.max_batch_size_ =
+      input_shape[0] < 0 ? max_batch_size_ : static_cast<int>(input_shape[0]);
+}
+
+void OnnxRuntimeBackend::run(ModelSession &model,
+                             std::span<const float> input_data,
+                             const ModelInfo &model_info,
+                             const std::vector<int64_t> &shape) {
+  if (shape.empty() ||
+      static_cast<size_t>(element_count(shape)) != input_data.size()) {
+    throw std::runtime_error("Input data size does not match input shape");
+  }
+  const int64_t batch = shape[0];
+
+  try {
+    // ORT only reads bound inputs, so the caller's buffer is wrapped as is
+    Ort::Value input_tensor = Ort::Value::CreateTensor<float>(
+        memory_info_, const_cast<float *>(input_data.data()),
+        input_data.size(), shape.data(), shape.size());
+    model.binding->BindInput(model_info.input_name_.c_str(), input_tensor);
+
+    if (model.bound_batch != batch) {
+      std::vector<int64_t> output_shape = {batch};
+      output_shape.insert(output_shape.end(), model.output_shape.begin(),
+                          model.output_shape.end());
+      model.output_buffer.assign(
+          static_cast<size_t>(element_count(output_shape)), 0.0f);
+      model.output_tensor = Ort::Value::CreateTensor<float>(
+          memory_info_, model.output_buffer.data(), model.output_buffer.size(),
+          output_shape.data(), output_shape.size());
+      model.binding->BindOutput(model_info.output_name_.c_str(),
+                                model.output_tensor);
+      model.bound_batch = batch;
+    }
+
+    model.session->Run(Ort::RunOptions{nullptr}, *model.binding);
+  } catch (const Ort::Exception &e) {
+    throw std::runtime_error("Inference failed: " + std::string(e.what()));
+  }
+}
+
+void OnnxRuntimeBackend::run_unbound(ModelSession &model,
+                                     std::span<const float> input_data,
+                                     const std::vector<int64_t> &shape,
+                                     std::vector<float> &logits) {
+  if (shape.empty() ||
+      static_cast<size_t>(element_count(shape)) != input_data.size()) {
+    throw std::runtime_error("Input data size does not match input shape");
+  }
+  try {
+    Ort::Value input_tensor = Ort::Value::CreateTensor<float>(
+        memory_info_, const_cast<float *>(input_data.data()),
+        input_data.size(), shape.data(), shape.size());
+    const char *input_name = model.input_name.c_str();
+    const char *output_name = model.output_name.c_str();
+    auto outputs = model.session->Run(Ort::RunOptions{nullptr}, &input_name,
+                                      &input_tensor, 1, &output_name, 1);
+    const float *output = outputs[0].GetTensorData<float>();
+    logits.assign(output,
+                  output +
+                      outputs[0].GetTensorTypeAndShapeInfo().GetElementCount());
+  } catch (const Ort::Exception &e) {
+    throw std::runtime_error("Inference failed: " + std::string(e.what()));
+  }
+}
+
+std::vector<float>
+OnnxRuntimeBackend::infer_logits(const std::vector<float> &input_data,
+                                 const std::string &model_name,
+                                 const ModelInfo &model_info,
+                                 const std::vector<int64_t> &shape) {
+  std::vector<float> logits;
+  infer_logits_into(input_data, model_name, model_info, shape, logits);
+  return logits;
+}
+
+void OnnxRuntimeBackend::infer_logits_into(std::span<const float> input_data,
+                                           const std::string &model_name,
+                                           const ModelInfo &model_info,
+                                           const std::vector<int64_t> &shape,
+                                           std::vector<float> &logits) {
+  ModelSession &model = session_for(model_name);
+  std::unique_lock<std::mutex> lock(model.mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    // Another thread holds the binding; Session::Run is thread-safe
+    run_unbound(model, input_data, shape, logits);
+    return;
+  }
+  run(model, input_data, model_info, shape);
+  logits.assign(model.output_buffer.begin(), model.output_buffer.end());
+}
@@ -0,0 +1,151 @@
+#include "video_classification/parallel_video_decoder.hpp"
+#include "video_classification/tracer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+size_t resolve_threads(size_t requested) {
+  if (requested > 0) {
+    return requested;
+  }
+  return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+}
+
+ParallelVideoDecoder::ParallelVideoDecoder(const std::string &video_path,
+                                           const ParallelDecodeOptions &options)
+    : video_path_(video_path), options_(options),
+      pool_(resolve_threads(options.num_threads)) {
+  options_.max_buffered_windows =
+      std::max<size_t>(options_.max_buffered_windows, 1);
+}
+
+void ParallelVideoDecoder::decode(
+    const std::vector<VideoProcessor::WindowIndices> &windows,
+    const WindowCallback &on_window) {
+  if (windows.empty()) {
+    return;
+  }
+
+  // Segments must fit in the buffer together or later decoders just wait
+  const size_t threads = pool_.size();
+  const size_t even_split = (windows.size() + threads - 1) / threads;
+  const size_t buffer_share =
+      std::max<size_t>(options_.max_buffered_windows / threads, 1);
+  const size_t segment_length = std::min(even_split, buffer_share);
+  const size_t num_segments =
+      (windows.size() + segment_length - 1) / segment_length;
+
+  std::mutex mutex;
+  std::condition_variable ready_cv;
+  std::condition_variable space_cv;
+  std::map<size_t, std::vector<cv::Mat>> decoded;
+  size_t next_to_deliver = 0;
+  bool stop = false;
+  std::exception_ptr error;
+  std::atomic<size_t> next_segment{0};
+
+  auto decode_segments = [&] {
+    try {
+      VideoProcessor processor;
+      if (!processor.openVideo(video_path_, options_.seek_index)) {
+        throw std::runtime_error("Failed to open video: " + video_path_);
+      }
+      // Segments are claimed in order, so the one holding next_to_deliver is
+      // always being decoded and waiting on the buffer cannot deadlock
+      for (size_t segment = next_segment++; segment < num_segments;
+           segment = next_segment++) {
+        const size_t first = segment * segment_length;
+        const size_t last = std::min(first + segment_length, windows.size());
+        for (size_t w = first; w < last; ++w) {
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            space_cv.wait(lock, [&] {
+              return stop ||
+                     w < next_to_deliver + options_.max_buffered_windows;
+            });
+            if (stop) {
+              return;
+            }
+          }
+
+          {
+            TRACE_SCOPE("decode_window", .video = video_path_,
+                        .window = static_cast<int64_t>(w));
+            auto frames = processor.extractFrames(windows[w].indices);
+            if (options_.convert_rgb) {
+              for (auto &frame : frames) {
+                cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
+              }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            decoded.emplace(w, std::move(frames));
+          }
+          ready_cv.notify_all();
+        }
+      }
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        stop = true;
+      }
+      ready_cv.notify_all();
+      space_cv.notify_all();
+    }
+  };
+
+  const size_t workers = std::min(threads, num_segments);
+  for (size_t i = 0; i < workers; ++i) {
+    pool_.submit(decode_segments);
+  }
+
+  try {
+    for (size_t w = 0; w < windows.size(); ++w) {
+      std::vector<cv::Mat> frames;
+      {
+        // Time spent here is decode falling behind the consumer
+        TRACE_SCOPE("wait_window", .video = video_path_,
+                    .window = static_cast<int64_t>(w));
+        std::unique_lock<std::mutex> lock(mutex);
+        ready_cv.wait(lock, [&] { return stop || decoded.count(w) > 0; });
+        if (stop) {
+          break;
+        }
+        auto it = decoded.find(w);
+        frames = std::move(it->second);
+        decoded.erase(it);
+        next_to_deliver = w + 1;
+      }
+      space_cv.notify_all();
+      TRACE_SCOPE("process_window", .video = video_path_,
+                  .window = static_cast<int64_t>(w));
+      on_window(w, windows[w], frames);
+    }
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      stop = true;
+    }
+    space_cv.notify_all();
+  }
+
+  // Decoders reference locals of this call, let them finish before leaving
+  pool_.wait_idle();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
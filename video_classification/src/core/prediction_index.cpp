@@ -0,0 +1,402 @@
+#include "video_classification/prediction_index.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char MAGIC[8] = {'V', 'C', 'P', 'I', 'D', 'X', '0', '1'};
+constexpr uint32_t FORMAT_VERSION = 1;
+constexpr size_t ALIGNMENT = 8;
+
+/**
+ * Layout, every section starting on an 8-byte boundary:
+ *   FileHeader
+ *   video names: uint64 end offsets[num_videos], then the bytes
+ *   label names: uint64 end offsets[num_labels], then the bytes
+ *   windows:     uint32 video[n], float start[n], float end[n]
+ *   postings:    uint64 label begin[num_labels + 1], uint32 window[p],
+ *                float probability[p]
+ */
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_videos;
+  uint32_t num_labels;
+  uint32_t reserved;
+  uint64_t num_windows;
+  uint64_t num_postings;
+  uint64_t video_names_offset;
+  uint64_t label_names_offset;
+  uint64_t windows_offset;
+  uint64_t postings_offset;
+};
+static_assert(sizeof(FileHeader) == 72, "FileHeader must have no padding");
+
+/**
+ * @brief Exclusive advisory lock on a file, held while in scope
+ */
+class FileLock {
+public:
+  explicit FileLock(const std::string &path)
+      : fd_(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)) {
+    if (fd_ < 0 || ::flock(fd_, LOCK_EX) != 0) {
+      if (fd_ >= 0) {
+        ::close(fd_);
+      }
+      throw std::runtime_error("Failed to lock " + path);
+    }
+  }
+  ~FileLock() { ::close(fd_); }
+
+  FileLock(const FileLock &) = delete;
+  FileLock &operator=(const FileLock &) = delete;
+
+private:
+  int fd_;
+};
+
+size_t align_up(size_t offset) {
+  return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+class SectionWriter {
+public:
+  explicit SectionWriter(std::ofstream &out) : out_(out) {}
+
+  template <typename T> void write_array(const T *data, size_t count) {
+    out_.write(reinterpret_cast<const char *>(data),
+               static_cast<std::streamsize>(count * sizeof(T)));
+    offset_ += count * sizeof(T);
+  }
+
+  void write_bytes(const std::string &bytes) {
+    write_array(bytes.data(), bytes.size());
+  }
+
+  /// Pads to the next section boundary and returns its offset
+  size_t align() {
+    static const char zeros[ALIGNMENT] = {};
+    const size_t aligned = align_up(offset_);
+    write_array(zeros, aligned - offset_);
+    return offset_;
+  }
+
+private:
+  std::ofstream &out_;
+  size_t offset_ = 0;
+};
+
+void write_names(SectionWriter &writer, const std::vector<std::string> &names) {
+  std::vector<uint64_t> ends;
+  ends.reserve(names.size());
+  uint64_t end = 0;
+  for (const auto &name : names) {
+    end += name.size();
+    ends.push_back(end);
+  }
+  writer.write_array(ends.data(), ends.size());
+  for (const auto &name : names) {
+    writer.write_bytes(name);
+  }
+}
+
+std::vector<std::string_view> read_names(const unsigned char *data,
+                                         size_t size, uint64_t offset,
+                                         uint32_t count) {
+  const size_t bytes_offset = offset + count * sizeof(uint64_t);
+  if (bytes_offset > size) {
+    throw std::runtime_error("Prediction index is truncated");
+  }
+  const auto *ends = reinterpret_cast<const uint64_t *>(data + offset);
+  const char *bytes = reinterpret_cast<const char *>(data + bytes_offset);
+  std::vector<std::string_view> names;
+  names.reserve(count);
+  uint64_t begin = 0;
+  for (uint32_t i = 0; i < count; ++i) {
+    if (ends[i] < begin || bytes_offset + ends[i] > size) {
+      throw std::runtime_error("Prediction index has a corrupt name table");
+    }
+    names.emplace_back(bytes + begin, ends[i] - begin);
+    begin = ends[i];
+  }
+  return names;
+}
+}
+
+uint32_t
+PredictionIndexWriter::intern(const std::string &name,
+                              std::unordered_map<std::string, uint32_t> &ids,
+                              std::vector<std::string> &names) {
+  auto [it, inserted] =
+      ids.emplace(name, static_cast<uint32_t>(names.size()));
+  if (inserted) {
+    names.push_back(name);
+  }
+  return it->second;
+}
+
+void PredictionIndexWriter::add_posting(uint32_t window,
+                                        const std::string &label,
+                                        float probability) {
+  const uint32_t label_id = intern(label, label_ids_, labels_);
+  if (label_id >= postings_.size()) {
+    postings_.resize(label_id + 1);
+  }
+  postings_[label_id].push_back({window, probability});
+}
+
+void PredictionIndexWriter::add_window(
+    const std::string &video, double start_time, double end_time,
+    const std::vector<InferenceBackend::InferenceResult> &predictions) {
+  const auto window = static_cast<uint32_t>(window_video_.size());
+  window_video_.push_back(intern(video, video_ids_, videos_));
+  window_start_.push_back(static_cast<float>(start_time));
+  window_end_.push_back(static_cast<float>(end_time));
+  for (const auto &prediction : predictions) {
+    add_posting(window, prediction.label, prediction.probability);
+  }
+}
+
+void PredictionIndexWriter::write(const std::string &path) const {
+  // Unique per writer, so concurrent writes never share a temporary file
+  static std::atomic<uint64_t> next_tmp{0};
+  const std::string tmp_path = path + ".tmp." + std::to_string(::getpid()) +
+                               "." + std::to_string(next_tmp++);
+  std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("Failed to create prediction index: " + tmp_path);
+  }
+
+  // Sort every posting list by descending probability for early exit
+  std::vector<uint64_t> posting_begin;
+  posting_begin.reserve(labels_.size() + 1);
+  std::vector<uint32_t> posting_window;
+  std::vector<float> posting_probability;
+  for (size_t label = 0; label < labels_.size(); ++label) {
+    posting_begin.push_back(posting_window.size());
+    std::vector<Posting> list = postings_[label];
+    std::stable_sort(list.begin(), list.end(),
+                     [](const Posting &a, const Posting &b) {
+                       return a.probability > b.probability;
+                     });
+    for (const auto &posting : list) {
+      posting_window.push_back(posting.window);
+      posting_probability.push_back(posting.probability);
+    }
+  }
+  posting_begin.push_back(posting_window.size());
+
+  FileHeader header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = FORMAT_VERSION;
+  header.num_videos = static_cast<uint32_t>(videos_.size());
+  header.num_labels = static_cast<uint32_t>(labels_.size());
+  header.num_windows = window_video_.size();
+  header.num_postings = posting_window.size();
+
+  // The header is rewritten once section offsets are known
+  SectionWriter writer(out);
+  writer.write_array(&header, 1);
+  header.video_names_offset = writer.align();
+  write_names(writer, videos_);
+  header.label_names_offset = writer.align();
+  write_names(writer, labels_);
+  header.windows_offset = writer.align();
+  writer.write_array(window_video_.data(), window_video_.size());
+  writer.align();
+  writer.write_array(window_start_.data(), window_start_.size());
+  writer.align();
+  writer.write_array(window_end_.data(), window_end_.size());
+  header.postings_offset = writer.align();
+  writer.write_array(posting_begin.data(), posting_begin.size());
+  writer.write_array(posting_window.data(), posting_window.size());
+  writer.align();
+  writer.write_array(posting_probability.data(), posting_probability.size());
+
+  out.seekp(0);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.close();
+  if (!out) {
+    std::filesystem::remove(tmp_path);
+    throw std::runtime_error("Failed to write prediction index: " + tmp_path);
+  }
+  std::filesystem::rename(tmp_path, path);
+}
+
+void PredictionIndexWriter::merge_into(const std::string &path,
+                                       const std::string &replace_video) const {
+  FileLock lock(path + ".lock");
+  PredictionIndexWriter merged;
+  if (std::filesystem::exists(path)) {
+    PredictionIndex(path).append_to(merged, replace_video);
+  }
+  const auto offset = static_cast<uint32_t>(merged.num_windows());
+  for (size_t w = 0; w < window_video_.size(); ++w) {
+    merged.add_window(videos_[window_video_[w]], window_start_[w],
+                      window_end_[w], {});
+  }
+  for (size_t label = 0; label < postings_.size(); ++label) {
+    for (const auto &posting : postings_[label]) {
+      merged.add_posting(offset + posting.window, labels_[label],
+                         posting.probability);
+    }
+  }
+  merged.write(path);
+}
+
+PredictionIndex::PredictionIndex(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open prediction index: " + path);
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    throw std::runtime_error("Invalid prediction index: " + path);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+  void *mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // The mapping keeps the file alive
+  if (mapped == MAP_FAILED) {
+    throw std::runtime_error("Failed to map prediction index: " + path);
+  }
+  data_ = static_cast<const unsigned char *>(mapped);
+
+  try {
+    FileHeader header;
+    std::memcpy(&header, data_, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header.version != FORMAT_VERSION) {
+      throw std::runtime_error("Not a prediction index: " + path);
+    }
+
+    num_windows_ = header.num_windows;
+    const size_t windows_column = align_up(num_windows_ * sizeof(uint32_t));
+    const size_t posting_column =
+        align_up(header.num_postings * sizeof(uint32_t));
+    const size_t posting_table = (header.num_labels + 1) * sizeof(uint64_t);
+    if (header.windows_offset + 3 * windows_column > size_ ||
+        header.postings_offset + posting_table + posting_column +
+                header.num_postings * sizeof(float) >
+            size_) {
+      throw std::runtime_error("Prediction index is truncated: " + path);
+    }
+
+    videos_ = read_names(data_, size_, header.video_names_offset,
+                         header.num_videos);
+    labels_ = read_names(data_, size_, header.label_names_offset,
+                         header.num_labels);
+    for (uint32_t i = 0; i < header.num_labels; ++i) {
+      label_ids_.emplace(labels_[i], i);
+    }
+
+    const unsigned char *windows = data_ + header.windows_offset;
+    window_video_ = reinterpret_cast<const uint32_t *>(windows);
+    window_start_ = reinterpret_cast<const float *>(windows + windows_column);
+    window_end_ =
+        reinterpret_cast<const float *>(windows + 2 * windows_column);
+
+    const unsigned char *postings = data_ + header.postings_offset;
+    posting_begin_ = reinterpret_cast<const uint64_t *>(postings);
+    for (uint32_t i = 0; i < header.num_labels; ++i) {
+      if (posting_begin_[i] > posting_begin_[i + 1]) {
+        throw std::runtime_error("Prediction index has corrupt postings: " +
+                                 path);
+      }
+    }
+    if (posting_begin_[header.num_labels] != header.num_postings) {
+      throw std::runtime_error("Prediction index has corrupt postings: " +
+                               path);
+    }
+    posting_window_ =
+        reinterpret_cast<const uint32_t *>(postings + posting_table);
+    posting_probability_ = reinterpret_cast<const float *>(
+        postings + posting_table + posting_column);
+  } catch (...) {
+    ::munmap(const_cast<unsigned char *>(data_), size_);
+    throw;
+  }
+}
+
+PredictionIndex::~PredictionIndex() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<unsigned char *>(data_), size_);
+  }
+}
+
+std::vector<PredictionHit>
+PredictionIndex::query(const PredictionQuery &query) const {
+  std::vector<PredictionHit> hits;
+  const auto label_it = label_ids_.find(query.label);
+  if (label_it == label_ids_.end()) {
+    return hits;
+  }
+
+  uint32_t video_id = 0;
+  const bool filter_video = !query.video.empty();
+  if (filter_video) {
+    const auto video_it =
+        std::find(videos_.begin(), videos_.end(), query.video);
+    if (video_it == videos_.end()) {
+      return hits;
+    }
+    video_id = static_cast<uint32_t>(video_it - videos_.begin());
+  }
+
+  const uint64_t begin = posting_begin_[label_it->second];
+  const uint64_t end = posting_begin_[label_it->second + 1];
+  for (uint64_t p = begin; p < end; ++p) {
+    const float probability = posting_probability_[p];
+    if (probability < query.min_probability) {
+      break; // Sorted by descending probability
+    }
+    const uint32_t window = posting_window_[p];
+    if (window >= num_windows_ ||
+        (filter_video && window_video_[window] != video_id) ||
+        window_end_[window] < query.start_time ||
+        window_start_[window] > query.end_time) {
+      continue;
+    }
+    hits.push_back({videos_[window_video_[window]], window_start_[window],
+                    window_end_[window], probability});
+    if (query.limit > 0 && hits.size() >= query.limit) {
+      break;
+    }
+  }
+  return hits;
+}
+
+void PredictionIndex::append_to(PredictionIndexWriter &writer,
+                                const std::string &exclude_video) const {
+  // Window and label ids are reassigned by the writer
+  constexpr uint32_t SKIPPED = std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> new_window(num_windows_, SKIPPED);
+  for (size_t w = 0; w < num_windows_; ++w) {
+    const std::string_view video = videos_[window_video_[w]];
+    if (!exclude_video.empty() && video == exclude_video) {
+      continue;
+    }
+    new_window[w] = static_cast<uint32_t>(writer.num_windows());
+    writer.add_window(std::string(video), window_start_[w], window_end_[w], {});
+  }
+  for (size_t label = 0; label < labels_.size(); ++label) {
+    const std::string name(labels_[label]);
+    for (uint64_t p = posting_begin_[label]; p < posting_begin_[label + 1];
+         ++p) {
+      const uint32_t window = posting_window_[p];
+      if (window < num_windows_ && new_window[window] != SKIPPED) {
+        writer.add_posting(new_window[window], name, posting_probability_[p]);
+      }
+    }
+  }
+}
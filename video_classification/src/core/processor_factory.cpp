@@ -0,0 +1,94 @@
+#include "video_classification/processor_factory.hpp"
+#include "video_classification/timesformer_image_processor.hpp"
+#include "video_classification/videomae_image_processor.hpp"
+#include "video_classification/vivit_image_processor.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <rapidjson/error/en.h>
+#include <rapidjson/istreamwrapper.h>
+#include <stdexcept>
+
+void load_config_from_file(const std::string &config_path,
+                           rapidjson::Document &config) {
+  std::ifstream ifs(config_path);
+  if (!ifs.is_open()) {
+    throw std::runtime_error("Failed to open config file: " + config_path);
+  }
+  rapidjson::IStreamWrapper isw(ifs);
+  config.ParseStream(isw);
+  if (config.HasParseError()) {
+    throw std::runtime_error("Failed to parse config file: " + config_path +
+                             " - Error: " +
+                             rapidjson::GetParseError_En(config.GetParseError()) +
+                             " at offset " +
+                             std::to_string(config.GetErrorOffset()));
+  }
+}
+
+std::unique_ptr<ImageProcessor> create_processor(const std::string &model_type,
+                                                 const rapidjson::Document &config) {
+  if (model_type == "vivit") {
+    return std::make_unique<VivitImageProcessor>(config);
+  } else if (model_type == "timesformer") {
+    return std::make_unique<TimeSformerImageProcessor>(config);
+  } else if (model_type == "videomae") {
+    return std::make_unique<VideoMAEImageProcessor>(config);
+  } else {
+    throw std::runtime_error("Unknown model type: " + model_type +
+                             ". Supported types: videomae, vivit, timesformer");
+  }
+}
+
+std::string detect_model_type(const std::string &model_name) {
+  if (model_name.find("vivit") != std::string::npos) {
+    return "vivit";
+  } else if (model_name.find("timesformer") != std::string::npos) {
+    return "timesformer";
+  }
+  return "videomae";
+}
+
+std::unique_ptr<ImageProcessor> load_processor(const std::string &config_file,
+                                               const std::string &model_name,
+                                               std::string &model_type) {
+  rapidjson::Document config;
+
+  if (!config_file.empty()) {
+    // Load from specified config file
+    load_config_from_file(config_file, config);
+    if (config.HasMember("model_type") && config["model_type"].IsString()) {
+      model_type = config["model_type"].GetString();
+    }
+    return create_processor(model_type, config);
+  }
+
+  // Try to auto-detect model type from model name or use specified type
+  if (model_type == "auto") {
+    model_type = detect_model_type(model_name);
+  }
+
+  // Try to load default config file
+  std::string default_config = "configs/" + model_type + ".json";
+  if (std::filesystem::exists(default_config)) {
+    load_config_from_file(default_config, config);
+  } else {
+    // Fallback to hardcoded defaults
+    std::cerr << "Warning: No config file found, using hardcoded defaults for "
+              << model_type << "\n";
+    std::string config_json;
+    if (model_type == "vivit") {
+      config_json = R"({"shortest_edge": 256, "crop_size": 224, "rescale_factor": 0.00784313725, "offset": true, "mean": [0.485, 0.456, 0.406], "std": [0.229, 0.224, 0.225]})";
+    } else if (model_type == "timesformer") {
+      config_json = R"({"shortest_edge": 224, "crop_size": 224, "rescale_factor": 0.003921568627, "mean": [0.45, 0.45, 0.45], "std": [0.225, 0.225, 0.225]})";
+    } else {
+      config_json = R"({"image_size": 224, "mean": [0.485, 0.456, 0.406], "std": [0.229, 0.224, 0.225]})";
+    }
+    config.Parse(config_json.c_str());
+    if (config.HasParseError()) {
+      throw std::runtime_error("Failed to parse default config JSON");
+    }
+  }
+  return create_processor(model_type, config);
+}
@@ -0,0 +1,293 @@
+#include "video_classification/shard_queue.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <rapidjson/document.h>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr const char *MANIFEST_FILE = "manifest.txt";
+constexpr const char *PENDING_DIR = "pending";
+constexpr const char *LEASED_DIR = "leased";
+constexpr const char *DONE_DIR = "done";
+constexpr const char *RESULTS_DIR = "results";
+constexpr const char *RESULTS_SUFFIX = ".jsonl";
+
+std::vector<std::string> read_lines(const fs::path &path) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("Failed to read " + path.string());
+  }
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty()) {
+      lines.push_back(line);
+    }
+  }
+  return lines;
+}
+
+/// Writes a file next to its destination and renames it into place
+void write_atomically(const fs::path &path,
+                      const std::vector<std::string> &lines) {
+  const fs::path tmp_path = path.string() + ".tmp";
+  {
+    std::ofstream out(tmp_path, std::ios::trunc);
+    for (const auto &line : lines) {
+      out << line << '\n';
+    }
+    if (!out) {
+      throw std::runtime_error("Failed to write " + tmp_path.string());
+    }
+  }
+  fs::rename(tmp_path, path);
+}
+
+std::vector<fs::path> sorted_entries(const fs::path &dir) {
+  std::vector<fs::path> entries;
+  std::error_code ec;
+  for (const auto &entry : fs::directory_iterator(dir, ec)) {
+    entries.push_back(entry.path());
+  }
+  std::sort(entries.begin(), entries.end());
+  return entries;
+}
+
+bool touch(const fs::path &path) {
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  return !ec;
+}
+
+/**
+ * @brief Reads the results file of one worker, skipping a torn last line
+ */
+void read_results(const fs::path &path,
+                  const std::function<void(const std::string &video,
+                                           const std::string &line,
+                                           bool failed)> &visit) {
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    rapidjson::Document doc;
+    doc.Parse(line.c_str(), line.size());
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("video") ||
+        !doc["video"].IsString()) {
+      continue;
+    }
+    visit(doc["video"].GetString(), line, doc.HasMember("error"));
+  }
+}
+}
+
+ShardQueue::ShardQueue(const std::string &queue_dir,
+                       const std::string &worker_id,
+                       std::chrono::milliseconds lease_duration)
+    : queue_dir_(queue_dir), worker_id_(worker_id),
+      lease_duration_(lease_duration) {
+  if (worker_id_.empty() ||
+      worker_id_.find_first_of("@/") != std::string::npos) {
+    throw std::runtime_error("Invalid worker id '" + worker_id_ + "'");
+  }
+  if (!fs::exists(fs::path(queue_dir_) / MANIFEST_FILE)) {
+    throw std::runtime_error("Not a work queue: " + queue_dir_);
+  }
+}
+
+void ShardQueue::create(const std::string &queue_dir,
+                        const std::vector<std::string> &videos,
+                        size_t shard_size) {
+  const fs::path root(queue_dir);
+  if (fs::exists(root / MANIFEST_FILE)) {
+    throw std::runtime_error("Work queue already exists: " + queue_dir);
+  }
+  shard_size = std::max<size_t>(shard_size, 1);
+  for (const char *dir : {PENDING_DIR, LEASED_DIR, DONE_DIR, RESULTS_DIR}) {
+    fs::create_directories(root / dir);
+  }
+
+  for (size_t first = 0; first < videos.size(); first += shard_size) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "shard-%05zu", first / shard_size);
+    const auto last = std::min(first + shard_size, videos.size());
+    write_atomically(
+        root / PENDING_DIR / name,
+        std::vector<std::string>(videos.begin() + static_cast<long>(first),
+                                 videos.begin() + static_cast<long>(last)));
+  }
+  // Written last: workers refuse to open a queue without it
+  write_atomically(root / MANIFEST_FILE, videos);
+}
+
+std::optional<ShardLease> ShardQueue::claim() {
+  const fs::path root(queue_dir_);
+
+  for (const auto &pending : sorted_entries(root / PENDING_DIR)) {
+    const std::string shard = pending.filename().string();
+    if (pending.extension() == ".tmp") {
+      continue; // Still being written by create()
+    }
+    const fs::path leased = root / LEASED_DIR / (shard + "@" + worker_id_);
+    std::error_code ec;
+    fs::rename(pending, leased, ec);
+    if (!ec) {
+      touch(leased);
+      return ShardLease{shard, leased.string()};
+    }
+    // Another worker renamed it first
+  }
+
+  const auto now = fs::file_time_type::clock::now();
+  for (const auto &leased : sorted_entries(root / LEASED_DIR)) {
+    const std::string name = leased.filename().string();
+    const auto at = name.find('@');
+    if (at == std::string::npos) {
+      continue;
+    }
+    std::error_code ec;
+    const auto heartbeat = fs::last_write_time(leased, ec);
+    if (ec || now - heartbeat < lease_duration_) {
+      continue;
+    }
+
+    // An expired lease under our own id was left by an earlier run of this
+    // worker that died; it is taken over like any other
+    const std::string shard = name.substr(0, at);
+    const std::string owner = name.substr(at + 1);
+    const fs::path taken = root / LEASED_DIR / (shard + "@" + worker_id_);
+    fs::rename(leased, taken, ec);
+    if (!ec) {
+      std::cerr << "Warning: Taking over expired lease of " << shard
+                << " from worker " << owner
+                << (owner == worker_id_ ? " (an earlier run of this worker)"
+                                        : "")
+                << std::endl;
+      touch(taken);
+      return ShardLease{shard, taken.string()};
+    }
+  }
+  return std::nullopt;
+}
+
+bool ShardQueue::renew(const ShardLease &lease) const {
+  return touch(lease.path);
+}
+
+bool ShardQueue::complete(const ShardLease &lease) const {
+  std::error_code ec;
+  fs::rename(lease.path, fs::path(queue_dir_) / DONE_DIR / lease.shard, ec);
+  return !ec;
+}
+
+std::vector<std::string>
+ShardQueue::shard_videos(const ShardLease &lease) const {
+  return read_lines(lease.path);
+}
+
+std::set<std::string>
+ShardQueue::completed_videos(const std::string &shard) const {
+  std::set<std::string> completed;
+  const std::string prefix = shard + "@";
+  for (const auto &path : sorted_entries(fs::path(queue_dir_) / RESULTS_DIR)) {
+    if (path.filename().string().rfind(prefix, 0) != 0) {
+      continue;
+    }
+    read_results(path, [&completed](const std::string &video,
+                                    const std::string &, bool) {
+      completed.insert(video);
+    });
+  }
+  return completed;
+}
+
+void ShardQueue::record_result(const ShardLease &lease,
+                               const std::string &json_line) const {
+  const fs::path path = fs::path(queue_dir_) / RESULTS_DIR /
+                        (lease.shard + "@" + worker_id_ + RESULTS_SUFFIX);
+  const std::string data = json_line + "\n";
+
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                  0644);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open " + path.string() + ": " +
+                             std::strerror(errno));
+  }
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      const std::string reason = std::strerror(errno);
+      ::close(fd);
+      throw std::runtime_error("Failed to write " + path.string() + ": " +
+                               reason);
+    }
+    written += static_cast<size_t>(n);
+  }
+  // The checkpoint must survive a crash of this node
+  ::fsync(fd);
+  ::close(fd);
+}
+
+size_t ShardQueue::merge(const std::string &output_path) const {
+  const fs::path root(queue_dir_);
+
+  // A video may have been processed by several workers after a takeover;
+  // keep the first success, or the first failure if it never succeeded
+  std::map<std::string, std::pair<std::string, bool>> results;
+  for (const auto &path : sorted_entries(root / RESULTS_DIR)) {
+    read_results(path, [&results](const std::string &video,
+                                  const std::string &line, bool failed) {
+      auto it = results.find(video);
+      if (it == results.end()) {
+        results.emplace(video, std::make_pair(line, failed));
+      } else if (it->second.second && !failed) {
+        it->second = {line, failed};
+      }
+    });
+  }
+
+  std::vector<std::string> lines;
+  size_t missing = 0;
+  for (const auto &video : read_lines(root / MANIFEST_FILE)) {
+    auto it = results.find(video);
+    if (it == results.end()) {
+      ++missing;
+      continue;
+    }
+    lines.push_back(it->second.first);
+  }
+  write_atomically(output_path, lines);
+  return missing;
+}
+
+ShardQueueStatus ShardQueue::status() const {
+  const fs::path root(queue_dir_);
+  ShardQueueStatus status;
+  status.pending = sorted_entries(root / PENDING_DIR).size();
+  status.leased = sorted_entries(root / LEASED_DIR).size();
+  status.done = sorted_entries(root / DONE_DIR).size();
+  return status;
+}
+
+std::string ShardQueue::default_worker_id() {
+  char host[256] = {};
+  if (::gethostname(host, sizeof(host) - 1) != 0) {
+    std::strcpy(host, "worker");
+  }
+  return std::string(host) + "-" + std::to_string(::getpid());
+}
@@ -0,0 +1,358 @@
+#include "video_classification/stream_scheduler.hpp"
+#include "video_classification/tracer.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+constexpr int MAX_DEGRADATION = 3;
+// Outcomes judged before a stream's degradation level changes
+constexpr size_t DEGRADATION_WINDOWS = 20;
+constexpr double MAX_MISS_RATE = 0.1;
+constexpr double BATCH_LATENCY_SMOOTHING = 0.2;
+}
+
+StreamScheduler::StreamScheduler(std::vector<InferenceBackend *> backends,
+                                 const std::string &model_name,
+                                 const ModelInfo &model_info,
+                                 const SchedulerOptions &options)
+    : model_name_(model_name), model_info_(model_info),
+      max_batch_size_(static_cast<size_t>(std::max(model_info.max_batch_size_, 1))),
+      top_k_(options.top_k) {
+  if (backends.empty()) {
+    throw std::runtime_error("StreamScheduler needs at least one backend");
+  }
+  if (options.max_batch_size > 0) {
+    max_batch_size_ = std::min(max_batch_size_, options.max_batch_size);
+  }
+  for (InferenceBackend *backend : backends) {
+    workers_.emplace_back([this, backend] { run_worker(backend); });
+  }
+}
+
+StreamScheduler::~StreamScheduler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+size_t StreamScheduler::add_stream(const StreamOptions &options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stream stream;
+  stream.options = options;
+  stream.options.max_queued = std::max<size_t>(options.max_queued, 1);
+  stream.stats.name = options.name;
+  streams_.push_back(std::move(stream));
+  return streams_.size() - 1;
+}
+
+void StreamScheduler::submit(size_t stream_id, std::vector<float> pixel_values,
+                             Callback on_done) {
+  const auto now = Clock::now();
+  std::vector<Pending> shed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stream &stream = streams_.at(stream_id);
+    ++stream.stats.submitted;
+    if (stream.queued == stream.options.max_queued) {
+      // The oldest window is the least likely to still make its deadline
+      auto oldest = std::find_if(queue_.begin(), queue_.end(),
+                                 [stream_id](const Pending &pending) {
+                                   return pending.stream == stream_id;
+                                 });
+      shed.push_back(std::move(*oldest));
+      queue_.erase(oldest);
+      --stream.queued;
+      record_outcome(stream, Outcome::Shed,
+                     std::chrono::duration<double, std::milli>(
+                         now - shed.back().submitted)
+                         .count());
+    }
+    queue_.push_back({stream_id, next_sequence_++, now,
+                      now + stream.options.slo, std::move(pixel_values),
+                      std::move(on_done)});
+    ++stream.queued;
+  }
+  work_cv_.notify_one();
+
+  for (auto &pending : shed) {
+    pending.on_done({Outcome::Shed,
+                     {},
+                     std::chrono::duration_cast<std::chrono::milliseconds>(
+                         now - pending.submitted),
+                     ""});
+  }
+}
+
+int StreamScheduler::degradation(size_t stream) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return streams_.at(stream).stats.degradation;
+}
+
+void StreamScheduler::wait_idle() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_cv_.wait(lock, [this] { return queue_.empty() && in_flight_ == 0; });
+}
+
+std::vector<StreamStats> StreamScheduler::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<StreamStats> result;
+  result.reserve(streams_.size());
+  for (const auto &stream : streams_) {
+    StreamStats stats = stream.stats;
+    const uint64_t classified = stats.on_time + stats.late;
+    if (classified > 0) {
+      stats.mean_latency_ms =
+          stream.total_latency_ms / static_cast<double>(classified);
+    }
+    result.push_back(std::move(stats));
+  }
+  return result;
+}
+
+void StreamScheduler::run_worker(InferenceBackend *backend) {
+  const size_t window_elements = static_cast<size_t>(model_info_.input_t_) *
+                                 static_cast<size_t>(model_info_.input_c_) *
+                                 static_cast<size_t>(model_info_.input_h_) *
+                                 static_cast<size_t>(model_info_.input_w_);
+  std::vector<float> batch_input;
+  std::vector<float> logits; // Reused by every batch of this worker
+  std::vector<float> window_logits;
+
+  while (true) {
+    std::vector<Pending> shed;
+    std::vector<Pending> batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return; // Stopping with nothing left
+      }
+      batch = take_batch(shed);
+      in_flight_ += batch.size();
+    }
+
+    const auto dispatched = Clock::now();
+    for (auto &pending : shed) {
+      pending.on_done({Outcome::Shed,
+                       {},
+                       std::chrono::duration_cast<std::chrono::milliseconds>(
+                           dispatched - pending.submitted),
+                       ""});
+    }
+    if (batch.empty()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (queue_.empty() && in_flight_ == 0) {
+        idle_cv_.notify_all();
+      }
+      continue;
+    }
+
+    std::string error;
+    {
+      TRACE_SCOPE("scheduler_batch");
+      batch_input.clear();
+      for (const auto &pending : batch) {
+        if (pending.pixel_values.size() != window_elements) {
+          error = "Invalid input data size: expected " +
+                  std::to_string(window_elements) + " elements, got " +
+                  std::to_string(pending.pixel_values.size());
+          break;
+        }
+        batch_input.insert(batch_input.end(), pending.pixel_values.begin(),
+                           pending.pixel_values.end());
+      }
+      if (error.empty()) {
+        const std::vector<int64_t> shape = {
+            static_cast<int64_t>(batch.size()), model_info_.input_t_,
+            model_info_.input_c_, model_info_.input_h_, model_info_.input_w_};
+        try {
+          backend->infer_logits_into(batch_input, model_name_, model_info_,
+                                     shape, logits);
+        } catch (const std::exception &e) {
+          error = e.what();
+        }
+      }
+    }
+    const auto finished = Clock::now();
+    const size_t classes = logits.size() / batch.size();
+    if (error.empty() && classes * batch.size() != logits.size()) {
+      error = "Model returned " + std::to_string(logits.size()) +
+              " logits for a batch of " + std::to_string(batch.size());
+    }
+
+    std::vector<WindowResult> results;
+    results.reserve(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+      WindowResult result{Outcome::Failed, {},
+                          std::chrono::duration_cast<std::chrono::milliseconds>(
+                              finished - batch[i].submitted),
+                          error};
+      if (error.empty()) {
+        window_logits.assign(
+            logits.begin() + static_cast<long>(i * classes),
+            logits.begin() + static_cast<long>((i + 1) * classes));
+        result.predictions = backend->postprocess_results(window_logits, top_k_);
+        result.outcome =
+            finished <= batch[i].deadline ? Outcome::OnTime : Outcome::Late;
+      }
+      results.push_back(std::move(result));
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (error.empty()) {
+        const double batch_ms =
+            std::chrono::duration<double, std::milli>(finished - dispatched)
+                .count();
+        batch_ms_ = batch_ms_ == 0.0
+                        ? batch_ms
+                        : batch_ms_ + BATCH_LATENCY_SMOOTHING *
+                                          (batch_ms - batch_ms_);
+      }
+      for (size_t i = 0; i < batch.size(); ++i) {
+        record_outcome(streams_[batch[i].stream], results[i].outcome,
+                       std::chrono::duration<double, std::milli>(
+                           finished - batch[i].submitted)
+                           .count());
+      }
+    }
+    for (size_t i = 0; i < batch.size(); ++i) {
+      batch[i].on_done(results[i]);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      in_flight_ -= batch.size();
+      if (queue_.empty() && in_flight_ == 0) {
+        idle_cv_.notify_all();
+      }
+    }
+  }
+}
+
+std::vector<StreamScheduler::Pending>
+StreamScheduler::take_batch(std::vector<Pending> &shed) {
+  // Windows that would finish after their deadline even if sent now
+  const auto now = Clock::now();
+  const auto expected_latency =
+      std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double, std::milli>(batch_ms_));
+  for (auto it = queue_.begin(); it != queue_.end();) {
+    if (batch_ms_ > 0.0 && now + expected_latency > it->deadline) {
+      Stream &stream = streams_[it->stream];
+      --stream.queued;
+      record_outcome(stream, Outcome::Shed,
+                     std::chrono::duration<double, std::milli>(
+                         now - it->submitted)
+                         .count());
+      shed.push_back(std::move(*it));
+      it = queue_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  std::vector<size_t> order(queue_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    const Pending &x = queue_[a];
+    const Pending &y = queue_[b];
+    if (x.deadline != y.deadline) {
+      return x.deadline < y.deadline;
+    }
+    return x.sequence < y.sequence;
+  });
+
+  // Fair shares of the batch among streams with queued windows
+  std::vector<size_t> quota(streams_.size(), 0);
+  size_t total_weight = 0;
+  for (const auto &stream : streams_) {
+    if (stream.queued > 0) {
+      total_weight += static_cast<size_t>(1 + std::max(stream.options.priority, 0));
+    }
+  }
+  for (size_t s = 0; s < streams_.size(); ++s) {
+    if (streams_[s].queued > 0) {
+      const auto weight =
+          static_cast<size_t>(1 + std::max(streams_[s].options.priority, 0));
+      quota[s] = std::max<size_t>(max_batch_size_ * weight / total_weight, 1);
+    }
+  }
+
+  std::vector<bool> taken(queue_.size(), false);
+  size_t batch_size = 0;
+  for (bool within_quota : {true, false}) {
+    for (size_t index : order) {
+      if (batch_size == max_batch_size_) {
+        break;
+      }
+      const size_t stream = queue_[index].stream;
+      if (taken[index] || (within_quota && quota[stream] == 0)) {
+        continue;
+      }
+      if (within_quota) {
+        --quota[stream];
+      }
+      taken[index] = true;
+      ++batch_size;
+    }
+  }
+
+  std::vector<Pending> batch;
+  std::vector<Pending> remaining;
+  for (size_t i : order) {
+    if (taken[i]) {
+      --streams_[queue_[i].stream].queued;
+      batch.push_back(std::move(queue_[i]));
+    }
+  }
+  for (size_t i = 0; i < queue_.size(); ++i) {
+    if (!taken[i]) {
+      remaining.push_back(std::move(queue_[i]));
+    }
+  }
+  queue_ = std::move(remaining);
+  return batch;
+}
+
+void StreamScheduler::record_outcome(Stream &stream, Outcome outcome,
+                                     double latency_ms) {
+  auto &stats = stream.stats;
+  switch (outcome) {
+  case Outcome::OnTime:
+    ++stats.on_time;
+    stream.total_latency_ms += latency_ms;
+    break;
+  case Outcome::Late:
+    ++stats.late;
+    stream.total_latency_ms += latency_ms;
+    break;
+  case Outcome::Shed:
+    ++stats.shed;
+    break;
+  case Outcome::Failed:
+    ++stats.failed;
+    return; // Says nothing about load
+  }
+
+  stream.recent_misses.push_back(outcome != Outcome::OnTime);
+  if (stream.recent_misses.size() < DEGRADATION_WINDOWS) {
+    return;
+  }
+  const auto misses = static_cast<size_t>(std::count(
+      stream.recent_misses.begin(), stream.recent_misses.end(), true));
+  if (static_cast<double>(misses) >
+          MAX_MISS_RATE * static_cast<double>(DEGRADATION_WINDOWS) &&
+      stats.degradation < MAX_DEGRADATION) {
+    ++stats.degradation;
+  } else if (misses == 0 && stats.degradation > 0) {
+    --stats.degradation;
+  }
+  stream.recent_misses.clear();
+}
@@ -0,0 +1,200 @@
+#include "video_classification/temporal_localizer.hpp"
+#include "video_classification/parallel_video_decoder.hpp"
+#include "video_classification/video_utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+
+TemporalLocalizer::TemporalLocalizer(InferenceBackend &client,
+                                     ImageProcessor &processor,
+                                     const std::string &model_name,
+                                     const ModelInfo &model_info,
+                                     const LocalizationOptions &options)
+    : client_(client), processor_(processor), model_name_(model_name),
+      model_info_(model_info), options_(options), target_index_(0) {
+  const int index = client_.label_index(options_.target_label);
+  if (index < 0) {
+    throw std::runtime_error("Unknown target label: " + options_.target_label);
+  }
+  target_index_ = static_cast<size_t>(index);
+  if (options_.coarse_fps <= 0.0f || options_.fine_fps <= 0.0f) {
+    throw std::runtime_error("Localization sampling rates must be positive");
+  }
+}
+
+TemporalLocalizer::Result
+TemporalLocalizer::localize(const std::string &video_path,
+                            std::shared_ptr<const VideoSeekIndex> seek_index) {
+  VideoProcessor video;
+  if (!video.openVideo(video_path, seek_index)) {
+    throw std::runtime_error("Failed to open video: " + video_path);
+  }
+  const double duration = video.getVideoInfo().duration;
+  const int window_size = model_info_.input_t_;
+  const int coarse_stride =
+      options_.coarse_stride > 0 ? options_.coarse_stride : window_size;
+  const int fine_stride = options_.fine_stride > 0
+                              ? options_.fine_stride
+                              : std::max(window_size / 2, 1);
+
+  Result result;
+  const auto coarse_scores = score_windows(
+      video_path, seek_index,
+      video.splitVideoIntoWindows(window_size, options_.coarse_fps,
+                                  coarse_stride, 0.0, duration));
+  result.coarse_windows = coarse_scores.size();
+
+  // A coarse window only sees frames one coarse interval apart, so the action
+  // may start or end anywhere up to the neighbouring samples
+  const double coarse_interval = 1.0 / options_.coarse_fps;
+  std::vector<TimeSpan> regions;
+  for (const auto &window : coarse_scores) {
+    if (window.probability >= options_.coarse_threshold) {
+      regions.push_back({std::max(window.start_time - coarse_interval, 0.0),
+                         std::min(window.end_time + coarse_interval, duration),
+                         window.probability});
+    }
+  }
+  regions = merge_spans(std::move(regions));
+
+  std::vector<VideoProcessor::WindowIndices> fine_windows;
+  double fine_duration = 0.0;
+  for (const auto &region : regions) {
+    fine_duration += region.end - region.start;
+    auto windows = video.splitVideoIntoWindows(
+        window_size, options_.fine_fps, fine_stride, region.start, region.end);
+    fine_windows.insert(fine_windows.end(), windows.begin(), windows.end());
+  }
+  result.fine_fraction =
+      duration > 0.0 ? std::min(fine_duration / duration, 1.0) : 0.0;
+
+  const auto fine_scores = score_windows(video_path, seek_index, fine_windows);
+  result.fine_windows = fine_scores.size();
+
+  const double fine_interval = 1.0 / options_.fine_fps;
+  std::vector<TimeSpan> hits;
+  for (const auto &window : fine_scores) {
+    if (window.probability >= options_.fine_threshold) {
+      hits.push_back({window.start_time, window.end_time + fine_interval,
+                      window.probability});
+    }
+  }
+  result.intervals = merge_spans(std::move(hits));
+  return result;
+}
+
+std::vector<TemporalLocalizer::ScoredWindow> TemporalLocalizer::score_windows(
+    const std::string &video_path,
+    const std::shared_ptr<const VideoSeekIndex> &seek_index,
+    const std::vector<VideoProcessor::WindowIndices> &windows) {
+  std::vector<ScoredWindow> scores;
+  if (windows.empty()) {
+    return scores;
+  }
+
+  // Overlapping windows share frames: decode each frame once, in chunks of
+  // one window, and assemble windows from the frames decoded so far
+  std::vector<int> needed;
+  for (const auto &window : windows) {
+    needed.insert(needed.end(), window.indices.begin(), window.indices.end());
+  }
+  std::sort(needed.begin(), needed.end());
+  needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+  const auto chunk_size = static_cast<size_t>(std::max(model_info_.input_t_, 1));
+  std::vector<VideoProcessor::WindowIndices> chunks;
+  for (size_t i = 0; i < needed.size(); i += chunk_size) {
+    VideoProcessor::WindowIndices chunk;
+    chunk.indices.assign(
+        needed.begin() + static_cast<long>(i),
+        needed.begin() + static_cast<long>(std::min(i + chunk_size,
+                                                    needed.size())));
+    chunk.startTime = 0.0;
+    chunk.endTime = 0.0;
+    chunks.push_back(std::move(chunk));
+  }
+
+  const std::vector<int64_t> shape = {1, model_info_.input_t_,
+                                      model_info_.input_c_,
+                                      model_info_.input_h_,
+                                      model_info_.input_w_};
+  std::deque<std::pair<int, cv::Mat>> buffered;
+  size_t next_window = 0;
+  std::vector<float> logits;
+
+  ParallelDecodeOptions decode_options;
+  decode_options.num_threads = options_.decode_threads;
+  decode_options.seek_index = seek_index;
+  ParallelVideoDecoder decoder(video_path, decode_options);
+  decoder.decode(chunks, [&](size_t,
+                             const VideoProcessor::WindowIndices &chunk,
+                             std::vector<cv::Mat> &frames) {
+    // Reads only fail past the end of a video, so decoded frames belong to
+    // the leading indices of a short chunk
+    for (size_t i = 0; i < frames.size(); ++i) {
+      buffered.emplace_back(chunk.indices[i], std::move(frames[i]));
+    }
+
+    while (next_window < windows.size() &&
+           windows[next_window].indices.back() <= chunk.indices.back()) {
+      const auto &window = windows[next_window++];
+      std::vector<cv::Mat> clip;
+      for (int index : window.indices) {
+        auto it = std::lower_bound(
+            buffered.begin(), buffered.end(), index,
+            [](const auto &entry, int value) { return entry.first < value; });
+        if (it != buffered.end() && it->first == index) {
+          clip.push_back(it->second);
+        }
+      }
+      if (!clip.empty()) {
+        auto pixel_values =
+            processor_.process(pad_video_frames(clip, model_info_.input_t_),
+                               model_info_.input_c_, model_info_.input_format_);
+        client_.infer_logits_into(pixel_values, model_name_, model_info_,
+                                  shape, logits);
+        if (target_index_ >= logits.size()) {
+          throw std::runtime_error(
+              "Target label index " + std::to_string(target_index_) +
+              " is out of range for " + std::to_string(logits.size()) +
+              " model outputs");
+        }
+        const float max_logit = *std::max_element(logits.begin(), logits.end());
+        float sum = 0.0f;
+        for (float logit : logits) {
+          sum += std::exp(logit - max_logit);
+        }
+        scores.push_back({window.startTime, window.endTime,
+                          std::exp(logits[target_index_] - max_logit) / sum});
+      }
+
+      // Later windows start no earlier, so older frames are done with
+      const int keep_from = next_window < windows.size()
+                                ? windows[next_window].indices.front()
+                                : std::numeric_limits<int>::max();
+      while (!buffered.empty() && buffered.front().first < keep_from) {
+        buffered.pop_front();
+      }
+    }
+  });
+  return scores;
+}
+
+std::vector<TimeSpan> TemporalLocalizer::merge_spans(std::vector<TimeSpan> spans,
+                                                     double max_gap) {
+  std::sort(spans.begin(), spans.end(),
+            [](const TimeSpan &a, const TimeSpan &b) { return a.start < b.start; });
+  std::vector<TimeSpan> merged;
+  for (const auto &span : spans) {
+    if (!merged.empty() && span.start <= merged.back().end + max_gap) {
+      merged.back().end = std::max(merged.back().end, span.end);
+      merged.back().probability =
+          std::max(merged.back().probability, span.probability);
+    } else {
+      merged.push_back(span);
+    }
+  }
+  return merged;
+}
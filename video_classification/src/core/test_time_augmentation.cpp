@@ -0,0 +1,79 @@
+#include "video_classification/test_time_augmentation.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+std::vector<float> classify_multi_view(InferenceBackend &backend,
+                                       const ImageProcessor &processor,
+                                       const std::string &model_name,
+                                       const ModelInfo &model_info,
+                                       const std::vector<std::vector<cv::Mat>> &clips,
+                                       int num_crops) {
+  if (clips.empty()) {
+    throw std::runtime_error("No clips to classify");
+  }
+  num_crops = std::max(num_crops, 1);
+  const size_t num_frames = clips.front().size();
+  const size_t view_elements = num_frames *
+                               static_cast<size_t>(model_info.input_c_) *
+                               static_cast<size_t>(model_info.input_h_) *
+                               static_cast<size_t>(model_info.input_w_);
+
+  // All views back to back: [clip][crop][frames, c, h, w]
+  std::vector<float> views;
+  views.reserve(clips.size() * static_cast<size_t>(num_crops) * view_elements);
+  for (const auto &clip : clips) {
+    if (clip.size() != num_frames) {
+      throw std::runtime_error("All clips must have the same number of frames");
+    }
+    auto clip_views = processor.process_multi_crop(
+        clip, model_info.input_c_, model_info.input_format_, num_crops);
+    if (clip_views.size() != static_cast<size_t>(num_crops) * view_elements) {
+      throw std::runtime_error("Invalid input data size: expected " +
+                               std::to_string(static_cast<size_t>(num_crops) *
+                                              view_elements) +
+                               " elements, got " +
+                               std::to_string(clip_views.size()));
+    }
+    views.insert(views.end(), clip_views.begin(), clip_views.end());
+  }
+
+  const size_t total_views = views.size() / view_elements;
+  const size_t max_batch =
+      static_cast<size_t>(std::max(model_info.max_batch_size_, 1));
+  std::vector<float> summed;
+  std::vector<float> logits;
+
+  for (size_t first = 0; first < total_views; first += max_batch) {
+    const size_t count = std::min(max_batch, total_views - first);
+    std::vector<int64_t> shape = {static_cast<int64_t>(count),
+                                  static_cast<int64_t>(num_frames),
+                                  model_info.input_c_, model_info.input_h_,
+                                  model_info.input_w_};
+
+    backend.infer_logits_into(
+        std::span<const float>(views).subspan(first * view_elements,
+                                              count * view_elements),
+        model_name, model_info, shape, logits);
+
+    if (logits.size() % count != 0) {
+      throw std::runtime_error("Unexpected output size " +
+                               std::to_string(logits.size()) + " for batch of " +
+                               std::to_string(count));
+    }
+    const size_t num_classes = logits.size() / count;
+    if (summed.empty()) {
+      summed.assign(num_classes, 0.0f);
+    } else if (summed.size() != num_classes) {
+      throw std::runtime_error("Inconsistent number of classes across batches");
+    }
+    for (size_t i = 0; i < logits.size(); ++i) {
+      summed[i % num_classes] += logits[i];
+    }
+  }
+
+  for (auto &logit : summed) {
+    logit /= static_cast<float>(total_views);
+  }
+  return summed;
+}
@@ -37,6 +37,23 @@ TimeSformerImageProcessor::TimeSformerImageProcessor(
   }
 }
 
+ImageProcessor::ResizePlan
+TimeSformerImageProcessor::resize_plan(const cv::Size &frame_size,
+                                       bool /*multi_crop*/) const {
+  return {shortest_edge_size(frame_size, shortest_edge), crop_size,
+          cv::INTER_CUBIC};
+}
+
+void TimeSformerImageProcessor::channel_affine(std::vector<float> &scale,
+                                               std::vector<float> &bias) const {
+  scale.resize(mean.size());
+  bias.resize(mean.size());
+  for (size_t c = 0; c < mean.size(); ++c) {
+    scale[c] = rescale_factor / std[c];
+    bias[c] = -mean[c] / std[c];
+  }
+}
+
 std::vector<float> TimeSformerImageProcessor::process(
     const std::vector<cv::Mat> &frames, int channels,
     const std::string &format) {
@@ -0,0 +1,313 @@
+#include "video_classification/tracer.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+constexpr size_t CHUNK_EVENTS = 4096;
+constexpr uint32_t NO_STRING = 0;
+constexpr size_t FLUSH_BYTES = 1 << 20;
+
+struct Event {
+  const char *name;
+  uint64_t start_ns;
+  uint64_t end_ns;
+  uint64_t async_id; ///< 0 for spans nested on one thread
+  int64_t window;
+  int64_t frame;
+  uint32_t video;   ///< Interned string id, NO_STRING if unset
+  uint32_t request; ///< Interned string id, NO_STRING if unset
+};
+
+uint32_t intern(std::string_view value);
+
+/// Lets the per-thread cache be searched with a string_view
+struct StringHash {
+  using is_transparent = void;
+  size_t operator()(std::string_view value) const noexcept {
+    return std::hash<std::string_view>{}(value);
+  }
+};
+
+struct Chunk {
+  Event events[CHUNK_EVENTS];
+  std::atomic<size_t> size{0};
+  std::atomic<Chunk *> next{nullptr};
+};
+
+/**
+ * @brief Events of one thread, appended only by that thread
+ */
+struct ThreadBuffer {
+  uint32_t tid = 0;
+  std::unique_ptr<Chunk> head = std::make_unique<Chunk>();
+  Chunk *tail = head.get();
+  /// Ids of the strings this thread has interned, so repeats skip the lock
+  std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>>
+      string_ids;
+
+  ~ThreadBuffer() {
+    std::unique_ptr<Chunk> chunk(head->next.load());
+    while (chunk) {
+      std::unique_ptr<Chunk> next(chunk->next.load());
+      chunk = std::move(next);
+    }
+  }
+
+  void append(const Event &event) {
+    size_t size = tail->size.load(std::memory_order_relaxed);
+    if (size == CHUNK_EVENTS) {
+      auto *chunk = new Chunk();
+      tail->next.store(chunk, std::memory_order_release);
+      tail = chunk;
+      size = 0;
+    }
+    tail->events[size] = event;
+    tail->size.store(size + 1, std::memory_order_release);
+  }
+
+  uint32_t string_id(std::string_view value) {
+    if (value.empty()) {
+      return NO_STRING;
+    }
+    auto it = string_ids.find(value);
+    if (it == string_ids.end()) {
+      it = string_ids.emplace(std::string(value), intern(value)).first;
+    }
+    return it->second;
+  }
+};
+
+/**
+ * @brief Registry of thread buffers and interned strings
+ *
+ * Buffers outlive their threads so a trace still holds the events of
+ * workers that have exited.
+ */
+struct TraceState {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  std::unordered_map<std::string, uint32_t> string_ids;
+  std::vector<std::string> strings{""}; ///< Index 0 is NO_STRING
+  uint64_t start_ns = 0;
+};
+
+TraceState &state() {
+  static TraceState instance;
+  return instance;
+}
+
+ThreadBuffer &thread_buffer() {
+  thread_local ThreadBuffer *buffer = [] {
+    auto &trace = state();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    trace.buffers.push_back(std::make_unique<ThreadBuffer>());
+    trace.buffers.back()->tid = static_cast<uint32_t>(trace.buffers.size());
+    return trace.buffers.back().get();
+  }();
+  return *buffer;
+}
+
+uint32_t intern(std::string_view value) {
+  auto &trace = state();
+  std::lock_guard<std::mutex> lock(trace.mutex);
+  auto [it, inserted] = trace.string_ids.emplace(
+      std::string(value), static_cast<uint32_t>(trace.strings.size()));
+  if (inserted) {
+    trace.strings.emplace_back(value);
+  }
+  return it->second;
+}
+
+Event make_event(ThreadBuffer &buffer, const char *name, uint64_t start_ns,
+                 uint64_t end_ns, uint64_t async_id, const TraceArgs &args) {
+  return Event{name,
+               start_ns,
+               end_ns,
+               async_id,
+               args.window,
+               args.frame,
+               buffer.string_id(args.video),
+               buffer.string_id(args.request)};
+}
+
+void write_args(rapidjson::Writer<rapidjson::StringBuffer> &writer,
+                const Event &event, const std::vector<std::string> &strings) {
+  writer.Key("args");
+  writer.StartObject();
+  if (event.video != NO_STRING) {
+    const auto &video = strings[event.video];
+    writer.Key("video");
+    writer.String(video.c_str(),
+                  static_cast<rapidjson::SizeType>(video.size()));
+  }
+  if (event.window >= 0) {
+    writer.Key("window");
+    writer.Int64(event.window);
+  }
+  if (event.frame >= 0) {
+    writer.Key("frame");
+    writer.Int64(event.frame);
+  }
+  if (event.request != NO_STRING) {
+    const auto &request = strings[event.request];
+    writer.Key("request");
+    writer.String(request.c_str(),
+                  static_cast<rapidjson::SizeType>(request.size()));
+  }
+  writer.EndObject();
+}
+
+double to_us(uint64_t ns, uint64_t origin_ns) {
+  return static_cast<double>(ns > origin_ns ? ns - origin_ns : 0) / 1000.0;
+}
+}
+
+std::atomic<bool> Tracer::enabled_{false};
+
+void Tracer::start() {
+  {
+    auto &trace = state();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    trace.start_ns = now_ns();
+  }
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+uint64_t Tracer::now_ns() noexcept {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void Tracer::record(const char *name, uint64_t start_ns, uint64_t end_ns,
+                    const TraceArgs &args) {
+  if (!enabled()) {
+    return;
+  }
+  auto &buffer = thread_buffer();
+  buffer.append(make_event(buffer, name, start_ns, end_ns, 0, args));
+}
+
+void Tracer::record_async(const char *name, uint64_t id, uint64_t start_ns,
+                          uint64_t end_ns, const TraceArgs &args) {
+  if (!enabled()) {
+    return;
+  }
+  auto &buffer = thread_buffer();
+  // Id 0 marks synchronous spans
+  buffer.append(make_event(buffer, name, start_ns, end_ns, id + 1, args));
+}
+
+void Tracer::write(const std::string &path) {
+  enabled_.store(false, std::memory_order_relaxed);
+
+  std::ofstream out(path, std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error("Failed to write trace: " + path);
+  }
+
+  auto &trace = state();
+  std::lock_guard<std::mutex> lock(trace.mutex);
+  const uint64_t origin_ns = trace.start_ns;
+  rapidjson::StringBuffer json;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(json);
+  auto flush = [&](bool force) {
+    if (force || json.GetSize() >= FLUSH_BYTES) {
+      out.write(json.GetString(),
+                static_cast<std::streamsize>(json.GetSize()));
+      json.Clear();
+    }
+  };
+
+  writer.StartObject();
+  writer.Key("displayTimeUnit");
+  writer.String("ms");
+  writer.Key("traceEvents");
+  writer.StartArray();
+  for (const auto &buffer : trace.buffers) {
+    writer.StartObject();
+    writer.Key("name");
+    writer.String("thread_name");
+    writer.Key("ph");
+    writer.String("M");
+    writer.Key("pid");
+    writer.Uint(1);
+    writer.Key("tid");
+    writer.Uint(buffer->tid);
+    writer.Key("args");
+    writer.StartObject();
+    writer.Key("name");
+    const std::string thread_name = "thread " + std::to_string(buffer->tid);
+    writer.String(thread_name.c_str(),
+                  static_cast<rapidjson::SizeType>(thread_name.size()));
+    writer.EndObject();
+    writer.EndObject();
+
+    for (const Chunk *chunk = buffer->head.get(); chunk != nullptr;
+         chunk = chunk->next.load(std::memory_order_acquire)) {
+      const size_t size = chunk->size.load(std::memory_order_acquire);
+      for (size_t i = 0; i < size; ++i) {
+        const Event &event = chunk->events[i];
+        if (event.end_ns < origin_ns) {
+          continue;
+        }
+        if (event.async_id == 0) {
+          writer.StartObject();
+          writer.Key("name");
+          writer.String(event.name);
+          writer.Key("ph");
+          writer.String("X");
+          writer.Key("pid");
+          writer.Uint(1);
+          writer.Key("tid");
+          writer.Uint(buffer->tid);
+          writer.Key("ts");
+          writer.Double(to_us(event.start_ns, origin_ns));
+          writer.Key("dur");
+          writer.Double(to_us(event.end_ns, event.start_ns));
+          write_args(writer, event, trace.strings);
+          writer.EndObject();
+        } else {
+          // Async spans are a begin/end pair matched by category and id
+          for (const char *phase : {"b", "e"}) {
+            writer.StartObject();
+            writer.Key("name");
+            writer.String(event.name);
+            writer.Key("cat");
+            writer.String(event.name);
+            writer.Key("ph");
+            writer.String(phase);
+            writer.Key("id");
+            writer.Uint64(event.async_id);
+            writer.Key("pid");
+            writer.Uint(1);
+            writer.Key("tid");
+            writer.Uint(buffer->tid);
+            writer.Key("ts");
+            writer.Double(to_us(
+                phase[0] == 'b' ? event.start_ns : event.end_ns, origin_ns));
+            write_args(writer, event, trace.strings);
+            writer.EndObject();
+          }
+        }
+        flush(false);
+      }
+    }
+  }
+  writer.EndArray();
+  writer.EndObject();
+  flush(true);
+  if (!out) {
+    throw std::runtime_error("Failed to write trace: " + path);
+  }
+}
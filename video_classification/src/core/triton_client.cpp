@@ -1,10 +1,13 @@
 #include "video_classification/triton_client.hpp"
+#include "video_classification/tracer.hpp"
 #include <algorithm>
-#include <numeric>
+#include <array>
+#include <condition_variable>
 #include <opencv2/opencv.hpp>
 #include <stdexcept>
+#include <thread>
+#include <utility>
 
-#include <fstream>
 #include <iostream>
 
 namespace tc = triton::client;
@@ -12,46 +15,188 @@ namespace tc = triton::client;
 // Constants
 namespace {
 constexpr const char* DEFAULT_MODEL_VERSION = "4";
-constexpr int DEFAULT_FRAME_COUNT = 16;
 constexpr int DEFAULT_IMAGE_SIZE = 224;
 constexpr int DEFAULT_CHANNELS = 3;
+// A request is sent at most twice: once, plus a hedge or a failover
+constexpr size_t MAX_ATTEMPTS = 2;
+
+std::vector<std::string> split_urls(const std::string &server_url) {
+  std::vector<std::string> urls;
+  size_t start = 0;
+  while (start <= server_url.size()) {
+    size_t end = server_url.find(',', start);
+    if (end == std::string::npos) {
+      end = server_url.size();
+    }
+    if (end > start) {
+      urls.push_back(server_url.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+  return urls;
 }
 
-void TritonClient::load_labels(const std::string &labels_file) {
-  if (labels_file.empty()) {
-    return;
+double latency_quantile(const std::vector<double> &latencies, double quantile,
+                        std::vector<double> &scratch) {
+  if (latencies.empty()) {
+    return 0.0;
   }
+  scratch.assign(latencies.begin(), latencies.end());
+  const auto rank = static_cast<std::ptrdiff_t>(
+      quantile * static_cast<double>(scratch.size() - 1));
+  std::nth_element(scratch.begin(), scratch.begin() + rank, scratch.end());
+  return scratch[static_cast<size_t>(rank)];
+}
+}
 
-  std::ifstream file(labels_file);
-  if (!file.is_open()) {
-    std::cerr << "Warning: Could not open labels file: " << labels_file
-              << std::endl;
-    return;
+/**
+ * @brief One send of a request to an endpoint
+ *
+ * Keeps its Triton input and output objects across requests; inputs are
+ * rebound with Reset() and AppendRaw() instead of being recreated.
+ */
+struct TritonClient::Attempt {
+  TritonClient *client = nullptr;
+  RequestContext *context = nullptr;
+  Endpoint *endpoint = nullptr;
+  bool hedge = false;
+  std::chrono::steady_clock::time_point start;
+  std::string input_name;
+  std::string input_datatype;
+  std::string output_name;
+  std::unique_ptr<tc::InferInput> input;
+  std::unique_ptr<tc::InferRequestedOutput> output;
+  std::vector<tc::InferInput *> inputs;
+  std::vector<const tc::InferRequestedOutput *> outputs;
+};
+
+/**
+ * @brief Reusable state shared by the attempts of one request
+ *
+ * Callbacks of losing attempts can fire after the request has returned, so
+ * everything they touch lives here rather than on the caller's stack, and a
+ * context returns to the pool only once its caller has left and no attempt is
+ * in flight.
+ */
+struct TritonClient::RequestContext {
+  tc::InferOptions options{""};
+  std::string output_name;
+  std::vector<float> input_copy; ///< Owned input when attempts may outlive the call
+  const float *input_data = nullptr;
+  size_t input_bytes = 0;
+  std::array<Attempt, MAX_ATTEMPTS> attempts;
+  size_t num_attempts = 0;
+
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  bool in_use = false; ///< A caller is waiting on this context
+  int in_flight = 0;
+  bool done = false;
+  std::span<float> logits;             ///< Caller buffer for the winning response
+  std::vector<float> *output = nullptr; ///< Resizable caller buffer, if any
+  size_t num_logits = 0;
+  std::string last_error;
+};
+
+/**
+ * @brief Readiness probes of one endpoint, run on their own thread
+ *
+ * A probe of a server that accepts connections but never answers blocks for
+ * as long as the connect timeout, so the thread owns its HTTP client and is
+ * detached: the client only posts requests and collects results, and never
+ * waits for a probe except briefly at startup.
+ */
+struct TritonClient::Prober {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::unique_ptr<tc::InferenceServerHttpClient> client;
+  bool stopping = false;
+  bool due = false;         ///< The thread should probe
+  bool requested = false;   ///< A probe was requested and not yet consumed
+  std::optional<bool> ready; ///< Result of the last probe, until consumed
+};
+
+TritonClient::TritonClient(const std::string &server_url,
+                           const std::string &labels_file,
+                           const TritonRoutingOptions &routing)
+    : TritonClient(split_urls(server_url), labels_file, routing) {}
+
+TritonClient::TritonClient(const std::vector<std::string> &server_urls,
+                           const std::string &labels_file,
+                           const TritonRoutingOptions &routing)
+    : InferenceBackend(labels_file), routing_(routing) {
+  if (server_urls.empty()) {
+    throw std::runtime_error("At least one Triton server URL is required");
+  }
+  for (const auto &url : server_urls) {
+    auto endpoint = std::make_unique<Endpoint>();
+    endpoint->url = url;
+    endpoint->latencies_ms.reserve(routing_.latency_window);
+    endpoint->latency_scratch.reserve(routing_.latency_window);
+    tc::Error err = tc::InferenceServerHttpClient::Create(
+        &endpoint->sync_client, url, false);
+    if (err.IsOk()) {
+      err = tc::InferenceServerHttpClient::Create(&endpoint->async_client, url,
+                                                  false);
+    }
+    if (!err.IsOk()) {
+      throw std::runtime_error("Failed to create HTTP client for " + url +
+                               ": " + err.Message());
+    }
+    endpoints_.push_back(std::move(endpoint));
   }
 
-  std::string line;
-  int id = 0;
-  while (std::getline(file, line)) {
-    if (!line.empty()) {
-      id2label_[std::to_string(id)] = line;
-      id++;
+  if (endpoints_.size() > 1) {
+    for (auto &endpoint : endpoints_) {
+      auto prober = std::make_shared<Prober>();
+      tc::Error err =
+          tc::InferenceServerHttpClient::Create(&prober->client, endpoint->url,
+                                                false);
+      if (!err.IsOk()) {
+        throw std::runtime_error("Failed to create HTTP client for " +
+                                 endpoint->url + ": " + err.Message());
+      }
+      request_probe(*prober);
+      std::thread(run_prober, prober).detach();
+      endpoint->prober = std::move(prober);
+    }
+
+    // Probes run concurrently; replicas that are down, or have not answered
+    // within probe_timeout, start in the ejected state
+    const auto deadline =
+        std::chrono::steady_clock::now() + routing_.probe_timeout;
+    for (auto &endpoint : endpoints_) {
+      Prober &prober = *endpoint->prober;
+      std::unique_lock<std::mutex> lock(prober.mutex);
+      prober.cv.wait_until(lock, deadline,
+                           [&prober] { return prober.ready.has_value(); });
+      if (prober.ready.has_value()) {
+        prober.requested = false;
+        if (std::exchange(prober.ready, std::nullopt).value()) {
+          continue;
+        }
+      }
+      std::cerr << "Warning: Triton endpoint " << endpoint->url
+                << " is not ready, ejecting" << std::endl;
+      endpoint->ejected = true;
+      endpoint->ejected_until =
+          std::chrono::steady_clock::now() + routing_.eject_cooldown;
     }
   }
 }
 
-TritonClient::TritonClient(const std::string &server_url,
-                           const std::string &labels_file) {
-  tc::Error err =
-      tc::InferenceServerHttpClient::Create(&http_client_, server_url, false);
-  if (!err.IsOk()) {
-    throw std::runtime_error("Failed to create HTTP client: " + err.Message());
-  }
-  if (!labels_file.empty()) {
-    load_labels(labels_file);
+TritonClient::~TritonClient() {
+  for (auto &endpoint : endpoints_) {
+    if (endpoint->prober) {
+      {
+        std::lock_guard<std::mutex> lock(endpoint->prober->mutex);
+        endpoint->prober->stopping = true;
+      }
+      endpoint->prober->cv.notify_all();
+    }
   }
 }
 
-// Re-adding parse_model_http functionality.
 void TritonClient::parse_model_http(const rapidjson::Document &model_metadata,
                                     const rapidjson::Document &model_config,
                                     const size_t batch_size,
@@ -150,10 +295,13 @@ void TritonClient::parse_model_http(const rapidjson::Document &model_metadata,
              : std::to_string(input_shape_itr->value.Size())));
   }
 
-  // Validate input shape matches [batch, 16, 3, 224, 224]
+  // Validate input shape matches [batch, frames, 3, 224, 224]; the frame
+  // count varies between models, e.g. 8-frame models in a cascade
   int frame_idx = input_batch_dim ? 1 : 0;
-  if (input_shape_itr->value[static_cast<rapidjson::SizeType>(frame_idx)]
-              .GetInt() != DEFAULT_FRAME_COUNT ||
+  const int frame_count =
+      input_shape_itr->value[static_cast<rapidjson::SizeType>(frame_idx)]
+          .GetInt();
+  if (frame_count <= 0 ||
       input_shape_itr->value[static_cast<rapidjson::SizeType>(frame_idx) + 1]
               .GetInt() != DEFAULT_CHANNELS ||
       input_shape_itr->value[static_cast<rapidjson::SizeType>(frame_idx) + 2]
@@ -161,8 +309,7 @@ void TritonClient::parse_model_http(const rapidjson::Document &model_metadata,
       input_shape_itr->value[static_cast<rapidjson::SizeType>(frame_idx) + 3]
               .GetInt() != DEFAULT_IMAGE_SIZE) {
     throw std::runtime_error(
-        "Unexpected input shape, expecting [batch, " +
-        std::to_string(DEFAULT_FRAME_COUNT) + ", " +
+        "Unexpected input shape, expecting [batch, frames, " +
         std::to_string(DEFAULT_CHANNELS) + ", " +
         std::to_string(DEFAULT_IMAGE_SIZE) + ", " +
         std::to_string(DEFAULT_IMAGE_SIZE) + "]");
@@ -188,6 +335,7 @@ void TritonClient::parse_model_http(const rapidjson::Document &model_metadata,
               << std::endl;
   }
 
+  model_info->input_t_ = frame_count;
   model_info->output_name_ =
       std::string(output_metadata["name"].GetString(),
                   output_metadata["name"].GetStringLength());
@@ -232,121 +380,485 @@ void TritonClient::parse_model_http(const rapidjson::Document &model_metadata,
 
 void TritonClient::get_model_info(const std::string &model_name,
                                   ModelInfo &model_info) {
-  tc::Error err;
-  std::string model_metadata;
-  err = http_client_->ModelMetadata(&model_metadata, model_name,
-                                    DEFAULT_MODEL_VERSION);
-  if (!err.IsOk()) {
-    throw std::runtime_error("Failed to get model metadata: " + err.Message());
+  // Replicas serve the same models, so any endpoint that answers will do
+  std::string last_error;
+  for (auto &endpoint : endpoints_) {
+    std::lock_guard<std::mutex> lock(endpoint->sync_mutex);
+    tc::Error err;
+    std::string model_metadata;
+    err = endpoint->sync_client->ModelMetadata(&model_metadata, model_name,
+                                               DEFAULT_MODEL_VERSION);
+    if (!err.IsOk()) {
+      last_error = "Failed to get model metadata from " + endpoint->url +
+                   ": " + err.Message();
+      continue;
+    }
+    rapidjson::Document model_metadata_json;
+    err = tc::ParseJson(&model_metadata_json, model_metadata);
+    if (!err.IsOk()) {
+      throw std::runtime_error("Failed to parse model metadata: " +
+                               err.Message());
+    }
+
+    std::string model_config;
+    err = endpoint->sync_client->ModelConfig(&model_config, model_name,
+                                             DEFAULT_MODEL_VERSION);
+    if (!err.IsOk()) {
+      last_error = "Failed to get model config from " + endpoint->url + ": " +
+                   err.Message();
+      continue;
+    }
+    rapidjson::Document model_config_json;
+    err = tc::ParseJson(&model_config_json, model_config);
+    if (!err.IsOk()) {
+      throw std::runtime_error("Failed to parse model config: " +
+                               err.Message());
+    }
+
+    parse_model_http(model_metadata_json, model_config_json, 1, &model_info);
+    return;
   }
-  rapidjson::Document model_metadata_json;
-  err = tc::ParseJson(&model_metadata_json, model_metadata);
-  if (!err.IsOk()) {
-    throw std::runtime_error("Failed to parse model metadata: " +
-                             err.Message());
+  throw std::runtime_error(last_error);
+}
+
+void TritonClient::run_prober(std::shared_ptr<Prober> prober) {
+  std::unique_lock<std::mutex> lock(prober->mutex);
+  while (true) {
+    prober->cv.wait(lock, [&prober] { return prober->stopping || prober->due; });
+    if (prober->stopping) {
+      return;
+    }
+    prober->due = false;
+    lock.unlock();
+    bool ready = false;
+    tc::Error err = prober->client->IsServerReady(&ready);
+    lock.lock();
+    prober->ready = err.IsOk() && ready;
+    prober->cv.notify_all();
   }
+}
 
-  std::string model_config;
-  err = http_client_->ModelConfig(&model_config, model_name, DEFAULT_MODEL_VERSION);
-  if (!err.IsOk()) {
-    throw std::runtime_error("Failed to get model config: " + err.Message());
+void TritonClient::request_probe(Prober &prober) {
+  prober.due = true;
+  prober.requested = true;
+  prober.cv.notify_all();
+}
+
+void TritonClient::record_outcome(Endpoint &endpoint,
+                                  const TritonRoutingOptions &routing,
+                                  bool success, double latency_ms) {
+  std::lock_guard<std::mutex> lock(endpoint.mutex);
+  --endpoint.outstanding;
+  if (success) {
+    endpoint.consecutive_failures = 0;
+    if (!endpoint.prober) {
+      endpoint.ejected = false; // A lone server is never probed
+    }
+    if (endpoint.latencies_ms.size() < routing.latency_window) {
+      endpoint.latencies_ms.push_back(latency_ms);
+    } else if (!endpoint.latencies_ms.empty()) {
+      endpoint.latencies_ms[endpoint.next_latency] = latency_ms;
+      endpoint.next_latency =
+          (endpoint.next_latency + 1) % endpoint.latencies_ms.size();
+    }
+    return;
   }
-  rapidjson::Document model_config_json;
-  err = tc::ParseJson(&model_config_json, model_config);
-  if (!err.IsOk()) {
-    throw std::runtime_error("Failed to parse model config: " + err.Message());
+  ++endpoint.failures;
+  if (++endpoint.consecutive_failures >= routing.max_consecutive_failures &&
+      !endpoint.ejected) {
+    std::cerr << "Warning: Ejecting Triton endpoint " << endpoint.url
+              << " after " << endpoint.consecutive_failures
+              << " consecutive failures" << std::endl;
+    endpoint.ejected = true;
+    endpoint.ejected_until =
+        std::chrono::steady_clock::now() + routing.eject_cooldown;
   }
+}
 
-  parse_model_http(model_metadata_json, model_config_json, 1, &model_info);
+bool TritonClient::is_available(Endpoint &endpoint) {
+  std::lock_guard<std::mutex> lock(endpoint.mutex);
+  if (!endpoint.ejected) {
+    return true;
+  }
+  if (!endpoint.prober) {
+    return false;
+  }
+  // Never waits for a probe: results are picked up by a later request
+  Prober &prober = *endpoint.prober;
+  std::lock_guard<std::mutex> probe_lock(prober.mutex);
+  const auto now = std::chrono::steady_clock::now();
+  if (prober.ready.has_value()) {
+    prober.requested = false;
+    if (std::exchange(prober.ready, std::nullopt).value()) {
+      endpoint.ejected = false;
+      endpoint.consecutive_failures = 0;
+      return true;
+    }
+    endpoint.ejected_until = now + routing_.eject_cooldown;
+  } else if (!prober.requested && now >= endpoint.ejected_until) {
+    request_probe(prober);
+  }
+  return false;
 }
 
-std::vector<TritonClient::InferenceResult>
-TritonClient::infer(const std::vector<float> &input_data,
-                    const std::string &model_name, const ModelInfo &model_info,
-                    const std::vector<int64_t> &shape) {
-  tc::Error err;
+TritonClient::Endpoint *TritonClient::select_endpoint(const Endpoint *exclude) {
+  const size_t count = endpoints_.size();
+  const size_t first = next_endpoint_.fetch_add(1) % count; // rotates ties
+  Endpoint *best = nullptr;
+  size_t best_outstanding = 0;
+  for (size_t i = 0; i < count; ++i) {
+    Endpoint &endpoint = *endpoints_[(first + i) % count];
+    if (&endpoint == exclude || !is_available(endpoint)) {
+      continue;
+    }
+    std::lock_guard<std::mutex> lock(endpoint.mutex);
+    if (best == nullptr || endpoint.outstanding < best_outstanding) {
+      best = &endpoint;
+      best_outstanding = endpoint.outstanding;
+    }
+  }
 
-  tc::InferInput *input;
-  err = tc::InferInput::Create(&input, model_info.input_name_, shape,
-                               model_info.input_datatype_);
-  if (!err.IsOk()) {
-    throw std::runtime_error("Failed to create input: " + err.Message());
+  if (best == nullptr && exclude == nullptr) {
+    // Everything is ejected: try the one that went down first rather than fail
+    for (auto &endpoint : endpoints_) {
+      std::lock_guard<std::mutex> lock(endpoint->mutex);
+      if (best == nullptr || endpoint->ejected_until < best->ejected_until) {
+        best = endpoint.get();
+      }
+    }
+  }
+  return best;
+}
+
+std::optional<std::chrono::microseconds>
+TritonClient::hedge_delay(Endpoint &endpoint) {
+  std::lock_guard<std::mutex> lock(endpoint.mutex);
+  if (endpoint.latencies_ms.size() < routing_.min_hedge_samples) {
+    return std::nullopt;
   }
-  std::shared_ptr<tc::InferInput> input_ptr(input);
+  const double delay_ms = latency_quantile(
+      endpoint.latencies_ms, routing_.hedge_quantile, endpoint.latency_scratch);
+  return std::chrono::microseconds(static_cast<int64_t>(delay_ms * 1000.0));
+}
 
-  err =
-      input_ptr->AppendRaw(reinterpret_cast<const uint8_t *>(input_data.data()),
-                           input_data.size() * sizeof(float));
-  if (!err.IsOk()) {
-    throw std::runtime_error("Failed to set input data: " + err.Message());
+TritonClient::RequestContext &TritonClient::acquire_context() {
+  std::lock_guard<std::mutex> lock(contexts_mutex_);
+  if (free_contexts_.empty()) {
+    // Only while warming up: the pool grows to the peak request concurrency
+    contexts_.push_back(std::make_unique<RequestContext>());
+    free_contexts_.reserve(contexts_.size());
+    free_contexts_.push_back(contexts_.back().get());
   }
+  RequestContext *context = free_contexts_.back();
+  free_contexts_.pop_back();
+  return *context;
+}
 
-  tc::InferRequestedOutput *output;
-  err = tc::InferRequestedOutput::Create(&output, model_info.output_name_);
+void TritonClient::finish_context(RequestContext &context) {
+  {
+    std::lock_guard<std::mutex> lock(context.mutex);
+    context.in_use = false;
+    // Late attempts must not write into the caller's buffer any more
+    context.done = true;
+    context.logits = {};
+    if (context.in_flight > 0) {
+      return; // The last callback returns it
+    }
+  }
+  std::lock_guard<std::mutex> lock(contexts_mutex_);
+  free_contexts_.push_back(&context);
+}
+
+void TritonClient::send_attempt(Endpoint &endpoint, RequestContext &context,
+                                const ModelInfo &model_info,
+                                const std::vector<int64_t> &shape,
+                                bool hedge) {
+  // Only the calling thread adds attempts, callbacks never touch the count
+  Attempt &attempt = context.attempts[context.num_attempts];
+
+  tc::Error err;
+  if (!attempt.input || attempt.input_name != model_info.input_name_ ||
+      attempt.input_datatype != model_info.input_datatype_) {
+    tc::InferInput *input;
+    err = tc::InferInput::Create(&input, model_info.input_name_, shape,
+                                 model_info.input_datatype_);
+    if (!err.IsOk()) {
+      throw std::runtime_error("Failed to create input: " + err.Message());
+    }
+    attempt.input.reset(input);
+    attempt.input_name = model_info.input_name_;
+    attempt.input_datatype = model_info.input_datatype_;
+    attempt.inputs = {input};
+  } else {
+    err = attempt.input->Reset();
+    if (err.IsOk()) {
+      err = attempt.input->SetShape(shape);
+    }
+    if (!err.IsOk()) {
+      throw std::runtime_error("Failed to reset input: " + err.Message());
+    }
+  }
+  err = attempt.input->AppendRaw(
+      reinterpret_cast<const uint8_t *>(context.input_data),
+      context.input_bytes);
   if (!err.IsOk()) {
-    throw std::runtime_error("Failed to create output: " + err.Message());
+    throw std::runtime_error("Failed to set input data: " + err.Message());
   }
-  std::shared_ptr<tc::InferRequestedOutput> output_ptr(output);
 
-  std::vector<tc::InferInput *> inputs = {input_ptr.get()};
-  std::vector<const tc::InferRequestedOutput *> outputs = {output_ptr.get()};
+  if (!attempt.output || attempt.output_name != context.output_name) {
+    tc::InferRequestedOutput *output;
+    err = tc::InferRequestedOutput::Create(&output, context.output_name);
+    if (!err.IsOk()) {
+      throw std::runtime_error("Failed to create output: " + err.Message());
+    }
+    attempt.output.reset(output);
+    attempt.output_name = context.output_name;
+    attempt.outputs = {output};
+  }
 
-  tc::InferOptions options(model_name);
-  options.model_version_ = DEFAULT_MODEL_VERSION;
+  attempt.client = this;
+  attempt.context = &context;
+  attempt.endpoint = &endpoint;
+  attempt.hedge = hedge;
+  ++context.num_attempts;
+  {
+    std::lock_guard<std::mutex> lock(context.mutex);
+    ++context.in_flight;
+  }
+  {
+    std::lock_guard<std::mutex> lock(endpoint.mutex);
+    ++endpoint.outstanding;
+    ++endpoint.requests;
+    if (hedge) {
+      ++endpoint.hedges;
+    }
+  }
 
-  tc::InferResult *result;
-  err = http_client_->Infer(&result, options, inputs, outputs);
+  attempt.start = std::chrono::steady_clock::now();
+  // A single pointer fits std::function's inline storage: no allocation
+  Attempt *target = &attempt;
+  err = endpoint.async_client->AsyncInfer(
+      [target](tc::InferResult *result) {
+        target->client->complete_attempt(*target, result);
+      },
+      context.options, attempt.inputs, attempt.outputs);
   if (!err.IsOk()) {
-    throw std::runtime_error("Inference failed: " + err.Message());
+    // Never reached the wire, so the callback won't run: account for it here
+    {
+      std::lock_guard<std::mutex> lock(context.mutex);
+      --context.in_flight;
+      context.last_error = endpoint.url + ": " + err.Message();
+    }
+    record_outcome(endpoint, routing_, false, 0.0);
   }
-  std::unique_ptr<tc::InferResult> result_ptr(result);
+}
 
-  std::vector<float> logits;
-  const float *output_data;
-  size_t output_size;
-  err = result_ptr->RawData(model_info.output_name_,
-                            reinterpret_cast<const uint8_t **>(&output_data),
-                            &output_size);
-  if (!err.IsOk()) {
-    throw std::runtime_error("Failed to get output data: " + err.Message());
+void TritonClient::complete_attempt(Attempt &attempt,
+                                    tc::InferResult *raw_result) {
+  std::unique_ptr<tc::InferResult> result(raw_result);
+  const double latency_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() -
+                                attempt.start)
+                                .count();
+  if (TRACE_ENABLED()) {
+    // Attempts overlap on the callback thread, so they are async spans
+    const auto start_ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            attempt.start.time_since_epoch())
+            .count());
+    Tracer::record_async(attempt.hedge ? "triton_hedge" : "triton_request",
+                         reinterpret_cast<uintptr_t>(&attempt), start_ns,
+                         Tracer::now_ns(), {});
+  }
+  // The context may be reused once released below, so copy what we need
+  RequestContext &context = *attempt.context;
+  Endpoint &endpoint = *attempt.endpoint;
+  const bool hedge = attempt.hedge;
+
+  tc::Error status = result->RequestStatus();
+  const float *output_data = nullptr;
+  size_t output_bytes = 0;
+  if (status.IsOk()) {
+    status = result->RawData(context.output_name,
+                             reinterpret_cast<const uint8_t **>(&output_data),
+                             &output_bytes);
+  }
+
+  bool won = false;
+  bool release = false;
+  {
+    std::lock_guard<std::mutex> lock(context.mutex);
+    --context.in_flight;
+    if (status.IsOk() && !context.done) {
+      // Read the response straight into the caller's buffer; one that is
+      // too small is reported by run_request()
+      const size_t count = output_bytes / sizeof(float);
+      if (context.output != nullptr) {
+        context.output->assign(output_data, output_data + count);
+      } else if (count <= context.logits.size()) {
+        std::copy(output_data, output_data + count, context.logits.begin());
+      }
+      context.num_logits = count;
+      context.done = true;
+      won = true;
+    } else if (!status.IsOk()) {
+      context.last_error = endpoint.url + ": " + status.Message();
+    }
+    release = !context.in_use && context.in_flight == 0;
+  }
+  if (!release) {
+    context.done_cv.notify_all();
   }
-  logits.assign(output_data, output_data + output_size / sizeof(float));
 
-  return postprocess_results(logits);
+  record_outcome(endpoint, routing_, status.IsOk(), latency_ms);
+  if (won && hedge) {
+    std::lock_guard<std::mutex> lock(endpoint.mutex);
+    ++endpoint.hedge_wins;
+  }
+  if (release) {
+    std::lock_guard<std::mutex> lock(contexts_mutex_);
+    free_contexts_.push_back(&context);
+  }
 }
 
-std::vector<TritonClient::InferenceResult>
-TritonClient::postprocess_results(const std::vector<float> &logits) {
-  std::vector<InferenceResult> results;
-
-  std::vector<float> probs(logits.size());
-  float max_logit = *std::max_element(logits.begin(), logits.end());
-  float sum = 0.0;
-  for (size_t i = 0; i < logits.size(); ++i) {
-    probs[i] = std::exp(logits[i] - max_logit);
-    sum += probs[i];
-  }
-  for (auto &p : probs) {
-    p /= sum;
-  }
-
-  std::vector<int> indices(probs.size());
-  std::iota(indices.begin(), indices.end(), 0);
-  std::sort(indices.begin(), indices.end(), [&probs](int a, int b) {
-    return probs[static_cast<size_t>(a)] > probs[static_cast<size_t>(b)];
-  });
-
-  for (int i = 0; i < std::min(3, static_cast<int>(indices.size())); ++i) {
-    int idx = indices[static_cast<size_t>(i)];
-    InferenceResult result;
-    if (id2label_.count(std::to_string(idx))) {
-      result.label = id2label_.at(std::to_string(idx));
-    } else {
-      result.label = "unknown_" + std::to_string(idx);
+size_t TritonClient::run_request(RequestContext &context,
+                                 const float *input_data, size_t input_size,
+                                 const std::string &model_name,
+                                 const ModelInfo &model_info,
+                                 const std::vector<int64_t> &shape,
+                                 std::span<float> logits,
+                                 std::vector<float> *output) {
+  const bool can_hedge = endpoints_.size() > 1;
+
+  // Assignments reuse the capacity left by earlier requests
+  context.options.model_name_ = model_name;
+  context.options.model_version_ = DEFAULT_MODEL_VERSION;
+  context.output_name = model_info.output_name_;
+  if (can_hedge) {
+    // A losing attempt may still be uploading after we return
+    context.input_copy.assign(input_data, input_data + input_size);
+    context.input_data = context.input_copy.data();
+  } else {
+    context.input_data = input_data;
+  }
+  context.input_bytes = input_size * sizeof(float);
+  context.num_attempts = 0;
+  {
+    std::lock_guard<std::mutex> lock(context.mutex);
+    context.in_use = true;
+    context.done = false;
+    context.logits = logits;
+    context.output = output;
+    context.num_logits = 0;
+    context.last_error.clear();
+  }
+
+  auto finished = [&context] {
+    return context.done || context.in_flight == 0;
+  };
+
+  Endpoint *primary = select_endpoint(nullptr);
+  const auto deadline = can_hedge ? hedge_delay(*primary) : std::nullopt;
+  send_attempt(*primary, context, model_info, shape, false);
+
+  std::unique_lock<std::mutex> lock(context.mutex);
+  bool retried = false;
+  if (deadline &&
+      !context.done_cv.wait_for(lock, *deadline, finished)) {
+    // Slower than this endpoint's recent tail: race a duplicate elsewhere
+    lock.unlock();
+    if (Endpoint *backup = select_endpoint(primary)) {
+      send_attempt(*backup, context, model_info, shape, true);
+      retried = true;
+    }
+    lock.lock();
+  }
+  context.done_cv.wait(lock, finished);
+
+  if (!context.done && can_hedge && !retried) {
+    // Primary failed outright: fail over once
+    lock.unlock();
+    if (Endpoint *backup = select_endpoint(primary)) {
+      send_attempt(*backup, context, model_info, shape, false);
     }
-    result.probability = probs[static_cast<size_t>(idx)];
-    results.push_back(result);
+    lock.lock();
+    context.done_cv.wait(lock, finished);
   }
 
-  return results;
+  if (!context.done) {
+    throw std::runtime_error("Inference failed: " + context.last_error);
+  }
+  if (output == nullptr && context.num_logits > logits.size()) {
+    throw std::runtime_error("Output buffer holds " +
+                             std::to_string(logits.size()) +
+                             " logits, model returned " +
+                             std::to_string(context.num_logits));
+  }
+  return context.num_logits;
+}
+
+size_t TritonClient::infer_logits_into(std::span<const float> input_data,
+                                       const std::string &model_name,
+                                       const ModelInfo &model_info,
+                                       const std::vector<int64_t> &shape,
+                                       std::span<float> logits) {
+  RequestContext &context = acquire_context();
+  try {
+    const size_t count =
+        run_request(context, input_data.data(), input_data.size(), model_name,
+                    model_info, shape, logits, nullptr);
+    finish_context(context);
+    return count;
+  } catch (...) {
+    finish_context(context);
+    throw;
+  }
+}
+
+void TritonClient::infer_logits_into(std::span<const float> input_data,
+                                     const std::string &model_name,
+                                     const ModelInfo &model_info,
+                                     const std::vector<int64_t> &shape,
+                                     std::vector<float> &logits) {
+  RequestContext &context = acquire_context();
+  try {
+    run_request(context, input_data.data(), input_data.size(), model_name,
+                model_info, shape, {}, &logits);
+    finish_context(context);
+  } catch (...) {
+    finish_context(context);
+    throw;
+  }
+}
+
+std::vector<float>
+TritonClient::infer_logits(const std::vector<float> &input_data,
+                           const std::string &model_name,
+                           const ModelInfo &model_info,
+                           const std::vector<int64_t> &shape) {
+  std::vector<float> logits;
+  infer_logits_into(input_data, model_name, model_info, shape, logits);
+  return logits;
+}
+
+std::vector<EndpointStats> TritonClient::endpoint_stats() const {
+  std::vector<EndpointStats> stats;
+  stats.reserve(endpoints_.size());
+  for (const auto &endpoint : endpoints_) {
+    std::lock_guard<std::mutex> lock(endpoint->mutex);
+    EndpointStats entry;
+    entry.url = endpoint->url;
+    entry.healthy = !endpoint->ejected;
+    entry.outstanding = endpoint->outstanding;
+    entry.requests = endpoint->requests;
+    entry.failures = endpoint->failures;
+    entry.hedges = endpoint->hedges;
+    entry.hedge_wins = endpoint->hedge_wins;
+    entry.p50_ms = latency_quantile(endpoint->latencies_ms, 0.5,
+                                    endpoint->latency_scratch);
+    entry.p95_ms = latency_quantile(endpoint->latencies_ms, 0.95,
+                                    endpoint->latency_scratch);
+    stats.push_back(std::move(entry));
+  }
+  return stats;
 }
@@ -0,0 +1,244 @@
+#include "video_classification/video_fingerprint.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+constexpr int HASH_WIDTH = 9; // One more column than bits per row
+constexpr int HASH_HEIGHT = 8;
+constexpr double DURATION_TOLERANCE_S = 1.0;
+constexpr double DURATION_TOLERANCE_RATIO = 0.02;
+
+bool durations_match(double a, double b) {
+  return std::abs(a - b) <=
+         std::max(DURATION_TOLERANCE_S, std::max(a, b) * DURATION_TOLERANCE_RATIO);
+}
+
+std::string to_hex(uint64_t value) {
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx",
+                static_cast<unsigned long long>(value));
+  return hex;
+}
+
+std::string entry_line(const std::string &video,
+                       const VideoFingerprint &fingerprint,
+                       const std::vector<InferenceBackend::InferenceResult>
+                           &predictions) {
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.Key("video");
+  writer.String(video.c_str(), static_cast<rapidjson::SizeType>(video.size()));
+  writer.Key("duration");
+  writer.Double(fingerprint.duration);
+  writer.Key("hashes");
+  writer.StartArray();
+  for (uint64_t hash : fingerprint.frame_hashes) {
+    const std::string hex = to_hex(hash);
+    writer.String(hex.c_str(), static_cast<rapidjson::SizeType>(hex.size()));
+  }
+  writer.EndArray();
+  writer.Key("predictions");
+  writer.StartArray();
+  for (const auto &prediction : predictions) {
+    writer.StartObject();
+    writer.Key("label");
+    writer.String(prediction.label.c_str(),
+                  static_cast<rapidjson::SizeType>(prediction.label.size()));
+    writer.Key("probability");
+    writer.Double(prediction.probability);
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+  return std::string(buffer.GetString(), buffer.GetSize()) + "\n";
+}
+}
+
+VideoFingerprint
+VideoFingerprint::from_frames(const std::vector<cv::Mat> &frames,
+                              FrameColorFormat color_format, double duration) {
+  if (frames.empty()) {
+    throw std::runtime_error("Cannot fingerprint a window without frames");
+  }
+  VideoFingerprint fingerprint;
+  fingerprint.duration = duration;
+  for (size_t i = 0; i < NUM_FRAMES; ++i) {
+    // Centers of NUM_FRAMES equal slices of the window
+    const cv::Mat &frame =
+        frames[(2 * i + 1) * frames.size() / (2 * NUM_FRAMES)];
+    fingerprint.frame_hashes[i] =
+        color_format == FrameColorFormat::YUV420
+            ? dhash(frame.rowRange(0, frame.rows * 2 / 3)) // Luma plane
+            : dhash(frame, true);
+  }
+  return fingerprint;
+}
+
+uint64_t VideoFingerprint::dhash(const cv::Mat &frame, bool rgb) {
+  // Shrink first so the color conversion touches 72 pixels
+  cv::Mat thumbnail;
+  cv::resize(frame, thumbnail, cv::Size(HASH_WIDTH, HASH_HEIGHT), 0, 0,
+             cv::INTER_AREA);
+  if (thumbnail.channels() == 3) {
+    cv::cvtColor(thumbnail, thumbnail,
+                 rgb ? cv::COLOR_RGB2GRAY : cv::COLOR_BGR2GRAY);
+  }
+  uint64_t hash = 0;
+  for (int y = 0; y < HASH_HEIGHT; ++y) {
+    const auto *row = thumbnail.ptr<uchar>(y);
+    for (int x = 0; x + 1 < HASH_WIDTH; ++x) {
+      hash = (hash << 1) | (row[x] < row[x + 1] ? 1u : 0u);
+    }
+  }
+  return hash;
+}
+
+int VideoFingerprint::distance(const VideoFingerprint &other) const {
+  int bits = 0;
+  for (size_t i = 0; i < NUM_FRAMES; ++i) {
+    bits += std::popcount(frame_hashes[i] ^ other.frame_hashes[i]);
+  }
+  return bits;
+}
+
+FingerprintIndex::FingerprintIndex(const std::string &path, int max_distance)
+    : path_(path), max_distance_(max_distance) {
+  std::ofstream touch(path_, std::ios::app);
+  if (!touch) {
+    throw std::runtime_error("Failed to open fingerprint index: " + path_);
+  }
+  touch.close();
+  std::lock_guard<std::mutex> lock(mutex_);
+  read_new_entries();
+}
+
+std::optional<FingerprintIndex::Match>
+FingerprintIndex::find(const VideoFingerprint &fingerprint) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (auto match = find_loaded(fingerprint)) {
+    return match;
+  }
+  // Another process may have classified a duplicate since
+  const size_t loaded = entries_.size();
+  read_new_entries();
+  return entries_.size() > loaded ? find_loaded(fingerprint) : std::nullopt;
+}
+
+void FingerprintIndex::add(
+    const std::string &video, const VideoFingerprint &fingerprint,
+    const std::vector<InferenceBackend::InferenceResult> &predictions) {
+  const std::string line = entry_line(video, fingerprint, predictions);
+  std::lock_guard<std::mutex> lock(mutex_);
+  // A single O_APPEND write keeps lines of concurrent writers whole
+  const int fd = ::open(path_.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open fingerprint index: " + path_ +
+                             ": " + std::strerror(errno));
+  }
+  const ssize_t written = ::write(fd, line.data(), line.size());
+  ::close(fd);
+  if (written != static_cast<ssize_t>(line.size())) {
+    throw std::runtime_error("Failed to write fingerprint index: " + path_);
+  }
+  // Picks up this entry along with any appended by other processes
+  read_new_entries();
+}
+
+size_t FingerprintIndex::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void FingerprintIndex::read_new_entries() {
+  std::ifstream in(path_, std::ios::binary);
+  in.seekg(static_cast<std::streamoff>(read_offset_));
+  const std::string data((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+
+  size_t start = 0;
+  for (size_t end = data.find('\n'); end != std::string::npos;
+       start = end + 1, end = data.find('\n', start)) {
+    rapidjson::Document doc;
+    doc.Parse(data.c_str() + start, end - start);
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("video") ||
+        !doc["video"].IsString() || !doc.HasMember("duration") ||
+        !doc["duration"].IsNumber() || !doc.HasMember("hashes") ||
+        !doc["hashes"].IsArray() ||
+        doc["hashes"].Size() != VideoFingerprint::NUM_FRAMES ||
+        !doc.HasMember("predictions") || !doc["predictions"].IsArray()) {
+      std::cerr << "Warning: Skipping malformed entry in " << path_
+                << std::endl;
+      continue;
+    }
+
+    Entry entry;
+    entry.video = doc["video"].GetString();
+    entry.fingerprint.duration = doc["duration"].GetDouble();
+    bool valid = true;
+    for (rapidjson::SizeType i = 0; i < VideoFingerprint::NUM_FRAMES; ++i) {
+      const auto &hash = doc["hashes"][i];
+      valid = valid && hash.IsString();
+      if (valid) {
+        entry.fingerprint.frame_hashes[i] =
+            std::strtoull(hash.GetString(), nullptr, 16);
+      }
+    }
+    const auto &predictions = doc["predictions"];
+    for (rapidjson::SizeType i = 0; i < predictions.Size(); ++i) {
+      const auto &prediction = predictions[i];
+      if (prediction.IsObject() && prediction.HasMember("label") &&
+          prediction["label"].IsString() &&
+          prediction.HasMember("probability") &&
+          prediction["probability"].IsNumber()) {
+        InferenceBackend::InferenceResult result;
+        result.label = prediction["label"].GetString();
+        result.probability = prediction["probability"].GetFloat();
+        entry.predictions.push_back(std::move(result));
+      }
+    }
+    if (valid) {
+      entries_.push_back(std::move(entry));
+    }
+  }
+  // A partly written last line is read again next time
+  read_offset_ += start;
+}
+
+std::optional<FingerprintIndex::Match>
+FingerprintIndex::find_loaded(const VideoFingerprint &fingerprint) const {
+  const Entry *best = nullptr;
+  int best_distance = max_distance_ + 1;
+  for (const auto &entry : entries_) {
+    if (!durations_match(entry.fingerprint.duration, fingerprint.duration)) {
+      continue;
+    }
+    int bits = 0;
+    for (size_t i = 0; i < VideoFingerprint::NUM_FRAMES && bits < best_distance;
+         ++i) {
+      bits += std::popcount(entry.fingerprint.frame_hashes[i] ^
+                            fingerprint.frame_hashes[i]);
+    }
+    if (bits < best_distance) {
+      best = &entry;
+      best_distance = bits;
+    }
+  }
+  if (best == nullptr) {
+    return std::nullopt;
+  }
+  return Match{best->video, best_distance, best->predictions};
+}
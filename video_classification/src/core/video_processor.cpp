@@ -1,6 +1,13 @@
 #include "video_classification/video_processor.hpp"
+#include "video_classification/tracer.hpp"
 #include <algorithm>
 #include <cmath>
+#include <limits>
+
+namespace {
+// Forward gaps longer than this are seeked rather than grabbed through
+constexpr int MAX_GRAB_GAP = 64;
+}
 
 VideoProcessor::VideoProcessor() {}
 
@@ -10,15 +17,26 @@ VideoProcessor::~VideoProcessor() {
   }
 }
 
-bool VideoProcessor::openVideo(const std::string &videoPath) {
+bool VideoProcessor::openVideo(
+    const std::string &videoPath,
+    std::shared_ptr<const VideoSeekIndex> videoSeekIndex) {
   cap.open(videoPath);
   if (!cap.isOpened()) {
     return false;
   }
 
-  info.totalFrames = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_COUNT));
-  info.fps = cap.get(cv::CAP_PROP_FPS);
-  info.duration = info.totalFrames / info.fps;
+  path = videoPath;
+  seekIndex = std::move(videoSeekIndex);
+  if (seekIndex) {
+    info.totalFrames = seekIndex->frame_count();
+    info.fps = seekIndex->fps();
+    info.duration = seekIndex->duration();
+  } else {
+    info.totalFrames = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_COUNT));
+    info.fps = cap.get(cv::CAP_PROP_FPS);
+    info.duration = info.totalFrames / info.fps;
+  }
+  nextFrame = 0;
   return true;
 }
 
@@ -26,33 +44,78 @@ VideoProcessor::VideoInfo VideoProcessor::getVideoInfo() const { return info; }
 
 std::vector<VideoProcessor::WindowIndices>
 VideoProcessor::splitVideoIntoWindows(int windowSize, float samplingFps) const {
+  // Back-to-back windows; trailing frames that fill no window are skipped
+  return splitWindows(windowSize, samplingFps, windowSize, 0.0,
+                      std::numeric_limits<double>::infinity(), false);
+}
+
+std::vector<VideoProcessor::WindowIndices>
+VideoProcessor::splitVideoIntoWindows(int windowSize, float samplingFps,
+                                      int stride, double startTime,
+                                      double endTime) const {
+  return splitWindows(windowSize, samplingFps, stride, startTime, endTime,
+                      true);
+}
+
+std::vector<VideoProcessor::WindowIndices>
+VideoProcessor::splitWindows(int windowSize, float samplingFps, int stride,
+                             double startTime, double endTime,
+                             bool coverEnd) const {
   std::vector<WindowIndices> windows;
-  int interval = std::max(static_cast<int>(info.fps / samplingFps), 1);
   std::vector<int> sampledIndices;
-
-  for (int i = 0; i < info.totalFrames; i += interval) {
-    sampledIndices.push_back(i);
+  startTime = std::max(startTime, 0.0);
+
+  if (seekIndex) {
+    // Sample by presentation time, which stays correct at variable frame rate
+    for (int step = 0;; ++step) {
+      const double time = startTime + step / static_cast<double>(samplingFps);
+      int frame = seekIndex->frame_at_time(time);
+      if (frame >= info.totalFrames || time > endTime) {
+        break;
+      }
+      if (sampledIndices.empty() || frame > sampledIndices.back()) {
+        sampledIndices.push_back(frame);
+      }
+    }
+  } else {
+    int interval = std::max(static_cast<int>(info.fps / samplingFps), 1);
+    for (int i = static_cast<int>(std::ceil(startTime * info.fps));
+         i < info.totalFrames && i / info.fps <= endTime; i += interval) {
+      sampledIndices.push_back(i);
+    }
   }
+  auto frameTime = [this](int frame) {
+    return seekIndex ? seekIndex->frame_time(frame) : frame / info.fps;
+  };
 
-  for (size_t i = 0;
-       i + static_cast<size_t>(windowSize) <= sampledIndices.size();
-       i += static_cast<size_t>(windowSize)) {
+  const size_t windowFrames = static_cast<size_t>(std::max(windowSize, 1));
+  auto addWindow = [&](size_t first) {
     WindowIndices window;
     window.indices.assign(
-        sampledIndices.begin() + static_cast<long>(i),
-        sampledIndices.begin() +
-            static_cast<long>(i + static_cast<size_t>(windowSize)));
-    window.startTime = window.indices.front() / info.fps;
-    window.endTime = window.indices.back() / info.fps;
+        sampledIndices.begin() + static_cast<long>(first),
+        sampledIndices.begin() + static_cast<long>(first + windowFrames));
+    window.startTime = frameTime(window.indices.front());
+    window.endTime = frameTime(window.indices.back());
     windows.push_back(window);
+  };
+
+  const size_t strideFrames = static_cast<size_t>(std::max(stride, 1));
+  size_t next = 0; // First sample no window covers
+  for (size_t i = 0; i + windowFrames <= sampledIndices.size();
+       i += strideFrames) {
+    addWindow(i);
+    next = i + windowFrames;
+  }
+  if (coverEnd && !windows.empty() && next < sampledIndices.size()) {
+    addWindow(sampledIndices.size() - windowFrames);
   }
 
   // Handle last window if needed
   if (!sampledIndices.empty() && windows.empty()) {
     WindowIndices window;
     window.indices = sampledIndices;
-    window.startTime = window.indices.front() / info.fps;
-    window.endTime = window.indices.back() / info.fps;
+    window.startTime = frameTime(window.indices.front());
+    window.endTime = frameTime(window.indices.back());
     windows.push_back(window);
   }
 
@@ -62,24 +125,33 @@ VideoProcessor::splitVideoIntoWindows(int windowSize, float samplingFps) const {
 std::vector<cv::Mat>
 VideoProcessor::extractFrames(const std::vector<int> &indices) {
   std::vector<cv::Mat> frames;
-  int currentFrame = 0;
 
+  // The capture position carries over between calls, so consecutive windows
+  // continue decoding where the previous one stopped
   for (int targetFrame : indices) {
-    if (targetFrame < currentFrame) {
+    TRACE_SCOPE("decode_frame", .video = path, .frame = targetFrame);
+    const bool seek = seekIndex ? seekIndex->should_seek(nextFrame, targetFrame)
+                                : targetFrame < nextFrame ||
+                                      targetFrame - nextFrame > MAX_GRAB_GAP;
+    if (seek && seekIndex) {
+      nextFrame = seekIndex->seek(cap, targetFrame);
+    } else if (seek) {
       cap.set(cv::CAP_PROP_POS_FRAMES, targetFrame);
-      currentFrame = targetFrame;
+      nextFrame = targetFrame;
     }
 
-    while (currentFrame < targetFrame) {
-      cap.grab();
-      currentFrame++;
+    int grabbed = -1;
+    while (nextFrame <= targetFrame && cap.grab()) {
+      grabbed = seekIndex ? seekIndex->grabbed_frame(cap, nextFrame) : nextFrame;
+      nextFrame = grabbed + 1;
     }
 
     cv::Mat frame;
-    if (cap.read(frame)) {
+    if (grabbed == targetFrame && cap.retrieve(frame)) {
       frames.push_back(frame);
+    } else {
+      nextFrame = std::numeric_limits<int>::max(); // Unknown, seek next time
     }
-    currentFrame++;
   }
 
   return frames;
@@ -0,0 +1,322 @@
+#include "video_classification/video_seek_index.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+constexpr char MAGIC[8] = {'V', 'C', 'S', 'E', 'E', 'K', '0', '1'};
+constexpr uint32_t FORMAT_VERSION = 2;
+constexpr const char *INDEX_SUFFIX = ".seekidx";
+constexpr size_t HASH_CHUNK_SIZE = 1 << 20;
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+// OpenCV's FFmpeg backend seeks to the keyframe preceding target - 16 and
+// decodes forward from there
+constexpr int SEEK_PREROLL_FRAMES = 16;
+// Without keyframe positions, forward gaps longer than this are seeked
+constexpr int FALLBACK_GRAB_GAP = 64;
+// Intervals further than this from the mean mark a variable frame rate
+constexpr double VFR_TOLERANCE = 0.1;
+
+/**
+ * Layout: FileHeader, uint32 frame_ms[num_frames], uint32 keyframes[n]
+ */
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_frames;
+  uint64_t file_hash;
+  double nominal_fps;
+  uint32_t num_keyframes;
+  uint32_t start_ms;
+};
+static_assert(sizeof(FileHeader) == 40, "FileHeader must have no padding");
+
+uint64_t fnv1a(uint64_t hash, const char *data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+std::string index_path(const std::string &index_dir, uint64_t file_hash) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx",
+                static_cast<unsigned long long>(file_hash));
+  return (fs::path(index_dir) / (std::string(name) + INDEX_SUFFIX)).string();
+}
+}
+
+VideoSeekIndex::VideoSeekIndex(uint64_t file_hash, double nominal_fps,
+                               std::vector<double> frame_times,
+                               std::vector<int> keyframes)
+    : file_hash_(file_hash), nominal_fps_(nominal_fps) {
+  if (frame_times.empty()) {
+    throw std::runtime_error("Seek index needs at least one frame");
+  }
+  std::sort(frame_times.begin(), frame_times.end());
+  start_ms_ = static_cast<uint32_t>(
+      std::lround(std::max(frame_times.front(), 0.0) * 1000.0));
+  frame_ms_.reserve(frame_times.size());
+  for (double time : frame_times) {
+    frame_ms_.push_back(static_cast<uint32_t>(
+        std::lround(std::max(time - frame_times.front(), 0.0) * 1000.0)));
+  }
+  for (int keyframe : keyframes) {
+    if (keyframe >= 0 && keyframe < frame_count()) {
+      keyframes_.push_back(static_cast<uint32_t>(keyframe));
+    }
+  }
+  std::sort(keyframes_.begin(), keyframes_.end());
+}
+
+VideoSeekIndex VideoSeekIndex::build(const std::string &video_path) {
+  const uint64_t file_hash = hash_file(video_path);
+
+  // Raw mode hands out demuxed packets without decoding them
+  cv::VideoCapture cap(video_path, cv::CAP_FFMPEG, {cv::CAP_PROP_FORMAT, -1});
+  if (!cap.isOpened()) {
+    throw std::runtime_error("Failed to open video: " + video_path);
+  }
+  const double nominal_fps = cap.get(cv::CAP_PROP_FPS);
+
+  // Packets arrive in decode order; with B-frames their timestamps are not
+  // monotonic, so frame numbers are assigned after sorting
+  std::vector<double> packet_times;
+  std::vector<double> keyframe_times;
+  while (cap.grab()) {
+    const double time = cap.get(cv::CAP_PROP_POS_MSEC) / 1000.0;
+    packet_times.push_back(time);
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && CV_VERSION_MINOR >= 7)
+    if (cap.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0) {
+      keyframe_times.push_back(time);
+    }
+#endif
+  }
+  cap.release();
+  if (packet_times.empty()) {
+    throw std::runtime_error("No frames could be read from video: " +
+                             video_path);
+  }
+
+  std::vector<double> frame_times = packet_times;
+  std::sort(frame_times.begin(), frame_times.end());
+  if (std::adjacent_find(frame_times.begin(), frame_times.end()) !=
+      frame_times.end()) {
+    // Missing timestamps: fall back to the nominal rate and give up on
+    // keyframes, whose positions can no longer be matched to frames
+    std::cerr << "Warning: " << video_path
+              << " has no usable timestamps, assuming constant frame rate"
+              << std::endl;
+    const double fps = nominal_fps > 0 ? nominal_fps : 1.0;
+    for (size_t i = 0; i < frame_times.size(); ++i) {
+      frame_times[i] = static_cast<double>(i) / fps;
+    }
+    keyframe_times.clear();
+  }
+
+  std::vector<int> keyframes;
+  keyframes.reserve(keyframe_times.size());
+  for (double time : keyframe_times) {
+    keyframes.push_back(static_cast<int>(
+        std::lower_bound(frame_times.begin(), frame_times.end(), time) -
+        frame_times.begin()));
+  }
+  return VideoSeekIndex(file_hash, nominal_fps, std::move(frame_times),
+                        std::move(keyframes));
+}
+
+std::shared_ptr<const VideoSeekIndex>
+VideoSeekIndex::load_or_build(const std::string &video_path,
+                              const std::string &index_dir) {
+  const uint64_t file_hash = hash_file(video_path);
+  const std::string path = index_path(index_dir, file_hash);
+  if (auto index = load(path, file_hash)) {
+    return std::make_shared<const VideoSeekIndex>(std::move(*index));
+  }
+
+  auto index = std::make_shared<const VideoSeekIndex>(build(video_path));
+  try {
+    fs::create_directories(index_dir);
+    index->save(path);
+  } catch (const std::exception &e) {
+    std::cerr << "Warning: Failed to cache seek index of " << video_path
+              << ": " << e.what() << std::endl;
+  }
+  return index;
+}
+
+std::optional<VideoSeekIndex> VideoSeekIndex::load(const std::string &path,
+                                                   uint64_t file_hash) {
+  std::ifstream in(path, std::ios::binary);
+  FileHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+      header.version != FORMAT_VERSION || header.file_hash != file_hash ||
+      header.num_frames == 0) {
+    return std::nullopt;
+  }
+
+  std::vector<uint32_t> frame_ms(header.num_frames);
+  std::vector<uint32_t> keyframes(header.num_keyframes);
+  in.read(reinterpret_cast<char *>(frame_ms.data()),
+          static_cast<std::streamsize>(frame_ms.size() * sizeof(uint32_t)));
+  in.read(reinterpret_cast<char *>(keyframes.data()),
+          static_cast<std::streamsize>(keyframes.size() * sizeof(uint32_t)));
+  if (!in || !std::is_sorted(frame_ms.begin(), frame_ms.end()) ||
+      !std::is_sorted(keyframes.begin(), keyframes.end()) ||
+      (!keyframes.empty() && keyframes.back() >= header.num_frames)) {
+    return std::nullopt;
+  }
+
+  VideoSeekIndex index(file_hash, header.nominal_fps, {0.0}, {});
+  index.start_ms_ = header.start_ms;
+  index.frame_ms_ = std::move(frame_ms);
+  index.keyframes_ = std::move(keyframes);
+  return index;
+}
+
+void VideoSeekIndex::save(const std::string &path) const {
+  FileHeader header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = FORMAT_VERSION;
+  header.num_frames = static_cast<uint32_t>(frame_ms_.size());
+  header.file_hash = file_hash_;
+  header.nominal_fps = nominal_fps_;
+  header.num_keyframes = static_cast<uint32_t>(keyframes_.size());
+  header.start_ms = start_ms_;
+
+  // Unique per writer, so concurrent saves of the same video do not interleave
+  static std::atomic<uint64_t> next_tmp{0};
+  const std::string tmp_path = path + ".tmp." + std::to_string(::getpid()) +
+                               "." + std::to_string(next_tmp++);
+  std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(frame_ms_.data()),
+            static_cast<std::streamsize>(frame_ms_.size() * sizeof(uint32_t)));
+  out.write(reinterpret_cast<const char *>(keyframes_.data()),
+            static_cast<std::streamsize>(keyframes_.size() * sizeof(uint32_t)));
+  out.close();
+  if (!out) {
+    fs::remove(tmp_path);
+    throw std::runtime_error("Failed to write seek index: " + tmp_path);
+  }
+  fs::rename(tmp_path, path);
+}
+
+uint64_t VideoSeekIndex::hash_file(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Failed to open video: " + path);
+  }
+  in.seekg(0, std::ios::end);
+  const auto size = static_cast<uint64_t>(in.tellg());
+  uint64_t hash = fnv1a(FNV_OFFSET_BASIS, reinterpret_cast<const char *>(&size),
+                        sizeof(size));
+
+  std::vector<char> chunk(HASH_CHUNK_SIZE);
+  const uint64_t tail = size > HASH_CHUNK_SIZE ? size - HASH_CHUNK_SIZE : 0;
+  for (uint64_t offset : {uint64_t{0}, tail}) {
+    in.seekg(static_cast<std::streamoff>(offset));
+    in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    hash = fnv1a(hash, chunk.data(), static_cast<size_t>(in.gcount()));
+    in.clear();
+  }
+  return hash;
+}
+
+double VideoSeekIndex::duration() const {
+  // The last frame is shown for one average frame interval
+  return frame_ms_.back() / 1000.0 + 1.0 / fps();
+}
+
+double VideoSeekIndex::fps() const {
+  if (frame_ms_.size() < 2 || frame_ms_.back() == 0) {
+    return nominal_fps_ > 0 ? nominal_fps_ : 1.0;
+  }
+  return static_cast<double>(frame_ms_.size() - 1) /
+         (frame_ms_.back() / 1000.0);
+}
+
+double VideoSeekIndex::frame_time(int frame) const {
+  frame = std::clamp(frame, 0, frame_count() - 1);
+  return frame_ms_[static_cast<size_t>(frame)] / 1000.0;
+}
+
+int VideoSeekIndex::frame_at_time(double seconds) const {
+  const long long ms = std::llround(std::max(seconds, 0.0) * 1000.0);
+  if (ms > frame_ms_.back()) {
+    return frame_count();
+  }
+  return static_cast<int>(
+      std::lower_bound(frame_ms_.begin(), frame_ms_.end(),
+                       static_cast<uint32_t>(ms)) -
+      frame_ms_.begin());
+}
+
+int VideoSeekIndex::keyframe_before(int frame) const {
+  auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(),
+                             static_cast<uint32_t>(std::max(frame, 0)));
+  return it == keyframes_.begin() ? 0 : static_cast<int>(*(it - 1));
+}
+
+bool VideoSeekIndex::should_seek(int position, int target) const {
+  if (target < position) {
+    return true;
+  }
+  if (!has_keyframes()) {
+    return target - position > FALLBACK_GRAB_GAP;
+  }
+  // A seek restarts decoding at this keyframe; worth it only past position
+  return keyframe_before(target - SEEK_PREROLL_FRAMES) > position;
+}
+
+int VideoSeekIndex::seek(cv::VideoCapture &cap, int frame) const {
+  // The setter takes time from the first frame, unlike the getter
+  const double margin = nominal_fps_ > 0 ? 1.0 / nominal_fps_ : 0.0;
+  const double time = std::max(frame_time(frame) - margin, 0.0);
+  cap.set(cv::CAP_PROP_POS_MSEC, time * 1000.0);
+  return std::min(frame_at_time(time), frame);
+}
+
+int VideoSeekIndex::grabbed_frame(const cv::VideoCapture &cap,
+                                  int expected) const {
+  const double ms = cap.get(cv::CAP_PROP_POS_MSEC) - start_ms_;
+  if (ms < -1.0) {
+    return expected;
+  }
+  // Stored times are rounded to whole milliseconds
+  auto it = std::lower_bound(frame_ms_.begin(), frame_ms_.end(),
+                             static_cast<uint32_t>(std::max(ms - 1.0, 0.0)));
+  if (it == frame_ms_.end() || *it > ms + 1.0) {
+    return expected;
+  }
+  return static_cast<int>(it - frame_ms_.begin());
+}
+
+bool VideoSeekIndex::variable_frame_rate() const {
+  if (frame_ms_.size() < 3) {
+    return false;
+  }
+  const double mean = 1000.0 / fps();
+  for (size_t i = 1; i < frame_ms_.size(); ++i) {
+    const double interval = frame_ms_[i] - frame_ms_[i - 1];
+    if (std::abs(interval - mean) > mean * VFR_TOLERANCE &&
+        std::abs(interval - mean) > 1.0) {
+      return true;
+    }
+  }
+  return false;
+}
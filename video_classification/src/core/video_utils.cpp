@@ -1,45 +1,139 @@
 #include "video_classification/video_utils.hpp"
+#include "video_classification/tracer.hpp"
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <stdexcept>
 
+namespace {
+/**
+ * @brief Quotes a value for a gst-launch pipeline description
+ */
+std::string quote_pipeline_value(const std::string &value) {
+  std::string quoted = "\"";
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + '"';
+}
+
+/**
+ * @brief Opens a GStreamer pipeline that hands out planar I420 frames
+ *
+ * appsink pipelines generally support neither seeking by frame nor a frame
+ * count, so captures opened here are only read forward.
+ */
+void open_yuv420_capture(cv::VideoCapture &cap, const std::string &video_path) {
+  // videoconvert is a passthrough when the decoder already produces I420
+  const std::string pipeline = "filesrc location=" +
+                               quote_pipeline_value(video_path) +
+                               " ! decodebin ! videoconvert ! "
+                               "video/x-raw,format=I420 ! appsink";
+  if (!cap.open(pipeline, cv::CAP_GSTREAMER)) {
+    throw std::runtime_error("Failed to open video as YUV420 (requires "
+                             "OpenCV with GStreamer): " +
+                             video_path);
+  }
+}
+}
+
 std::vector<cv::Mat> read_video_frames(const std::string &video_path,
-                                       int target_frames) {
-  cv::VideoCapture cap(video_path);
+                                       int target_frames,
+                                       FrameColorFormat color_format,
+                                       const VideoSeekIndex *seek_index,
+                                       double *duration) {
+  cv::VideoCapture cap;
+  const bool sequential = color_format == FrameColorFormat::YUV420;
+  if (sequential) {
+    open_yuv420_capture(cap, video_path);
+  } else {
+    cap.open(video_path);
+  }
   if (!cap.isOpened()) {
     throw std::runtime_error("Failed to open video: " + video_path);
   }
 
-  // Get video properties
-  double fps = cap.get(cv::CAP_PROP_FPS);
-  if (fps <= 0) {
-    cap.release();
-    throw std::runtime_error("Invalid FPS for video: " + video_path);
-  }
-  int total_frames = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_COUNT));
-  double duration = total_frames / fps; // Duration in seconds
-
   // Calculate frame indices for 1 FPS sampling
   std::vector<int> indices;
-  int available_seconds = std::min(static_cast<int>(duration), target_frames);
-  for (int i = 0; i < available_seconds; ++i) {
-    int frame_idx = static_cast<int>(i * fps);
-    if (frame_idx < total_frames) {
+  double fps = 0.0;
+  if (seek_index != nullptr) {
+    fps = seek_index->fps();
+    if (duration != nullptr) {
+      *duration = seek_index->duration();
+    }
+    for (int i = 0; i < target_frames; ++i) {
+      int frame_idx = seek_index->frame_at_time(i);
+      if (frame_idx >= seek_index->frame_count()) {
+        break;
+      }
       indices.push_back(frame_idx);
     }
+  } else {
+    // Get video properties
+    fps = cap.get(cv::CAP_PROP_FPS);
+    if (fps <= 0) {
+      cap.release();
+      throw std::runtime_error("Invalid FPS for video: " + video_path);
+    }
+    // Without a frame count, reading simply stops at the end of the video
+    int total_frames = std::numeric_limits<int>::max();
+    int available_seconds = target_frames;
+    // Pipelines read forward may not know their length; 0 then
+    const double frame_count = cap.get(cv::CAP_PROP_FRAME_COUNT);
+    const double video_seconds = std::max(frame_count, 0.0) / fps;
+    if (duration != nullptr) {
+      *duration = video_seconds;
+    }
+    if (!sequential) {
+      total_frames = static_cast<int>(frame_count);
+      available_seconds =
+          std::min(static_cast<int>(video_seconds), target_frames);
+    }
+    for (int i = 0; i < available_seconds; ++i) {
+      int frame_idx = static_cast<int>(i * fps);
+      if (frame_idx < total_frames) {
+        indices.push_back(frame_idx);
+      }
+    }
   }
 
   // Read frames
   std::vector<cv::Mat> frames;
+  int position = 0; // Frame the next grab() returns
   for (int idx : indices) {
-    cap.set(cv::CAP_PROP_POS_FRAMES, idx);
+    TRACE_SCOPE("decode_frame", .video = video_path, .frame = idx);
+    if (!sequential && seek_index != nullptr &&
+        seek_index->should_seek(position, idx)) {
+      position = seek_index->seek(cap, idx);
+    } else if (!sequential && seek_index == nullptr) {
+      cap.set(cv::CAP_PROP_POS_FRAMES, idx);
+      position = idx;
+    }
+    int grabbed = -1;
+    while (position <= idx && cap.grab()) {
+      grabbed = seek_index != nullptr && !sequential
+                    ? seek_index->grabbed_frame(cap, position)
+                    : position;
+      position = grabbed + 1;
+    }
     cv::Mat frame;
-    if (!cap.read(frame)) {
+    if (grabbed != idx || !cap.retrieve(frame)) {
+      if (sequential) {
+        break; // End of the video
+      }
       std::cerr << "Warning: Failed to read frame at index " << idx
                 << " (time: " << idx / fps << "s)" << std::endl;
+      position = std::numeric_limits<int>::max(); // Seek next time
       continue;
     }
-    cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
-    frames.push_back(frame.clone());
+    if (color_format == FrameColorFormat::RGB) {
+      cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
+    }
+    frames.push_back(frame); // frame is re-created every iteration
   }
   cap.release();
 
@@ -62,3 +156,112 @@ std::vector<cv::Mat> pad_video_frames(const std::vector<cv::Mat> &frames,
   }
   return padded;
 }
+
+std::vector<std::vector<cv::Mat>>
+read_video_clips(const std::string &video_path, int clip_length, int num_clips,
+                 const VideoSeekIndex *seek_index) {
+  if (num_clips <= 1) {
+    return {pad_video_frames(read_video_frames(video_path, clip_length,
+                                               FrameColorFormat::RGB,
+                                               seek_index),
+                             clip_length)};
+  }
+
+  cv::VideoCapture cap(video_path);
+  if (!cap.isOpened()) {
+    throw std::runtime_error("Failed to open video: " + video_path);
+  }
+  double fps = 0.0;
+  int total_frames = 0;
+  int total_seconds = 0;
+  if (seek_index != nullptr) {
+    fps = seek_index->fps();
+    total_frames = seek_index->frame_count();
+    total_seconds = static_cast<int>(seek_index->duration());
+  } else {
+    fps = cap.get(cv::CAP_PROP_FPS);
+    if (fps <= 0) {
+      throw std::runtime_error("Invalid FPS for video: " + video_path);
+    }
+    total_frames = static_cast<int>(cap.get(cv::CAP_PROP_FRAME_COUNT));
+    total_seconds = static_cast<int>(total_frames / fps);
+  }
+  int last_start = std::max(total_seconds - clip_length, 0);
+
+  // Frame index of every second used by any clip, decoded once each
+  std::map<int, cv::Mat> decoded;
+  std::vector<std::vector<int>> clip_indices(static_cast<size_t>(num_clips));
+  for (int c = 0; c < num_clips; ++c) {
+    int start = last_start * c / (num_clips - 1);
+    for (int s = start; s < std::min(start + clip_length, total_seconds); ++s) {
+      int frame_idx = seek_index != nullptr ? seek_index->frame_at_time(s)
+                                            : static_cast<int>(s * fps);
+      if (frame_idx < total_frames) {
+        clip_indices[static_cast<size_t>(c)].push_back(frame_idx);
+        decoded.emplace(frame_idx, cv::Mat());
+      }
+    }
+  }
+
+  int position = 0; // Frame the next grab() returns
+  for (auto &[idx, frame] : decoded) {
+    TRACE_SCOPE("decode_frame", .video = video_path, .frame = idx);
+    if (seek_index != nullptr) {
+      if (seek_index->should_seek(position, idx)) {
+        position = seek_index->seek(cap, idx);
+      }
+    } else if (idx != position) {
+      cap.set(cv::CAP_PROP_POS_FRAMES, idx);
+      position = idx;
+    }
+    int grabbed = -1;
+    while (position <= idx && cap.grab()) {
+      grabbed = seek_index != nullptr ? seek_index->grabbed_frame(cap, position)
+                                      : position;
+      position = grabbed + 1;
+    }
+    if (grabbed != idx || !cap.retrieve(frame)) {
+      std::cerr << "Warning: Failed to read frame at index " << idx
+                << " (time: " << idx / fps << "s)" << std::endl;
+      frame = cv::Mat();
+      position = std::numeric_limits<int>::max(); // Seek next time
+      continue;
+    }
+    cv::cvtColor(frame, frame, cv::COLOR_BGR2RGB);
+  }
+  cap.release();
+
+  std::vector<std::vector<cv::Mat>> clips;
+  clips.reserve(static_cast<size_t>(num_clips));
+  for (const auto &indices : clip_indices) {
+    std::vector<cv::Mat> clip;
+    for (int idx : indices) {
+      const cv::Mat &frame = decoded.at(idx);
+      if (!frame.empty()) {
+        clip.push_back(frame);
+      }
+    }
+    if (clip.empty()) {
+      throw std::runtime_error("No frames could be read from video: " +
+                               video_path);
+    }
+    clips.push_back(pad_video_frames(clip, clip_length));
+  }
+  return clips;
+}
+
+std::vector<cv::Mat> sample_frames(const std::vector<cv::Mat> &frames,
+                                   int count) {
+  if (frames.empty()) {
+    throw std::runtime_error("Cannot sample from empty frames");
+  }
+  if (count <= 0 || frames.size() == static_cast<size_t>(count)) {
+    return frames;
+  }
+  std::vector<cv::Mat> sampled;
+  sampled.reserve(static_cast<size_t>(count));
+  for (size_t i = 0; i < static_cast<size_t>(count); ++i) {
+    sampled.push_back(frames[i * frames.size() / static_cast<size_t>(count)]);
+  }
+  return sampled;
+}
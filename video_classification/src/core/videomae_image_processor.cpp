@@ -27,6 +27,28 @@ VideoMAEImageProcessor::VideoMAEImageProcessor(
   }
 }
 
+ImageProcessor::ResizePlan
+VideoMAEImageProcessor::resize_plan(const cv::Size &frame_size,
+                                    bool multi_crop) const {
+  // Single view squashes to image_size; multi-crop keeps the aspect ratio so
+  // the crops cover different parts of the frame
+  if (multi_crop) {
+    return {shortest_edge_size(frame_size, image_size), image_size,
+            cv::INTER_LINEAR};
+  }
+  return {cv::Size(image_size, image_size), image_size, cv::INTER_LINEAR};
+}
+
+void VideoMAEImageProcessor::channel_affine(std::vector<float> &scale,
+                                            std::vector<float> &bias) const {
+  scale.resize(mean.size());
+  bias.resize(mean.size());
+  for (size_t c = 0; c < mean.size(); ++c) {
+    scale[c] = 1.0f / (255.0f * std[c]);
+    bias[c] = -mean[c] / std[c];
+  }
+}
+
 std::vector<float>
 VideoMAEImageProcessor::process(const std::vector<cv::Mat> &frames,
                                 int channels, const std::string &format) {
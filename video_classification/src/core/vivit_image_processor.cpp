@@ -39,6 +39,24 @@ VivitImageProcessor::VivitImageProcessor(const rapidjson::Document &config) {
   }
 }
 
+ImageProcessor::ResizePlan
+VivitImageProcessor::resize_plan(const cv::Size &frame_size,
+                                 bool /*multi_crop*/) const {
+  return {shortest_edge_size(frame_size, shortest_edge), crop_size,
+          cv::INTER_CUBIC};
+}
+
+void VivitImageProcessor::channel_affine(std::vector<float> &scale,
+                                         std::vector<float> &bias) const {
+  const float shift = offset ? 1.0f : 0.0f;
+  scale.resize(mean.size());
+  bias.resize(mean.size());
+  for (size_t c = 0; c < mean.size(); ++c) {
+    scale[c] = rescale_factor / std[c];
+    bias[c] = (-shift - mean[c]) / std[c];
+  }
+}
+
 std::vector<float>
 VivitImageProcessor::process(const std::vector<cv::Mat> &frames, int channels,
                              const std::string &format) {
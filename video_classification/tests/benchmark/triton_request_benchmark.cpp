@@ -0,0 +1,183 @@
+/**
+ * Counts heap allocations per Triton request, measured two ways:
+ *   raw:    the Triton HTTP client used directly with objects created once
+ *   client: TritonClient::infer_logits_into() with reused buffers
+ * Both share the Triton library's own allocations, so the difference is what
+ * the TritonClient layer adds per request, which must be zero once warm.
+ * Only operator new is counted; libcurl's malloc calls are not visible here.
+ *
+ * Run against a server, e.g. python/mock_triton_server.py:
+ *   triton_request_benchmark [-u url] [-m model] [-n requests]
+ */
+#include "video_classification/triton_client.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+
+constexpr int WARMUP_REQUESTS = 20;
+constexpr size_t MAX_LOGITS = 4096;
+}
+
+void *operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+namespace tc = triton::client;
+
+namespace {
+struct Measurement {
+  double allocations_per_request;
+  double ms_per_request;
+};
+
+template <typename Request>
+Measurement measure(int requests, Request &&request) {
+  for (int i = 0; i < WARMUP_REQUESTS; ++i) {
+    request();
+  }
+  const uint64_t before = g_allocations.load();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < requests; ++i) {
+    request();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return {static_cast<double>(g_allocations.load() - before) / requests,
+          std::chrono::duration<double, std::milli>(elapsed).count() /
+              requests};
+}
+
+/**
+ * @brief Sends requests through the Triton client with everything pre-built
+ */
+class RawRequest {
+public:
+  RawRequest(const std::string &url, const std::string &model_name,
+             const ModelInfo &info, const std::vector<int64_t> &shape,
+             const std::vector<float> &input)
+      : options_(model_name) {
+    check(tc::InferenceServerHttpClient::Create(&client_, url, false));
+    tc::InferInput *input_ptr;
+    check(tc::InferInput::Create(&input_ptr, info.input_name_, shape,
+                                 info.input_datatype_));
+    input_.reset(input_ptr);
+    check(input_->AppendRaw(reinterpret_cast<const uint8_t *>(input.data()),
+                            input.size() * sizeof(float)));
+    tc::InferRequestedOutput *output_ptr;
+    check(tc::InferRequestedOutput::Create(&output_ptr, info.output_name_));
+    output_.reset(output_ptr);
+    inputs_ = {input_.get()};
+    outputs_ = {output_.get()};
+  }
+
+  void operator()() {
+    RawRequest *self = this;
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_ = false;
+    check(client_->AsyncInfer(
+        [self](tc::InferResult *result) {
+          delete result;
+          {
+            std::lock_guard<std::mutex> done_lock(self->mutex_);
+            self->done_ = true;
+          }
+          self->done_cv_.notify_all();
+        },
+        options_, inputs_, outputs_));
+    done_cv_.wait(lock, [this] { return done_; });
+  }
+
+private:
+  static void check(const tc::Error &err) {
+    if (!err.IsOk()) {
+      throw std::runtime_error(err.Message());
+    }
+  }
+
+  std::unique_ptr<tc::InferenceServerHttpClient> client_;
+  tc::InferOptions options_;
+  std::unique_ptr<tc::InferInput> input_;
+  std::unique_ptr<tc::InferRequestedOutput> output_;
+  std::vector<tc::InferInput *> inputs_;
+  std::vector<const tc::InferRequestedOutput *> outputs_;
+  std::mutex mutex_;
+  std::condition_variable done_cv_;
+  bool done_ = false;
+};
+}
+
+int main(int argc, char **argv) {
+  std::string url = "http://localhost:8000";
+  std::string model_name = "videomae_large";
+  int requests = 1000;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "u:m:n:")) != -1) {
+    switch (opt) {
+    case 'u':
+      url = optarg;
+      break;
+    case 'm':
+      model_name = optarg;
+      break;
+    case 'n':
+      requests = std::max(std::atoi(optarg), 1);
+      break;
+    default:
+      std::cerr << "Usage: " << argv[0]
+                << " [-u url] [-m model] [-n requests]\n";
+      return 1;
+    }
+  }
+
+  try {
+    TritonClient client(url);
+    ModelInfo info;
+    client.get_model_info(model_name, info);
+    const std::vector<int64_t> shape = {1, info.input_t_, info.input_c_,
+                                        info.input_h_, info.input_w_};
+    const std::vector<float> input(
+        static_cast<size_t>(info.input_t_ * info.input_c_ * info.input_h_ *
+                            info.input_w_),
+        0.5f);
+    std::vector<float> logits(MAX_LOGITS);
+
+    RawRequest raw_request(url, model_name, info, shape, input);
+    const auto raw = measure(requests, raw_request);
+    const auto wrapped = measure(requests, [&] {
+      client.infer_logits_into(input, model_name, info, shape, logits);
+    });
+
+    const double added =
+        wrapped.allocations_per_request - raw.allocations_per_request;
+    std::cout << "raw:    " << raw.allocations_per_request
+              << " allocations/request, " << raw.ms_per_request << " ms\n"
+              << "client: " << wrapped.allocations_per_request
+              << " allocations/request, " << wrapped.ms_per_request << " ms\n"
+              << "added by TritonClient: " << added << " allocations/request"
+              << std::endl;
+    // Allow for noise in the library's own allocations
+    return added < 0.5 ? 0 : 1;
+  } catch (const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
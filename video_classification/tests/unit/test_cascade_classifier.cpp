@@ -0,0 +1,151 @@
+#include "video_classification/cascade_classifier.hpp"
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+namespace {
+/**
+ * @brief Produces the single input value the one-pixel test models expect
+ */
+class ConstantProcessor : public ImageProcessor {
+public:
+  std::vector<float> process(const std::vector<cv::Mat> &frames, int,
+                             const std::string &) override {
+    return std::vector<float>(frames.size(), 0.0f);
+  }
+
+protected:
+  ResizePlan resize_plan(const cv::Size &frame_size, bool) const override {
+    return {frame_size, 1, cv::INTER_NEAREST};
+  }
+  void channel_affine(std::vector<float> &scale,
+                      std::vector<float> &bias) const override {
+    scale.assign(1, 1.0f);
+    bias.assign(1, 0.0f);
+  }
+};
+
+/**
+ * @brief Answers every window with fixed class probabilities
+ */
+class ScriptedBackend : public InferenceBackend {
+public:
+  ScriptedBackend(std::vector<float> probabilities, int &calls)
+      : calls_(calls) {
+    for (float probability : probabilities) {
+      logits_.push_back(std::log(probability));
+    }
+  }
+
+  void get_model_info(const std::string &, ModelInfo &) override {}
+
+  std::vector<float> infer_logits(const std::vector<float> &,
+                                  const std::string &, const ModelInfo &,
+                                  const std::vector<int64_t> &) override {
+    ++calls_;
+    return logits_;
+  }
+
+private:
+  std::vector<float> logits_;
+  int &calls_;
+};
+
+ModelInfo pixel_model() {
+  ModelInfo info{};
+  info.input_t_ = 1;
+  info.input_c_ = 1;
+  info.input_h_ = 1;
+  info.input_w_ = 1;
+  info.input_format_ = "FORMAT_NCHW";
+  info.max_batch_size_ = 1;
+  return info;
+}
+
+CascadeClassifier::Tier make_tier(const std::string &name,
+                                  std::vector<float> probabilities,
+                                  int &calls) {
+  CascadeClassifier::Tier tier;
+  tier.model_name = name;
+  tier.client =
+      std::make_unique<ScriptedBackend>(std::move(probabilities), calls);
+  tier.processor = std::make_unique<ConstantProcessor>();
+  tier.model_info = pixel_model();
+  return tier;
+}
+
+class CascadeClassifierTest : public ::testing::Test {
+protected:
+  /**
+   * @brief Two-tier cascade whose tiers answer with the given probabilities
+   */
+  CascadeClassifier make_cascade(std::vector<float> cheap,
+                                 std::vector<float> expensive) {
+    std::vector<CascadeClassifier::Tier> tiers;
+    tiers.push_back(make_tier("cheap", std::move(cheap), cheap_calls_));
+    tiers.push_back(
+        make_tier("expensive", std::move(expensive), expensive_calls_));
+    CascadeOptions options;
+    options.min_confidence = 0.5f;
+    options.min_margin = 0.2f;
+    return CascadeClassifier(std::move(tiers), options);
+  }
+
+  const std::vector<cv::Mat> frames_ = {cv::Mat(1, 1, CV_8UC3)};
+  int cheap_calls_ = 0;
+  int expensive_calls_ = 0;
+};
+}
+
+TEST_F(CascadeClassifierTest, ConfidentFirstTierAnswers) {
+  auto cascade = make_cascade({0.7f, 0.2f, 0.1f}, {0.1f, 0.8f, 0.1f});
+  const auto result = cascade.classify(frames_);
+  EXPECT_EQ(result.tier, 0u);
+  EXPECT_EQ(result.model_name, "cheap");
+  ASSERT_EQ(result.predictions.size(), 3u);
+  EXPECT_EQ(result.predictions[0].label, "unknown_0");
+  EXPECT_NEAR(result.predictions[0].probability, 0.7f, 1e-5f);
+  EXPECT_EQ(expensive_calls_, 0);
+  EXPECT_DOUBLE_EQ(cascade.escalation_rate(), 0.0);
+}
+
+TEST_F(CascadeClassifierTest, LowConfidenceEscalates) {
+  auto cascade = make_cascade({0.45f, 0.15f, 0.4f}, {0.1f, 0.8f, 0.1f});
+  const auto result = cascade.classify(frames_);
+  EXPECT_EQ(result.tier, 1u);
+  EXPECT_EQ(result.predictions[0].label, "unknown_1");
+  EXPECT_EQ(cheap_calls_, 1);
+  EXPECT_EQ(expensive_calls_, 1);
+}
+
+TEST_F(CascadeClassifierTest, NarrowMarginEscalates) {
+  // Confident enough, but only 0.15 ahead of the runner-up
+  auto cascade = make_cascade({0.55f, 0.4f, 0.05f}, {0.1f, 0.8f, 0.1f});
+  EXPECT_EQ(cascade.classify(frames_).tier, 1u);
+
+  // The margin is still checked when a single prediction is requested
+  const auto result = cascade.classify(frames_, 1);
+  EXPECT_EQ(result.tier, 1u);
+  EXPECT_EQ(result.predictions.size(), 1u);
+}
+
+TEST_F(CascadeClassifierTest, LastTierAlwaysAnswers) {
+  auto cascade = make_cascade({0.4f, 0.35f, 0.25f}, {0.4f, 0.35f, 0.25f});
+  cascade.classify(frames_);
+  const auto result = cascade.classify(frames_);
+  EXPECT_EQ(result.tier, 1u);
+  EXPECT_NEAR(result.predictions[0].probability, 0.4f, 1e-5f);
+
+  const auto stats = cascade.stats();
+  ASSERT_EQ(stats.size(), 2u);
+  EXPECT_EQ(stats[0].calls, 2u);
+  EXPECT_EQ(stats[0].escalations, 2u);
+  EXPECT_EQ(stats[1].calls, 2u);
+  EXPECT_EQ(stats[1].escalations, 0u);
+  EXPECT_DOUBLE_EQ(cascade.escalation_rate(), 1.0);
+}
+
+TEST_F(CascadeClassifierTest, RejectsAnEmptyCascade) {
+  EXPECT_THROW(CascadeClassifier(std::vector<CascadeClassifier::Tier>{}),
+               std::runtime_error);
+}
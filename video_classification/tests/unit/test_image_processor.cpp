@@ -0,0 +1,156 @@
+#include "video_classification/processor_factory.hpp"
+
+#include <functional>
+#include <gtest/gtest.h>
+
+namespace {
+constexpr int EDGE = 8; ///< Short side of the test frames and crop size
+
+/**
+ * @brief Processor configuration and the normalization it should apply
+ */
+struct ProcessorCase {
+  std::string model_type;
+  std::string config;
+  std::function<float(int channel, float pixel)> expected;
+};
+
+const float MEAN[] = {0.5f, 0.25f, 0.125f};
+const float STD[] = {0.5f, 0.25f, 0.2f};
+
+std::vector<ProcessorCase> processor_cases() {
+  // Rescale factors are powers of two so the JSON values are exact floats
+  return {
+      {"videomae",
+       R"({"image_size": 8, "mean": [0.5, 0.25, 0.125],
+           "std": [0.5, 0.25, 0.2]})",
+       [](int c, float pixel) { return (pixel / 255.0f - MEAN[c]) / STD[c]; }},
+      {"vivit",
+       R"({"shortest_edge": 8, "crop_size": 8, "rescale_factor": 0.0078125,
+           "offset": true, "mean": [0.5, 0.25, 0.125],
+           "std": [0.5, 0.25, 0.2]})",
+       [](int c, float pixel) {
+         return (pixel * 0.0078125f - 1.0f - MEAN[c]) / STD[c];
+       }},
+      {"timesformer",
+       R"({"shortest_edge": 8, "crop_size": 8, "rescale_factor": 0.00390625,
+           "mean": [0.5, 0.25, 0.125], "std": [0.5, 0.25, 0.2]})",
+       [](int c, float pixel) {
+         return (pixel * 0.00390625f - MEAN[c]) / STD[c];
+       }},
+  };
+}
+
+std::unique_ptr<ImageProcessor> make_processor(const ProcessorCase &test) {
+  rapidjson::Document config;
+  config.Parse(test.config.c_str());
+  EXPECT_FALSE(config.HasParseError());
+  return create_processor(test.model_type, config);
+}
+
+/**
+ * @brief Frame already at the crop size along its short side
+ *
+ * Pixels encode their position along the long side, the channel and the
+ * frame, so the processors resize it unchanged and every output value
+ * identifies where it was cropped from.
+ */
+cv::Mat positional_frame(cv::Size size, int frame) {
+  cv::Mat mat(size, CV_8UC3);
+  const bool landscape = size.width >= size.height;
+  for (int y = 0; y < size.height; ++y) {
+    for (int x = 0; x < size.width; ++x) {
+      const int along = landscape ? x : y;
+      mat.at<cv::Vec3b>(y, x) = cv::Vec3b(
+          static_cast<uchar>(10 * along), static_cast<uchar>(200 - 10 * along),
+          static_cast<uchar>(40 * frame + 3));
+    }
+  }
+  return mat;
+}
+
+float positional_pixel(int channel, int along, int frame) {
+  const int values[] = {10 * along, 200 - 10 * along, 40 * frame + 3};
+  return static_cast<float>(values[channel]);
+}
+}
+
+TEST(ImageProcessorTest, MultiCropNormalizesEvenlySpacedCrops) {
+  const std::vector<cv::Mat> frames = {positional_frame({16, EDGE}, 0),
+                                       positional_frame({16, EDGE}, 1)};
+  const size_t frame_elements = 3 * EDGE * EDGE;
+  const int offsets[] = {0, 4, 8}; // Left, center and right of 16 columns
+
+  for (const auto &test : processor_cases()) {
+    SCOPED_TRACE(test.model_type);
+    const auto processor = make_processor(test);
+    const auto values =
+        processor->process_multi_crop(frames, 3, "FORMAT_NCHW", 3);
+    ASSERT_EQ(values.size(), 3 * frames.size() * frame_elements);
+
+    for (int v = 0; v < 3; ++v) {
+      for (int f = 0; f < 2; ++f) {
+        for (int c = 0; c < 3; ++c) {
+          for (int y = 0; y < EDGE; ++y) {
+            for (int x = 0; x < EDGE; ++x) {
+              const size_t at = static_cast<size_t>(v * 2 + f) *
+                                    frame_elements +
+                                static_cast<size_t>(c * EDGE * EDGE +
+                                                    y * EDGE + x);
+              ASSERT_NEAR(values[at],
+                          test.expected(
+                              c, positional_pixel(c, offsets[v] + x, f)),
+                          1e-5f)
+                  << "view " << v << " frame " << f << " channel " << c
+                  << " at " << x << "," << y;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(ImageProcessorTest, MultiCropFollowsTheLongSideOfPortraitFrames) {
+  const std::vector<cv::Mat> frames = {positional_frame({EDGE, 12}, 0)};
+  const int offsets[] = {0, 2, 4};
+
+  for (const auto &test : processor_cases()) {
+    SCOPED_TRACE(test.model_type);
+    const auto processor = make_processor(test);
+    const auto values =
+        processor->process_multi_crop(frames, 3, "FORMAT_NHWC", 3);
+    ASSERT_EQ(values.size(), 3u * 3 * EDGE * EDGE);
+
+    for (int v = 0; v < 3; ++v) {
+      for (int y = 0; y < EDGE; ++y) {
+        for (int x = 0; x < EDGE; ++x) {
+          for (int c = 0; c < 3; ++c) {
+            const size_t at = static_cast<size_t>(v) * 3 * EDGE * EDGE +
+                              static_cast<size_t>((y * EDGE + x) * 3 + c);
+            ASSERT_NEAR(values[at],
+                        test.expected(c,
+                                      positional_pixel(c, offsets[v] + y, 0)),
+                        1e-5f)
+                << "view " << v << " channel " << c << " at " << x << ","
+                << y;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(ImageProcessorTest, SingleCropIsCentered) {
+  const std::vector<cv::Mat> frames = {positional_frame({16, EDGE}, 0)};
+  for (const auto &test : processor_cases()) {
+    SCOPED_TRACE(test.model_type);
+    const auto values =
+        make_processor(test)->process_multi_crop(frames, 3, "FORMAT_NCHW", 1);
+    ASSERT_EQ(values.size(), 3u * EDGE * EDGE);
+    EXPECT_NEAR(values[0], test.expected(0, positional_pixel(0, 4, 0)), 1e-5f);
+    EXPECT_NEAR(values[EDGE - 1],
+                test.expected(0, positional_pixel(0, 4 + EDGE - 1, 0)),
+                1e-5f);
+  }
+}
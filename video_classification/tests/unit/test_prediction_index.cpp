@@ -0,0 +1,140 @@
+#include "video_classification/prediction_index.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+class PredictionIndexTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    path_ = (std::filesystem::temp_directory_path() /
+             ("prediction_index_" + std::to_string(::getpid()) + ".idx"))
+                .string();
+
+    PredictionIndexWriter writer;
+    writer.add_window("a.mp4", 0.0, 15.0,
+                      {{"dancing", 0.9f}, {"singing", 0.05f}});
+    writer.add_window("a.mp4", 16.0, 31.0,
+                      {{"singing", 0.7f}, {"dancing", 0.2f}});
+    writer.add_window("b.mp4", 0.0, 15.0,
+                      {{"dancing", 0.6f}, {"running", 0.3f}});
+    writer.write(path_);
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  std::string path_;
+};
+}
+
+TEST_F(PredictionIndexTest, ReturnsHitsAboveThresholdByProbability) {
+  PredictionIndex index(path_);
+  EXPECT_EQ(index.num_windows(), 3u);
+  EXPECT_EQ(index.num_videos(), 2u);
+
+  PredictionQuery query;
+  query.label = "dancing";
+  query.min_probability = 0.5f;
+  auto hits = index.query(query);
+  ASSERT_EQ(hits.size(), 2u);
+  EXPECT_EQ(hits[0].video, "a.mp4");
+  EXPECT_FLOAT_EQ(hits[0].probability, 0.9f);
+  EXPECT_EQ(hits[1].video, "b.mp4");
+  EXPECT_FLOAT_EQ(hits[1].probability, 0.6f);
+}
+
+TEST_F(PredictionIndexTest, FiltersByVideoTimeRangeAndLimit) {
+  PredictionIndex index(path_);
+
+  PredictionQuery query;
+  query.label = "dancing";
+  query.video = "a.mp4";
+  query.start_time = 20.0;
+  auto hits = index.query(query);
+  ASSERT_EQ(hits.size(), 1u);
+  EXPECT_FLOAT_EQ(hits[0].start_time, 16.0f);
+  EXPECT_FLOAT_EQ(hits[0].probability, 0.2f);
+
+  query = PredictionQuery{};
+  query.label = "dancing";
+  query.limit = 1;
+  EXPECT_EQ(index.query(query).size(), 1u);
+
+  query.label = "swimming";
+  EXPECT_TRUE(index.query(query).empty());
+  query.label = "dancing";
+  query.video = "missing.mp4";
+  EXPECT_TRUE(index.query(query).empty());
+}
+
+TEST_F(PredictionIndexTest, AppendsToExistingIndex) {
+  PredictionIndexWriter writer;
+  {
+    PredictionIndex index(path_);
+    index.append_to(writer);
+  }
+  writer.add_window("c.mp4", 0.0, 15.0, {{"running", 0.8f}});
+  writer.write(path_);
+
+  PredictionIndex index(path_);
+  EXPECT_EQ(index.num_windows(), 4u);
+  PredictionQuery query;
+  query.label = "running";
+  auto hits = index.query(query);
+  ASSERT_EQ(hits.size(), 2u);
+  EXPECT_EQ(hits[0].video, "c.mp4");
+  EXPECT_EQ(hits[1].video, "b.mp4");
+}
+
+TEST(PredictionIndex, RejectsInvalidFile) {
+  const auto path = std::filesystem::temp_directory_path() / "not_an_index";
+  {
+    std::ofstream out(path);
+    out << "not an index, just some text that is long enough for a header";
+  }
+  EXPECT_THROW(PredictionIndex index(path.string()), std::runtime_error);
+  std::filesystem::remove(path);
+}
+
+TEST_F(PredictionIndexTest, ReplacesExcludedVideoWhenAppending) {
+  PredictionIndexWriter writer;
+  {
+    PredictionIndex index(path_);
+    index.append_to(writer, "a.mp4");
+  }
+  writer.add_window("a.mp4", 0.0, 15.0, {{"running", 0.4f}});
+  writer.write(path_);
+
+  PredictionIndex index(path_);
+  EXPECT_EQ(index.num_windows(), 2u);
+  PredictionQuery query;
+  query.label = "dancing";
+  auto hits = index.query(query);
+  ASSERT_EQ(hits.size(), 1u);
+  EXPECT_EQ(hits[0].video, "b.mp4");
+}
+
+TEST_F(PredictionIndexTest, ConcurrentMergesKeepEveryWindow) {
+  std::vector<std::thread> writers;
+  for (int i = 0; i < 8; ++i) {
+    writers.emplace_back([this, i] {
+      PredictionIndexWriter writer;
+      writer.add_window("c" + std::to_string(i) + ".mp4", 0.0, 15.0,
+                        {{"running", 0.5f}});
+      writer.merge_into(path_, "a.mp4");
+    });
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+
+  PredictionIndex index(path_);
+  EXPECT_EQ(index.num_windows(), 9u); // b.mp4 and one per writer
+  PredictionQuery query;
+  query.label = "running";
+  EXPECT_EQ(index.query(query).size(), 9u);
+  std::filesystem::remove(path_ + ".lock");
+}
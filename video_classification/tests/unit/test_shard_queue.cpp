@@ -0,0 +1,140 @@
+#include "video_classification/shard_queue.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+using namespace std::chrono_literals;
+
+class ShardQueueTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir_ = (std::filesystem::temp_directory_path() /
+            ("shard_queue_" + std::to_string(::getpid())))
+               .string();
+    std::filesystem::remove_all(dir_);
+    ShardQueue::create(dir_, {"a.mp4", "b.mp4", "c.mp4", "d.mp4", "e.mp4"}, 2);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  static std::string result(const std::string &video) {
+    return "{\"video\":\"" + video + "\",\"predictions\":[]}";
+  }
+
+  std::string dir_;
+};
+}
+
+TEST_F(ShardQueueTest, EachShardIsClaimedOnce) {
+  ShardQueue first(dir_, "first", 60s);
+  ShardQueue second(dir_, "second", 60s);
+
+  auto a = first.claim();
+  auto b = second.claim();
+  auto c = first.claim();
+  ASSERT_TRUE(a && b && c);
+  EXPECT_EQ(a->shard, "shard-00000");
+  EXPECT_EQ(b->shard, "shard-00001");
+  EXPECT_EQ(c->shard, "shard-00002");
+  EXPECT_FALSE(second.claim()); // All leases are fresh
+
+  EXPECT_EQ(first.shard_videos(*a),
+            (std::vector<std::string>{"a.mp4", "b.mp4"}));
+  EXPECT_EQ(first.shard_videos(*c), (std::vector<std::string>{"e.mp4"}));
+
+  EXPECT_TRUE(first.complete(*a));
+  auto status = first.status();
+  EXPECT_EQ(status.pending, 0u);
+  EXPECT_EQ(status.leased, 2u);
+  EXPECT_EQ(status.done, 1u);
+}
+
+TEST_F(ShardQueueTest, ExpiredLeaseIsTakenOverAndResumed) {
+  ShardQueue crashed(dir_, "crashed", 0ms);
+  auto lease = crashed.claim();
+  ASSERT_TRUE(lease);
+  crashed.record_result(*lease, result("a.mp4"));
+  std::this_thread::sleep_for(5ms);
+
+  ShardQueue rescuer(dir_, "rescuer", 1ms);
+  // Pending shards are preferred over expired leases
+  auto pending = rescuer.claim();
+  ASSERT_TRUE(pending);
+  EXPECT_EQ(pending->shard, "shard-00001");
+  rescuer.claim(); // shard-00002
+
+  auto taken = rescuer.claim();
+  ASSERT_TRUE(taken);
+  EXPECT_EQ(taken->shard, "shard-00000");
+  EXPECT_FALSE(crashed.renew(*lease));
+  EXPECT_FALSE(crashed.complete(*lease));
+
+  auto completed = rescuer.completed_videos(taken->shard);
+  EXPECT_EQ(completed, (std::set<std::string>{"a.mp4"}));
+  EXPECT_TRUE(rescuer.renew(*taken));
+  EXPECT_TRUE(rescuer.complete(*taken));
+}
+
+TEST_F(ShardQueueTest, MergeWritesManifestOrderOnce) {
+  ShardQueue first(dir_, "first", 0ms);
+  ShardQueue second(dir_, "second", 0ms);
+  auto a = first.claim();
+  auto b = second.claim();
+  ASSERT_TRUE(a && b);
+
+  second.record_result(*b, result("d.mp4"));
+  second.record_result(*b, result("c.mp4"));
+  first.record_result(*a, "{\"video\":\"b.mp4\",\"error\":\"timeout\"}");
+  first.record_result(*a, result("a.mp4"));
+  // A second worker finished b.mp4 after a takeover, and a torn line
+  second.record_result(*a, result("b.mp4"));
+  second.record_result(*a, "{\"video\":\"a.m");
+
+  const std::string output = dir_ + "/merged.jsonl";
+  EXPECT_EQ(first.merge(output), 1u); // e.mp4 never ran
+
+  std::ifstream in(output);
+  std::vector<std::string> lines;
+  for (std::string line; std::getline(in, line);) {
+    lines.push_back(line);
+  }
+  EXPECT_EQ(lines, (std::vector<std::string>{result("a.mp4"), result("b.mp4"),
+                                             result("c.mp4"),
+                                             result("d.mp4")}));
+}
+
+TEST_F(ShardQueueTest, RejectsInvalidQueueAndWorker) {
+  EXPECT_THROW(ShardQueue(dir_ + "/missing", "worker", 1s), std::runtime_error);
+  EXPECT_THROW(ShardQueue(dir_, "bad@id", 1s), std::runtime_error);
+  EXPECT_THROW(ShardQueue::create(dir_, {"x.mp4"}, 1), std::runtime_error);
+}
+
+TEST_F(ShardQueueTest, RestartedWorkerResumesItsOwnExpiredLease) {
+  std::optional<ShardLease> lease;
+  {
+    ShardQueue crashed(dir_, "worker", 60s);
+    crashed.claim();
+    crashed.claim();
+    lease = crashed.claim();
+    ASSERT_TRUE(lease);
+    crashed.record_result(*lease, result("e.mp4"));
+  }
+  std::this_thread::sleep_for(5ms);
+
+  // Same id after a restart; every shard is leased to the dead run
+  ShardQueue restarted(dir_, "worker", 1ms);
+  std::set<std::string> shards;
+  while (auto taken = restarted.claim()) {
+    EXPECT_TRUE(restarted.complete(*taken));
+    shards.insert(taken->shard);
+  }
+  EXPECT_EQ(shards, (std::set<std::string>{"shard-00000", "shard-00001",
+                                           "shard-00002"}));
+  EXPECT_EQ(restarted.completed_videos("shard-00002"),
+            (std::set<std::string>{"e.mp4"}));
+  EXPECT_EQ(restarted.status().done, 3u);
+}
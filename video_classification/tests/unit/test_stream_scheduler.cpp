@@ -0,0 +1,121 @@
+#include "video_classification/stream_scheduler.hpp"
+
+#include <atomic>
+#include <future>
+#include <gtest/gtest.h>
+
+namespace {
+using namespace std::chrono_literals;
+
+/**
+ * @brief Returns three logits per window and records which streams each
+ *        batch held; the first float of a window is its stream id. The
+ *        first call blocks until gate_ is set.
+ */
+class FakeBackend : public InferenceBackend {
+public:
+  void get_model_info(const std::string &, ModelInfo &) override {}
+
+  std::vector<float> infer_logits(const std::vector<float> &input_data,
+                                  const std::string &, const ModelInfo &,
+                                  const std::vector<int64_t> &shape) override {
+    if (calls_++ == 0) {
+      entered_.set_value();
+      gate_.get_future().wait();
+    }
+    std::this_thread::sleep_for(delay_);
+    std::vector<int> streams;
+    for (int64_t i = 0; i < shape[0]; ++i) {
+      streams.push_back(static_cast<int>(input_data[static_cast<size_t>(i) * 2]));
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      batches_.push_back(streams);
+    }
+    return std::vector<float>(static_cast<size_t>(shape[0]) * 3, 0.0f);
+  }
+
+  std::vector<std::vector<int>> batches() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batches_;
+  }
+
+  std::promise<void> entered_; ///< Set when the first call starts
+  std::promise<void> gate_;    ///< Holds the first call until set
+  std::chrono::milliseconds delay_{0};
+
+private:
+  std::atomic<int> calls_{0};
+  std::mutex mutex_;
+  std::vector<std::vector<int>> batches_;
+};
+
+ModelInfo tiny_model(int max_batch_size) {
+  ModelInfo info{};
+  info.input_t_ = 1;
+  info.input_c_ = 1;
+  info.input_h_ = 1;
+  info.input_w_ = 2;
+  info.max_batch_size_ = max_batch_size;
+  return info;
+}
+}
+
+TEST(StreamSchedulerTest, HeavyStreamDoesNotStarveOthers) {
+  FakeBackend backend;
+  StreamScheduler scheduler({&backend}, "fake", tiny_model(4));
+  const size_t heavy = scheduler.add_stream({"heavy", 0, 10s, 32});
+  const size_t light = scheduler.add_stream({"light", 0, 10s, 32});
+
+  std::atomic<int> done{0};
+  auto count = [&done](const StreamScheduler::WindowResult &result) {
+    EXPECT_EQ(result.outcome, StreamScheduler::Outcome::OnTime);
+    ++done;
+  };
+  // Occupies the worker while the queue fills up
+  scheduler.submit(heavy, {0.0f, 0.0f}, count);
+  backend.entered_.get_future().wait();
+  for (int i = 0; i < 12; ++i) {
+    scheduler.submit(heavy, {0.0f, 0.0f}, count);
+  }
+  scheduler.submit(light, {1.0f, 0.0f}, count);
+  scheduler.submit(light, {1.0f, 0.0f}, count);
+  backend.gate_.set_value();
+  scheduler.wait_idle();
+
+  EXPECT_EQ(done.load(), 15);
+  const auto batches = backend.batches();
+  ASSERT_GE(batches.size(), 2u);
+  // Earliest-deadline-first alone would send four heavy windows first
+  EXPECT_EQ(std::count(batches[1].begin(), batches[1].end(), 1), 2);
+  EXPECT_EQ(batches[1].size(), 4u);
+  const auto stats = scheduler.stats();
+  EXPECT_EQ(stats[heavy].on_time, 13u);
+  EXPECT_EQ(stats[light].on_time, 2u);
+}
+
+TEST(StreamSchedulerTest, ShedsAndDegradesStreamsMissingTheirSlo) {
+  FakeBackend backend;
+  backend.gate_.set_value();
+  backend.delay_ = 5ms;
+  StreamScheduler scheduler({&backend}, "fake", tiny_model(1));
+  const size_t stream = scheduler.add_stream({"camera", 0, 1ms, 64});
+
+  std::atomic<int> classified{0};
+  for (int i = 0; i < 25; ++i) {
+    scheduler.submit(stream, {0.0f, 0.0f},
+                     [&classified](const StreamScheduler::WindowResult &result) {
+                       classified += result.predictions.empty() ? 0 : 1;
+                     });
+  }
+  scheduler.wait_idle();
+
+  const auto stats = scheduler.stats()[stream];
+  EXPECT_EQ(stats.submitted, 25u);
+  EXPECT_EQ(stats.on_time, 0u);
+  EXPECT_EQ(stats.deadline_misses(), 25u);
+  EXPECT_GT(stats.shed, 0u); // Not even sent once the batch latency is known
+  EXPECT_EQ(static_cast<uint64_t>(classified.load()), stats.late);
+  EXPECT_EQ(stats.degradation, 1);
+  EXPECT_EQ(scheduler.degradation(stream), 1);
+}
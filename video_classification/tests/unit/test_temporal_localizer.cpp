@@ -0,0 +1,159 @@
+#include "video_classification/temporal_localizer.hpp"
+
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace {
+constexpr double VIDEO_FPS = 2.0;
+constexpr int VIDEO_SECONDS = 60;
+constexpr int ACTION_START = 50; ///< The action runs to the end of the video
+
+/**
+ * @brief Reduces each frame to its mean brightness in [0, 1]
+ */
+class BrightnessProcessor : public ImageProcessor {
+public:
+  std::vector<float> process(const std::vector<cv::Mat> &frames, int,
+                             const std::string &) override {
+    std::vector<float> values;
+    for (const auto &frame : frames) {
+      values.push_back(static_cast<float>(cv::mean(frame)[0] / 255.0));
+    }
+    return values;
+  }
+
+protected:
+  ResizePlan resize_plan(const cv::Size &frame_size, bool) const override {
+    return {frame_size, std::min(frame_size.width, frame_size.height),
+            cv::INTER_AREA};
+  }
+  void channel_affine(std::vector<float> &scale,
+                      std::vector<float> &bias) const override {
+    scale.assign(3, 1.0f / 255.0f);
+    bias.assign(3, 0.0f);
+  }
+};
+
+/**
+ * @brief Scores output 1 by the share of bright frames in the window
+ */
+class FakeBackend : public InferenceBackend {
+public:
+  void get_model_info(const std::string &, ModelInfo &) override {}
+
+  std::vector<float> infer_logits(const std::vector<float> &input_data,
+                                  const std::string &, const ModelInfo &,
+                                  const std::vector<int64_t> &) override {
+    ++calls_;
+    const auto bright = std::count_if(input_data.begin(), input_data.end(),
+                                      [](float value) { return value > 0.5f; });
+    const float share =
+        static_cast<float>(bright) / static_cast<float>(input_data.size());
+    return {0.0f, 10.0f * (share - 0.5f)};
+  }
+
+  int calls_ = 0;
+};
+
+ModelInfo window_model() {
+  ModelInfo info{};
+  info.input_t_ = 4;
+  info.input_c_ = 1;
+  info.input_h_ = 1;
+  info.input_w_ = 1;
+  info.max_batch_size_ = 1;
+  return info;
+}
+
+/**
+ * @brief Dark video that turns bright at ACTION_START seconds
+ */
+class LocalizerVideoTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    path_ = (std::filesystem::temp_directory_path() /
+             ("localizer_" + std::to_string(::getpid()) + ".avi"))
+                .string();
+    cv::VideoWriter writer(path_, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                           VIDEO_FPS, cv::Size(32, 32));
+    ASSERT_TRUE(writer.isOpened());
+    for (int frame = 0; frame < VIDEO_SECONDS * VIDEO_FPS; ++frame) {
+      const bool action = frame >= ACTION_START * VIDEO_FPS;
+      writer.write(cv::Mat(32, 32, CV_8UC3, cv::Scalar::all(action ? 255 : 0)));
+    }
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  std::string path_;
+};
+}
+
+TEST(TemporalLocalizerTest, MergesOverlappingSpansInTimeOrder) {
+  const auto merged = TemporalLocalizer::merge_spans(
+      {{40.0, 48.0, 0.6f}, {10.0, 20.0, 0.7f}, {16.0, 24.0, 0.9f},
+       {24.0, 30.0, 0.5f}});
+  ASSERT_EQ(merged.size(), 2u);
+  EXPECT_DOUBLE_EQ(merged[0].start, 10.0);
+  EXPECT_DOUBLE_EQ(merged[0].end, 30.0); // Touching spans join
+  EXPECT_FLOAT_EQ(merged[0].probability, 0.9f);
+  EXPECT_DOUBLE_EQ(merged[1].start, 40.0);
+  EXPECT_FLOAT_EQ(merged[1].probability, 0.6f);
+}
+
+TEST(TemporalLocalizerTest, BridgesGapsUpToMaxGap) {
+  const std::vector<TimeSpan> spans = {{0.0, 5.0, 0.5f}, {7.0, 9.0, 0.8f}};
+  EXPECT_EQ(TemporalLocalizer::merge_spans(spans).size(), 2u);
+  const auto merged = TemporalLocalizer::merge_spans(spans, 2.0);
+  ASSERT_EQ(merged.size(), 1u);
+  EXPECT_DOUBLE_EQ(merged[0].end, 9.0);
+  EXPECT_TRUE(TemporalLocalizer::merge_spans({}).empty());
+}
+
+TEST_F(LocalizerVideoTest, StridedWindowsCoverTheEndOfTheRange) {
+  VideoProcessor video;
+  ASSERT_TRUE(video.openVideo(path_));
+
+  // 11 samples from 10 s to 20 s: strides end at sample 9, so a last window
+  // is aligned to the end
+  const auto windows = video.splitVideoIntoWindows(4, 1.0f, 3, 10.0, 20.0);
+  ASSERT_EQ(windows.size(), 4u);
+  EXPECT_DOUBLE_EQ(windows.front().startTime, 10.0);
+  EXPECT_DOUBLE_EQ(windows[2].endTime, 19.0);
+  EXPECT_DOUBLE_EQ(windows.back().startTime, 17.0);
+  EXPECT_DOUBLE_EQ(windows.back().endTime, 20.0);
+
+  // Back-to-back windows of the whole video keep skipping the remainder
+  const auto back_to_back = video.splitVideoIntoWindows(4, 0.5f);
+  ASSERT_EQ(back_to_back.size(), 7u); // 30 samples
+  EXPECT_DOUBLE_EQ(back_to_back.back().endTime, 54.0);
+}
+
+TEST_F(LocalizerVideoTest, LocalizesAnActionAtTheEndOfTheVideo) {
+  FakeBackend backend;
+  BrightnessProcessor processor;
+  LocalizationOptions options;
+  options.target_label = "unknown_1";
+  options.fine_threshold = 0.6f;
+  options.decode_threads = 2;
+  TemporalLocalizer localizer(backend, processor, "fake", window_model(),
+                              options);
+
+  const auto result = localizer.localize(path_);
+  // Samples every 4 s; the last window holds the samples at 48 s to 56 s
+  EXPECT_EQ(result.coarse_windows, 4u);
+  ASSERT_EQ(result.intervals.size(), 1u);
+  EXPECT_DOUBLE_EQ(result.intervals[0].start, ACTION_START);
+  EXPECT_DOUBLE_EQ(result.intervals[0].end, VIDEO_SECONDS);
+  EXPECT_GT(result.intervals[0].probability, 0.9f);
+  // Only the 20 s around the action get a fine pass
+  EXPECT_NEAR(result.fine_fraction, 1.0 / 3.0, 1e-9);
+  EXPECT_EQ(static_cast<size_t>(backend.calls_),
+            result.coarse_windows + result.fine_windows);
+
+  options.target_label = "missing";
+  EXPECT_THROW(TemporalLocalizer(backend, processor, "fake", window_model(),
+                                 options),
+               std::runtime_error);
+}
@@ -0,0 +1,122 @@
+#include "video_classification/test_time_augmentation.hpp"
+
+#include <gtest/gtest.h>
+
+namespace {
+/**
+ * @brief Single-channel processor that keeps pixel values as they are
+ *
+ * On 1 x 3 frames the three crops are the three pixels, so each view holds
+ * one known value per frame.
+ */
+class IdentityProcessor : public ImageProcessor {
+public:
+  std::vector<float> process(const std::vector<cv::Mat> &, int,
+                             const std::string &) override {
+    return {};
+  }
+
+protected:
+  ResizePlan resize_plan(const cv::Size &frame_size, bool) const override {
+    return {frame_size, 1, cv::INTER_NEAREST};
+  }
+  void channel_affine(std::vector<float> &scale,
+                      std::vector<float> &bias) const override {
+    scale.assign(1, 1.0f);
+    bias.assign(1, 0.0f);
+  }
+};
+
+/**
+ * @brief Returns {first frame, last frame} of each view and records shapes
+ */
+class FakeBackend : public InferenceBackend {
+public:
+  void get_model_info(const std::string &, ModelInfo &) override {}
+
+  std::vector<float> infer_logits(const std::vector<float> &input_data,
+                                  const std::string &, const ModelInfo &,
+                                  const std::vector<int64_t> &shape) override {
+    shapes_.push_back(shape);
+    const size_t batch = static_cast<size_t>(shape[0]);
+    const size_t view = input_data.size() / batch;
+    std::vector<float> logits;
+    for (size_t b = 0; b < batch; ++b) {
+      logits.push_back(input_data[b * view]);
+      logits.push_back(input_data[b * view + view - 1]);
+    }
+    return logits;
+  }
+
+  std::vector<std::vector<int64_t>> shapes_;
+};
+
+ModelInfo view_model(int max_batch_size) {
+  ModelInfo info{};
+  info.input_t_ = 2;
+  info.input_c_ = 1;
+  info.input_h_ = 1;
+  info.input_w_ = 1;
+  info.input_format_ = "FORMAT_NCHW";
+  info.max_batch_size_ = max_batch_size;
+  return info;
+}
+
+cv::Mat row_frame(uchar left, uchar center, uchar right) {
+  cv::Mat frame(1, 3, CV_8UC1);
+  frame.at<uchar>(0, 0) = left;
+  frame.at<uchar>(0, 1) = center;
+  frame.at<uchar>(0, 2) = right;
+  return frame;
+}
+
+// Two clips of two frames; the views of clip c are its left, center and right
+// pixels over both frames
+const std::vector<std::vector<cv::Mat>> CLIPS = {
+    {row_frame(1, 2, 3), row_frame(4, 5, 6)},
+    {row_frame(7, 8, 9), row_frame(10, 11, 12)},
+};
+}
+
+TEST(TestTimeAugmentationTest, BatchesViewsUpToMaxBatchSize) {
+  FakeBackend backend;
+  IdentityProcessor processor;
+  const auto logits = classify_multi_view(backend, processor, "fake",
+                                          view_model(4), CLIPS, 3);
+
+  ASSERT_EQ(backend.shapes_.size(), 2u);
+  EXPECT_EQ(backend.shapes_[0], (std::vector<int64_t>{4, 2, 1, 1, 1}));
+  EXPECT_EQ(backend.shapes_[1], (std::vector<int64_t>{2, 2, 1, 1, 1}));
+  // First frames 1, 2, 3, 7, 8, 9 and last frames 4, 5, 6, 10, 11, 12
+  ASSERT_EQ(logits.size(), 2u);
+  EXPECT_FLOAT_EQ(logits[0], 5.0f);
+  EXPECT_FLOAT_EQ(logits[1], 8.0f);
+}
+
+TEST(TestTimeAugmentationTest, SendsOneViewPerRequestWithoutBatching) {
+  FakeBackend backend;
+  IdentityProcessor processor;
+  const auto logits = classify_multi_view(backend, processor, "fake",
+                                          view_model(0), CLIPS, 3);
+
+  ASSERT_EQ(backend.shapes_.size(), 6u);
+  for (const auto &shape : backend.shapes_) {
+    EXPECT_EQ(shape[0], 1);
+  }
+  ASSERT_EQ(logits.size(), 2u);
+  EXPECT_FLOAT_EQ(logits[0], 5.0f);
+  EXPECT_FLOAT_EQ(logits[1], 8.0f);
+}
+
+TEST(TestTimeAugmentationTest, RejectsClipsOfDifferentLengths) {
+  FakeBackend backend;
+  IdentityProcessor processor;
+  auto clips = CLIPS;
+  clips[1].pop_back();
+  EXPECT_THROW(classify_multi_view(backend, processor, "fake", view_model(4),
+                                   clips, 3),
+               std::runtime_error);
+  EXPECT_THROW(classify_multi_view(backend, processor, "fake", view_model(4),
+                                   {}, 3),
+               std::runtime_error);
+}
@@ -0,0 +1,70 @@
+#include "video_classification/tracer.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <map>
+#include <rapidjson/document.h>
+#include <rapidjson/istreamwrapper.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+TEST(TracerTest, WritesEventsOfAllThreadsAsTraceJson) {
+  const std::string path =
+      (std::filesystem::temp_directory_path() /
+       ("trace_" + std::to_string(::getpid()) + ".json"))
+          .string();
+
+  Tracer::start();
+  ASSERT_TRUE(Tracer::enabled());
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; ++t) {
+    threads.emplace_back([t] {
+      // Enough events to span several buffer chunks
+      for (int frame = 0; frame < 5000; ++frame) {
+        const uint64_t start = Tracer::now_ns();
+        Tracer::record("decode_frame", start, start + 1000,
+                       {.video = "a.mp4", .window = t, .frame = frame});
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  const uint64_t start = Tracer::now_ns();
+  Tracer::record("request", start, start + 2000,
+                 {.video = "b.mp4", .request = "r1"});
+  Tracer::record_async("triton_request", 7, start, start + 5000, {});
+  Tracer::write(path);
+  EXPECT_FALSE(Tracer::enabled());
+
+  std::ifstream in(path);
+  rapidjson::IStreamWrapper stream(in);
+  rapidjson::Document trace;
+  trace.ParseStream(stream);
+  ASSERT_FALSE(trace.HasParseError());
+  ASSERT_TRUE(trace["traceEvents"].IsArray());
+
+  std::map<std::string, int> phases;
+  int frames = 0;
+  for (const auto &event : trace["traceEvents"].GetArray()) {
+    const std::string name = event["name"].GetString();
+    ++phases[event["ph"].GetString()];
+    if (name == "decode_frame") {
+      EXPECT_STREQ(event["args"]["video"].GetString(), "a.mp4");
+      EXPECT_NEAR(event["dur"].GetDouble(), 1.0, 1e-9);
+      ++frames;
+    } else if (name == "request") {
+      EXPECT_STREQ(event["args"]["video"].GetString(), "b.mp4");
+      EXPECT_STREQ(event["args"]["request"].GetString(), "r1");
+      EXPECT_FALSE(event["args"].HasMember("window"));
+    }
+  }
+  EXPECT_EQ(frames, 15000);
+  EXPECT_EQ(phases["X"], 15001);
+  EXPECT_EQ(phases["b"], 1);
+  EXPECT_EQ(phases["e"], 1);
+  EXPECT_GE(phases["M"], 4);
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,196 @@
+#include "video_classification/triton_client.hpp"
+
+#include <arpa/inet.h>
+#include <csignal>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+using namespace std::chrono_literals;
+
+/**
+ * @brief Listening socket on a free local port that never accepts, so
+ *        connections succeed but requests are never answered
+ */
+class BlackHole {
+public:
+  BlackHole() {
+    fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(addr);
+    if (::bind(fd_, reinterpret_cast<sockaddr *>(&addr), length) != 0 ||
+        ::listen(fd_, 16) != 0 ||
+        ::getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &length) != 0) {
+      throw std::runtime_error("Failed to open a local socket");
+    }
+    port_ = ntohs(addr.sin_port);
+  }
+  ~BlackHole() { ::close(fd_); }
+
+  int port() const { return port_; }
+  std::string url() const { return "127.0.0.1:" + std::to_string(port_); }
+
+private:
+  int fd_ = -1;
+  int port_ = 0;
+};
+
+int free_port() { return BlackHole().port(); }
+
+bool accepts_connections(int port) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  const bool connected =
+      ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+  ::close(fd);
+  return connected;
+}
+
+/**
+ * @brief python/mock_triton_server.py running in a child process
+ */
+class MockReplica {
+public:
+  explicit MockReplica(int port, double fail_rate = 0.0) : port_(port) {
+    const std::string port_arg = std::to_string(port);
+    const std::string fail_arg = std::to_string(fail_rate);
+    pid_ = ::fork();
+    if (pid_ == 0) {
+      ::execl(PYTHON_EXECUTABLE, PYTHON_EXECUTABLE, MOCK_TRITON_SERVER,
+              "--port", port_arg.c_str(), "--delay-ms", "5", "--fail-rate",
+              fail_arg.c_str(), static_cast<char *>(nullptr));
+      ::_exit(127);
+    }
+    for (int i = 0; i < 100 && !accepts_connections(port); ++i) {
+      std::this_thread::sleep_for(50ms);
+    }
+  }
+  ~MockReplica() {
+    ::kill(pid_, SIGTERM);
+    ::waitpid(pid_, nullptr, 0);
+  }
+
+  std::string url() const { return "127.0.0.1:" + std::to_string(port_); }
+
+private:
+  int port_;
+  pid_t pid_ = -1;
+};
+
+const EndpointStats &stats_of(const std::vector<EndpointStats> &stats,
+                              const std::string &url) {
+  for (const auto &entry : stats) {
+    if (entry.url == url) {
+      return entry;
+    }
+  }
+  throw std::runtime_error("No endpoint " + url);
+}
+
+ModelInfo mock_model() {
+  ModelInfo info{};
+  info.input_name_ = "pixel_values";
+  info.input_datatype_ = "FP32";
+  info.output_name_ = "logits";
+  return info;
+}
+
+// The mock answers 400 logits whatever the input
+void infer(TritonClient &client, int times) {
+  const std::vector<float> input(4, 0.0f);
+  for (int i = 0; i < times; ++i) {
+    EXPECT_EQ(client.infer_logits(input, "mock", mock_model(), {1, 4}).size(),
+              400u);
+  }
+}
+}
+
+TEST(TritonClientTest, BlackHoledReplicaDoesNotStallStartupOrRequests) {
+  MockReplica healthy(free_port());
+  BlackHole black_hole;
+  TritonRoutingOptions routing;
+  routing.probe_timeout = 300ms;
+  routing.eject_cooldown = 50ms;
+
+  const auto start = std::chrono::steady_clock::now();
+  TritonClient client({black_hole.url(), healthy.url()}, "", routing);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+
+  // Re-probes after the cooldown must not block the requests either
+  const auto requests_start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 10; ++i) {
+    infer(client, 1);
+    std::this_thread::sleep_for(20ms);
+  }
+  EXPECT_LT(std::chrono::steady_clock::now() - requests_start, 5s);
+
+  const auto stats = client.endpoint_stats();
+  EXPECT_FALSE(stats_of(stats, black_hole.url()).healthy);
+  EXPECT_EQ(stats_of(stats, black_hole.url()).requests, 0u);
+  EXPECT_EQ(stats_of(stats, healthy.url()).requests, 10u);
+}
+
+TEST(TritonClientTest, EjectsFailingReplicaAndFailsOver) {
+  MockReplica healthy(free_port());
+  MockReplica failing(free_port(), 1.0);
+  TritonRoutingOptions routing;
+  routing.eject_cooldown = 60s;
+  TritonClient client({failing.url(), healthy.url()}, "", routing);
+
+  infer(client, 20);
+
+  const auto stats = client.endpoint_stats();
+  const auto &failed = stats_of(stats, failing.url());
+  EXPECT_FALSE(failed.healthy);
+  EXPECT_EQ(failed.failures,
+            static_cast<uint64_t>(routing.max_consecutive_failures));
+  EXPECT_EQ(failed.requests, failed.failures);
+  EXPECT_EQ(stats_of(stats, healthy.url()).requests, 20u);
+}
+
+TEST(TritonClientTest, ReadmitsReplicaOnceItIsReady) {
+  MockReplica healthy(free_port());
+  const int late_port = free_port();
+  TritonRoutingOptions routing;
+  routing.eject_cooldown = 50ms;
+  const std::string late_url = "127.0.0.1:" + std::to_string(late_port);
+  TritonClient client({late_url, healthy.url()}, "", routing);
+  EXPECT_FALSE(stats_of(client.endpoint_stats(), late_url).healthy);
+
+  MockReplica late(late_port);
+  const auto deadline = std::chrono::steady_clock::now() + 5s;
+  while (!stats_of(client.endpoint_stats(), late_url).healthy &&
+         std::chrono::steady_clock::now() < deadline) {
+    infer(client, 1);
+    std::this_thread::sleep_for(20ms);
+  }
+  EXPECT_TRUE(stats_of(client.endpoint_stats(), late_url).healthy);
+
+  infer(client, 10);
+  EXPECT_GT(stats_of(client.endpoint_stats(), late_url).requests, 0u);
+}
+
+TEST(TritonClientTest, WritesIntoTheCallerBufferWithoutReallocating) {
+  MockReplica replica(free_port());
+  TritonClient client(replica.url());
+  const std::vector<float> input(4, 0.0f);
+  std::vector<float> logits;
+  client.infer_logits_into(input, "mock", mock_model(), {1, 4}, logits);
+  ASSERT_EQ(logits.size(), 400u);
+
+  const float *data = logits.data();
+  for (int i = 0; i < 5; ++i) {
+    client.infer_logits_into(input, "mock", mock_model(), {1, 4}, logits);
+    EXPECT_EQ(logits.size(), 400u);
+    EXPECT_EQ(logits.data(), data);
+  }
+}
@@ -0,0 +1,122 @@
+#include "video_classification/video_fingerprint.hpp"
+
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace {
+VideoFingerprint make_fingerprint(uint64_t seed, double duration) {
+  VideoFingerprint fingerprint;
+  for (size_t i = 0; i < VideoFingerprint::NUM_FRAMES; ++i) {
+    fingerprint.frame_hashes[i] = seed * 0x9e3779b97f4a7c15ull + i;
+  }
+  fingerprint.duration = duration;
+  return fingerprint;
+}
+
+class FingerprintIndexTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    path_ = (std::filesystem::temp_directory_path() /
+             ("fingerprints_" + std::to_string(::getpid()) + ".jsonl"))
+                .string();
+    std::filesystem::remove(path_);
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  std::string path_;
+};
+}
+
+TEST(VideoFingerprintTest, HashesBrightnessGradients) {
+  cv::Mat gradient(48, 64, CV_8UC1);
+  for (int x = 0; x < gradient.cols; ++x) {
+    gradient.col(x).setTo(x * 4);
+  }
+  EXPECT_EQ(VideoFingerprint::dhash(gradient), ~uint64_t{0});
+
+  cv::Mat flipped;
+  cv::flip(gradient, flipped, 1);
+  EXPECT_EQ(VideoFingerprint::dhash(flipped), uint64_t{0});
+
+  // Rescaling keeps the hash
+  cv::Mat color, larger;
+  cv::cvtColor(gradient, color, cv::COLOR_GRAY2BGR);
+  cv::resize(color, larger, cv::Size(320, 240));
+  EXPECT_EQ(VideoFingerprint::dhash(larger), VideoFingerprint::dhash(gradient));
+}
+
+TEST(VideoFingerprintTest, HashesTheDecodedWindow) {
+  // Brightness rises left to right in the first half of the window and falls
+  // in the second
+  std::vector<cv::Mat> window;
+  for (int f = 0; f < 16; ++f) {
+    cv::Mat gray(48, 64, CV_8UC1), frame;
+    for (int x = 0; x < gray.cols; ++x) {
+      gray.col(x).setTo(f < 8 ? x * 2 + f : 255 - x * 2 - f);
+    }
+    cv::cvtColor(gray, frame, cv::COLOR_GRAY2BGR);
+    window.push_back(frame);
+  }
+  const auto fingerprint =
+      VideoFingerprint::from_frames(window, FrameColorFormat::RGB, 30.0);
+  EXPECT_DOUBLE_EQ(fingerprint.duration, 30.0);
+  for (size_t i = 0; i < VideoFingerprint::NUM_FRAMES; ++i) {
+    EXPECT_EQ(fingerprint.frame_hashes[i],
+              i < VideoFingerprint::NUM_FRAMES / 2 ? ~uint64_t{0} : uint64_t{0});
+  }
+
+  // Rescaled frames match, mirrored ones do not
+  std::vector<cv::Mat> rescaled, mirrored;
+  for (const auto &frame : window) {
+    cv::Mat larger, flipped;
+    cv::resize(frame, larger, cv::Size(320, 240));
+    cv::flip(frame, flipped, 1);
+    rescaled.push_back(larger);
+    mirrored.push_back(flipped);
+  }
+  EXPECT_EQ(fingerprint.distance(VideoFingerprint::from_frames(
+                rescaled, FrameColorFormat::RGB, 30.0)),
+            0);
+  EXPECT_EQ(fingerprint.distance(VideoFingerprint::from_frames(
+                mirrored, FrameColorFormat::RGB, 30.0)),
+            64 * static_cast<int>(VideoFingerprint::NUM_FRAMES));
+
+  EXPECT_THROW(VideoFingerprint::from_frames({}, FrameColorFormat::RGB, 30.0),
+               std::runtime_error);
+}
+
+TEST_F(FingerprintIndexTest, FindsNearDuplicatesOnly) {
+  FingerprintIndex index(path_, 8);
+  const auto original = make_fingerprint(1, 60.0);
+  index.add("a.mp4", original, {{"archery", 0.9f}, {"bowling", 0.05f}});
+
+  auto reencoded = original;
+  reencoded.frame_hashes[0] ^= 0x7; // 3 bits flipped
+  reencoded.duration = 60.4;
+  auto match = index.find(reencoded);
+  ASSERT_TRUE(match);
+  EXPECT_EQ(match->video, "a.mp4");
+  EXPECT_EQ(match->distance, 3);
+  ASSERT_EQ(match->predictions.size(), 2u);
+  EXPECT_EQ(match->predictions[0].label, "archery");
+
+  EXPECT_FALSE(index.find(make_fingerprint(2, 60.0)));
+  auto trimmed = original;
+  trimmed.duration = 45.0;
+  EXPECT_FALSE(index.find(trimmed));
+}
+
+TEST_F(FingerprintIndexTest, SeesEntriesOfOtherWriters) {
+  FingerprintIndex first(path_, 8);
+  FingerprintIndex second(path_, 8);
+  first.add("a.mp4", make_fingerprint(1, 10.0), {{"archery", 0.9f}});
+  second.add("b.mp4", make_fingerprint(2, 10.0), {{"bowling", 0.8f}});
+
+  auto match = first.find(make_fingerprint(2, 10.0));
+  ASSERT_TRUE(match);
+  EXPECT_EQ(match->video, "b.mp4");
+  EXPECT_EQ(first.size(), 2u);
+  EXPECT_EQ(FingerprintIndex(path_, 8).size(), 2u);
+}
@@ -0,0 +1,155 @@
+#include "video_classification/video_seek_index.hpp"
+#include "video_classification/video_processor.hpp"
+#include "video_classification/video_utils.hpp"
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+namespace {
+std::string temp_path(const std::string &name) {
+  return (std::filesystem::temp_directory_path() /
+          (name + "_" + std::to_string(::getpid())))
+      .string();
+}
+
+/// 10 fps for one second, then 5 fps; keyframes every 5 frames
+VideoSeekIndex make_vfr_index() {
+  std::vector<double> times;
+  for (int i = 0; i < 10; ++i) {
+    times.push_back(0.5 + i * 0.1); // Timestamps need not start at zero
+  }
+  for (int i = 0; i < 10; ++i) {
+    times.push_back(1.5 + i * 0.2);
+  }
+  return VideoSeekIndex(42, 10.0, times, {0, 5, 10, 15});
+}
+}
+
+TEST(VideoSeekIndexTest, MapsTimesToFramesAtVariableRate) {
+  const auto index = make_vfr_index();
+  EXPECT_EQ(index.frame_count(), 20);
+  EXPECT_TRUE(index.variable_frame_rate());
+  EXPECT_DOUBLE_EQ(index.start_time(), 0.5);
+  EXPECT_DOUBLE_EQ(index.frame_time(0), 0.0);
+  EXPECT_DOUBLE_EQ(index.frame_time(12), 1.4);
+
+  EXPECT_EQ(index.frame_at_time(0.0), 0);
+  EXPECT_EQ(index.frame_at_time(0.95), 10);
+  EXPECT_EQ(index.frame_at_time(2.0), 15);
+  EXPECT_EQ(index.frame_at_time(2.85), 20); // Past the last frame
+}
+
+TEST(VideoSeekIndexTest, SeeksOnlyWhenAKeyframeIsAhead) {
+  const auto index = make_vfr_index();
+  EXPECT_EQ(index.keyframe_before(9), 5);
+  EXPECT_EQ(index.keyframe_before(15), 15);
+
+  EXPECT_TRUE(index.should_seek(10, 3)); // Backwards
+  EXPECT_FALSE(index.should_seek(6, 19)); // Seek would land on frame 0
+  std::vector<double> times(50);
+  for (size_t i = 0; i < times.size(); ++i) {
+    times[i] = static_cast<double>(i) / 25.0;
+  }
+  const VideoSeekIndex gop(1, 25.0, times, {0, 10, 20, 30, 40});
+  EXPECT_TRUE(gop.should_seek(2, 45));  // Restarts at keyframe 20
+  EXPECT_FALSE(gop.should_seek(12, 35)); // Would restart at keyframe 10
+  // Keyframe 20 lies in between, but the seek preroll starts before it
+  EXPECT_FALSE(gop.should_seek(12, 28));
+
+  const VideoSeekIndex unknown(1, 25.0, times, {});
+  EXPECT_FALSE(unknown.has_keyframes());
+  EXPECT_FALSE(unknown.should_seek(0, 40));
+}
+
+TEST(VideoSeekIndexTest, RoundTripsAndRejectsOtherVideos) {
+  const std::string path = temp_path("seek_index");
+  const auto index = make_vfr_index();
+  index.save(path);
+
+  auto loaded = VideoSeekIndex::load(path, 42);
+  ASSERT_TRUE(loaded);
+  EXPECT_EQ(loaded->frame_count(), index.frame_count());
+  EXPECT_DOUBLE_EQ(loaded->frame_time(19), index.frame_time(19));
+  EXPECT_EQ(loaded->keyframe_before(14), 10);
+  EXPECT_DOUBLE_EQ(loaded->start_time(), 0.5);
+  EXPECT_FALSE(VideoSeekIndex::load(path, 43));
+  EXPECT_FALSE(VideoSeekIndex::load(path + ".missing", 42));
+  std::filesystem::remove(path);
+}
+
+TEST(VideoSeekIndexTest, SaveLeavesNoTemporaryFiles) {
+  const std::filesystem::path dir = temp_path("seek_index_dir");
+  std::filesystem::create_directories(dir);
+  const auto index = make_vfr_index();
+  index.save((dir / "video.seekidx").string());
+  index.save((dir / "video.seekidx").string());
+  EXPECT_THROW(index.save((dir / "missing" / "video.seekidx").string()),
+               std::runtime_error);
+
+  std::vector<std::string> names;
+  for (const auto &entry : std::filesystem::directory_iterator(dir)) {
+    names.push_back(entry.path().filename().string());
+  }
+  EXPECT_EQ(names, std::vector<std::string>{"video.seekidx"});
+  std::filesystem::remove_all(dir);
+}
+
+TEST(VideoSeekIndexTest, HashChangesWithContent) {
+  const std::string path = temp_path("seek_index_video");
+  std::ofstream(path) << "first";
+  const uint64_t first = VideoSeekIndex::hash_file(path);
+  std::ofstream(path) << "second";
+  EXPECT_NE(VideoSeekIndex::hash_file(path), first);
+  std::filesystem::remove(path);
+  EXPECT_THROW(VideoSeekIndex::hash_file(path), std::runtime_error);
+}
+
+TEST(VideoSeekIndexTest, SeeksToTheIndexedFrameAtVariableRate) {
+  // Same timing as make_vfr_index(); frame n is filled with gray level 12 n
+  const std::string path = temp_path("seek_index_vfr") + ".mkv";
+  const std::string command =
+      "ffmpeg -v error -y -f lavfi -i color=c=black:s=64x64:r=10:d=2 -vf "
+      "\"format=gray,geq=lum='N*12',settb=1/1000,"
+      "setpts='(0.5+if(lt(N,10),N*0.1,1+(N-10)*0.2))/TB'\" -vsync vfr "
+      "-c:v mpeg4 -q:v 1 -g 5 -pix_fmt yuv420p " +
+      path + " >/dev/null 2>&1";
+  if (std::system(command.c_str()) != 0) {
+    GTEST_SKIP() << "ffmpeg is not available";
+  }
+
+  const auto index =
+      std::make_shared<const VideoSeekIndex>(VideoSeekIndex::build(path));
+  ASSERT_EQ(index->frame_count(), 20);
+  EXPECT_TRUE(index->variable_frame_rate());
+  EXPECT_NEAR(index->frame_time(15), 2.0, 0.002);
+
+  // Reference: every frame in decode order
+  std::vector<double> levels;
+  cv::VideoCapture cap(path);
+  for (cv::Mat frame; cap.read(frame);) {
+    levels.push_back(cv::mean(frame)[0]);
+  }
+  ASSERT_EQ(levels.size(), 20u);
+
+  // Forward past a keyframe, backwards, and into the slower second half
+  VideoProcessor processor;
+  ASSERT_TRUE(processor.openVideo(path, index));
+  const std::vector<int> targets = {2, 17, 6, 12, 19, 0};
+  const auto frames = processor.extractFrames(targets);
+  ASSERT_EQ(frames.size(), targets.size());
+  for (size_t i = 0; i < targets.size(); ++i) {
+    EXPECT_NEAR(cv::mean(frames[i])[0],
+                levels[static_cast<size_t>(targets[i])], 3.0)
+        << "frame " << targets[i];
+  }
+
+  const auto sampled = read_video_frames(path, 3, FrameColorFormat::RGB,
+                                         index.get());
+  ASSERT_EQ(sampled.size(), 3u); // Frames 0, 10 and 15, at 0 s, 1 s and 2 s
+  EXPECT_NEAR(cv::mean(sampled[1])[0], levels[10], 3.0);
+  EXPECT_NEAR(cv::mean(sampled[2])[0], levels[15], 3.0);
+  std::filesystem::remove(path);
+}